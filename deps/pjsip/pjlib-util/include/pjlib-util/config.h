@@ -132,6 +132,62 @@
 #   define PJ_DNS_RESOLVER_INVALID_TTL		    60
 #endif
 
+/**
+ * Maximum life-time of negative DNS response (NXDOMAIN or NODATA) in the
+ * resolver response cache. As specified by RFC 2308, the negative TTL is
+ * taken from the SOA record in the authority section of the response,
+ * and this value caps it. When the response carries no SOA record, this
+ * value is used as is. If the value is zero, negative responses will not
+ * be cached.
+ *
+ * Default: PJ_DNS_RESOLVER_INVALID_TTL
+ *
+ * @see PJ_DNS_RESOLVER_INVALID_TTL
+ */
+#ifndef PJ_DNS_RESOLVER_NEG_MAX_TTL
+#   define PJ_DNS_RESOLVER_NEG_MAX_TTL		    PJ_DNS_RESOLVER_INVALID_TTL
+#endif
+
+/**
+ * The interval, in seconds, after the expiration of a positive response in
+ * the resolver cache during which the expired response may still be
+ * returned to the application, while a single query to refresh the entry
+ * is started in the background (stale-while-revalidate). This prevents
+ * concurrent queries from all missing the cache at the same time when a
+ * popular record expires. If the value is zero, expired responses will
+ * never be returned.
+ *
+ * Default: 30
+ */
+#ifndef PJ_DNS_RESOLVER_STALE_TTL
+#   define PJ_DNS_RESOLVER_STALE_TTL		    30
+#endif
+
+/**
+ * Percentage of the original TTL remaining in a cached response below
+ * which the resolver will refresh the entry in the background (prefetch)
+ * when it is picked up from the cache. Only entries which have been used
+ * at least PJ_DNS_RESOLVER_PREFETCH_MIN_HITS times are prefetched. If the
+ * value is zero, prefetching is disabled.
+ *
+ * Default: 10
+ */
+#ifndef PJ_DNS_RESOLVER_PREFETCH_PCT
+#   define PJ_DNS_RESOLVER_PREFETCH_PCT		    10
+#endif
+
+/**
+ * Minimum number of cache hits for a cached response before it is
+ * considered for prefetching.
+ *
+ * Default: 3
+ *
+ * @see PJ_DNS_RESOLVER_PREFETCH_PCT
+ */
+#ifndef PJ_DNS_RESOLVER_PREFETCH_MIN_HITS
+#   define PJ_DNS_RESOLVER_PREFETCH_MIN_HITS	    3
+#endif
+
 /**
  * The interval on which nameservers which are known to be good to be 
  * probed again to determine whether they are still good. Note that
@@ -210,6 +266,20 @@
 #  define PJ_SCANNER_USE_BITWISE		    1
 #endif
 
+/**
+ * Macro PJ_SCANNER_USE_SIMD is defined and non-zero (by default yes) will
+ * enable vectorized scanning of character input specifications, which
+ * classifies 16 (SSSE3 or ARM NEON) or 32 (AVX2) characters at a time
+ * instead of one. It is only used with the uint backend (that is when
+ * PJ_SCANNER_USE_BITWISE is zero). On x86 the SSSE3 and AVX2 versions
+ * are compiled in with GCC function attributes and selected at run time,
+ * on ARM NEON is used on AArch64. Otherwise the scanner falls back to the
+ * scalar implementation.
+ */
+#ifndef PJ_SCANNER_USE_SIMD
+#  define PJ_SCANNER_USE_SIMD			    1
+#endif
+
 
 
 /* **************************************************************************
@@ -254,6 +324,33 @@
 #   define PJ_CRC32_HAS_TABLES			    1
 #endif
 
+/**
+ * Specifies whether CRC32 calculation may use carry-less multiplication
+ * (PCLMULQDQ on x86) or the CRC32 instructions of ARMv8 for large enough
+ * inputs. On x86 the instructions are compiled in with GCC function
+ * attributes and used only when the CPU reports them at run time; on ARM
+ * they are used when the compiler targets them (e.g. -march=armv8-a+crc).
+ * Only used with the table based implementation (PJ_CRC32_HAS_TABLES).
+ *
+ * Default: 1
+ */
+#ifndef PJ_CRC32_USE_SIMD
+#   define PJ_CRC32_USE_SIMD			    1
+#endif
+
+/**
+ * Specifies whether SHA1 (and thus HMAC-SHA1, which is used for the STUN
+ * MESSAGE-INTEGRITY) may use the SHA extensions of x86 CPUs (SHA-NI) or
+ * the ARMv8 cryptography extensions. As with PJ_CRC32_USE_SIMD, the x86
+ * version is selected at run time and the ARM version at compile time
+ * (e.g. -march=armv8-a+crypto).
+ *
+ * Default: 1
+ */
+#ifndef PJ_SHA1_USE_SIMD
+#   define PJ_SHA1_USE_SIMD			    1
+#endif
+
 
 /* **************************************************************************
  * HTTP Client configuration
@@ -39,13 +39,27 @@ PJ_BEGIN_DECL
  * for Message Authentication, as described in RFC 2104.
  */
 
+/**
+ * The key schedule of HMAC-SHA1, that is the SHA1 state after hashing the
+ * key xor-ed with the inner and the outer pad. Users which authenticate
+ * many messages with the same key (e.g. STUN with a long term credential)
+ * can compute it once with #pj_hmac_sha1_key_init() and start each
+ * calculation with #pj_hmac_sha1_init_key(), which saves hashing the two
+ * pad blocks per message.
+ */
+typedef struct pj_hmac_sha1_key
+{
+    pj_uint32_t	    ipad_state[5];  /**< SHA1 state after the ipad block */
+    pj_uint32_t	    opad_state[5];  /**< SHA1 state after the opad block */
+} pj_hmac_sha1_key;
+
 /**
  * The HMAC-SHA1 context used in the incremental HMAC calculation.
  */
 typedef struct pj_hmac_sha1_context
 {
-    pj_sha1_context context;	/**< SHA1 context	    */
-    pj_uint8_t	    k_opad[64];	/**< opad xor-ed with key   */
+    pj_sha1_context context;	    /**< SHA1 context		     */
+    pj_uint32_t	    opad_state[5];  /**< SHA1 state after the opad block */
 } pj_hmac_sha1_context;
 
 
@@ -74,6 +88,27 @@ PJ_DECL(void) pj_hmac_sha1(const pj_uint8_t *input, unsigned input_len,
 PJ_DECL(void) pj_hmac_sha1_init(pj_hmac_sha1_context *hctx, 
 			        const pj_uint8_t *key, unsigned key_len);
 
+/**
+ * Compute the key schedule of the specified key.
+ *
+ * @param hkey		The key schedule to be initialized.
+ * @param key		Pointer to the authentication key.
+ * @param key_len	Length of the authentication key.
+ */
+PJ_DECL(void) pj_hmac_sha1_key_init(pj_hmac_sha1_key *hkey,
+				    const pj_uint8_t *key, unsigned key_len);
+
+/**
+ * Initiate HMAC-SHA1 context for incremental hashing with a key schedule
+ * computed earlier by #pj_hmac_sha1_key_init(). The result is the same as
+ * calling #pj_hmac_sha1_init() with the key.
+ *
+ * @param hctx		HMAC-SHA1 context.
+ * @param hkey		The key schedule.
+ */
+PJ_DECL(void) pj_hmac_sha1_init_key(pj_hmac_sha1_context *hctx,
+				    const pj_hmac_sha1_key *hkey);
+
 /**
  * Append string to the message.
  *
@@ -66,9 +66,20 @@ PJ_BEGIN_DECL
  * across all resource record (RR) TTL in the response and further more it can
  * be limited to some preconfigured maximum TTL in the resolver. 
  *
- * Response caching can be  disabled by setting the maximum TTL value of the 
+ * Response caching can be  disabled by setting the maximum TTL value of the
  * resolver to zero.
  *
+ * Negative responses (NXDOMAIN and responses without answers) are cached
+ * too, with the TTL taken from the SOA record in the authority section as
+ * described by RFC 2308 (see #PJ_DNS_RESOLVER_NEG_MAX_TTL).
+ *
+ * Frequently used entries are refreshed in the background shortly before
+ * they expire (see #PJ_DNS_RESOLVER_PREFETCH_PCT), and an entry which has
+ * just expired is still returned for a short while as its refresh query is
+ * running (see #PJ_DNS_RESOLVER_STALE_TTL), so that the expiration of a
+ * popular record does not make all concurrent queries wait for the server.
+ * The cache statistics can be queried with #pj_dns_resolver_get_cache_stat().
+ *
  * \subsection PJ_DNS_RESOLVER_FEATURES_PARALLEL Parallel and Backup Name Servers
  *
  * When the resolver is configured with multiple nameservers, initially the
@@ -155,6 +166,8 @@ PJ_BEGIN_DECL
  *  - <A HREF="http://www.faqs.org/rfcs/rfc2782.html">
  *    RFC 2782: "A DNS RR for specifying the location of services (DNS SRV)"
  *    </A>
+ *  - <A HREF="http://www.faqs.org/rfcs/rfc2308.html">
+ *    RFC 2308: "Negative Caching of DNS Queries (DNS NCACHE)"</A>
  */
 
 
@@ -196,9 +209,29 @@ typedef struct pj_dns_settings
 				     value is zero, caching is disabled.    */
     unsigned	good_ns_ttl;	/**< See #PJ_DNS_RESOLVER_GOOD_NS_TTL	    */
     unsigned	bad_ns_ttl;	/**< See #PJ_DNS_RESOLVER_BAD_NS_TTL	    */
+    unsigned	cache_neg_max_ttl;/**< See #PJ_DNS_RESOLVER_NEG_MAX_TTL	    */
+    unsigned	cache_stale_ttl;/**< See #PJ_DNS_RESOLVER_STALE_TTL	    */
+    unsigned	prefetch_pct;	/**< See #PJ_DNS_RESOLVER_PREFETCH_PCT	    */
 } pj_dns_settings;
 
 
+/**
+ * This structure describes the response cache statistics of the resolver,
+ * as returned by #pj_dns_resolver_get_cache_stat().
+ */
+typedef struct pj_dns_cache_stat
+{
+    unsigned	hit;		/**< Queries answered from valid cache
+				     entries (including negative ones).    */
+    unsigned	neg_hit;	/**< Queries answered from negative cache
+				     entries.				    */
+    unsigned	stale_hit;	/**< Queries answered from expired entries
+				     while they were being refreshed.	    */
+    unsigned	miss;		/**< Queries not answered from the cache.   */
+    unsigned	prefetch;	/**< Background refresh queries started.    */
+} pj_dns_cache_stat;
+
+
 /**
  * This structure represents DNS A record, as the result of parsing
  * DNS response packet using #pj_dns_parse_a_response().
@@ -439,6 +472,18 @@ PJ_DECL(pj_status_t) pj_dns_resolver_add_entry(pj_dns_resolver *resolver,
 PJ_DECL(unsigned) pj_dns_resolver_get_cached_count(pj_dns_resolver *resolver);
 
 
+/**
+ * Get the response cache statistics of the resolver.
+ *
+ * @param resolver  The resolver instance.
+ * @param stat	    Buffer to be filled up with the cache statistics.
+ *
+ * @return	    PJ_SUCCESS on success, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_dns_resolver_get_cache_stat(pj_dns_resolver *resolver,
+						    pj_dns_cache_stat *stat);
+
+
 /**
  * Dump resolver state to the log.
  *
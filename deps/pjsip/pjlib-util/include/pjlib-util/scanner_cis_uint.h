@@ -42,11 +42,16 @@ typedef PJ_CIS_ELEM_TYPE pj_cis_elem_t;
 typedef int pj_cis_buf_t;
 
 /**
- * Character input specification.
+ * Character input specification. The nibble tables are used by the
+ * vectorized scanner (see #PJ_SCANNER_USE_SIMD), they are present in
+ * every build so that the layout doesn't depend on the compiler flags.
  */
 typedef struct pj_cis_t
 {
     PJ_CIS_ELEM_TYPE	cis_buf[256];	/**< Internal buffer.	*/
+    pj_uint8_t		simd_lo[16];	/**< Low nibble classes.	*/
+    pj_uint8_t		simd_hi[16];	/**< High nibble classes.	*/
+    int			simd_ok;	/**< Nibble tables are valid.	*/
 } pj_cis_t;
 
 
@@ -57,7 +62,8 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character.
  */
-#define PJ_CIS_SET(cis,c)   ((cis)->cis_buf[(int)(c)] = 1)
+#define PJ_CIS_SET(cis,c)   ((cis)->simd_ok = 0, \
+			     (cis)->cis_buf[(int)(c)] = 1)
 
 /**
  * Remove the membership of the specified character.
@@ -66,7 +72,8 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character to be removed from the membership.
  */
-#define PJ_CIS_CLR(cis,c)   ((cis)->cis_buf[(int)c] = 0)
+#define PJ_CIS_CLR(cis,c)   ((cis)->simd_ok = 0, \
+			     (cis)->cis_buf[(int)c] = 0)
 
 /**
  * Check the membership of the specified character.
@@ -10,6 +10,7 @@
  * this file is put on public domain as well.
  */
 #include <pjlib-util/crc32.h>
+#include <pjlib-util/config.h>
 
 
 #define CRC32_NEGL  0xffffffffL
@@ -147,6 +148,17 @@ static const pj_uint32_t crc_tab[] = {
 #   error "Endianness not defined"
 #endif
 
+#if defined(PJ_CRC32_USE_SIMD) && PJ_CRC32_USE_SIMD != 0 && \
+    defined(PJ_IS_LITTLE_ENDIAN) && PJ_IS_LITTLE_ENDIAN != 0 && \
+    defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)))
+#   define CRC32_HAS_SIMD   1
+#   include "crc32_simd.c"
+#else
+#   define CRC32_HAS_SIMD   0
+#endif
+
 
 PJ_DEF(void) pj_crc32_init(pj_crc32_context *ctx)
 {
@@ -163,6 +175,16 @@ PJ_DEF(pj_uint32_t) pj_crc32_update(pj_crc32_context *ctx,
 	crc = crc_tab[CRC32_INDEX(crc) ^ *data++] ^ CRC32_SHIFTED(crc);
     }
 
+#if CRC32_HAS_SIMD
+    if (nbytes >= CRC32_SIMD_MIN && crc32_simd_available()) {
+	pj_size_t len = nbytes & ~(pj_size_t)(CRC32_SIMD_ALIGN - 1);
+
+	crc = crc32_simd_update(crc, data, len);
+	data += len;
+	nbytes -= len;
+    }
+#endif
+
     while (nbytes >= 4) {
 	crc ^= *(const pj_uint32_t *)data;
 	crc = crc_tab[CRC32_INDEX(crc)] ^ CRC32_SHIFTED(crc);
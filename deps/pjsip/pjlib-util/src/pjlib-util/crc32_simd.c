@@ -0,0 +1,139 @@
+/* $Id$ */
+/*
+ * This file is put on public domain, as crc32.c which includes it.
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY crc32.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * CRC32 of larger blocks with carry-less multiplication (x86 PCLMULQDQ)
+ * or the ARMv8 CRC32 instructions. The PCLMULQDQ version folds four
+ * 128-bit lanes in parallel over the input, then folds the lanes into one
+ * and reduces it to 32 bits (Barrett reduction), as described in Intel's
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction". Both work on the reflected CRC register, i.e. the value
+ * the table loop in crc32.c works on, and return the updated register.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/* Minimum input length, and the granularity of the input consumed */
+#define CRC32_SIMD_MIN	    64
+#define CRC32_SIMD_ALIGN    16
+
+/* Folding constants for the CRC32 polynomial (bit reflected) */
+static const pj_uint64_t crc32_k1k2[2] = { 0x0154442bd4ULL,
+					   0x01c6e41596ULL };
+static const pj_uint64_t crc32_k3k4[2] = { 0x01751997d0ULL,
+					   0x00ccaa009eULL };
+static const pj_uint64_t crc32_k5k0[2] = { 0x0163cd6124ULL,
+					   0x0000000000ULL };
+static const pj_uint64_t crc32_poly[2] = { 0x01db710641ULL,
+					   0x01f7011641ULL };
+
+/* Fold x by 128 (or 512) bits with the constants in k and add y */
+#define CRC32_FOLD(x, k, y) \
+    _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), \
+				_mm_clmulepi64_si128(x, k, 0x11)), y)
+
+/* len must be at least CRC32_SIMD_MIN and a multiple of CRC32_SIMD_ALIGN */
+__attribute__((target("pclmul,sse4.1")))
+static pj_uint32_t crc32_simd_update(pj_uint32_t crc, const pj_uint8_t *buf,
+				     pj_size_t len)
+{
+    __m128i x0, x1, x2, x3, x4, mask;
+
+    x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    buf += 64;
+    len -= 64;
+
+    /* Fold four lanes by 512 bits at a time */
+    x0 = _mm_loadu_si128((const __m128i*)crc32_k1k2);
+    while (len >= 64) {
+	x1 = CRC32_FOLD(x1, x0, _mm_loadu_si128((const __m128i*)(buf+0x00)));
+	x2 = CRC32_FOLD(x2, x0, _mm_loadu_si128((const __m128i*)(buf+0x10)));
+	x3 = CRC32_FOLD(x3, x0, _mm_loadu_si128((const __m128i*)(buf+0x20)));
+	x4 = CRC32_FOLD(x4, x0, _mm_loadu_si128((const __m128i*)(buf+0x30)));
+	buf += 64;
+	len -= 64;
+    }
+
+    /* Fold the lanes into one, then the remaining 128-bit blocks */
+    x0 = _mm_loadu_si128((const __m128i*)crc32_k3k4);
+    x1 = CRC32_FOLD(x1, x0, x2);
+    x1 = CRC32_FOLD(x1, x0, x3);
+    x1 = CRC32_FOLD(x1, x0, x4);
+    while (len >= 16) {
+	x1 = CRC32_FOLD(x1, x0, _mm_loadu_si128((const __m128i*)buf));
+	buf += 16;
+	len -= 16;
+    }
+
+    /* Fold 128 bits to 64 bits */
+    mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64((const __m128i*)crc32_k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = _mm_loadu_si128((const __m128i*)crc32_poly);
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (pj_uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+#undef CRC32_FOLD
+
+/* The result is cached, concurrent first calls merely repeat the check */
+static int crc32_simd_available(void)
+{
+    static int available = -1;
+
+    if (available < 0) {
+	unsigned eax, ebx, ecx, edx;
+
+	available = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+		    (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+    }
+    return available;
+}
+
+#else	/* ARMv8 */
+
+#include <arm_acle.h>
+#include <pj/string.h>
+
+#define CRC32_SIMD_MIN	    8
+#define CRC32_SIMD_ALIGN    8
+
+/* len must be a multiple of CRC32_SIMD_ALIGN */
+static pj_uint32_t crc32_simd_update(pj_uint32_t crc, const pj_uint8_t *buf,
+				     pj_size_t len)
+{
+    for ( ; len; len -= 8, buf += 8) {
+	pj_uint64_t v;
+	pj_memcpy(&v, buf, 8);
+	crc = __crc32d(crc, v);
+    }
+    return crc;
+}
+
+#define crc32_simd_available()	1
+
+#endif
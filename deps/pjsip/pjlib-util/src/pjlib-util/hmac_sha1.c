@@ -21,10 +21,20 @@
 #include <pj/string.h>
 
 
-PJ_DEF(void) pj_hmac_sha1_init(pj_hmac_sha1_context *hctx, 
-			       const pj_uint8_t *key, unsigned key_len)
+/* Start a SHA1 context from the state after one 64 bytes block */
+static void sha1_resume(pj_sha1_context *ctx, const pj_uint32_t state[5])
+{
+    pj_memcpy(ctx->state, state, sizeof(ctx->state));
+    ctx->count[0] = 64 << 3;
+    ctx->count[1] = 0;
+}
+
+PJ_DEF(void) pj_hmac_sha1_key_init(pj_hmac_sha1_key *hkey,
+				   const pj_uint8_t *key, unsigned key_len)
 {
+    pj_sha1_context ctx;
     pj_uint8_t k_ipad[64];
+    pj_uint8_t k_opad[64];
     pj_uint8_t tk[20];
     unsigned i;
 
@@ -46,20 +56,50 @@ PJ_DEF(void) pj_hmac_sha1_init(pj_hmac_sha1_context *hctx,
 
     /* start out by storing key in pads */
     pj_bzero( k_ipad, sizeof(k_ipad));
-    pj_bzero( hctx->k_opad, sizeof(hctx->k_opad));
+    pj_bzero( k_opad, sizeof(k_opad));
     pj_memcpy( k_ipad, key, key_len);
-    pj_memcpy( hctx->k_opad, key, key_len);
+    pj_memcpy( k_opad, key, key_len);
 
     /* XOR key with ipad and opad values */
     for (i=0; i<64; i++) {
         k_ipad[i] ^= 0x36;
-        hctx->k_opad[i] ^= 0x5c;
+        k_opad[i] ^= 0x5c;
     }
+
+    /*
+     * hash the pads; the 64 bytes update runs exactly one transform, so
+     * the state can be taken without finalizing
+     */
+    pj_sha1_init(&ctx);
+    pj_sha1_update(&ctx, k_ipad, 64);
+    pj_memcpy(hkey->ipad_state, ctx.state, sizeof(hkey->ipad_state));
+
+    pj_sha1_init(&ctx);
+    pj_sha1_update(&ctx, k_opad, 64);
+    pj_memcpy(hkey->opad_state, ctx.state, sizeof(hkey->opad_state));
+
+    pj_bzero(k_ipad, sizeof(k_ipad));
+    pj_bzero(k_opad, sizeof(k_opad));
+    pj_bzero(&ctx, sizeof(ctx));
+}
+
+PJ_DEF(void) pj_hmac_sha1_init_key(pj_hmac_sha1_context *hctx,
+				   const pj_hmac_sha1_key *hkey)
+{
     /*
      * perform inner SHA1
      */
-    pj_sha1_init(&hctx->context);
-    pj_sha1_update(&hctx->context, k_ipad, 64);
+    sha1_resume(&hctx->context, hkey->ipad_state);
+    pj_memcpy(hctx->opad_state, hkey->opad_state, sizeof(hctx->opad_state));
+}
+
+PJ_DEF(void) pj_hmac_sha1_init(pj_hmac_sha1_context *hctx, 
+			       const pj_uint8_t *key, unsigned key_len)
+{
+    pj_hmac_sha1_key hkey;
+
+    pj_hmac_sha1_key_init(&hkey, key, key_len);
+    pj_hmac_sha1_init_key(hctx, &hkey);
 }
 
 PJ_DEF(void) pj_hmac_sha1_update(pj_hmac_sha1_context *hctx,
@@ -76,8 +116,7 @@ PJ_DEF(void) pj_hmac_sha1_final(pj_hmac_sha1_context *hctx,
     /*
      * perform outer SHA1
      */
-    pj_sha1_init(&hctx->context);
-    pj_sha1_update(&hctx->context, hctx->k_opad, 64);
+    sha1_resume(&hctx->context, hctx->opad_state);
     pj_sha1_update(&hctx->context, digest, 20);
     pj_sha1_final(&hctx->context, digest);
 }
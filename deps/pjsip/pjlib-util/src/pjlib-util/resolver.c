@@ -141,6 +141,7 @@ struct pj_dns_async_query
     unsigned		 options;	/**< Query options.		    */
     void		*user_data;	/**< Application data.		    */
     pj_dns_callback	*cb;		/**< Callback to be called.	    */
+    pj_bool_t		 is_refresh;	/**< Background cache refresh?	    */
     struct query_head	 child_head;	/**< Child queries list head.	    */
 };
 
@@ -156,6 +157,9 @@ struct cached_res
     struct res_key	     key;	    /**< Resource key.		    */
     pj_hash_entry_buf	     hbuf;	    /**< Hash buffer		    */
     pj_time_val		     expiry_time;   /**< Expiration time.	    */
+    unsigned		     ttl;	    /**< Original TTL (0: never
+						 expires).		    */
+    unsigned		     hit_cnt;	    /**< Number of cache hits.	    */
     pj_dns_parsed_packet    *pkt;	    /**< The response packet.	    */
     unsigned		     ref_cnt;	    /**< Reference counter.	    */
 };
@@ -207,6 +211,9 @@ struct pj_dns_resolver
 
     /* Query entries free list */
     struct query_head	 query_free_nodes;
+
+    /* Response cache statistics */
+    pj_dns_cache_stat	 cache_stat;
 };
 
 
@@ -291,6 +298,9 @@ PJ_DEF(void) pj_dns_settings_default(pj_dns_settings *s)
     s->cache_max_ttl = PJ_DNS_RESOLVER_MAX_TTL;
     s->good_ns_ttl = PJ_DNS_RESOLVER_GOOD_NS_TTL;
     s->bad_ns_ttl = PJ_DNS_RESOLVER_BAD_NS_TTL;
+    s->cache_neg_max_ttl = PJ_DNS_RESOLVER_NEG_MAX_TTL;
+    s->cache_stale_ttl = PJ_DNS_RESOLVER_STALE_TTL;
+    s->prefetch_pct = PJ_DNS_RESOLVER_PREFETCH_PCT;
 }
 
 
@@ -732,6 +742,65 @@ static void free_entry(pj_dns_resolver *resolver, struct cached_res *cache)
 }
 
 
+/* Assign transaction ID to a new query, send it and register it in the
+ * pending query hash tables. On failure, the query is put back to the
+ * free list.
+ */
+static pj_status_t start_new_query(pj_dns_resolver *resolver,
+				   pj_dns_async_query *q,
+				   const struct res_key *key)
+{
+    pj_status_t status;
+
+    /* Save the ID and key */
+    /* TODO: dnsext-forgery-resilient: randomize id for security */
+    q->id = resolver->last_id++;
+    if (resolver->last_id == 0)
+	resolver->last_id = 1;
+    pj_memcpy(&q->key, key, sizeof(struct res_key));
+
+    /* Send the query */
+    status = transmit_query(resolver, q);
+    if (status != PJ_SUCCESS) {
+	pj_list_push_back(&resolver->query_free_nodes, q);
+	return status;
+    }
+
+    /* Add query entry to the hash tables */
+    pj_hash_set_np(resolver->hquerybyid, &q->id, sizeof(q->id), 
+		   0, q->hbufid, q);
+    pj_hash_set_np(resolver->hquerybyres, &q->key, sizeof(q->key),
+		   0, q->hbufkey, q);
+
+    return PJ_SUCCESS;
+}
+
+
+/* Start a background query to refresh a cached entry, unless there is
+ * already a pending query for the same resource. The response of this
+ * query is only used to update the cache.
+ */
+static void refresh_entry(pj_dns_resolver *resolver,
+			  const struct res_key *key)
+{
+    pj_dns_async_query *q;
+
+    if (pj_hash_get(resolver->hquerybyres, key, sizeof(*key), NULL))
+	return;
+
+    q = alloc_qnode(resolver, 0, NULL, NULL);
+    q->is_refresh = PJ_TRUE;
+
+    if (start_new_query(resolver, q, key) != PJ_SUCCESS)
+	return;
+
+    ++resolver->cache_stat.prefetch;
+
+    PJ_LOG(5,(resolver->name.ptr, "Refreshing cached DNS %s record for %s",
+	      pj_dns_get_type_name(key->qtype), key->name));
+}
+
+
 /*
  * Create and start asynchronous DNS query for a single resource.
  */
@@ -779,14 +848,28 @@ PJ_DEF(pj_status_t) pj_dns_resolver_start_query( pj_dns_resolver *resolver,
     cache = (struct cached_res *) pj_hash_get(resolver->hrescache, &key, 
     					      sizeof(key), &hval);
     if (cache) {
+	pj_bool_t is_valid, is_stale = PJ_FALSE;
+
 	/* We've found a cached entry. */
 
-	/* Check for expiration */
-	if (PJ_TIME_VAL_GT(cache->expiry_time, now)) {
+	/* Check for expiration. A positive entry which has just expired
+	 * may still be used while it is being refreshed in the background.
+	 */
+	is_valid = PJ_TIME_VAL_GT(cache->expiry_time, now);
+	if (!is_valid && cache->pkt->hdr.anscount &&
+	    PJ_DNS_GET_RCODE(cache->pkt->hdr.flags) == 0 &&
+	    now.sec - cache->expiry_time.sec <
+		(long)resolver->settings.cache_stale_ttl)
+	{
+	    is_valid = is_stale = PJ_TRUE;
+	}
+
+	if (is_valid) {
 
 	    /* Log */
 	    PJ_LOG(5,(resolver->name.ptr, 
-		      "Picked up DNS %s record for %.*s from cache, ttl=%d",
+		      "Picked up %sDNS %s record for %.*s from cache, ttl=%d",
+		      (is_stale ? "stale " : ""),
 		      pj_dns_get_type_name(type),
 		      (int)name->slen, name->ptr,
 		      (int)(cache->expiry_time.sec - now.sec)));
@@ -795,6 +878,26 @@ PJ_DEF(pj_status_t) pj_dns_resolver_start_query( pj_dns_resolver *resolver,
 	    status = PJ_DNS_GET_RCODE(cache->pkt->hdr.flags);
 	    status = PJ_STATUS_FROM_DNS_RCODE(status);
 
+	    /* Update statistics, and refresh the entry in the background
+	     * if it has expired, or if it is popular and about to expire.
+	     */
+	    ++cache->hit_cnt;
+	    if (is_stale) {
+		++resolver->cache_stat.stale_hit;
+		refresh_entry(resolver, &key);
+	    } else {
+		++resolver->cache_stat.hit;
+		if (status != PJ_SUCCESS || cache->pkt->hdr.anscount == 0)
+		    ++resolver->cache_stat.neg_hit;
+		else if (cache->ttl && resolver->settings.prefetch_pct &&
+			 cache->hit_cnt >= PJ_DNS_RESOLVER_PREFETCH_MIN_HITS &&
+			 (cache->expiry_time.sec - now.sec) * 100 <
+			     (long)(cache->ttl * resolver->settings.prefetch_pct))
+		{
+		    refresh_entry(resolver, &key);
+		}
+	    }
+
 	    /* Workaround for deadlock problem. Need to increment the cache's
 	     * ref counter first before releasing mutex, so the cache won't be
 	     * destroyed by other thread while in callback.
@@ -838,6 +941,8 @@ PJ_DEF(pj_status_t) pj_dns_resolver_start_query( pj_dns_resolver *resolver,
 	/* Must continue with creating a query now */
     }
 
+    ++resolver->cache_stat.miss;
+
     /* Next, check if we have pending query on the same resource */
     q = (pj_dns_async_query *) pj_hash_get(resolver->hquerybyres, &key, 
     					   sizeof(key), NULL);
@@ -861,25 +966,9 @@ PJ_DEF(pj_status_t) pj_dns_resolver_start_query( pj_dns_resolver *resolver,
     /* There's no pending query to the same key, initiate a new one. */
     q = alloc_qnode(resolver, options, user_data, cb);
 
-    /* Save the ID and key */
-    /* TODO: dnsext-forgery-resilient: randomize id for security */
-    q->id = resolver->last_id++;
-    if (resolver->last_id == 0)
-	resolver->last_id = 1;
-    pj_memcpy(&q->key, &key, sizeof(struct res_key));
-
-    /* Send the query */
-    status = transmit_query(resolver, q);
-    if (status != PJ_SUCCESS) {
-	pj_list_push_back(&resolver->query_free_nodes, q);
+    status = start_new_query(resolver, q, &key);
+    if (status != PJ_SUCCESS)
 	goto on_return;
-    }
-
-    /* Add query entry to the hash tables */
-    pj_hash_set_np(resolver->hquerybyid, &q->id, sizeof(q->id), 
-		   0, q->hbufid, q);
-    pj_hash_set_np(resolver->hquerybyres, &q->key, sizeof(q->key),
-		   0, q->hbufkey, q);
 
     if (p_query)
 	*p_query = q;
@@ -1183,6 +1272,48 @@ static void report_nameserver_status(pj_dns_resolver *resolver,
 }
 
 
+/* Get the TTL of a negative response (NXDOMAIN or NODATA). As specified
+ * by RFC 2308, this is the minimum of the TTL of the SOA record in the
+ * authority section and its MINIMUM field, capped by the configured
+ * maximum negative TTL.
+ */
+static pj_uint32_t get_neg_ttl(pj_dns_resolver *resolver,
+			       pj_status_t status,
+			       const pj_dns_parsed_packet *pkt)
+{
+    pj_uint32_t ttl = resolver->settings.cache_neg_max_ttl;
+    unsigned i;
+
+    if (status != PJ_SUCCESS &&
+	status != PJ_STATUS_FROM_DNS_RCODE(PJ_DNS_RCODE_NXDOMAIN))
+    {
+	return ttl;
+    }
+
+    for (i=0; pkt->ns && i<pkt->hdr.nscount; ++i) {
+	const pj_dns_parsed_rr *rr = &pkt->ns[i];
+	pj_uint32_t minimum;
+
+	/* The MINIMUM field is the last 32bit of the SOA rdata, after
+	 * the MNAME, RNAME, SERIAL, REFRESH, RETRY, and EXPIRE fields.
+	 */
+	if (rr->type != PJ_DNS_TYPE_SOA || !rr->data || rr->rdlength < 22)
+	    continue;
+
+	pj_memcpy(&minimum, (const pj_uint8_t*)rr->data + rr->rdlength - 4, 4);
+	minimum = pj_ntohl(minimum);
+
+	if (rr->ttl < minimum)
+	    minimum = rr->ttl;
+	if (minimum < ttl)
+	    ttl = minimum;
+	break;
+    }
+
+    return ttl;
+}
+
+
 /* Update response cache */
 static void update_res_cache(pj_dns_resolver *resolver,
 			     const struct res_key *key,
@@ -1210,10 +1341,10 @@ static void update_res_cache(pj_dns_resolver *resolver,
     if (set_expiry) {
 	if (pkt->hdr.anscount == 0 || status != PJ_SUCCESS) {
 	    /* If we don't have answers for the name, then give a different
-	     * ttl value (note: PJ_DNS_RESOLVER_INVALID_TTL may be zero, 
+	     * ttl value (note: PJ_DNS_RESOLVER_NEG_MAX_TTL may be zero, 
 	     * which means that invalid names won't be kept in the cache)
 	     */
-	    ttl = PJ_DNS_RESOLVER_INVALID_TTL;
+	    ttl = get_neg_ttl(resolver, status, pkt);
 
 	} else {
 	    /* Otherwise get the minimum TTL from the answers */
@@ -1279,6 +1410,7 @@ static void update_res_cache(pj_dns_resolver *resolver,
     if (set_expiry) {
 	pj_gettimeofday(&cache->expiry_time);
 	cache->expiry_time.sec += ttl;
+	cache->ttl = ttl;
     } else {
 	cache->expiry_time.sec = 0x7FFFFFFFL;
 	cache->expiry_time.msec = 0;
@@ -1505,8 +1637,14 @@ static void on_read_complete(pj_ioqueue_key_t *key,
     /* Workaround for deadlock problem in #1108 */
     pj_mutex_lock(resolver->mutex);
 
-    /* Save/update response cache. */
-    update_res_cache(resolver, &q->key, status, PJ_TRUE, dns_pkt);
+    /* Save/update response cache. A failed background refresh keeps
+     * the existing entry, unless the name is now known not to exist.
+     */
+    if (!q->is_refresh || status == PJ_SUCCESS ||
+	status == PJ_STATUS_FROM_DNS_RCODE(PJ_DNS_RCODE_NXDOMAIN))
+    {
+	update_res_cache(resolver, &q->key, status, PJ_TRUE, dns_pkt);
+    }
     
     /* Recycle query objects, starting with the child queries */
     if (!pj_list_empty(&q->child_head)) {
@@ -1615,6 +1753,22 @@ PJ_DEF(unsigned) pj_dns_resolver_get_cached_count(pj_dns_resolver *resolver)
 }
 
 
+/*
+ * Get the response cache statistics.
+ */
+PJ_DEF(pj_status_t) pj_dns_resolver_get_cache_stat(pj_dns_resolver *resolver,
+						   pj_dns_cache_stat *stat)
+{
+    PJ_ASSERT_RETURN(resolver && stat, PJ_EINVAL);
+
+    pj_mutex_lock(resolver->mutex);
+    pj_memcpy(stat, &resolver->cache_stat, sizeof(*stat));
+    pj_mutex_unlock(resolver->mutex);
+
+    return PJ_SUCCESS;
+}
+
+
 /*
  * Dump resolver state to the log.
  */
@@ -1646,6 +1800,11 @@ PJ_DEF(void) pj_dns_resolver_dump(pj_dns_resolver *resolver,
 
     PJ_LOG(3,(resolver->name.ptr, "  Nb. of cached responses: %u",
 	      pj_hash_count(resolver->hrescache)));
+    PJ_LOG(3,(resolver->name.ptr, "  Cache hit: %u (negative: %u, stale: %u), "
+	      "miss: %u, prefetch: %u",
+	      resolver->cache_stat.hit, resolver->cache_stat.neg_hit,
+	      resolver->cache_stat.stale_hit, resolver->cache_stat.miss,
+	      resolver->cache_stat.prefetch));
     if (detail) {
 	pj_hash_iterator_t itbuf, *it;
 	it = pj_hash_first(resolver->hrescache, &itbuf);
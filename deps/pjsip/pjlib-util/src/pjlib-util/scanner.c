@@ -37,6 +37,27 @@
 #  include "scanner_cis_uint.c"
 #endif
 
+#if defined(PJ_SCANNER_USE_SIMD) && PJ_SCANNER_USE_SIMD != 0 && \
+    (!defined(PJ_SCANNER_USE_BITWISE) || PJ_SCANNER_USE_BITWISE == 0) && \
+    defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     (defined(__aarch64__) && defined(__ARM_NEON)))
+#  include "scanner_simd.c"
+#  define CIS_UPDATE(cis)		cis_update_simd(cis)
+#  define SCAN_SKIP_MATCH(spec,s,end)	do { \
+					    if ((spec)->simd_ok) \
+						s = simd_skip_match(spec,s,end); \
+					} while (0)
+#  define SCAN_SKIP_NOMATCH(spec,s,end) do { \
+					    if ((spec)->simd_ok) \
+						s = simd_skip_nomatch(spec,s,end); \
+					} while (0)
+#else
+#  define CIS_UPDATE(cis)
+#  define SCAN_SKIP_MATCH(spec,s,end)
+#  define SCAN_SKIP_NOMATCH(spec,s,end)
+#endif
+
 
 static void pj_scan_syntax_err(pj_scanner *scanner)
 {
@@ -53,6 +74,7 @@ PJ_DEF(void) pj_cis_add_range(pj_cis_t *cis, int cstart, int cend)
         PJ_CIS_SET(cis, cstart);
 	++cstart;
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_cis_add_alpha(pj_cis_t *cis)
@@ -72,6 +94,7 @@ PJ_DEF(void) pj_cis_add_str( pj_cis_t *cis, const char *str)
         PJ_CIS_SET(cis, *str);
 	++str;
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_cis_add_cis( pj_cis_t *cis, const pj_cis_t *rhs)
@@ -81,6 +104,7 @@ PJ_DEF(void) pj_cis_add_cis( pj_cis_t *cis, const pj_cis_t *rhs)
 	if (PJ_CIS_ISSET(rhs, i))
 	    PJ_CIS_SET(cis, i);
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_cis_del_range( pj_cis_t *cis, int cstart, int cend)
@@ -89,6 +113,7 @@ PJ_DEF(void) pj_cis_del_range( pj_cis_t *cis, int cstart, int cend)
         PJ_CIS_CLR(cis, cstart);
         cstart++;
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_cis_del_str( pj_cis_t *cis, const char *str)
@@ -97,6 +122,7 @@ PJ_DEF(void) pj_cis_del_str( pj_cis_t *cis, const char *str)
         PJ_CIS_CLR(cis, *str);
 	++str;
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_cis_invert( pj_cis_t *cis )
@@ -109,6 +135,7 @@ PJ_DEF(void) pj_cis_invert( pj_cis_t *cis )
         else
             PJ_CIS_SET(cis,i);
     }
+    CIS_UPDATE(cis);
 }
 
 PJ_DEF(void) pj_scan_init( pj_scanner *scanner, char *bufstart, 
@@ -212,6 +239,7 @@ PJ_DEF(int) pj_scan_peek( pj_scanner *scanner,
     }
 
     /* Don't need to check EOF with PJ_SCAN_CHECK_EOF(s) */
+    SCAN_SKIP_MATCH(spec, s, scanner->end);
     while (pj_cis_match(spec, *s))
 	++s;
 
@@ -246,6 +274,7 @@ PJ_DEF(int) pj_scan_peek_until( pj_scanner *scanner,
 	return -1;
     }
 
+    SCAN_SKIP_NOMATCH(spec, s, scanner->end);
     while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match( spec, *s))
 	++s;
 
@@ -267,9 +296,10 @@ PJ_DEF(void) pj_scan_get( pj_scanner *scanner,
 	return;
     }
 
-    do {
+    ++s;
+    SCAN_SKIP_MATCH(spec, s, scanner->end);
+    while (pj_cis_match(spec, *s))
 	++s;
-    } while (pj_cis_match(spec, *s));
     /* No need to check EOF here (PJ_SCAN_CHECK_EOF(s)) because
      * buffer is NULL terminated and pj_cis_match(spec,0) should be
      * false.
@@ -320,10 +350,11 @@ PJ_DEF(void) pj_scan_get_unescape( pj_scanner *scanner,
 	}
 	
 	if (pj_cis_match(spec, *s)) {
-	    char *start = s;
-	    do {
+	    char *start = s++;
+
+	    SCAN_SKIP_MATCH(spec, s, scanner->end);
+	    while (pj_cis_match(spec, *s))
 		++s;
-	    } while (pj_cis_match(spec, *s));
 
 	    if (dst != start) pj_memmove(dst, start, s-start);
 	    dst += (s-start);
@@ -504,6 +535,7 @@ PJ_DEF(void) pj_scan_get_until( pj_scanner *scanner,
 	return;
     }
 
+    SCAN_SKIP_NOMATCH(spec, s, scanner->end);
     while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match(spec, *s)) {
 	++s;
     }
@@ -528,9 +560,9 @@ PJ_DEF(void) pj_scan_get_until_ch( pj_scanner *scanner,
 	return;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && *s != until_char) {
-	++s;
-    }
+    s = (char*) memchr(s, until_char, scanner->end - s);
+    if (!s)
+	s = scanner->end;
 
     pj_strset3(out, scanner->curptr, s);
 
@@ -33,7 +33,9 @@ PJ_DEF(void) pj_cis_buf_init( pj_cis_buf_t *cis_buf)
 PJ_DEF(pj_status_t) pj_cis_init(pj_cis_buf_t *cis_buf, pj_cis_t *cis)
 {
     PJ_UNUSED_ARG(cis_buf);
-    pj_bzero(cis->cis_buf, sizeof(cis->cis_buf));
+    pj_bzero(cis, sizeof(*cis));
+    /* All zero nibble tables describe the empty specification */
+    cis->simd_ok = 1;
     return PJ_SUCCESS;
 }
 
@@ -0,0 +1,219 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY scanner.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * Vectorized character classification. Each character is split into its
+ * low and high nibble, and each nibble is looked up in a 16 entry table
+ * with a byte shuffle instruction. The specification is partitioned into
+ * at most 8 classes, one per bit, so that a character is a member when
+ * the lookups of both of its nibbles have a common bit. Specifications
+ * which cannot be partitioned this way (more than 8 distinct high nibble
+ * columns) are scanned with the scalar loop.
+ */
+
+/* Rebuild the nibble tables after the specification has been modified. */
+static void cis_update_simd(pj_cis_t *cis)
+{
+    pj_uint16_t classes[8];
+    unsigned h, l, i, cnt = 0;
+
+    pj_bzero(cis->simd_lo, sizeof(cis->simd_lo));
+    pj_bzero(cis->simd_hi, sizeof(cis->simd_hi));
+    cis->simd_ok = 0;
+
+    for (h=0; h<16; ++h) {
+	pj_uint16_t column = 0;
+
+	for (l=0; l<16; ++l) {
+	    if (PJ_CIS_ISSET(cis, (h << 4) | l))
+		column |= (pj_uint16_t)(1 << l);
+	}
+	if (column == 0)
+	    continue;
+
+	for (i=0; i<cnt && classes[i] != column; ++i)
+	    ;
+	if (i == cnt) {
+	    if (cnt == PJ_ARRAY_SIZE(classes))
+		return;
+	    classes[cnt++] = column;
+	}
+	cis->simd_hi[h] |= (pj_uint8_t)(1 << i);
+    }
+
+    for (i=0; i<cnt; ++i) {
+	for (l=0; l<16; ++l) {
+	    if (classes[i] & (1 << l))
+		cis->simd_lo[l] |= (pj_uint8_t)(1 << i);
+	}
+    }
+
+    cis->simd_ok = 1;
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/* The SSSE3 and AVX2 versions are compiled in with function attributes,
+ * and selected at run time.
+ */
+#define SIMD_SSSE3	__attribute__((target("ssse3")))
+#define SIMD_AVX2	__attribute__((target("avx2")))
+
+/* Get the mask of characters in the block which are not members of the
+ * specification, one bit per character.
+ */
+SIMD_SSSE3
+static pj_uint32_t nonmatch_ssse3(__m128i tbl_lo, __m128i tbl_hi,
+				  const char *s)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i v = _mm_loadu_si128((const __m128i*)s);
+    __m128i lo = _mm_shuffle_epi8(tbl_lo, _mm_and_si128(v, nibble));
+    __m128i hi = _mm_shuffle_epi8(tbl_hi,
+				  _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+    __m128i m = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    return (pj_uint32_t)_mm_movemask_epi8(m);
+}
+
+SIMD_AVX2
+static pj_uint32_t nonmatch_avx2(__m256i tbl_lo, __m256i tbl_hi,
+				 const char *s)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i v = _mm256_loadu_si256((const __m256i*)s);
+    __m256i lo = _mm256_shuffle_epi8(tbl_lo, _mm256_and_si256(v, nibble));
+    __m256i hi = _mm256_shuffle_epi8(tbl_hi,
+			_mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i m = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi),
+				  _mm256_setzero_si256());
+    return (pj_uint32_t)_mm256_movemask_epi8(m);
+}
+
+/* Skip the characters which are members of the specification (or not,
+ * when nomatch is set), as long as whole blocks are available before the
+ * end of the buffer. The caller continues with the scalar loop from the
+ * returned position.
+ */
+SIMD_SSSE3
+static char *skip_ssse3(const pj_cis_t *cis, char *s, const char *end,
+			pj_uint32_t nomatch)
+{
+    const __m128i tbl_lo = _mm_loadu_si128((const __m128i*)cis->simd_lo);
+    const __m128i tbl_hi = _mm_loadu_si128((const __m128i*)cis->simd_hi);
+
+    while (end - s >= 16) {
+	pj_uint32_t mask = (nonmatch_ssse3(tbl_lo, tbl_hi, s) ^ nomatch) &
+			   0xFFFF;
+	if (mask)
+	    return s + __builtin_ctz(mask);
+	s += 16;
+    }
+    return s;
+}
+
+SIMD_AVX2
+static char *skip_avx2(const pj_cis_t *cis, char *s, const char *end,
+		       pj_uint32_t nomatch)
+{
+    const __m256i tbl_lo = _mm256_broadcastsi128_si256(
+			    _mm_loadu_si128((const __m128i*)cis->simd_lo));
+    const __m256i tbl_hi = _mm256_broadcastsi128_si256(
+			    _mm_loadu_si128((const __m128i*)cis->simd_hi));
+
+    while (end - s >= 32) {
+	pj_uint32_t mask = nonmatch_avx2(tbl_lo, tbl_hi, s) ^ nomatch;
+	if (mask)
+	    return s + __builtin_ctz(mask);
+	s += 32;
+    }
+    return s;
+}
+
+/* The result is cached, concurrent first calls merely repeat the check.
+ * __builtin_cpu_supports() also checks that the OS saves the AVX state.
+ */
+static int simd_level(void)
+{
+    static int level = -1;
+
+    if (level < 0) {
+	__builtin_cpu_init();
+	level = __builtin_cpu_supports("avx2") ? 2 :
+		__builtin_cpu_supports("ssse3") ? 1 : 0;
+    }
+    return level;
+}
+
+static char *simd_skip(const pj_cis_t *cis, char *s, const char *end,
+		       pj_uint32_t nomatch)
+{
+    switch (simd_level()) {
+    case 2:
+	return skip_avx2(cis, s, end, nomatch);
+    case 1:
+	return skip_ssse3(cis, s, end, nomatch);
+    default:
+	return s;
+    }
+}
+
+#else	/* NEON */
+
+#include <arm_neon.h>
+
+/* Skip the characters which are members of the specification (or not,
+ * when nomatch is set), as long as whole blocks are available before the
+ * end of the buffer. The caller continues with the scalar loop from the
+ * returned position.
+ */
+static char *simd_skip(const pj_cis_t *cis, char *s, const char *end,
+		       pj_uint32_t nomatch)
+{
+    const uint8x16_t tbl_lo = vld1q_u8(cis->simd_lo);
+    const uint8x16_t tbl_hi = vld1q_u8(cis->simd_hi);
+    const pj_uint64_t invert = nomatch ? ~(pj_uint64_t)0 : 0;
+
+    while (end - s >= 16) {
+	uint8x16_t v = vld1q_u8((const pj_uint8_t*)s);
+	uint8x16_t lo = vqtbl1q_u8(tbl_lo, vandq_u8(v, vdupq_n_u8(0x0F)));
+	uint8x16_t hi = vqtbl1q_u8(tbl_hi, vshrq_n_u8(v, 4));
+	uint8x16_t m = vceqq_u8(vandq_u8(lo, hi), vdupq_n_u8(0));
+	pj_uint64_t mask;
+
+	/* Narrow each 8bit lane to 4bit, as NEON has no movemask */
+	mask = vget_lane_u64(vreinterpret_u64_u8(
+		    vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0) ^ invert;
+	if (mask)
+	    return s + __builtin_ctzll(mask) / 4;
+	s += 16;
+    }
+    return s;
+}
+
+#endif
+
+#define simd_skip_match(cis,s,end)	simd_skip(cis, s, end, 0)
+#define simd_skip_nomatch(cis,s,end)	simd_skip(cis, s, end, 0xFFFFFFFF)
@@ -100,10 +100,22 @@ A million repetitions of "a"
 #include "sha1.h"
 */
 #include <pjlib-util/sha1.h>
+#include <pjlib-util/config.h>
 #include <pj/string.h>
 
 #undef SHA1HANDSOFF
 
+#if defined(PJ_SHA1_USE_SIMD) && PJ_SHA1_USE_SIMD != 0 && \
+    defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__) || \
+     (defined(__aarch64__) && \
+      (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))))
+#   define SHA1_HAS_SIMD    1
+#   include "sha1_simd.c"
+#else
+#   define SHA1_HAS_SIMD    0
+#endif
+
 
 static void SHA1_Transform(pj_uint32_t state[5], pj_uint8_t buffer[64]);
 
@@ -189,6 +201,26 @@ static void SHA1_Transform(pj_uint32_t state[5], pj_uint8_t buffer[64])
 }
 
 
+/* Hash consecutive 512-bit blocks of the input. */
+static void SHA1_Blocks(pj_uint32_t state[5], const pj_uint8_t *data,
+			pj_size_t nblocks)
+{
+#if SHA1_HAS_SIMD
+    if (sha1_simd_available()) {
+	sha1_simd_transform(state, data, nblocks);
+	return;
+    }
+#endif
+
+    /* SHA1_Transform() works on the block in place */
+    for ( ; nblocks; --nblocks, data += 64) {
+	pj_uint8_t tmp[64];
+	pj_memcpy(tmp, data, 64);
+	SHA1_Transform(state, tmp);
+    }
+}
+
+
 /* SHA1Init - Initialize new context */
 PJ_DEF(void) pj_sha1_init(pj_sha1_context* context)
 {
@@ -214,12 +246,9 @@ PJ_DEF(void) pj_sha1_update(pj_sha1_context* context,
     context->count[1] += ((pj_uint32_t)len >> 29);
     if ((j + len) > 63) {
         pj_memcpy(&context->buffer[j], data, (i = 64-j));
-        SHA1_Transform(context->state, context->buffer);
-        for ( ; i + 63 < len; i += 64) {
-	    pj_uint8_t tmp[64];
-	    pj_memcpy(tmp, data + i, 64);
-            SHA1_Transform(context->state, tmp);
-        }
+        SHA1_Blocks(context->state, context->buffer, 1);
+        SHA1_Blocks(context->state, data + i, (len - i) / 64);
+        i += (len - i) & ~(pj_size_t)63;
         j = 0;
     }
     else i = 0;
@@ -234,15 +263,19 @@ PJ_DEF(void) pj_sha1_final(pj_sha1_context* context,
 {
     pj_uint32_t i;
     pj_uint8_t  finalcount[8];
+    pj_uint8_t  padding[64];
+    pj_uint32_t used;
 
     for (i = 0; i < 8; i++) {
         finalcount[i] = (unsigned char)((context->count[(i >= 4 ? 0 : 1)]
          >> ((3-(i & 3)) * 8) ) & 255);  /* Endian independent */
     }
-    pj_sha1_update(context, (pj_uint8_t *)"\200", 1);
-    while ((context->count[0] & 504) != 448) {
-        pj_sha1_update(context, (pj_uint8_t *)"\0", 1);
-    }
+
+    /* Pad with 0x80 and zeroes up to 56 bytes modulo 64, in one go */
+    used = (context->count[0] >> 3) & 63;
+    pj_bzero(padding, sizeof(padding));
+    padding[0] = 0x80;
+    pj_sha1_update(context, padding, (used < 56) ? 56 - used : 120 - used);
     pj_sha1_update(context, finalcount, 8);  /* Should cause a SHA1_Transform() */
     for (i = 0; i < PJ_SHA1_DIGEST_SIZE; i++) {
         digest[i] = (pj_uint8_t)
@@ -0,0 +1,189 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY sha1.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * SHA1 block transform with the SHA instructions of x86 (SHA-NI) or ARMv8.
+ * Each group of four rounds takes its message words from one of four
+ * vector registers, and the message schedule for group i+4 is computed
+ * from the registers while groups i..i+3 are being hashed. The x86 version
+ * is compiled with function attributes and selected at run time, the ARM
+ * version is used when the compiler targets the crypto extensions.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA1_SIMD_TARGET    __attribute__((target("sha,ssse3,sse4.1")))
+
+/* Rounds 4i..4i+3. e[i&1] holds E plus the message words of the group,
+ * e[(i+1)&1] receives the state the E of the next group is derived from.
+ */
+#define SHA1_ROUNDS4(i)							\
+    do {								\
+	if (i < 4) {							\
+	    msg[i&3] = _mm_shuffle_epi8(				\
+			_mm_loadu_si128((const __m128i*)(data+i*16)),	\
+			bswap);						\
+	}								\
+	if (i == 0)							\
+	    e[0] = _mm_add_epi32(e[0], msg[0]);				\
+	else								\
+	    e[i&1] = _mm_sha1nexte_epu32(e[i&1], msg[i&3]);		\
+	e[(i+1)&1] = abcd;						\
+	if (i >= 3 && i <= 18)						\
+	    msg[(i+1)&3] = _mm_sha1msg2_epu32(msg[(i+1)&3], msg[i&3]);	\
+	abcd = _mm_sha1rnds4_epu32(abcd, e[i&1], i/5);			\
+	if (i >= 1 && i <= 16)						\
+	    msg[(i+3)&3] = _mm_sha1msg1_epu32(msg[(i+3)&3], msg[i&3]);	\
+	if (i >= 2 && i <= 17)						\
+	    msg[(i+2)&3] = _mm_xor_si128(msg[(i+2)&3], msg[i&3]);	\
+    } while (0)
+
+SHA1_SIMD_TARGET
+static void sha1_simd_transform(pj_uint32_t state[5],
+				const pj_uint8_t *data, pj_size_t nblocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL,
+					 0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_save, e_save, e[2], msg[4];
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    e[0] = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    for (; nblocks; --nblocks, data += 64) {
+	abcd_save = abcd;
+	e_save = e[0];
+
+	SHA1_ROUNDS4(0);  SHA1_ROUNDS4(1);  SHA1_ROUNDS4(2);
+	SHA1_ROUNDS4(3);  SHA1_ROUNDS4(4);  SHA1_ROUNDS4(5);
+	SHA1_ROUNDS4(6);  SHA1_ROUNDS4(7);  SHA1_ROUNDS4(8);
+	SHA1_ROUNDS4(9);  SHA1_ROUNDS4(10); SHA1_ROUNDS4(11);
+	SHA1_ROUNDS4(12); SHA1_ROUNDS4(13); SHA1_ROUNDS4(14);
+	SHA1_ROUNDS4(15); SHA1_ROUNDS4(16); SHA1_ROUNDS4(17);
+	SHA1_ROUNDS4(18); SHA1_ROUNDS4(19);
+
+	e[0] = _mm_sha1nexte_epu32(e[0], e_save);
+	abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (pj_uint32_t)_mm_extract_epi32(e[0], 3);
+}
+
+#undef SHA1_ROUNDS4
+
+/* Check for the SHA extensions and the SSSE3/SSE4.1 instructions used
+ * alongside them. The result is cached, concurrent first calls merely
+ * repeat the check.
+ */
+static int sha1_simd_available(void)
+{
+    static int available = -1;
+
+    if (available < 0) {
+	unsigned eax, ebx, ecx, edx;
+	int ok = 0;
+
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+	    (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) &&
+	    __get_cpuid_max(0, NULL) >= 7)
+	{
+	    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+	    ok = (ebx & (1 << 29)) != 0;
+	}
+	available = ok;
+    }
+    return available;
+}
+
+#else	/* ARMv8 */
+
+#include <arm_neon.h>
+
+/* Rounds 4i..4i+3, tmp[i&1] holds the message words of the group with
+ * the round constant added.
+ */
+#define SHA1_ROUNDS4(i, op)						\
+    do {								\
+	e[(i+1)&1] = vsha1h_u32(vgetq_lane_u32(abcd, 0));		\
+	abcd = op(abcd, e[i&1], tmp[i&1]);				\
+	if (i <= 17)							\
+	    tmp[i&1] = vaddq_u32(msg[(i+2)&3], k[((i+2)/5)&3]);	\
+	if (i >= 1 && i <= 16)						\
+	    msg[(i+3)&3] = vsha1su1q_u32(msg[(i+3)&3], msg[(i+2)&3]);	\
+	if (i <= 15)							\
+	    msg[i&3] = vsha1su0q_u32(msg[i&3], msg[(i+1)&3],		\
+				     msg[(i+2)&3]);			\
+    } while (0)
+
+static void sha1_simd_transform(pj_uint32_t state[5],
+				const pj_uint8_t *data, pj_size_t nblocks)
+{
+    uint32x4_t k[4], abcd, abcd_save, msg[4], tmp[2];
+    uint32_t e[2], e_save;
+    unsigned i;
+
+    k[0] = vdupq_n_u32(0x5A827999);
+    k[1] = vdupq_n_u32(0x6ED9EBA1);
+    k[2] = vdupq_n_u32(0x8F1BBCDC);
+    k[3] = vdupq_n_u32(0xCA62C1D6);
+
+    abcd = vld1q_u32(state);
+    e[0] = state[4];
+
+    for (; nblocks; --nblocks, data += 64) {
+	abcd_save = abcd;
+	e_save = e[0];
+
+	for (i=0; i<4; ++i) {
+	    msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data+i*16)));
+	}
+	tmp[0] = vaddq_u32(msg[0], k[0]);
+	tmp[1] = vaddq_u32(msg[1], k[0]);
+
+	SHA1_ROUNDS4(0, vsha1cq_u32);  SHA1_ROUNDS4(1, vsha1cq_u32);
+	SHA1_ROUNDS4(2, vsha1cq_u32);  SHA1_ROUNDS4(3, vsha1cq_u32);
+	SHA1_ROUNDS4(4, vsha1cq_u32);  SHA1_ROUNDS4(5, vsha1pq_u32);
+	SHA1_ROUNDS4(6, vsha1pq_u32);  SHA1_ROUNDS4(7, vsha1pq_u32);
+	SHA1_ROUNDS4(8, vsha1pq_u32);  SHA1_ROUNDS4(9, vsha1pq_u32);
+	SHA1_ROUNDS4(10, vsha1mq_u32); SHA1_ROUNDS4(11, vsha1mq_u32);
+	SHA1_ROUNDS4(12, vsha1mq_u32); SHA1_ROUNDS4(13, vsha1mq_u32);
+	SHA1_ROUNDS4(14, vsha1mq_u32); SHA1_ROUNDS4(15, vsha1pq_u32);
+	SHA1_ROUNDS4(16, vsha1pq_u32); SHA1_ROUNDS4(17, vsha1pq_u32);
+	SHA1_ROUNDS4(18, vsha1pq_u32); SHA1_ROUNDS4(19, vsha1pq_u32);
+
+	e[0] += e_save;
+	abcd = vaddq_u32(abcd, abcd_save);
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e[0];
+}
+
+#undef SHA1_ROUNDS4
+
+#define sha1_simd_available()	1
+
+#endif
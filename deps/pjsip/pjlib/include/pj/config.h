@@ -413,6 +413,28 @@
 #  define PJ_LOG_USE_STACK_BUFFER   1
 #endif
 
+/**
+ * Enable support for writing log messages from a background thread,
+ * see pj_log_start_async(). This requires thread support and a GCC
+ * compatible compiler for the atomic builtins.
+ *
+ * Default: 1
+ */
+#ifndef PJ_LOG_HAS_ASYNC
+#  define PJ_LOG_HAS_ASYNC	    1
+#endif
+
+/**
+ * Default number of messages that can be queued for the log writer thread
+ * when pj_log_start_async() is called with zero max_msg. Each message
+ * takes PJ_LOG_MAX_SIZE bytes.
+ *
+ * Default: 64
+ */
+#ifndef PJ_LOG_ASYNC_MAX_MSG
+#  define PJ_LOG_ASYNC_MAX_MSG	    64
+#endif
+
 /**
  * Enable log indentation feature.
  *
@@ -480,6 +502,27 @@
 #endif
 
 
+/**
+ * Maximum number of released pools of each size which are kept by each
+ * thread in its own cache in the caching pool, to be reused by the pools
+ * created by that thread without taking the caching pool lock. When a
+ * thread cache holds more than this, half of the pools are given back to
+ * the caching pool (or destroyed when this exceeds its maximum capacity),
+ * and when it runs out of pools, it is refilled with up to half of this
+ * from the caching pool. The pools kept by the threads are counted in the
+ * maximum capacity of the caching pool, and the caches of threads which
+ * have been idle since the previous rebalance of any thread are emptied,
+ * so that the pools of exited threads are reclaimed. Per-thread caches
+ * are not used when the maximum capacity of the caching pool is zero.
+ * Set to zero to disable.
+ *
+ * Default: 8
+ */
+#ifndef PJ_CACHING_POOL_THREAD_CACHE
+#  define PJ_CACHING_POOL_THREAD_CACHE	    8
+#endif
+
+
 /**
  * Enable timer heap debugging facility. When this is enabled, application
  * can call pj_timer_heap_dump() to show the contents of the timer heap
@@ -36,7 +36,8 @@ PJ_BEGIN_DECL
  * A hash table is a dictionary in which keys are mapped to array positions by
  * hash functions. Having the keys of more than one item map to the same 
  * position is called a collision. In this library, we will chain the nodes
- * that have the same key in a list.
+ * that have the same key in a list, unless the table is created with
+ * #PJ_HASH_OPEN_ADDRESSING, which stores the entries in a flat array.
  */
 
 /**
@@ -96,6 +97,45 @@ PJ_DECL(pj_uint32_t) pj_hash_calc_tolower(pj_uint32_t hval,
 PJ_DECL(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size);
 
 
+/**
+ * Hash table options, to be specified in #pj_hash_create2().
+ */
+typedef enum pj_hash_option
+{
+    /**
+     * Store the entries in a flat array with open addressing instead of
+     * chaining pool allocated nodes. The array keeps a control byte with
+     * a part of the hash value for each entry, so that a lookup usually
+     * compares the key of the matching entry only, and it grows as entries
+     * are added. The arrays are allocated from the pool given to
+     * #pj_hash_create2(), which hence must remain valid and must only be
+     * used while the table is locked by its user. Memory of the previous
+     * array is not returned to the pool when the table grows.
+     *
+     * The pool and entry_buf arguments of the set functions are only used
+     * to copy the key, and entry_buf is not used at all. Deleting the
+     * current entry while iterating the table is allowed, adding entries
+     * is not.
+     */
+    PJ_HASH_OPEN_ADDRESSING = 1
+
+} pj_hash_option;
+
+
+/**
+ * Create a hash table with the specified options.
+ *
+ * @param pool	    the pool from which the hash table will be allocated from.
+ * @param size	    the bucket size, or with #PJ_HASH_OPEN_ADDRESSING, the
+ *		    number of entries the table can hold before it grows.
+ * @param options   bitmask of #pj_hash_option.
+ *
+ * @return the hash table.
+ */
+PJ_DECL(pj_hash_table_t*) pj_hash_create2(pj_pool_t *pool, unsigned size,
+					  unsigned options);
+
+
 /**
  * Get the value associated with the specified key.
  *
@@ -241,6 +241,34 @@ PJ_DECL(void) pj_log_set_color(int level, pj_color_t color);
  */
 PJ_DECL(pj_color_t) pj_log_get_color(int level);
 
+/**
+ * Write log messages from a background thread. After this call, the
+ * logging functions only format the message into a queue, and the log
+ * output function set with pj_log_set_log_func() is called by the log
+ * writer thread. Messages are written in the order they were queued.
+ * When the queue is full, the message is dropped instead of blocking the
+ * caller, and the number of dropped messages is reported in the log.
+ * Messages logged by the log output function itself are written directly.
+ *
+ * This is only supported when PJ_LOG_HAS_ASYNC is enabled.
+ *
+ * @param pool	    Pool to allocate the queue and the writer thread.
+ * @param max_msg   Maximum number of queued messages, rounded up to power
+ *		    of two, or zero to use PJ_LOG_ASYNC_MAX_MSG.
+ *
+ * @return	    PJ_SUCCESS on success, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_log_start_async(pj_pool_t *pool, unsigned max_msg);
+
+/**
+ * Write the queued log messages, stop the log writer thread and return to
+ * writing log messages from the calling thread. Other threads may keep
+ * logging, this waits for the messages being queued by them. Application
+ * should call this before the pool given to pj_log_start_async() is
+ * released.
+ */
+PJ_DECL(void) pj_log_stop_async(void);
+
 /**
  * Internal function to be called by pj_init()
  */
@@ -343,6 +371,19 @@ pj_status_t pj_log_init(void);
 #  define pj_log_get_color(level) 0
 
 
+/**
+ * Write log messages from a background thread.
+ *
+ * @param pool	    Pool to allocate the queue and the writer thread.
+ * @param max_msg   Maximum number of queued messages.
+ */
+#  define pj_log_start_async(pool, max_msg)	PJ_SUCCESS
+
+/**
+ * Stop the log writer thread.
+ */
+#  define pj_log_stop_async()
+
 /**
  * Internal.
  */
@@ -790,6 +790,10 @@ PJ_INLINE(void) pj_pool_factory_dump( pj_pool_factory *pf,
  * limit, the factory will keep the pool in the internal cache, otherwise the
  * pool will be destroyed, thus releasing the memory back to the system.
  *
+ * To reduce the contention on the factory lock, each thread also keeps a
+ * few released pools of each size in its own cache, which are reused by
+ * the pools it creates (see #PJ_CACHING_POOL_THREAD_CACHE).
+ *
  * @{
  */
 
@@ -814,7 +818,8 @@ struct pj_caching_pool
      *  and available for application in this factory. The factory's
      *  capacity represents the size of all pools kept by this factory
      *  in it's free list, which will be returned to application when it
-     *  requests to create a new pool.
+     *  requests to create a new pool. The pools kept in the per-thread
+     *  caches are not included, #pj_pool_factory_dump() reports the total.
      */
     pj_size_t	    capacity;
 
@@ -822,13 +827,22 @@ struct pj_caching_pool
      *  has exceeded @a max_capacity, further #pj_pool_release() will
      *  flush the pool. If the capacity is still below the @a max_capacity,
      *  #pj_pool_release() will save the pool to the factory's free list.
+     *  The capacity reserved by the per-thread caches is counted too.
      */
     pj_size_t       max_capacity;
 
+    /** Capacity reserved by the per-thread caches for the pools they
+     *  keep, which is counted together with @a capacity against
+     *  @a max_capacity.
+     */
+    pj_size_t	    thread_capacity;
+
     /**
      * Number of pools currently held by applications. This number gets
      * incremented everytime #pj_pool_create() is called, and gets
-     * decremented when #pj_pool_release() is called.
+     * decremented when #pj_pool_release() is called. The pools created
+     * through the per-thread caches are not included,
+     * #pj_pool_factory_dump() reports the total.
      */
     pj_size_t       used_count;
 
@@ -862,6 +876,17 @@ struct pj_caching_pool
      * Mutex.
      */
     pj_lock_t	   *lock;
+
+    /**
+     * Thread local storage index of the per-thread caches, or -1 if
+     * per-thread caches are not used. See #PJ_CACHING_POOL_THREAD_CACHE.
+     */
+    long	    tls_id;
+
+    /**
+     * List of per-thread caches.
+     */
+    pj_list	    thread_caches;
 };
 
 
@@ -875,7 +900,9 @@ struct pj_caching_pool
  *			the pool is returned to the cache, it will be kept in
  *			recycling list if the total capacity of pools in this
  *			list plus the capacity of the pool is still below this
- *			value.
+ *			value. When zero, no pool is kept and the per-thread
+ *			caches are not used (see
+ *			#PJ_CACHING_POOL_THREAD_CACHE).
  */
 PJ_DECL(void) pj_caching_pool_init( pj_caching_pool *ch_pool, 
 				    const pj_pool_factory_policy *policy,
@@ -297,6 +297,12 @@ extern const pj_uint16_t PJ_TCP_NODELAY;
  *  @see pj_SO_REUSEADDR */
 extern const pj_uint16_t PJ_SO_REUSEADDR;
 
+/** Allows several sockets to be bound to the same address and port, with
+ *  the incoming traffic distributed among them by the kernel. The value
+ *  is 0xFFFF when not supported by the platform.
+ *  @see pj_SO_REUSEPORT */
+extern const pj_uint16_t PJ_SO_REUSEPORT;
+
 /** Do not generate SIGPIPE. @see pj_SO_NOSIGPIPE */
 extern const pj_uint16_t PJ_SO_NOSIGPIPE;
 
@@ -336,6 +342,9 @@ extern const pj_uint16_t PJ_IP_DROP_MEMBERSHIP;
     /** Get #PJ_SO_REUSEADDR constant */
     PJ_DECL(pj_uint16_t) pj_SO_REUSEADDR(void);
 
+    /** Get #PJ_SO_REUSEPORT constant */
+    PJ_DECL(pj_uint16_t) pj_SO_REUSEPORT(void);
+
     /** Get #PJ_SO_NOSIGPIPE constant */
     PJ_DECL(pj_uint16_t) pj_SO_NOSIGPIPE(void);
 
@@ -372,6 +381,9 @@ extern const pj_uint16_t PJ_IP_DROP_MEMBERSHIP;
     /** Get #PJ_SO_REUSEADDR constant */
 #   define pj_SO_REUSEADDR() PJ_SO_REUSEADDR
 
+    /** Get #PJ_SO_REUSEPORT constant */
+#   define pj_SO_REUSEPORT() PJ_SO_REUSEPORT
+
     /** Get #PJ_SO_NOSIGPIPE constant */
 #   define pj_SO_NOSIGPIPE() PJ_SO_NOSIGPIPE
 
@@ -30,6 +30,19 @@
  */
 #define PJ_HASH_MULTIPLIER	33
 
+/*
+ * Open addressing. Each slot has a control byte telling whether it is
+ * empty, deleted (a tombstone, which lookups must probe past), or holds
+ * an entry, in which case it has the low 7 bits of the mixed hash value.
+ * Slots are probed linearly from the position given by the top bits of
+ * the mixed hash value, the table grows before it is 3/4 full.
+ */
+#define HASH_CTRL_EMPTY		0x80
+#define HASH_CTRL_DELETED	0xFE
+#define HASH_CTRL_PENDING	0xFD	/* Only used by oa_rehash()	*/
+#define HASH_MIX		0x9E3779B1
+#define HASH_MIN_SLOTS		16
+
 
 struct pj_hash_entry
 {
@@ -40,12 +53,29 @@ struct pj_hash_entry
     void *value;
 };
 
+typedef struct hash_slot
+{
+    pj_uint32_t		hash;
+    pj_uint32_t		keylen;
+    const void	       *key;
+    void	       *value;
+} hash_slot;
+
 
 struct pj_hash_table_t
 {
     pj_hash_entry     **table;
     unsigned		count, rows;
     pj_hash_iterator_t	iterator;
+
+    /* With PJ_HASH_OPEN_ADDRESSING, table is NULL and rows is the
+     * number of slots minus one.
+     */
+    pj_pool_t	       *pool;
+    pj_uint8_t	       *ctrl;
+    hash_slot	       *slots;
+    unsigned		shift;
+    unsigned		deleted;
 };
 
 
@@ -101,7 +131,30 @@ PJ_DEF(pj_uint32_t) pj_hash_calc_tolower( pj_uint32_t hval,
 }
 
 
+/* Allocate the slot arrays of open addressing table, slot_cnt is 2^n */
+static void oa_alloc_slots(pj_hash_table_t *ht, unsigned slot_cnt)
+{
+    unsigned shift = 32;
+
+    while ((1U << (32 - shift)) < slot_cnt)
+	--shift;
+
+    ht->ctrl = (pj_uint8_t*) pj_pool_alloc(ht->pool, slot_cnt);
+    pj_memset(ht->ctrl, HASH_CTRL_EMPTY, slot_cnt);
+    ht->slots = (hash_slot*) pj_pool_alloc(ht->pool,
+					   slot_cnt * sizeof(hash_slot));
+    ht->rows = slot_cnt - 1;
+    ht->shift = shift;
+    ht->deleted = 0;
+}
+
 PJ_DEF(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size)
+{
+    return pj_hash_create2(pool, size, 0);
+}
+
+PJ_DEF(pj_hash_table_t*) pj_hash_create2(pj_pool_t *pool, unsigned size,
+					 unsigned options)
 {
     pj_hash_table_t *h;
     unsigned table_size;
@@ -109,11 +162,22 @@ PJ_DEF(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size)
     /* Check that PJ_HASH_ENTRY_BUF_SIZE is correct. */
     PJ_ASSERT_RETURN(sizeof(pj_hash_entry)<=PJ_HASH_ENTRY_BUF_SIZE, NULL);
 
-    h = PJ_POOL_ALLOC_T(pool, pj_hash_table_t);
+    h = PJ_POOL_ZALLOC_T(pool, pj_hash_table_t);
     h->count = 0;
 
     PJ_LOG( 6, ("hashtbl", "hash table %p created from pool %s", h, pj_pool_getobjname(pool)));
 
+    if (options & PJ_HASH_OPEN_ADDRESSING) {
+	/* Room for size entries below the 3/4 load limit */
+	table_size = HASH_MIN_SLOTS;
+	while (table_size < 0x80000000U && table_size / 4 * 3 <= size)
+	    table_size <<= 1;
+
+	h->pool = pool;
+	oa_alloc_slots(h, table_size);
+	return h;
+    }
+
     /* size must be 2^n - 1.
        round-up the size to this rule, except when size is 2^n, then size
        will be round-down to 2^n-1.
@@ -130,13 +194,14 @@ PJ_DEF(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size)
     return h;
 }
 
-static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht, 
-				   const void *key, unsigned keylen,
-				   void *val, pj_uint32_t *hval,
-				   void *entry_buf, pj_bool_t lower)
+/* Get the hash value of the key, or use the one given in hval, and
+ * resolve PJ_HASH_KEY_STRING keylen.
+ */
+static pj_uint32_t key_hash( const void *key, unsigned *p_keylen,
+			     pj_uint32_t *hval, pj_bool_t lower)
 {
+    unsigned keylen = *p_keylen;
     pj_uint32_t hash;
-    pj_hash_entry **p_entry, *entry;
 
     if (hval && *hval != 0) {
 	hash = *hval;
@@ -173,6 +238,20 @@ static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht,
 	    *hval = hash;
     }
 
+    *p_keylen = keylen;
+    return hash;
+}
+
+static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht, 
+				   const void *key, unsigned keylen,
+				   void *val, pj_uint32_t *hval,
+				   void *entry_buf, pj_bool_t lower)
+{
+    pj_uint32_t hash;
+    pj_hash_entry **p_entry, *entry;
+
+    hash = key_hash(key, &keylen, hval, lower);
+
     /* scan the linked list */
     for (p_entry = &ht->table[hash & ht->rows], entry=*p_entry; 
 	 entry; 
@@ -222,11 +301,221 @@ static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht,
     return p_entry;
 }
 
+/* Find the slot of the key in open addressing table. Returns the slot
+ * index, or -1 if it's not found, in which case p_free (if specified) is
+ * set to the slot where the key should be inserted.
+ */
+static int oa_find( pj_hash_table_t *ht, pj_uint32_t hash,
+		    const void *key, unsigned keylen, pj_bool_t lower,
+		    int *p_free)
+{
+    pj_uint32_t mix = hash * HASH_MIX;
+    pj_uint8_t h7 = (pj_uint8_t)(mix & 0x7F);
+    unsigned i = mix >> ht->shift;
+    int free_slot = -1;
+
+    /* There is always an empty slot to end the probe, see oa_insert() */
+    for (;; i = (i + 1) & ht->rows) {
+	pj_uint8_t c = ht->ctrl[i];
+
+	if (c == h7) {
+	    const hash_slot *slot = &ht->slots[i];
+	    if (slot->hash==hash && slot->keylen==keylen &&
+		((lower && pj_ansi_strnicmp((const char*)slot->key,
+					    (const char*)key, keylen)==0) ||
+		 (!lower && pj_memcmp(slot->key, key, keylen)==0)))
+	    {
+		return (int)i;
+	    }
+	} else if (c == HASH_CTRL_EMPTY) {
+	    if (free_slot < 0)
+		free_slot = (int)i;
+	    break;
+	} else if (c == HASH_CTRL_DELETED && free_slot < 0) {
+	    free_slot = (int)i;
+	}
+    }
+
+    if (p_free)
+	*p_free = free_slot;
+    return -1;
+}
+
+/* Drop the tombstones without changing the size of the table, so the
+ * slot arrays are reused. The live entries are marked as pending and the
+ * tombstones become empty, then every pending entry is put at the first
+ * empty or pending slot of its probe sequence, swapping it with the
+ * pending entry found there, which is then placed the same way. The
+ * probe sequence of a placed entry only crosses placed entries, which
+ * stay where they are, so every entry is found again.
+ */
+static void oa_drop_deleted(pj_hash_table_t *ht)
+{
+    unsigned i, slot_cnt = ht->rows + 1;
+
+    for (i = 0; i < slot_cnt; ++i) {
+	ht->ctrl[i] = (ht->ctrl[i] & 0x80) ? HASH_CTRL_EMPTY :
+					     HASH_CTRL_PENDING;
+    }
+
+    for (i = 0; i < slot_cnt; ++i) {
+	hash_slot slot;
+
+	if (ht->ctrl[i] != HASH_CTRL_PENDING)
+	    continue;
+
+	slot = ht->slots[i];
+	ht->ctrl[i] = HASH_CTRL_EMPTY;
+
+	for (;;) {
+	    pj_uint32_t mix = slot.hash * HASH_MIX;
+	    pj_uint8_t c;
+	    unsigned j;
+
+	    for (j = mix >> ht->shift;
+		 ht->ctrl[j] != HASH_CTRL_EMPTY &&
+		 ht->ctrl[j] != HASH_CTRL_PENDING;
+		 j = (j + 1) & ht->rows)
+	    {
+	    }
+
+	    c = ht->ctrl[j];
+	    ht->ctrl[j] = (pj_uint8_t)(mix & 0x7F);
+	    if (c == HASH_CTRL_EMPTY) {
+		ht->slots[j] = slot;
+		break;
+	    } else {
+		hash_slot tmp = ht->slots[j];
+		ht->slots[j] = slot;
+		slot = tmp;
+	    }
+	}
+    }
+
+    ht->deleted = 0;
+}
+
+/* Move the entries to new slot arrays, dropping the tombstones. The old
+ * arrays stay in the pool, which is bounded since the size doubles.
+ */
+static void oa_rehash(pj_hash_table_t *ht, unsigned slot_cnt)
+{
+    pj_uint8_t *old_ctrl = ht->ctrl;
+    hash_slot *old_slots = ht->slots;
+    unsigned i, old_cnt = ht->rows + 1;
+
+    if (slot_cnt == old_cnt) {
+	oa_drop_deleted(ht);
+	return;
+    }
+
+    oa_alloc_slots(ht, slot_cnt);
+
+    for (i = 0; i < old_cnt; ++i) {
+	pj_uint32_t mix;
+	unsigned j;
+
+	if (old_ctrl[i] & 0x80)
+	    continue;
+
+	mix = old_slots[i].hash * HASH_MIX;
+	for (j = mix >> ht->shift; ht->ctrl[j] != HASH_CTRL_EMPTY;
+	     j = (j + 1) & ht->rows)
+	{
+	}
+	ht->ctrl[j] = (pj_uint8_t)(mix & 0x7F);
+	ht->slots[j] = old_slots[i];
+    }
+
+    PJ_LOG(6, ("hashtbl", "%p: rehashed to %u slots, pool used=%u", ht,
+	       slot_cnt, pj_pool_get_used_size(ht->pool)));
+}
+
+static void oa_set( pj_pool_t *pool, pj_hash_table_t *ht,
+		    const void *key, unsigned keylen, pj_uint32_t hval,
+		    void *value, pj_bool_t lower )
+{
+    pj_uint32_t hash;
+    unsigned i;
+    int idx, free_slot;
+
+    hash = key_hash(key, &keylen, &hval, lower);
+    idx = oa_find(ht, hash, key, keylen, lower, &free_slot);
+
+    if (idx >= 0) {
+	if (value) {
+	    /* overwrite */
+	    ht->slots[idx].value = value;
+	    return;
+	}
+
+	/* delete entry. The slot can be made empty when the next one is,
+	 * since then no probe continues past it.
+	 */
+	i = ((unsigned)idx + 1) & ht->rows;
+	if (ht->ctrl[i] == HASH_CTRL_EMPTY) {
+	    ht->ctrl[idx] = HASH_CTRL_EMPTY;
+	} else {
+	    ht->ctrl[idx] = HASH_CTRL_DELETED;
+	    ++ht->deleted;
+	}
+	ht->slots[idx].value = NULL;
+	--ht->count;
+	return;
+    }
+
+    if (value == NULL)
+	return;
+
+    /* Keep the table below 3/4 full including the tombstones, growing it
+     * if it's more than half full with live entries.
+     */
+    if (ht->ctrl[free_slot] == HASH_CTRL_EMPTY &&
+	(ht->count + ht->deleted + 1) * 4 > (ht->rows + 1) * 3)
+    {
+	unsigned slot_cnt = ht->rows + 1;
+	if ((ht->count + 1) * 2 > slot_cnt)
+	    slot_cnt <<= 1;
+	oa_rehash(ht, slot_cnt);
+	oa_find(ht, hash, key, keylen, lower, &free_slot);
+    }
+
+    if (ht->ctrl[free_slot] == HASH_CTRL_DELETED)
+	--ht->deleted;
+
+    if (pool) {
+	void *key_copy = pj_pool_alloc(pool, keylen);
+	pj_memcpy(key_copy, key, keylen);
+	key = key_copy;
+    }
+
+    ht->ctrl[free_slot] = (pj_uint8_t)((hash * HASH_MIX) & 0x7F);
+    ht->slots[free_slot].hash = hash;
+    ht->slots[free_slot].keylen = keylen;
+    ht->slots[free_slot].key = key;
+    ht->slots[free_slot].value = value;
+    ++ht->count;
+}
+
+static void *oa_get( pj_hash_table_t *ht, const void *key, unsigned keylen,
+		     pj_uint32_t *hval, pj_bool_t lower )
+{
+    pj_uint32_t hash;
+    int idx;
+
+    hash = key_hash(key, &keylen, hval, lower);
+    idx = oa_find(ht, hash, key, keylen, lower, NULL);
+    return idx >= 0 ? ht->slots[idx].value : NULL;
+}
+
 PJ_DEF(void *) pj_hash_get( pj_hash_table_t *ht,
 			    const void *key, unsigned keylen,
 			    pj_uint32_t *hval)
 {
     pj_hash_entry *entry;
+
+    if (ht->ctrl)
+	return oa_get(ht, key, keylen, hval, PJ_FALSE);
     entry = *find_entry( NULL, ht, key, keylen, NULL, hval, NULL, PJ_FALSE);
     return entry ? entry->value : NULL;
 }
@@ -236,6 +525,9 @@ PJ_DEF(void *) pj_hash_get_lower( pj_hash_table_t *ht,
 			          pj_uint32_t *hval)
 {
     pj_hash_entry *entry;
+
+    if (ht->ctrl)
+	return oa_get(ht, key, keylen, hval, PJ_TRUE);
     entry = *find_entry( NULL, ht, key, keylen, NULL, hval, NULL, PJ_TRUE);
     return entry ? entry->value : NULL;
 }
@@ -246,6 +538,11 @@ static void hash_set( pj_pool_t *pool, pj_hash_table_t *ht,
 {
     pj_hash_entry **p_entry;
 
+    if (ht->ctrl) {
+	oa_set(pool, ht, key, keylen, hval, value, lower);
+	return;
+    }
+
     p_entry = find_entry( pool, ht, key, keylen, value, &hval, entry_buf,
                           lower);
     if (*p_entry) {
@@ -306,6 +603,17 @@ PJ_DEF(pj_hash_iterator_t*) pj_hash_first( pj_hash_table_t *ht,
     it->index = 0;
     it->entry = NULL;
 
+    if (ht->ctrl) {
+	/* entry points to the slot of the current entry */
+	for (; it->index <= ht->rows; ++it->index) {
+	    if ((ht->ctrl[it->index] & 0x80) == 0) {
+		it->entry = (pj_hash_entry*) &ht->slots[it->index];
+		return it;
+	    }
+	}
+	return NULL;
+    }
+
     for (; it->index <= ht->rows; ++it->index) {
 	it->entry = ht->table[it->index];
 	if (it->entry) {
@@ -319,6 +627,16 @@ PJ_DEF(pj_hash_iterator_t*) pj_hash_first( pj_hash_table_t *ht,
 PJ_DEF(pj_hash_iterator_t*) pj_hash_next( pj_hash_table_t *ht, 
 					  pj_hash_iterator_t *it )
 {
+    if (ht->ctrl) {
+	for (++it->index; it->index <= ht->rows; ++it->index) {
+	    if ((ht->ctrl[it->index] & 0x80) == 0) {
+		it->entry = (pj_hash_entry*) &ht->slots[it->index];
+		return it;
+	    }
+	}
+	return NULL;
+    }
+
     it->entry = it->entry->next;
     if (it->entry) {
 	return it;
@@ -337,7 +655,8 @@ PJ_DEF(pj_hash_iterator_t*) pj_hash_next( pj_hash_table_t *ht,
 PJ_DEF(void*) pj_hash_this( pj_hash_table_t *ht, pj_hash_iterator_t *it )
 {
     PJ_CHECK_STACK();
-    PJ_UNUSED_ARG(ht);
+    if (ht->ctrl)
+	return ((hash_slot*)it->entry)->value;
     return it->entry->value;
 }
 
@@ -0,0 +1,1080 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/*
+ * ioqueue_uring.c
+ *
+ * This is the implementation of IOQueue framework using Linux io_uring
+ * (kernel 5.11 or later). The ring is only used to wait for readiness,
+ * with one-shot poll requests which are armed when an operation is
+ * queued on the key and re-armed after the event has been dispatched.
+ * The re-arm requests of all events processed in one poll are submitted
+ * together in the same io_uring_enter() call which waits for the next
+ * events, and a socket with no pending operation costs nothing. The
+ * actual I/O is performed by the common ioqueue abstraction, the same
+ * way as the select and epoll backends.
+ */
+
+#include <pj/ioqueue.h>
+#include <pj/os.h>
+#include <pj/lock.h>
+#include <pj/log.h>
+#include <pj/list.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include <pj/assert.h>
+#include <pj/errno.h>
+#include <pj/sock.h>
+#include <pj/compat/socket.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define THIS_FILE   "ioq_uring"
+
+//#define TRACE_(expr) PJ_LOG(3,expr)
+#define TRACE_(expr)
+
+/* Number of submission queue entries. The completion queue is sized from
+ * the maximum number of handles, since each handle may have one read and
+ * one write poll outstanding, plus their removal.
+ */
+#define SQ_ENTRIES	    256
+
+/* Poll request direction, stored in the lowest bit of user_data. */
+#define POLL_READ	    0
+#define POLL_WRITE	    1
+
+/* user_data of the poll removal requests, which completions are ignored. */
+#define REMOVE_USER_DATA    ((pj_uint64_t)-1)
+
+/*
+ * Include common ioqueue abstraction.
+ */
+#include "ioqueue_common_abs.h"
+
+/*
+ * This describes each key.
+ */
+struct pj_ioqueue_key_t
+{
+    DECLARE_COMMON_KEY
+
+    unsigned		    slot;
+    pj_bool_t		    read_armed;
+    pj_bool_t		    write_armed;
+};
+
+/*
+ * Registered keys are addressed by slot and generation in the user_data
+ * of their poll requests, so that a late completion for a key which has
+ * been unregistered (and perhaps reused) is recognized and ignored.
+ */
+struct slot
+{
+    pj_ioqueue_key_t	   *key;
+    pj_uint32_t		    gen;
+};
+
+struct queue
+{
+    pj_ioqueue_key_t	    *key;
+    enum ioqueue_event_type  event_type;
+};
+
+/*
+ * This describes the I/O queue.
+ */
+struct pj_ioqueue_t
+{
+    DECLARE_COMMON_IOQUEUE
+
+    unsigned		max, count;
+    pj_ioqueue_key_t	active_list;
+
+    struct slot	       *slots;
+    unsigned	       *free_slots;
+    unsigned		free_slot_cnt;
+
+    int			ring_fd;
+    void	       *sq_ring;
+    pj_size_t		sq_ring_len;
+    void	       *cq_ring;
+    pj_size_t		cq_ring_len;
+    struct io_uring_sqe *sqes;
+    pj_size_t		sqes_len;
+
+    unsigned	       *sq_khead;
+    unsigned	       *sq_ktail;
+    unsigned	       *sq_array;
+    unsigned		sq_mask;
+    unsigned		sq_entries;
+    unsigned		sq_tail;
+
+    unsigned	       *cq_khead;
+    unsigned	       *cq_ktail;
+    unsigned		cq_mask;
+    struct io_uring_cqe *cqes;
+
+    /* Number of queued requests not yet submitted to the kernel, and
+     * number of threads waiting in pj_ioqueue_poll().
+     */
+    unsigned		sq_pending;
+    unsigned		waiters;
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    pj_mutex_t	       *ref_cnt_mutex;
+    pj_ioqueue_key_t	closing_list;
+    pj_ioqueue_key_t	free_list;
+#endif
+};
+
+/* Include implementation for common abstraction after we declare
+ * pj_ioqueue_key_t and pj_ioqueue_t.
+ */
+#include "ioqueue_common_abs.c"
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Scan closing keys to be put to free list again */
+static void scan_closing_keys(pj_ioqueue_t *ioqueue);
+#endif
+
+
+static int os_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int os_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+			  unsigned flags, void *arg, pj_size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+			flags, arg, argsz);
+}
+
+/* Unmap the rings and close the io_uring instance. */
+static void uring_close(pj_ioqueue_t *ioqueue)
+{
+    if (ioqueue->sqes)
+	munmap(ioqueue->sqes, ioqueue->sqes_len);
+    if (ioqueue->cq_ring && ioqueue->cq_ring != ioqueue->sq_ring)
+	munmap(ioqueue->cq_ring, ioqueue->cq_ring_len);
+    if (ioqueue->sq_ring)
+	munmap(ioqueue->sq_ring, ioqueue->sq_ring_len);
+    if (ioqueue->ring_fd >= 0)
+	close(ioqueue->ring_fd);
+
+    ioqueue->sqes = NULL;
+    ioqueue->cq_ring = ioqueue->sq_ring = NULL;
+    ioqueue->ring_fd = -1;
+}
+
+/* Create the io_uring instance and map its rings. */
+static pj_status_t uring_open(pj_ioqueue_t *ioqueue, unsigned max_fd)
+{
+    struct io_uring_params p;
+    char *sq, *cq;
+    pj_status_t status;
+
+    pj_bzero(&p, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    p.cq_entries = SQ_ENTRIES * 2;
+    while (p.cq_entries < max_fd * 4)
+	p.cq_entries <<= 1;
+
+    ioqueue->ring_fd = os_uring_setup(SQ_ENTRIES, &p);
+    if (ioqueue->ring_fd < 0)
+	return PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+
+    /* We need the timeout argument of io_uring_enter() */
+    if ((p.features & IORING_FEAT_EXT_ARG) == 0) {
+	PJ_LOG(2,(THIS_FILE, "io_uring in this kernel is too old"));
+	uring_close(ioqueue);
+	return PJ_ENOTSUP;
+    }
+
+    ioqueue->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ioqueue->cq_ring_len = p.cq_off.cqes +
+			   p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+	if (ioqueue->cq_ring_len > ioqueue->sq_ring_len)
+	    ioqueue->sq_ring_len = ioqueue->cq_ring_len;
+	ioqueue->cq_ring_len = ioqueue->sq_ring_len;
+    }
+
+    sq = (char*)mmap(NULL, ioqueue->sq_ring_len, PROT_READ | PROT_WRITE,
+		     MAP_SHARED | MAP_POPULATE, ioqueue->ring_fd,
+		     IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+	goto on_error;
+    ioqueue->sq_ring = sq;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+	cq = sq;
+    } else {
+	cq = (char*)mmap(NULL, ioqueue->cq_ring_len, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, ioqueue->ring_fd,
+			 IORING_OFF_CQ_RING);
+	if (cq == MAP_FAILED)
+	    goto on_error;
+    }
+    ioqueue->cq_ring = cq;
+
+    ioqueue->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    ioqueue->sqes = (struct io_uring_sqe*)
+		    mmap(NULL, ioqueue->sqes_len, PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_POPULATE, ioqueue->ring_fd,
+			 IORING_OFF_SQES);
+    if (ioqueue->sqes == MAP_FAILED) {
+	ioqueue->sqes = NULL;
+	goto on_error;
+    }
+
+    ioqueue->sq_khead = (unsigned*)(sq + p.sq_off.head);
+    ioqueue->sq_ktail = (unsigned*)(sq + p.sq_off.tail);
+    ioqueue->sq_array = (unsigned*)(sq + p.sq_off.array);
+    ioqueue->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    ioqueue->sq_entries = p.sq_entries;
+    ioqueue->sq_tail = *ioqueue->sq_ktail;
+
+    ioqueue->cq_khead = (unsigned*)(cq + p.cq_off.head);
+    ioqueue->cq_ktail = (unsigned*)(cq + p.cq_off.tail);
+    ioqueue->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    ioqueue->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    ioqueue->sq_pending = 0;
+    ioqueue->waiters = 0;
+
+    return PJ_SUCCESS;
+
+on_error:
+    status = PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+    uring_close(ioqueue);
+    return status;
+}
+
+/* Submit the queued requests to the kernel, without waiting.
+ * The kernel may consume fewer entries than requested (e.g. when it is
+ * short of memory or the completion queue has overflowed); the rest stay
+ * in the ring and are submitted on the next call.
+ * Must be called with ioqueue's lock held.
+ */
+static void uring_submit(pj_ioqueue_t *ioqueue)
+{
+    unsigned to_submit = ioqueue->sq_pending;
+    int rc;
+
+    if (to_submit == 0)
+	return;
+
+    ioqueue->sq_pending = 0;
+    rc = os_uring_enter(ioqueue->ring_fd, to_submit, 0, 0, NULL, 0);
+    if (rc < 0) {
+	ioqueue->sq_pending += to_submit;
+	TRACE_((THIS_FILE, "io_uring_enter submit error: %d", errno));
+    } else if ((unsigned)rc < to_submit) {
+	ioqueue->sq_pending += to_submit - rc;
+	TRACE_((THIS_FILE, "io_uring_enter submitted %d of %u",
+		rc, to_submit));
+    }
+}
+
+/* Get a free submission queue entry, submitting the queued requests if
+ * the queue is full. Must be called with ioqueue's lock held.
+ */
+static struct io_uring_sqe *uring_get_sqe(pj_ioqueue_t *ioqueue)
+{
+    struct io_uring_sqe *sqe;
+    unsigned head;
+
+    head = __atomic_load_n(ioqueue->sq_khead, __ATOMIC_ACQUIRE);
+    if (ioqueue->sq_tail - head >= ioqueue->sq_entries) {
+	uring_submit(ioqueue);
+	head = __atomic_load_n(ioqueue->sq_khead, __ATOMIC_ACQUIRE);
+	if (ioqueue->sq_tail - head >= ioqueue->sq_entries) {
+	    PJ_LOG(2,(THIS_FILE, "io_uring submission queue is full"));
+	    return NULL;
+	}
+    }
+
+    sqe = &ioqueue->sqes[ioqueue->sq_tail & ioqueue->sq_mask];
+    pj_bzero(sqe, sizeof(*sqe));
+    return sqe;
+}
+
+/* Make the entry returned by uring_get_sqe() visible to the kernel. */
+static void uring_commit_sqe(pj_ioqueue_t *ioqueue)
+{
+    unsigned idx = ioqueue->sq_tail & ioqueue->sq_mask;
+
+    ioqueue->sq_array[idx] = idx;
+    ++ioqueue->sq_tail;
+    __atomic_store_n(ioqueue->sq_ktail, ioqueue->sq_tail, __ATOMIC_RELEASE);
+    ++ioqueue->sq_pending;
+}
+
+static pj_uint64_t poll_user_data(pj_ioqueue_t *ioqueue,
+				  pj_ioqueue_key_t *key, int dir)
+{
+    return ((pj_uint64_t)ioqueue->slots[key->slot].gen << 32) |
+	   (key->slot << 1) | dir;
+}
+
+/* Queue a one-shot poll request for the key. */
+static pj_bool_t uring_queue_poll(pj_ioqueue_t *ioqueue,
+				  pj_ioqueue_key_t *key, int dir)
+{
+    struct io_uring_sqe *sqe;
+    pj_uint32_t events;
+
+    sqe = uring_get_sqe(ioqueue);
+    if (!sqe)
+	return PJ_FALSE;
+
+    events = (dir == POLL_READ) ? POLLIN : POLLOUT;
+#if defined(PJ_IS_BIG_ENDIAN) && PJ_IS_BIG_ENDIAN!=0
+    events = (events << 16) | (events >> 16);
+#endif
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = key->fd;
+    sqe->poll32_events = events;
+    sqe->user_data = poll_user_data(ioqueue, key, dir);
+    uring_commit_sqe(ioqueue);
+
+    return PJ_TRUE;
+}
+
+/* Queue the removal of an armed poll request of the key. */
+static void uring_queue_poll_remove(pj_ioqueue_t *ioqueue,
+				    pj_ioqueue_key_t *key, int dir)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = uring_get_sqe(ioqueue);
+    if (!sqe)
+	return;
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = poll_user_data(ioqueue, key, dir);
+    sqe->user_data = REMOVE_USER_DATA;
+    uring_commit_sqe(ioqueue);
+}
+
+/* Arm the poll requests needed by the pending operations of the key.
+ * Must be called with ioqueue's lock held.
+ */
+static void uring_arm_key(pj_ioqueue_t *ioqueue, pj_ioqueue_key_t *key)
+{
+    if (IS_CLOSING(key) || ioqueue->slots[key->slot].key != key)
+	return;
+
+    if (!key->read_armed &&
+	(key_has_pending_read(key) || key_has_pending_accept(key)))
+    {
+	key->read_armed = uring_queue_poll(ioqueue, key, POLL_READ);
+    }
+
+    if (!key->write_armed &&
+	(key_has_pending_write(key) || key_has_pending_connect(key)))
+    {
+	key->write_armed = uring_queue_poll(ioqueue, key, POLL_WRITE);
+    }
+}
+
+/*
+ * pj_ioqueue_name()
+ */
+PJ_DEF(const char*) pj_ioqueue_name(void)
+{
+    return "io_uring";
+}
+
+/*
+ * pj_ioqueue_create()
+ *
+ * Create io_uring ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_create( pj_pool_t *pool,
+                                       pj_size_t max_fd,
+                                       pj_ioqueue_t **p_ioqueue)
+{
+    pj_ioqueue_t *ioqueue;
+    pj_status_t rc;
+    pj_lock_t *lock;
+    unsigned i;
+
+    /* Check that arguments are valid. */
+    PJ_ASSERT_RETURN(pool != NULL && p_ioqueue != NULL &&
+                     max_fd > 0, PJ_EINVAL);
+
+    /* Check that size of pj_ioqueue_op_key_t is sufficient */
+    PJ_ASSERT_RETURN(sizeof(pj_ioqueue_op_key_t)-sizeof(void*) >=
+                     sizeof(union operation_key), PJ_EBUG);
+
+    ioqueue = PJ_POOL_ZALLOC_T(pool, pj_ioqueue_t);
+
+    ioqueue_init(ioqueue);
+
+    ioqueue->max = (unsigned)max_fd;
+    ioqueue->count = 0;
+    ioqueue->ring_fd = -1;
+    pj_list_init(&ioqueue->active_list);
+
+    /* Slot table, with all slots initially free */
+    ioqueue->slots = (struct slot*)
+		     pj_pool_calloc(pool, max_fd, sizeof(struct slot));
+    ioqueue->free_slots = (unsigned*)
+			  pj_pool_calloc(pool, max_fd, sizeof(unsigned));
+    for (i=0; i<max_fd; ++i)
+	ioqueue->free_slots[i] = (unsigned)max_fd - i - 1;
+    ioqueue->free_slot_cnt = (unsigned)max_fd;
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* When safe unregistration is used (the default), we pre-create
+     * all keys and put them in the free list.
+     */
+
+    /* Mutex to protect key's reference counter
+     * We don't want to use key's mutex or ioqueue's mutex because
+     * that would create deadlock situation in some cases.
+     */
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->ref_cnt_mutex);
+    if (rc != PJ_SUCCESS)
+	return rc;
+
+
+    /* Init key list */
+    pj_list_init(&ioqueue->free_list);
+    pj_list_init(&ioqueue->closing_list);
+
+
+    /* Pre-create all keys according to max_fd */
+    for ( i=0; i<max_fd; ++i) {
+	pj_ioqueue_key_t *key;
+
+	key = PJ_POOL_ALLOC_T(pool, pj_ioqueue_key_t);
+	key->ref_count = 0;
+	rc = pj_lock_create_recursive_mutex(pool, NULL, &key->lock);
+	if (rc != PJ_SUCCESS) {
+	    key = ioqueue->free_list.next;
+	    while (key != &ioqueue->free_list) {
+		pj_lock_destroy(key->lock);
+		key = key->next;
+	    }
+	    pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+	    return rc;
+	}
+
+	pj_list_push_back(&ioqueue->free_list, key);
+    }
+#endif
+
+    rc = pj_lock_create_simple_mutex(pool, "ioq%p", &lock);
+    if (rc != PJ_SUCCESS)
+	return rc;
+
+    rc = pj_ioqueue_set_lock(ioqueue, lock, PJ_TRUE);
+    if (rc != PJ_SUCCESS)
+        return rc;
+
+    rc = uring_open(ioqueue, ioqueue->max);
+    if (rc != PJ_SUCCESS) {
+	pj_lock_acquire(ioqueue->lock);
+	ioqueue_destroy(ioqueue);
+	return rc;
+    }
+
+    PJ_LOG(4, ("pjlib", "io_uring I/O Queue created (%p)", ioqueue));
+
+    *p_ioqueue = ioqueue;
+    return PJ_SUCCESS;
+}
+
+/*
+ * pj_ioqueue_destroy()
+ *
+ * Destroy ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_destroy(pj_ioqueue_t *ioqueue)
+{
+    pj_ioqueue_key_t *key;
+
+    PJ_ASSERT_RETURN(ioqueue, PJ_EINVAL);
+    PJ_ASSERT_RETURN(ioqueue->ring_fd >= 0, PJ_EINVALIDOP);
+
+    pj_lock_acquire(ioqueue->lock);
+    uring_close(ioqueue);
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* Destroy reference counters */
+    key = ioqueue->active_list.next;
+    while (key != &ioqueue->active_list) {
+	pj_lock_destroy(key->lock);
+	key = key->next;
+    }
+
+    key = ioqueue->closing_list.next;
+    while (key != &ioqueue->closing_list) {
+	pj_lock_destroy(key->lock);
+	key = key->next;
+    }
+
+    key = ioqueue->free_list.next;
+    while (key != &ioqueue->free_list) {
+	pj_lock_destroy(key->lock);
+	key = key->next;
+    }
+
+    pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+#else
+    PJ_UNUSED_ARG(key);
+#endif
+    return ioqueue_destroy(ioqueue);
+}
+
+/*
+ * pj_ioqueue_register_sock()
+ *
+ * Register a socket to ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock2(pj_pool_t *pool,
+					      pj_ioqueue_t *ioqueue,
+					      pj_sock_t sock,
+					      pj_grp_lock_t *grp_lock,
+					      void *user_data,
+					      const pj_ioqueue_callback *cb,
+                                              pj_ioqueue_key_t **p_key)
+{
+    pj_ioqueue_key_t *key = NULL;
+    pj_uint32_t value;
+    pj_status_t rc = PJ_SUCCESS;
+
+    PJ_ASSERT_RETURN(pool && ioqueue && sock != PJ_INVALID_SOCKET &&
+                     cb && p_key, PJ_EINVAL);
+
+    pj_lock_acquire(ioqueue->lock);
+
+    if (ioqueue->count >= ioqueue->max || ioqueue->free_slot_cnt == 0) {
+        rc = PJ_ETOOMANY;
+	TRACE_((THIS_FILE, "pj_ioqueue_register_sock error: too many files"));
+	goto on_return;
+    }
+
+    /* Set socket to nonblocking. */
+    value = 1;
+    if ((rc=ioctl(sock, FIONBIO, &value))) {
+	TRACE_((THIS_FILE, "pj_ioqueue_register_sock error: ioctl rc=%d",
+                rc));
+        rc = pj_get_netos_error();
+	goto on_return;
+    }
+
+    /* If safe unregistration (PJ_IOQUEUE_HAS_SAFE_UNREG) is used, get
+     * the key from the free list. Otherwise allocate a new one.
+     */
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+
+    /* Scan closing_keys first to let them come back to free_list */
+    scan_closing_keys(ioqueue);
+
+    pj_assert(!pj_list_empty(&ioqueue->free_list));
+    if (pj_list_empty(&ioqueue->free_list)) {
+	rc = PJ_ETOOMANY;
+	goto on_return;
+    }
+
+    key = ioqueue->free_list.next;
+    pj_list_erase(key);
+#else
+    /* Create key. */
+    key = (pj_ioqueue_key_t*)pj_pool_zalloc(pool, sizeof(pj_ioqueue_key_t));
+#endif
+
+    rc = ioqueue_init_key(pool, ioqueue, key, sock, grp_lock, user_data, cb);
+    if (rc != PJ_SUCCESS) {
+	key = NULL;
+	goto on_return;
+    }
+
+    /* Assign a slot. Poll requests are only armed when an operation is
+     * queued on the key.
+     */
+    key->slot = ioqueue->free_slots[--ioqueue->free_slot_cnt];
+    key->read_armed = key->write_armed = PJ_FALSE;
+    ioqueue->slots[key->slot].key = key;
+
+    /* Register */
+    pj_list_insert_before(&ioqueue->active_list, key);
+    ++ioqueue->count;
+
+on_return:
+    if (rc != PJ_SUCCESS) {
+	if (key && key->grp_lock)
+	    pj_grp_lock_dec_ref_dbg(key->grp_lock, "ioqueue", 0);
+    }
+    *p_key = key;
+    pj_lock_release(ioqueue->lock);
+
+    return rc;
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock( pj_pool_t *pool,
+					      pj_ioqueue_t *ioqueue,
+					      pj_sock_t sock,
+					      void *user_data,
+					      const pj_ioqueue_callback *cb,
+					      pj_ioqueue_key_t **p_key)
+{
+    return pj_ioqueue_register_sock2(pool, ioqueue, sock, NULL, user_data,
+                                     cb, p_key);
+}
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Increment key's reference counter */
+static void increment_counter(pj_ioqueue_key_t *key)
+{
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    ++key->ref_count;
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+}
+
+/* Decrement the key's reference counter, and when the counter reach zero,
+ * destroy the key.
+ *
+ * Note: MUST NOT CALL THIS FUNCTION WHILE HOLDING ioqueue's LOCK.
+ */
+static void decrement_counter(pj_ioqueue_key_t *key)
+{
+    pj_lock_acquire(key->ioqueue->lock);
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    --key->ref_count;
+    if (key->ref_count == 0) {
+
+	pj_assert(key->closing == 1);
+	pj_gettickcount(&key->free_time);
+	key->free_time.msec += PJ_IOQUEUE_KEY_FREE_DELAY;
+	pj_time_val_normalize(&key->free_time);
+
+	pj_list_erase(key);
+	pj_list_push_back(&key->ioqueue->closing_list, key);
+
+    }
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+    pj_lock_release(key->ioqueue->lock);
+}
+#endif
+
+/*
+ * pj_ioqueue_unregister()
+ *
+ * Unregister handle from ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_unregister( pj_ioqueue_key_t *key)
+{
+    pj_ioqueue_t *ioqueue;
+    struct slot *slot;
+
+    PJ_ASSERT_RETURN(key != NULL, PJ_EINVAL);
+
+    ioqueue = key->ioqueue;
+
+    /* Lock the key to make sure no callback is simultaneously modifying
+     * the key. We need to lock the key before ioqueue here to prevent
+     * deadlock.
+     */
+    pj_ioqueue_lock_key(key);
+
+    /* Also lock ioqueue */
+    pj_lock_acquire(ioqueue->lock);
+
+    pj_assert(ioqueue->count > 0);
+    --ioqueue->count;
+#if !PJ_IOQUEUE_HAS_SAFE_UNREG
+    pj_list_erase(key);
+#endif
+
+    /* Remove the armed poll requests, since they hold a reference to the
+     * socket, and release the slot. Completions of the removed requests
+     * carry the old generation and will be ignored.
+     */
+    if (key->read_armed)
+	uring_queue_poll_remove(ioqueue, key, POLL_READ);
+    if (key->write_armed)
+	uring_queue_poll_remove(ioqueue, key, POLL_WRITE);
+    uring_submit(ioqueue);
+    key->read_armed = key->write_armed = PJ_FALSE;
+
+    slot = &ioqueue->slots[key->slot];
+    slot->key = NULL;
+    ++slot->gen;
+    ioqueue->free_slots[ioqueue->free_slot_cnt++] = key->slot;
+
+    /* Destroy the key. */
+    pj_sock_close(key->fd);
+
+    pj_lock_release(ioqueue->lock);
+
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+    /* Mark key is closing. */
+    key->closing = 1;
+
+    /* Decrement counter. */
+    decrement_counter(key);
+
+    /* Done. */
+    if (key->grp_lock) {
+	/* just dec_ref and unlock. we will set grp_lock to NULL
+	 * elsewhere */
+	pj_grp_lock_t *grp_lock = key->grp_lock;
+	// Don't set grp_lock to NULL otherwise the other thread
+	// will crash. Just leave it as dangling pointer, but this
+	// should be safe
+	//key->grp_lock = NULL;
+	pj_grp_lock_dec_ref_dbg(grp_lock, "ioqueue", 0);
+	pj_grp_lock_release(grp_lock);
+    } else {
+	pj_ioqueue_unlock_key(key);
+    }
+#else
+    if (key->grp_lock) {
+	/* set grp_lock to NULL and unlock */
+	pj_grp_lock_t *grp_lock = key->grp_lock;
+	// Don't set grp_lock to NULL otherwise the other thread
+	// will crash. Just leave it as dangling pointer, but this
+	// should be safe
+	//key->grp_lock = NULL;
+	pj_grp_lock_dec_ref_dbg(grp_lock, "ioqueue", 0);
+	pj_grp_lock_release(grp_lock);
+    } else {
+	pj_ioqueue_unlock_key(key);
+    }
+
+    pj_lock_destroy(key->lock);
+#endif
+
+    return PJ_SUCCESS;
+}
+
+/* ioqueue_remove_from_set()
+ * This function is called from ioqueue_dispatch_event() to instruct
+ * the ioqueue to remove the specified descriptor from ioqueue's descriptor
+ * set for the specified event.
+ */
+static void ioqueue_remove_from_set( pj_ioqueue_t *ioqueue,
+                                     pj_ioqueue_key_t *key,
+                                     enum ioqueue_event_type event_type)
+{
+    /* Poll requests are one-shot, and are not re-armed once there is no
+     * pending operation for the event.
+     */
+    PJ_UNUSED_ARG(ioqueue);
+    PJ_UNUSED_ARG(key);
+    PJ_UNUSED_ARG(event_type);
+}
+
+/*
+ * ioqueue_add_to_set()
+ * This function is called from pj_ioqueue_recv(), pj_ioqueue_send() etc
+ * to instruct the ioqueue to add the specified handle to ioqueue's descriptor
+ * set for the specified event.
+ */
+static void ioqueue_add_to_set( pj_ioqueue_t *ioqueue,
+                                pj_ioqueue_key_t *key,
+                                enum ioqueue_event_type event_type )
+{
+    PJ_UNUSED_ARG(event_type);
+
+    pj_lock_acquire(ioqueue->lock);
+
+    uring_arm_key(ioqueue, key);
+
+    /* Threads already waiting for events would not see the new request
+     * until they return, so submit it now. Otherwise it will be submitted
+     * along with the next wait.
+     */
+    if (ioqueue->waiters)
+	uring_submit(ioqueue);
+
+    pj_lock_release(ioqueue->lock);
+}
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+/* Scan closing keys to be put to free list again */
+static void scan_closing_keys(pj_ioqueue_t *ioqueue)
+{
+    pj_time_val now;
+    pj_ioqueue_key_t *h;
+
+    pj_gettickcount(&now);
+    h = ioqueue->closing_list.next;
+    while (h != &ioqueue->closing_list) {
+	pj_ioqueue_key_t *next = h->next;
+
+	pj_assert(h->closing != 0);
+
+	if (PJ_TIME_VAL_GTE(now, h->free_time)) {
+	    pj_list_erase(h);
+	    // Don't set grp_lock to NULL otherwise the other thread
+	    // will crash. Just leave it as dangling pointer, but this
+	    // should be safe
+	    //h->grp_lock = NULL;
+	    pj_list_push_back(&ioqueue->free_list, h);
+	}
+	h = next;
+    }
+}
+#endif
+
+/* Translate a poll completion to the event to be dispatched for the key,
+ * or NO_EVENT. Must be called with ioqueue's lock held.
+ */
+static enum ioqueue_event_type get_event(pj_ioqueue_t *ioqueue,
+					 const struct io_uring_cqe *cqe,
+					 pj_ioqueue_key_t **p_key)
+{
+    pj_ioqueue_key_t *h;
+    pj_uint64_t user_data = cqe->user_data;
+    unsigned slot;
+    int dir;
+
+    if (user_data == REMOVE_USER_DATA)
+	return NO_EVENT;
+
+    slot = (unsigned)(user_data & 0xFFFFFFFF) >> 1;
+    dir = (int)(user_data & 1);
+    if (slot >= ioqueue->max ||
+	ioqueue->slots[slot].gen != (pj_uint32_t)(user_data >> 32))
+    {
+	return NO_EVENT;
+    }
+
+    h = ioqueue->slots[slot].key;
+    if (!h || IS_CLOSING(h))
+	return NO_EVENT;
+
+    if (dir == POLL_READ)
+	h->read_armed = PJ_FALSE;
+    else
+	h->write_armed = PJ_FALSE;
+
+    if (cqe->res < 0) {
+	/* Requests are cancelled when the thread which submitted them
+	 * exits, so arm the key again.
+	 */
+	TRACE_((THIS_FILE, "poll completion error: %d", -cqe->res));
+	if (cqe->res == -ECANCELED)
+	    uring_arm_key(ioqueue, h);
+	return NO_EVENT;
+    }
+
+    *p_key = h;
+
+    if (dir == POLL_READ) {
+	if (key_has_pending_read(h) || key_has_pending_accept(h))
+	    return READABLE_EVENT;
+
+	/* Error on a connecting socket is reported as exception */
+	if ((cqe->res & POLLERR) && h->connecting)
+	    return EXCEPTION_EVENT;
+    } else {
+	if (key_has_pending_write(h) || key_has_pending_connect(h))
+	    return WRITEABLE_EVENT;
+    }
+
+    return NO_EVENT;
+}
+
+/*
+ * pj_ioqueue_poll()
+ *
+ */
+PJ_DEF(int) pj_ioqueue_poll( pj_ioqueue_t *ioqueue, const pj_time_val *timeout)
+{
+    int i, rc, event_cnt, processed_cnt;
+    int msec;
+    enum { MAX_EVENTS = PJ_IOQUEUE_MAX_CAND_EVENTS };
+    struct queue queue[MAX_EVENTS];
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned to_submit, head, tail;
+    pj_timestamp t1, t2;
+
+    PJ_CHECK_STACK();
+
+    msec = timeout ? PJ_TIME_VAL_MSEC(*timeout) : 9000;
+    if (msec < 0)
+	msec = 0;
+
+    ts.tv_sec = msec / 1000;
+    ts.tv_nsec = (msec % 1000) * 1000000;
+    pj_bzero(&arg, sizeof(arg));
+    arg.ts = (pj_uint64_t)(pj_size_t)&ts;
+
+    /* Take the queued requests (re-arms from the previous poll) to be
+     * submitted in the same call which waits for completions.
+     */
+    pj_lock_acquire(ioqueue->lock);
+    to_submit = ioqueue->sq_pending;
+    ioqueue->sq_pending = 0;
+    ++ioqueue->waiters;
+    pj_lock_release(ioqueue->lock);
+
+    TRACE_((THIS_FILE, "start io_uring_enter, msec=%d", msec));
+    pj_get_timestamp(&t1);
+
+    rc = os_uring_enter(ioqueue->ring_fd, to_submit, 1,
+			IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+			&arg, sizeof(arg));
+    if (rc < 0)
+	rc = -pj_get_native_os_error();
+
+    pj_get_timestamp(&t2);
+    TRACE_((THIS_FILE, "io_uring_enter returns %d, time=%d usec",
+		       rc, pj_elapsed_usec(&t1, &t2)));
+
+    /* Lock ioqueue. */
+    pj_lock_acquire(ioqueue->lock);
+    --ioqueue->waiters;
+
+    /* Nothing has been submitted on error, otherwise rc is the number
+     * of entries consumed by the kernel. Put back the rest.
+     */
+    if (rc < 0)
+	ioqueue->sq_pending += to_submit;
+    else if ((unsigned)rc < to_submit)
+	ioqueue->sq_pending += to_submit - rc;
+
+    head = *ioqueue->cq_khead;
+    tail = __atomic_load_n(ioqueue->cq_ktail, __ATOMIC_ACQUIRE);
+
+    /* Leave the completions which do not fit in the queue for the next
+     * poll.
+     */
+    for (event_cnt=0; head != tail && event_cnt < MAX_EVENTS; ++head) {
+	const struct io_uring_cqe *cqe = &ioqueue->cqes[head & ioqueue->cq_mask];
+	pj_ioqueue_key_t *h = NULL;
+	enum ioqueue_event_type event_type;
+
+	event_type = get_event(ioqueue, cqe, &h);
+	if (event_type == NO_EVENT)
+	    continue;
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+	increment_counter(h);
+#endif
+	queue[event_cnt].key = h;
+	queue[event_cnt].event_type = event_type;
+	++event_cnt;
+    }
+    __atomic_store_n(ioqueue->cq_khead, head, __ATOMIC_RELEASE);
+
+    if (event_cnt == 0) {
+	/* Submit the re-arms of cancelled requests, if any */
+	if (ioqueue->waiters)
+	    uring_submit(ioqueue);
+
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+	/* Check the closing keys only when there's no activity and when
+	 * there are pending closing keys.
+	 */
+	if (!pj_list_empty(&ioqueue->closing_list))
+	    scan_closing_keys(ioqueue);
+#endif
+	pj_lock_release(ioqueue->lock);
+
+	if (rc < 0 && rc != -ETIME && rc != -EINTR && rc != -EBUSY) {
+	    TRACE_((THIS_FILE, "io_uring_enter error"));
+	    return -PJ_RETURN_OS_ERROR(-rc);
+	}
+	TRACE_((THIS_FILE, "io_uring_enter timed out"));
+	return 0;
+    }
+
+    for (i=0; i<event_cnt; ++i) {
+	if (queue[i].key->grp_lock)
+	    pj_grp_lock_add_ref_dbg(queue[i].key->grp_lock, "ioqueue", 0);
+    }
+
+    PJ_RACE_ME(5);
+
+    pj_lock_release(ioqueue->lock);
+
+    PJ_RACE_ME(5);
+
+    processed_cnt = 0;
+
+    /* Now process the events. */
+    for (i=0; i<event_cnt; ++i) {
+
+	/* Just do not exceed PJ_IOQUEUE_MAX_EVENTS_IN_SINGLE_POLL */
+	if (processed_cnt < PJ_IOQUEUE_MAX_EVENTS_IN_SINGLE_POLL) {
+	    switch (queue[i].event_type) {
+	    case READABLE_EVENT:
+		if (ioqueue_dispatch_read_event(ioqueue, queue[i].key))
+		    ++processed_cnt;
+		break;
+	    case WRITEABLE_EVENT:
+		if (ioqueue_dispatch_write_event(ioqueue, queue[i].key))
+		    ++processed_cnt;
+		break;
+	    case EXCEPTION_EVENT:
+		if (ioqueue_dispatch_exception_event(ioqueue, queue[i].key))
+		    ++processed_cnt;
+		break;
+	    case NO_EVENT:
+		pj_assert(!"Invalid event!");
+		break;
+	    }
+	}
+    }
+
+    /* Re-arm the keys which still have pending operations, including the
+     * ones which could not be dispatched above. The requests are submitted
+     * with the next wait, unless another thread is already waiting.
+     */
+    pj_lock_acquire(ioqueue->lock);
+    for (i=0; i<event_cnt; ++i)
+	uring_arm_key(ioqueue, queue[i].key);
+    if (ioqueue->waiters)
+	uring_submit(ioqueue);
+    pj_lock_release(ioqueue->lock);
+
+    for (i=0; i<event_cnt; ++i) {
+#if PJ_IOQUEUE_HAS_SAFE_UNREG
+	decrement_counter(queue[i].key);
+#endif
+
+	if (queue[i].key->grp_lock)
+	    pj_grp_lock_dec_ref_dbg(queue[i].key->grp_lock,
+	                            "ioqueue", 0);
+    }
+
+    TRACE_((THIS_FILE, "     poll: events=%d processed=%d",
+		       event_cnt, processed_cnt));
+
+    return processed_cnt;
+}
@@ -19,8 +19,11 @@
  */
 #include <pj/types.h>
 #include <pj/log.h>
+#include <pj/assert.h>
+#include <pj/errno.h>
 #include <pj/string.h>
 #include <pj/os.h>
+#include <pj/pool.h>
 #include <pj/compat/stdarg.h>
 
 #if PJ_LOG_MAX_LEVEL >= 1
@@ -84,6 +87,47 @@ static char log_buffer[PJ_LOG_MAX_SIZE];
 
 #define LOG_MAX_INDENT		80
 
+#if PJ_LOG_HAS_ASYNC && PJ_HAS_THREADS && defined(__GNUC__)
+#  define LOG_ASYNC		1
+#else
+#  define LOG_ASYNC		0
+#endif
+
+#if LOG_ASYNC
+/* A formatted message waiting for the writer thread. seq tells the state
+ * of the slot relative to the queue position pos it is used for: seq==pos
+ * when it is free for the producer claiming pos, seq==pos+1 once the
+ * message is complete and may be written.
+ */
+typedef struct log_slot
+{
+    unsigned	     seq;
+    int		     level;
+    int		     len;
+    char	     buf[PJ_LOG_MAX_SIZE];
+} log_slot;
+
+typedef struct log_async
+{
+    log_slot	    *slots;
+    unsigned	     mask;
+    unsigned	     tail;	/* Next position to claim by producers.	*/
+    unsigned	     head;	/* Next position to write, writer only.	*/
+    unsigned	     dropped;	/* Messages dropped since last report.	*/
+    pj_bool_t	     quit;
+    pj_sem_t	    *sem;
+    pj_thread_t	    *thread;
+} log_async;
+
+static log_async *async_log;
+
+/* Number of pj_log() calls which may be using async_log. */
+static unsigned async_users;
+
+/* Set in the writer thread, which writes its own messages directly. */
+static __thread pj_bool_t is_log_writer;
+#endif	/* LOG_ASYNC */
+
 #if PJ_HAS_THREADS
 static void logging_shutdown(void)
 {
@@ -313,30 +357,17 @@ static pj_bool_t is_logging_suspended(void)
     }
 }
 
-PJ_DEF(void) pj_log( const char *sender, int level, 
-		     const char *format, va_list marker)
+/* Format the message with its decoration to log_buffer, which size is
+ * buf_size. Logging must be suspended for the calling thread. Returns the
+ * length of the message, level is set to 1 if it can not be formatted.
+ */
+static int log_format(char *log_buffer, int buf_size, const char *sender,
+		      int *level, const char *format, va_list marker)
 {
     pj_time_val now;
     pj_parsed_time ptime;
     char *pre;
-#if PJ_LOG_USE_STACK_BUFFER
-    char log_buffer[PJ_LOG_MAX_SIZE];
-#endif
-    int saved_level, len, print_len, indent;
-
-    PJ_CHECK_STACK();
-
-    if (level > pj_log_max_level)
-	return;
-
-    if (is_logging_suspended())
-	return;
-
-    /* Temporarily disable logging for this thread. Some of PJLIB APIs that
-     * this function calls below will recursively call the logging function 
-     * back, hence it will cause infinite recursive calls if we allow that.
-     */
-    suspend_logging(&saved_level);
+    int len, print_len, indent;
 
     /* Get current date/time. */
     pj_gettimeofday(&now);
@@ -346,7 +377,7 @@ PJ_DEF(void) pj_log( const char *sender, int level,
     if (log_decor & PJ_LOG_HAS_LEVEL_TEXT) {
 	static const char *ltexts[] = { "FATAL:", "ERROR:", " WARN:", 
 			      " INFO:", "DEBUG:", "TRACE:", "DETRC:"};
-	pj_ansi_strcpy(pre, ltexts[level]);
+	pj_ansi_strcpy(pre, ltexts[*level]);
 	pre += 6;
     }
     if (log_decor & PJ_LOG_HAS_DAY_NAME) {
@@ -439,18 +470,17 @@ PJ_DEF(void) pj_log( const char *sender, int level,
     len = (int)(pre - log_buffer);
 
     /* Print the whole message to the string log_buffer. */
-    print_len = pj_ansi_vsnprintf(pre, sizeof(log_buffer)-len, format, 
-				  marker);
+    print_len = pj_ansi_vsnprintf(pre, buf_size-len, format, marker);
     if (print_len < 0) {
-	level = 1;
-	print_len = pj_ansi_snprintf(pre, sizeof(log_buffer)-len, 
+	*level = 1;
+	print_len = pj_ansi_snprintf(pre, buf_size-len, 
 				     "<logging error: msg too long>");
     }
-    if (print_len < 1 || print_len >= (int)(sizeof(log_buffer)-len)) {
-	print_len = sizeof(log_buffer) - len - 1;
+    if (print_len < 1 || print_len >= buf_size-len) {
+	print_len = buf_size - len - 1;
     }
     len = len + print_len;
-    if (len > 0 && len < (int)sizeof(log_buffer)-2) {
+    if (len > 0 && len < buf_size-2) {
 	if (log_decor & PJ_LOG_HAS_CR) {
 	    log_buffer[len++] = '\r';
 	}
@@ -459,15 +489,219 @@ PJ_DEF(void) pj_log( const char *sender, int level,
 	}
 	log_buffer[len] = '\0';
     } else {
-	len = sizeof(log_buffer)-1;
+	len = buf_size-1;
 	if (log_decor & PJ_LOG_HAS_CR) {
-	    log_buffer[sizeof(log_buffer)-3] = '\r';
+	    log_buffer[buf_size-3] = '\r';
 	}
 	if (log_decor & PJ_LOG_HAS_NEWLINE) {
-	    log_buffer[sizeof(log_buffer)-2] = '\n';
+	    log_buffer[buf_size-2] = '\n';
+	}
+	log_buffer[buf_size-1] = '\0';
+    }
+
+    return len;
+}
+
+#if LOG_ASYNC
+/* Claim the slot for the next queue position, or count the message as
+ * dropped when the queue is full.
+ */
+static log_slot *async_claim(log_async *q, unsigned *p_pos)
+{
+    unsigned pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+	log_slot *slot = &q->slots[pos & q->mask];
+	unsigned seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+	int dif = (int)(seq - pos);
+
+	if (dif == 0) {
+	    /* On failure pos is updated to the current tail */
+	    if (__atomic_compare_exchange_n(&q->tail, &pos, pos+1, PJ_TRUE,
+					    __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+	    {
+		*p_pos = pos;
+		return slot;
+	    }
+	} else if (dif < 0) {
+	    /* The slot still holds the message of the previous round */
+	    __atomic_add_fetch(&q->dropped, 1, __ATOMIC_RELAXED);
+	    return NULL;
+	} else {
+	    pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	}
+    }
+}
+
+/* Write all complete messages, in queue order */
+static void async_drain(log_async *q)
+{
+    unsigned dropped;
+
+    for (;;) {
+	log_slot *slot = &q->slots[q->head & q->mask];
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != q->head+1)
+	    break;
+
+	if (log_writer)
+	    (*log_writer)(slot->level, slot->buf, slot->len);
+
+	__atomic_store_n(&slot->seq, q->head + q->mask + 1, __ATOMIC_RELEASE);
+	++q->head;
+    }
+
+    dropped = __atomic_exchange_n(&q->dropped, 0, __ATOMIC_RELAXED);
+    if (dropped) {
+	PJ_LOG(2,("log.c", "%u log message(s) dropped, queue is full",
+		  dropped));
+    }
+}
+
+static int async_writer_thread(void *arg)
+{
+    log_async *q = (log_async*) arg;
+
+    is_log_writer = PJ_TRUE;
+
+    while (!q->quit) {
+	pj_sem_wait(q->sem);
+	async_drain(q);
+    }
+
+    /* Messages completed after the last wake up */
+    async_drain(q);
+    return 0;
+}
+
+PJ_DEF(pj_status_t) pj_log_start_async(pj_pool_t *pool, unsigned max_msg)
+{
+    log_async *q;
+    unsigned i, count;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(pool, PJ_EINVAL);
+    PJ_ASSERT_RETURN(async_log == NULL, PJ_EINVALIDOP);
+
+    if (max_msg == 0)
+	max_msg = PJ_LOG_ASYNC_MAX_MSG;
+
+    /* Round up to power of two, positions are masked into the array */
+    for (count = 2; count < max_msg && count < 0x10000; count <<= 1)
+	;
+
+    q = PJ_POOL_ZALLOC_T(pool, log_async);
+    q->slots = (log_slot*) pj_pool_calloc(pool, count, sizeof(log_slot));
+    q->mask = count - 1;
+    for (i = 0; i < count; ++i)
+	q->slots[i].seq = i;
+
+    status = pj_sem_create(pool, "logsem", 0, count, &q->sem);
+    if (status != PJ_SUCCESS)
+	return status;
+
+    status = pj_thread_create(pool, "logwriter", &async_writer_thread, q,
+			      0, 0, &q->thread);
+    if (status != PJ_SUCCESS) {
+	pj_sem_destroy(q->sem);
+	return status;
+    }
+
+    __atomic_store_n(&async_log, q, __ATOMIC_RELEASE);
+    return PJ_SUCCESS;
+}
+
+PJ_DEF(void) pj_log_stop_async(void)
+{
+    log_async *q = async_log;
+
+    if (q == NULL)
+	return;
+
+    /* Wait for the producers which may have seen the queue. Those which
+     * come later see NULL, as async_users is incremented before async_log
+     * is read.
+     */
+    __atomic_store_n(&async_log, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&async_users, __ATOMIC_SEQ_CST) != 0)
+	pj_thread_sleep(0);
+
+    q->quit = PJ_TRUE;
+    pj_sem_post(q->sem);
+    pj_thread_join(q->thread);
+    pj_thread_destroy(q->thread);
+    pj_sem_destroy(q->sem);
+}
+
+#else	/* LOG_ASYNC */
+
+PJ_DEF(pj_status_t) pj_log_start_async(pj_pool_t *pool, unsigned max_msg)
+{
+    PJ_UNUSED_ARG(pool);
+    PJ_UNUSED_ARG(max_msg);
+    return PJ_ENOTSUP;
+}
+
+PJ_DEF(void) pj_log_stop_async(void)
+{
+}
+
+#endif	/* LOG_ASYNC */
+
+PJ_DEF(void) pj_log( const char *sender, int level, 
+		     const char *format, va_list marker)
+{
+#if PJ_LOG_USE_STACK_BUFFER
+    char log_buffer[PJ_LOG_MAX_SIZE];
+#endif
+#if LOG_ASYNC
+    log_async *q;
+#endif
+    int saved_level, len;
+
+    PJ_CHECK_STACK();
+
+    if (level > pj_log_max_level)
+	return;
+
+    if (is_logging_suspended())
+	return;
+
+    /* Temporarily disable logging for this thread. Some of PJLIB APIs that
+     * this function calls below will recursively call the logging function 
+     * back, hence it will cause infinite recursive calls if we allow that.
+     */
+    suspend_logging(&saved_level);
+
+#if LOG_ASYNC
+    /* Format into a queue slot and leave the writing to the writer thread.
+     * The message is formatted here since the arguments may not outlive
+     * this call.
+     */
+    __atomic_add_fetch(&async_users, 1, __ATOMIC_SEQ_CST);
+    q = __atomic_load_n(&async_log, __ATOMIC_SEQ_CST);
+    if (q && !is_log_writer) {
+	log_slot *slot;
+	unsigned pos;
+
+	slot = async_claim(q, &pos);
+	if (slot) {
+	    slot->len = log_format(slot->buf, sizeof(slot->buf), sender,
+				   &level, format, marker);
+	    slot->level = level;
+	    __atomic_store_n(&slot->seq, pos+1, __ATOMIC_RELEASE);
+	    pj_sem_post(q->sem);
 	}
-	log_buffer[sizeof(log_buffer)-1] = '\0';
+	__atomic_sub_fetch(&async_users, 1, __ATOMIC_RELEASE);
+	resume_logging(&saved_level);
+	return;
     }
+    __atomic_sub_fetch(&async_users, 1, __ATOMIC_RELEASE);
+#endif
+
+    len = log_format(log_buffer, sizeof(log_buffer), sender, &level,
+		     format, marker);
 
     /* It should be safe to resume logging at this point. Application can
      * recursively call the logging function inside the callback.
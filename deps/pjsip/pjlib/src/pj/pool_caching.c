@@ -49,6 +49,49 @@ static pj_size_t pool_sizes[PJ_CACHING_POOL_ARRAY_SIZE] =
  */
 #define START_SIZE  5
 
+/* Per-thread cache of a caching pool. The free lists are filled and
+ * emptied by the owning thread, and emptied by the other threads when the
+ * cache has been idle. The used list may also be modified by other
+ * threads releasing a pool created by the owner. The cache of an idle
+ * thread which has no pool left may be taken over by a new thread, since
+ * the owner may have exited. Everything is protected by the lock of the
+ * cache, so a cache that still turns out to be shared by two threads is
+ * only less efficient. The lock order is the caching pool lock first,
+ * then the thread cache lock.
+ */
+typedef struct thread_cache
+{
+    PJ_DECL_LIST_MEMBER(struct thread_cache);
+
+    /* Capacity of the pools in the free lists, and number of used pools */
+    pj_size_t	    capacity;
+    pj_size_t	    used_count;
+
+    /* Capacity reserved in the caching pool for the free lists, which is
+     * at least the capacity. Only changed with both locks held.
+     */
+    pj_size_t	    quota;
+
+    /* The stamp is incremented on each use of the cache, the sweep of the
+     * idle caches compares it with the stamp of the previous sweep.
+     */
+    unsigned	    stamp;
+    unsigned	    swept_stamp;
+
+    /* Emptied by a sweep, and may be taken over by another thread */
+    pj_bool_t	    idle;
+
+    /* Lists of pools in the cache, indexed by pool size */
+    unsigned	    free_cnt[PJ_CACHING_POOL_ARRAY_SIZE];
+    pj_list	    free_list[PJ_CACHING_POOL_ARRAY_SIZE];
+
+    /* List of pools created by this thread and not yet released */
+    pj_list	    used_list;
+
+    char	    pool_buf[256 * (sizeof(size_t) / 4)];
+    pj_lock_t	   *lock;
+} thread_cache;
+
 
 PJ_DEF(void) pj_caching_pool_init( pj_caching_pool *cp, 
 				   const pj_pool_factory_policy *policy,
@@ -79,20 +122,27 @@ PJ_DEF(void) pj_caching_pool_init( pj_caching_pool *cp,
 
     pool = pj_pool_create_on_buf("cachingpool", cp->pool_buf, sizeof(cp->pool_buf));
     pj_lock_create_simple_mutex(pool, "cachingpool", &cp->lock);
+
+    /* Per-thread caches are only used when pools may be kept at all */
+    cp->tls_id = -1;
+    pj_list_init(&cp->thread_caches);
+#if PJ_CACHING_POOL_THREAD_CACHE
+    if (max_capacity && pj_thread_local_alloc(&cp->tls_id) != PJ_SUCCESS)
+	cp->tls_id = -1;
+#endif
 }
 
-PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
+/* Destroy the pools in the free lists and used list */
+static void destroy_lists(pj_list free_list[], pj_list *used_list)
 {
     int i;
     pj_pool_t *pool;
 
-    PJ_CHECK_STACK();
-
     /* Delete all pool in free list */
     for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
 	pj_pool_t *next;
-	pool = (pj_pool_t*) cp->free_list[i].next;
-	for (; pool != (void*)&cp->free_list[i]; pool = next) {
+	pool = (pj_pool_t*) free_list[i].next;
+	for (; pool != (void*)&free_list[i]; pool = next) {
 	    next = pool->next;
 	    pj_list_erase(pool);
 	    pj_pool_destroy_int(pool);
@@ -100,8 +150,8 @@ PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
     }
 
     /* Delete all pools in used list */
-    pool = (pj_pool_t*) cp->used_list.next;
-    while (pool != (pj_pool_t*) &cp->used_list) {
+    pool = (pj_pool_t*) used_list->next;
+    while (pool != (pj_pool_t*) used_list) {
 	pj_pool_t *next = pool->next;
 	pj_list_erase(pool);
 	PJ_LOG(4,(pool->obj_name, 
@@ -109,6 +159,32 @@ PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
 	pj_pool_destroy_int(pool);
 	pool = next;
     }
+}
+
+PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
+{
+    thread_cache *tc;
+
+    PJ_CHECK_STACK();
+
+    destroy_lists(cp->free_list, &cp->used_list);
+
+    /* Delete the per-thread caches */
+    tc = (thread_cache*) cp->thread_caches.next;
+    while (tc != (thread_cache*) &cp->thread_caches) {
+	thread_cache *next = tc->next;
+	pj_list_erase(tc);
+	destroy_lists(tc->free_list, &tc->used_list);
+	pj_lock_destroy(tc->lock);
+	(*cp->factory.policy.block_free)(&cp->factory, tc, sizeof(*tc));
+	tc = next;
+    }
+
+    if (cp->tls_id != -1) {
+	pj_thread_local_set(cp->tls_id, NULL);
+	pj_thread_local_free(cp->tls_id);
+	cp->tls_id = -1;
+    }
 
     if (cp->lock) {
 	pj_lock_destroy(cp->lock);
@@ -116,6 +192,209 @@ PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
     }
 }
 
+/* Take over an idle cache for the calling thread. Returns NULL if none. */
+static thread_cache *adopt_idle_cache(pj_caching_pool *cp)
+{
+    thread_cache *tc;
+
+    pj_lock_acquire(cp->lock);
+
+    for (tc = (thread_cache*) cp->thread_caches.next;
+	 tc != (thread_cache*) &cp->thread_caches;
+	 tc = tc->next)
+    {
+	pj_bool_t adopted = PJ_FALSE;
+
+	pj_lock_acquire(tc->lock);
+	if (tc->idle && tc->stamp == tc->swept_stamp && tc->used_count == 0 &&
+	    pj_thread_local_set(cp->tls_id, tc) == PJ_SUCCESS)
+	{
+	    tc->idle = PJ_FALSE;
+	    ++tc->stamp;
+	    adopted = PJ_TRUE;
+	}
+	pj_lock_release(tc->lock);
+
+	if (adopted)
+	    break;
+    }
+
+    pj_lock_release(cp->lock);
+
+    return tc != (thread_cache*) &cp->thread_caches ? tc : NULL;
+}
+
+/* Get the cache of the calling thread, taking over an idle one or
+ * creating one on first use. Returns NULL when per-thread caching is not
+ * used.
+ */
+static thread_cache *get_thread_cache(pj_caching_pool *cp)
+{
+    thread_cache *tc;
+    pj_pool_t *pool;
+    int i;
+
+    if (cp->tls_id == -1)
+	return NULL;
+
+    tc = (thread_cache*) pj_thread_local_get(cp->tls_id);
+    if (tc)
+	return tc;
+
+    tc = adopt_idle_cache(cp);
+    if (tc)
+	return tc;
+
+    tc = (thread_cache*)
+	 (*cp->factory.policy.block_alloc)(&cp->factory, sizeof(*tc));
+    if (!tc)
+	return NULL;
+
+    pj_bzero(tc, sizeof(*tc));
+    pj_list_init(&tc->used_list);
+    for (i=0; i<PJ_CACHING_POOL_ARRAY_SIZE; ++i)
+	pj_list_init(&tc->free_list[i]);
+
+    pool = pj_pool_create_on_buf("cpoolthread", tc->pool_buf,
+				 sizeof(tc->pool_buf));
+    if (!pool ||
+	pj_lock_create_simple_mutex(pool, "cpoolthread",
+				    &tc->lock) != PJ_SUCCESS)
+    {
+	(*cp->factory.policy.block_free)(&cp->factory, tc, sizeof(*tc));
+	return NULL;
+    }
+
+    if (pj_thread_local_set(cp->tls_id, tc) != PJ_SUCCESS) {
+	pj_lock_destroy(tc->lock);
+	(*cp->factory.policy.block_free)(&cp->factory, tc, sizeof(*tc));
+	return NULL;
+    }
+
+    pj_lock_acquire(cp->lock);
+    pj_list_insert_before(&cp->thread_caches, tc);
+    pj_lock_release(cp->lock);
+
+    return tc;
+}
+
+/* Move the least recently used pool of a free list of the thread cache
+ * back to the caching pool, or destroy it if the caching pool is full.
+ * Called with both locks held.
+ */
+static void return_pool(pj_caching_pool *cp, thread_cache *tc, int idx)
+{
+    pj_pool_t *pool = (pj_pool_t*) tc->free_list[idx].prev;
+    pj_size_t pool_capacity = pj_pool_get_capacity(pool);
+
+    pj_list_erase(pool);
+    --tc->free_cnt[idx];
+    tc->capacity -= pool_capacity;
+    tc->quota -= pool_capacity;
+    cp->thread_capacity -= pool_capacity;
+
+    if (cp->capacity + cp->thread_capacity + pool_capacity >
+	cp->max_capacity)
+    {
+	pj_pool_destroy_int(pool);
+    } else {
+	pj_list_insert_after(&cp->free_list[idx], pool);
+	cp->capacity += pool_capacity;
+    }
+}
+
+/* Empty the caches which haven't been used since the previous sweep,
+ * except the cache of the calling thread, so that the pools of threads
+ * which have become idle or have exited are not held forever. Called
+ * with the caching pool lock held.
+ */
+static void sweep_idle_caches(pj_caching_pool *cp, thread_cache *self)
+{
+    thread_cache *tc;
+    int i;
+
+    for (tc = (thread_cache*) cp->thread_caches.next;
+	 tc != (thread_cache*) &cp->thread_caches;
+	 tc = tc->next)
+    {
+	if (tc == self)
+	    continue;
+
+	pj_lock_acquire(tc->lock);
+
+	if (tc->stamp != tc->swept_stamp) {
+	    tc->swept_stamp = tc->stamp;
+	} else if (!tc->idle) {
+	    for (i=0; i<PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
+		while (tc->free_cnt[i])
+		    return_pool(cp, tc, i);
+	    }
+	    cp->thread_capacity -= tc->quota;
+	    tc->quota = 0;
+	    tc->idle = (tc->used_count == 0);
+	}
+
+	pj_lock_release(tc->lock);
+    }
+}
+
+/* Move the pools exceeding half of the per-thread limit back to the
+ * caching pool, or destroy them if it's full, then empty the idle caches.
+ */
+static void rebalance_thread_cache(pj_caching_pool *cp, thread_cache *tc,
+				   int idx)
+{
+    pj_lock_acquire(cp->lock);
+
+    pj_lock_acquire(tc->lock);
+    while (tc->free_cnt[idx] > PJ_CACHING_POOL_THREAD_CACHE / 2)
+	return_pool(cp, tc, idx);
+    pj_lock_release(tc->lock);
+
+    sweep_idle_caches(cp, tc);
+
+    pj_lock_release(cp->lock);
+}
+
+/* Keep a released pool in the thread cache, after reserving its capacity
+ * in the caching pool. If the caching pool is full, the idle caches are
+ * emptied first, and the pool is destroyed if there's still no room.
+ * Returns the number of free pools of that size in the thread cache.
+ */
+static unsigned reserve_and_keep(pj_caching_pool *cp, thread_cache *tc,
+				 pj_pool_t *pool, int idx)
+{
+    pj_size_t pool_capacity = pj_pool_get_capacity(pool);
+    unsigned free_cnt = 0;
+
+    pj_lock_acquire(cp->lock);
+
+    if (cp->capacity + cp->thread_capacity + pool_capacity >
+	cp->max_capacity)
+    {
+	sweep_idle_caches(cp, tc);
+    }
+
+    pj_lock_acquire(tc->lock);
+    if (cp->capacity + cp->thread_capacity + pool_capacity >
+	cp->max_capacity)
+    {
+	pj_pool_destroy_int(pool);
+    } else {
+	cp->thread_capacity += pool_capacity;
+	tc->quota += pool_capacity;
+	pj_list_insert_after(&tc->free_list[idx], pool);
+	free_cnt = ++tc->free_cnt[idx];
+	tc->capacity += pool_capacity;
+	tc->idle = PJ_FALSE;
+	++tc->stamp;
+    }
+    pj_lock_release(tc->lock);
+
+    pj_lock_release(cp->lock);
+    return free_cnt;
+}
+
 static pj_pool_t* cpool_create_pool(pj_pool_factory *pf, 
 					      const char *name, 
 					      pj_size_t initial_size, 
@@ -123,13 +402,12 @@ static pj_pool_t* cpool_create_pool(pj_pool_factory *pf,
 					      pj_pool_callback *callback)
 {
     pj_caching_pool *cp = (pj_caching_pool*)pf;
+    thread_cache *tc;
     pj_pool_t *pool;
     int idx;
 
     PJ_CHECK_STACK();
 
-    pj_lock_acquire(cp->lock);
-
     /* Use pool factory's policy when callback is NULL */
     if (callback == NULL) {
 	callback = pf->policy.callback;
@@ -154,6 +432,38 @@ static pj_pool_t* cpool_create_pool(pj_pool_factory *pf,
 	    ;
     }
 
+    /* Try the cache of this thread first, which doesn't need the caching
+     * pool lock.
+     */
+    tc = get_thread_cache(cp);
+    if (tc && idx < PJ_CACHING_POOL_ARRAY_SIZE) {
+	pj_lock_acquire(tc->lock);
+
+	if (!pj_list_empty(&tc->free_list[idx])) {
+	    pool = (pj_pool_t*) tc->free_list[idx].next;
+	    pj_list_erase(pool);
+	    --tc->free_cnt[idx];
+	    tc->capacity -= pj_pool_get_capacity(pool);
+
+	    pj_pool_init_int(pool, name, increment_sz, callback);
+
+	    pj_list_insert_before(&tc->used_list, pool);
+	    pool->factory_data = tc;
+	    ++tc->used_count;
+	    ++tc->stamp;
+
+	    pj_lock_release(tc->lock);
+
+	    PJ_LOG(6, (pool->obj_name, "pool reused, size=%u",
+		       pool->capacity));
+	    return pool;
+	}
+
+	pj_lock_release(tc->lock);
+    }
+
+    pj_lock_acquire(cp->lock);
+
     /* Check whether there's a pool in the list. */
     if (idx==PJ_CACHING_POOL_ARRAY_SIZE || pj_list_empty(&cp->free_list[idx])) {
 	/* No pool is available. */
@@ -187,14 +497,49 @@ static pj_pool_t* cpool_create_pool(pj_pool_factory *pf,
 	PJ_LOG(6, (pool->obj_name, "pool reused, size=%u", pool->capacity));
     }
 
-    /* Put in used list. */
-    pj_list_insert_before( &cp->used_list, pool );
+    if (tc) {
+	pj_lock_acquire(tc->lock);
+
+	/* Refill the thread cache with a batch of pools of this size, so
+	 * that the next creations don't need the caching pool lock.
+	 */
+	while (idx < PJ_CACHING_POOL_ARRAY_SIZE &&
+	       tc->free_cnt[idx] < PJ_CACHING_POOL_THREAD_CACHE / 2 &&
+	       !pj_list_empty(&cp->free_list[idx]))
+	{
+	    pj_pool_t *p = (pj_pool_t*) cp->free_list[idx].next;
+	    pj_size_t pool_capacity = pj_pool_get_capacity(p);
+
+	    pj_list_erase(p);
+	    if (cp->capacity > pool_capacity) {
+		cp->capacity -= pool_capacity;
+	    } else {
+		cp->capacity = 0;
+	    }
+	    pj_list_insert_before(&tc->free_list[idx], p);
+	    ++tc->free_cnt[idx];
+	    tc->capacity += pool_capacity;
+	    tc->quota += pool_capacity;
+	    cp->thread_capacity += pool_capacity;
+	}
+
+	/* Put in the used list of the thread. */
+	pj_list_insert_before(&tc->used_list, pool);
+	pool->factory_data = tc;
+	++tc->used_count;
+	tc->idle = PJ_FALSE;
+	++tc->stamp;
 
-    /* Mark factory data */
-    pool->factory_data = (void*) (pj_ssize_t) idx;
+	pj_lock_release(tc->lock);
 
-    /* Increment used count. */
-    ++cp->used_count;
+    } else {
+	/* Put in used list. */
+	pj_list_insert_before( &cp->used_list, pool );
+	pool->factory_data = NULL;
+
+	/* Increment used count. */
+	++cp->used_count;
+    }
 
     pj_lock_release(cp->lock);
     return pool;
@@ -203,18 +548,32 @@ static pj_pool_t* cpool_create_pool(pj_pool_factory *pf,
 static void cpool_release_pool( pj_pool_factory *pf, pj_pool_t *pool)
 {
     pj_caching_pool *cp = (pj_caching_pool*)pf;
+    thread_cache *owner, *tc;
+    pj_lock_t *lock;
     pj_size_t pool_capacity;
-    unsigned i;
+    int i;
 
     PJ_CHECK_STACK();
 
     PJ_ASSERT_ON_FAIL(pf && pool, return);
 
-    pj_lock_acquire(cp->lock);
+    /* Get it before taking any lock, as it may need the caching pool lock */
+    tc = get_thread_cache(cp);
+
+    /* The pool is in the used list of the thread which created it, or in
+     * the caching pool used list.
+     */
+    owner = (thread_cache*) pool->factory_data;
+    lock = owner ? owner->lock : cp->lock;
+
+    pj_lock_acquire(lock);
 
 #if PJ_SAFE_POOL
     /* Make sure pool is still in our used list */
-    if (pj_list_find_node(&cp->used_list, pool) != pool) {
+    if (pj_list_find_node(owner ? &owner->used_list : &cp->used_list,
+			  pool) != pool)
+    {
+	pj_lock_release(lock);
 	pj_assert(!"Attempt to destroy pool that has been destroyed before");
 	return;
     }
@@ -224,19 +583,17 @@ static void cpool_release_pool( pj_pool_factory *pf, pj_pool_t *pool)
     pj_list_erase(pool);
 
     /* Decrement used count. */
-    --cp->used_count;
+    if (owner)
+	--owner->used_count;
+    else
+	--cp->used_count;
 
     pool_capacity = pj_pool_get_capacity(pool);
 
-    /* Destroy the pool if the size is greater than our size or if the total
-     * capacity in our recycle list (plus the size of the pool) exceeds 
-     * maximum capacity.
-   . */
-    if (pool_capacity > pool_sizes[PJ_CACHING_POOL_ARRAY_SIZE-1] ||
-	cp->capacity + pool_capacity > cp->max_capacity)
-    {
+    /* Destroy the pool if the size is greater than our size. */
+    if (pool_capacity > pool_sizes[PJ_CACHING_POOL_ARRAY_SIZE-1]) {
 	pj_pool_destroy_int(pool);
-	pj_lock_release(cp->lock);
+	pj_lock_release(lock);
 	return;
     }
 
@@ -246,51 +603,135 @@ static void cpool_release_pool( pj_pool_factory *pf, pj_pool_t *pool)
 	       pj_pool_get_used_size(pool)*100/pool_capacity));
     pj_pool_reset(pool);
 
-    pool_capacity = pj_pool_get_capacity(pool);
-
-    /*
-     * Otherwise put the pool in our recycle list.
+    /* After reset, the capacity is the initial size of the pool, which
+     * tells the free list where the pool belongs.
      */
-    i = (unsigned) (unsigned long) (pj_ssize_t) pool->factory_data;
+    pool_capacity = pj_pool_get_capacity(pool);
+    for (i=0; i<PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
+	if (pool_sizes[i] == pool_capacity)
+	    break;
+    }
 
     pj_assert(i<PJ_CACHING_POOL_ARRAY_SIZE);
     if (i >= PJ_CACHING_POOL_ARRAY_SIZE ) {
 	/* Something has gone wrong with the pool. */
+	pj_pool_destroy_int(pool);
+	pj_lock_release(lock);
+	return;
+    }
+
+    /* Keep the pool in the cache of this thread, within the capacity it
+     * has reserved, and give the excess back to the caching pool.
+     */
+    if (tc) {
+	unsigned free_cnt = 0;
+
+	if (lock != tc->lock) {
+	    pj_lock_release(lock);
+	    pj_lock_acquire(tc->lock);
+	}
+
+	if (tc->capacity + pool_capacity <= tc->quota) {
+	    pj_list_insert_after(&tc->free_list[i], pool);
+	    free_cnt = ++tc->free_cnt[i];
+	    tc->capacity += pool_capacity;
+	    ++tc->stamp;
+	    pool = NULL;
+	}
+
+	pj_lock_release(tc->lock);
+
+	if (pool)
+	    free_cnt = reserve_and_keep(cp, tc, pool, i);
+
+	if (free_cnt > PJ_CACHING_POOL_THREAD_CACHE)
+	    rebalance_thread_cache(cp, tc, i);
+	return;
+    }
+
+    if (lock != cp->lock) {
+	pj_lock_release(lock);
+	pj_lock_acquire(cp->lock);
+    }
+
+    /* Destroy the pool if the total capacity in our recycle list and the
+     * per-thread caches (plus the size of the pool) exceeds maximum
+     * capacity.
+     */
+    if (cp->capacity + cp->thread_capacity + pool_capacity >
+	cp->max_capacity)
+    {
 	pj_pool_destroy_int(pool);
 	pj_lock_release(cp->lock);
 	return;
     }
 
+    /*
+     * Otherwise put the pool in our recycle list.
+     */
     pj_list_insert_after(&cp->free_list[i], pool);
     cp->capacity += pool_capacity;
 
     pj_lock_release(cp->lock);
 }
 
+#if PJ_LOG_MAX_LEVEL >= 3
+/* Dump the pools in a used list */
+static void dump_used_list(pj_list *used_list, pj_size_t *total_used,
+			   pj_size_t *total_capacity)
+{
+    pj_pool_t *pool = (pj_pool_t*) used_list->next;
+
+    while (pool != (void*)used_list) {
+	pj_size_t pool_capacity = pj_pool_get_capacity(pool);
+	PJ_LOG(3,("cachpool", "   %16s: %8d of %8d (%d%%) used", 
+			      pj_pool_getobjname(pool), 
+			      pj_pool_get_used_size(pool), 
+			      pool_capacity,
+			      pj_pool_get_used_size(pool)*100/pool_capacity));
+	*total_used += pj_pool_get_used_size(pool);
+	*total_capacity += pool_capacity;
+	pool = pool->next;
+    }
+}
+#endif
+
 static void cpool_dump_status(pj_pool_factory *factory, pj_bool_t detail )
 {
 #if PJ_LOG_MAX_LEVEL >= 3
     pj_caching_pool *cp = (pj_caching_pool*)factory;
+    pj_size_t capacity, used_count;
+    thread_cache *tc;
 
     pj_lock_acquire(cp->lock);
 
+    /* Include the pools held in the per-thread caches */
+    capacity = cp->capacity;
+    used_count = cp->used_count;
+    for (tc = (thread_cache*) cp->thread_caches.next;
+	 tc != (thread_cache*) &cp->thread_caches;
+	 tc = tc->next)
+    {
+	pj_lock_acquire(tc->lock);
+	capacity += tc->capacity;
+	used_count += tc->used_count;
+	pj_lock_release(tc->lock);
+    }
+
     PJ_LOG(3,("cachpool", " Dumping caching pool:"));
     PJ_LOG(3,("cachpool", "   Capacity=%u, max_capacity=%u, used_cnt=%u", \
-			     cp->capacity, cp->max_capacity, cp->used_count));
+			     capacity, cp->max_capacity, used_count));
     if (detail) {
-	pj_pool_t *pool = (pj_pool_t*) cp->used_list.next;
 	pj_size_t total_used = 0, total_capacity = 0;
         PJ_LOG(3,("cachpool", "  Dumping all active pools:"));
-	while (pool != (void*)&cp->used_list) {
-	    pj_size_t pool_capacity = pj_pool_get_capacity(pool);
-	    PJ_LOG(3,("cachpool", "   %16s: %8d of %8d (%d%%) used", 
-				  pj_pool_getobjname(pool), 
-				  pj_pool_get_used_size(pool), 
-				  pool_capacity,
-				  pj_pool_get_used_size(pool)*100/pool_capacity));
-	    total_used += pj_pool_get_used_size(pool);
-	    total_capacity += pool_capacity;
-	    pool = pool->next;
+	dump_used_list(&cp->used_list, &total_used, &total_capacity);
+	for (tc = (thread_cache*) cp->thread_caches.next;
+	     tc != (thread_cache*) &cp->thread_caches;
+	     tc = tc->next)
+	{
+	    pj_lock_acquire(tc->lock);
+	    dump_used_list(&tc->used_list, &total_used, &total_capacity);
+	    pj_lock_release(tc->lock);
 	}
 	if (total_capacity) {
 	    PJ_LOG(3,("cachpool", "  Total %9d of %9d (%d %%) used!",
@@ -1269,6 +1269,11 @@ PJ_DEF(pj_uint16_t) pj_SO_REUSEADDR(void)
     return PJ_SO_REUSEADDR;
 }
 
+PJ_DEF(pj_uint16_t) pj_SO_REUSEPORT(void)
+{
+    return PJ_SO_REUSEPORT;
+}
+
 PJ_DEF(pj_uint16_t) pj_SO_NOSIGPIPE(void)
 {
     return PJ_SO_NOSIGPIPE;
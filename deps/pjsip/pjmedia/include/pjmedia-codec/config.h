@@ -139,6 +139,23 @@
 #endif
 
 
+/**
+ * Number of initialized Opus encoder states, and as many decoder states,
+ * that the Opus codec factory keeps for reuse. Opening a codec takes a
+ * state with the same clock rate and channel count from this pool and
+ * resets it instead of allocating and initializing a new one, and closing
+ * the codec returns the state to the pool, evicting the least recently
+ * used one when the pool is full. The pool is filled with states for the
+ * default clock rate when the codec is initialized, so that the first
+ * calls do not pay for the setup either. Set to zero to disable the pool.
+ *
+ * Default: 8
+ */
+#ifndef PJMEDIA_CODEC_OPUS_WARM_POOL_SIZE
+#   define PJMEDIA_CODEC_OPUS_WARM_POOL_SIZE	8
+#endif
+
+
 /**
  * Enable Passthrough codecs.
  *
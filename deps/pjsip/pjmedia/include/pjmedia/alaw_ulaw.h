@@ -140,72 +140,50 @@ PJ_DECL(unsigned char) pjmedia_ulaw2alaw(unsigned char uval);
 #endif
 
 /**
- * Encode 16-bit linear PCM data to 8-bit U-Law data.
+ * Encode 16-bit linear PCM data to 8-bit U-Law data. The data may be
+ * encoded in place, i.e. dst may be the same buffer as src.
  *
  * @param dst	    Destination buffer for 8-bit U-Law data.
  * @param src	    Source, 16-bit linear PCM data.
  * @param count	    Number of samples.
  */
-PJ_INLINE(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
-				    pj_size_t count)
-{
-    const pj_int16_t *end = src + count;
-    
-    while (src < end) {
-	*dst++ = pjmedia_linear2ulaw(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
+				  pj_size_t count);
 
 /**
- * Encode 16-bit linear PCM data to 8-bit A-Law data.
+ * Encode 16-bit linear PCM data to 8-bit A-Law data. The data may be
+ * encoded in place, i.e. dst may be the same buffer as src.
  *
  * @param dst	    Destination buffer for 8-bit A-Law data.
  * @param src	    Source, 16-bit linear PCM data.
  * @param count	    Number of samples.
  */
-PJ_INLINE(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
-				    pj_size_t count)
-{
-    const pj_int16_t *end = src + count;
-    
-    while (src < end) {
-	*dst++ = pjmedia_linear2alaw(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
+				  pj_size_t count);
 
 /**
- * Decode 8-bit U-Law data to 16-bit linear PCM data.
+ * Decode 8-bit U-Law data to 16-bit linear PCM data. The data may be
+ * decoded in place when it is at the end of the destination buffer,
+ * i.e. src is (pj_uint8_t*)dst + len.
  *
  * @param dst	    Destination buffer for 16-bit PCM data.
  * @param src	    Source, 8-bit U-Law data.
  * @param len	    Encoded frame/source length in bytes.
  */
-PJ_INLINE(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
-				    pj_size_t len)
-{
-    const pj_uint8_t *end = src + len;
-    
-    while (src < end) {
-	*dst++ = pjmedia_ulaw2linear(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
+				  pj_size_t len);
 
 /**
- * Decode 8-bit A-Law data to 16-bit linear PCM data.
+ * Decode 8-bit A-Law data to 16-bit linear PCM data. The data may be
+ * decoded in place when it is at the end of the destination buffer,
+ * i.e. src is (pj_uint8_t*)dst + len.
  *
  * @param dst	    Destination buffer for 16-bit PCM data.
  * @param src	    Source, 8-bit A-Law data.
  * @param len	    Encoded frame/source length in bytes.
  */
-PJ_INLINE(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
-				    pj_size_t len)
-{
-    const pj_uint8_t *end = src + len;
-    
-    while (src < end) {
-	*dst++ = pjmedia_alaw2linear(*src++);
-    }
-}
+PJ_DECL(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
+				  pj_size_t len);
 
 PJ_END_DECL
 
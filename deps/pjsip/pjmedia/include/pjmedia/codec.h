@@ -180,6 +180,15 @@ PJ_BEGIN_DECL
  * intrinsic PLC, PJMEDIA will suply the PLC implementation from the
  * @ref PJMED_PLC implementation.
  *
+ * Codecs which carry forward error correction data of the previous frame
+ * in their packets (such as Opus in-band FEC) may also implement
+ * <tt>recover_fec</tt>, which recovers a missing frame from the frame
+ * following it.
+ *
+ * Codecs which keep state between frames may implement <tt>reset_enc</tt>,
+ * so that a stream can transmit the payload encoded by another stream for
+ * a while, and encode again from a clean state afterwards.
+ *
  * @subsection close_codec Closing and Releasing the Codec
  *
  * The codec must be closed by calling <tt>close</tt> member of the codec's
@@ -485,6 +494,43 @@ typedef struct pjmedia_codec_op
     pj_status_t (*recover)(pjmedia_codec *codec,
 			   unsigned out_size,
 			   struct pjmedia_frame *output);
+
+    /**
+     * Instruct the codec to recover a missing frame from the forward error
+     * correction data in the frame following it. This is optional and may
+     * be NULL.
+     *
+     * Application should call #pjmedia_codec_recover_fec() instead of 
+     * calling this function directly.
+     *
+     * @param codec	The codec instance.
+     * @param next	The frame following the missing frame, as returned
+     *			by #parse(). It is not decoded.
+     * @param out_size	The length of buffer in the output frame, which
+     *			must be the size of exactly one frame.
+     * @param output	The output frame where the recovered signal
+     *			will be placed.
+     *
+     * @return		PJ_SUCCESS on success, or PJ_ENOTSUP if the
+     *			frame can't be recovered from the next frame.
+     */
+    pj_status_t (*recover_fec)(pjmedia_codec *codec,
+			       const struct pjmedia_frame *next,
+			       unsigned out_size,
+			       struct pjmedia_frame *output);
+
+    /**
+     * Reset the state of the encoder, as if it had not encoded any frame
+     * yet, keeping its settings. This is optional and may be NULL.
+     *
+     * Application should call #pjmedia_codec_reset_enc() instead of 
+     * calling this function directly.
+     *
+     * @param codec	The codec instance.
+     *
+     * @return		PJ_SUCCESS on success.
+     */
+    pj_status_t (*reset_enc)(pjmedia_codec *codec);
 } pjmedia_codec_op;
 
 
@@ -1115,6 +1161,53 @@ PJ_INLINE(pj_status_t) pjmedia_codec_recover( pjmedia_codec *codec,
 }
 
 
+/**
+ * Instruct the codec to recover a missing frame from the forward error
+ * correction data in the frame following it.
+ *
+ * @param codec		The codec instance.
+ * @param next		The frame following the missing frame.
+ * @param out_size	The length of buffer in the output frame, which
+ *			must be the size of exactly one frame.
+ * @param output	The output frame where the recovered signal
+ *			will be placed.
+ *
+ * @return		PJ_SUCCESS on success, or PJ_ENOTSUP if the codec
+ *			doesn't support this or the frame can't be
+ *			recovered from the next frame.
+ */
+PJ_INLINE(pj_status_t) pjmedia_codec_recover_fec(
+					pjmedia_codec *codec,
+					const struct pjmedia_frame *next,
+					unsigned out_size,
+					struct pjmedia_frame *output )
+{
+    if (codec->op && codec->op->recover_fec)
+	return (*codec->op->recover_fec)(codec, next, out_size, output);
+    else
+	return PJ_ENOTSUP;
+}
+
+
+/**
+ * Reset the state of the encoder, as if it had not encoded any frame yet.
+ * This is needed before encoding again with a codec which keeps state
+ * between frames, when the frames in between were not encoded by it.
+ *
+ * @param codec		The codec instance.
+ *
+ * @return		PJ_SUCCESS on success, or PJ_ENOTSUP if the codec
+ *			doesn't support this.
+ */
+PJ_INLINE(pj_status_t) pjmedia_codec_reset_enc( pjmedia_codec *codec )
+{
+    if (codec->op && codec->op->reset_enc)
+	return (*codec->op->reset_enc)(codec);
+    else
+	return PJ_ENOTSUP;
+}
+
+
 /**
  * @}
  */
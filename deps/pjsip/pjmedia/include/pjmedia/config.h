@@ -75,6 +75,41 @@
 #endif
 
 
+/**
+ * Specify whether the conference bridge should encode the audio only once
+ * for stream ports that receive exactly the same mix, and use the same
+ * codec settings (see #pjmedia_stream_put_frame_shared()). This saves the
+ * redundant encoding when many streams listen to the same source, such as
+ * an announcement or a listen-only conference. Only codecs which keep no
+ * state between frames (PCMU and PCMA), or whose encoder can be reset
+ * (Opus), share, see #pjmedia_stream_can_share_enc(). The ports need not
+ * run at the clock rate of the bridge, but their frames must last as long
+ * as the bridge's.
+ *
+ * Default: 1
+ */
+#ifndef PJMEDIA_CONF_SHARE_ENCODING
+#   define PJMEDIA_CONF_SHARE_ENCODING	    1
+#endif
+
+
+/**
+ * Specify whether the conference bridge should relay the received payload
+ * of a stream port to the stream port listening to it, instead of decoding
+ * and encoding it again, when these two only talk to each other and use
+ * the same codec settings (see #pjmedia_stream_relay_frame()). Audio is
+ * mixed as usual again as soon as another port joins either of them, or
+ * the level of either of them is adjusted. The signal levels of relayed
+ * ports are reported as zero. The two ports need not run at the clock
+ * rate of the bridge, but their frames must last as long as the bridge's.
+ *
+ * Default: 1
+ */
+#ifndef PJMEDIA_CONF_RELAY_ENCODED
+#   define PJMEDIA_CONF_RELAY_ENCODED	    1
+#endif
+
+
 /*
  * Types of sound stream backends.
  */
@@ -231,6 +266,37 @@
 #endif
 
 
+/**
+ * Specify whether the pitch search of WSOLA (used by the PLC, and when
+ * expanding or compressing audio) may compute the correlation with SSE2
+ * (and AVX2 when the CPU has it) on x86 or NEON on ARM, when the compiler
+ * targets them. This applies to both the floating point and fixed point
+ * builds of PJMEDIA_WSOLA_IMP_WSOLA. The vectorized correlation is exact
+ * integer arithmetic, so it may differ slightly from the floating point
+ * one when two positions correlate almost equally.
+ *
+ * Default: 1
+ */
+#ifndef PJMEDIA_WSOLA_USE_SIMD
+#   define PJMEDIA_WSOLA_USE_SIMD	    1
+#endif
+
+
+/**
+ * Specify the step, in samples, of the coarse pitch search of WSOLA. When
+ * this is greater than one, the correlation is first computed at every
+ * step samples of the search range, then at every sample around the best
+ * of those only. This takes about (range/step + 2*step) correlations
+ * instead of range, at the risk of missing a narrow correlation peak
+ * between two coarse positions. Value 1 searches every position.
+ *
+ * Default: 1
+ */
+#ifndef PJMEDIA_WSOLA_SEARCH_STEP
+#   define PJMEDIA_WSOLA_SEARCH_STEP	    1
+#endif
+
+
 /**
  * Limit the number of calls by stream to the PLC to generate synthetic
  * frames to this duration. If packets are still lost after this maximum
@@ -276,6 +342,20 @@
 #endif
 
 
+/**
+ * Specify whether the block A-law/U-law conversion functions, such as
+ * #pjmedia_ulaw_encode(), may use SSE2 on x86 or NEON on ARM, when the
+ * compiler targets them. The results are the same as those of the
+ * A-law/U-law table, so this is only used when
+ * PJMEDIA_HAS_ALAW_ULAW_TABLE is enabled.
+ *
+ * Default: 1
+ */
+#ifndef PJMEDIA_ALAW_ULAW_USE_SIMD
+#   define PJMEDIA_ALAW_ULAW_USE_SIMD	    1
+#endif
+
+
 /**
  * Unless specified otherwise, G711 codec is included by default.
  */
@@ -375,6 +455,27 @@
 #endif
 
 
+/**
+ * Default size of each of the two buffers of file writer port created
+ * with PJMEDIA_FILE_WRITE_ASYNC flag. The buffers hold 16 bit samples,
+ * the default is 4 seconds of 8KHz mono audio.
+ */
+#ifndef PJMEDIA_FILE_WRITER_ASYNC_BUFSIZE
+#   define PJMEDIA_FILE_WRITER_ASYNC_BUFSIZE	65536
+#endif
+
+
+/**
+ * Maximum size of the audio data of a file played with PJMEDIA_FILE_SHARED
+ * flag. Larger files are played from the file as if the flag was not
+ * given. Cached G.711 data takes twice this size once decoded. Default is
+ * 4MB, about 4 minutes of 8KHz mono PCM audio.
+ */
+#ifndef PJMEDIA_WAV_PLAYER_SHARED_MAX_SIZE
+#   define PJMEDIA_WAV_PLAYER_SHARED_MAX_SIZE	(4 * 1024 * 1024)
+#endif
+
+
 /**
  * Maximum frame duration (in msec) to be supported.
  * This (among other thing) will affect the size of buffers to be allocated
@@ -582,6 +683,41 @@
 #endif
 
 
+/**
+ * Packet loss rate, in percent, above which the stream holds one extra
+ * frame in the jitter buffer, so that a lost frame can be recovered from
+ * the forward error correction data of the packet following it (for codecs
+ * that support it, such as Opus). The extra frame is released again when
+ * the loss rate drops below half of this value. The loss rate is measured
+ * over periods of about five seconds.
+ *
+ * Without the extra frame, the recovery only happens when the next packet
+ * already happens to be in the jitter buffer.
+ *
+ * Use zero to never add the extra frame.
+ *
+ * Default: 3
+ */
+#ifndef PJMEDIA_STREAM_FEC_LOSS_THRESHOLD
+#   define PJMEDIA_STREAM_FEC_LOSS_THRESHOLD	3
+#endif
+
+
+/**
+ * Enable adaptive playout in the stream. The stream then keeps its delay
+ * close to the burst level learnt by the jitter buffer by time-scaling the
+ * decoded audio with WSOLA: it is compressed, a few milliseconds per frame,
+ * while the jitter buffer holds more frames than needed, and stretched
+ * while it holds fewer. The jitter buffer itself no longer discards frames
+ * to reduce the delay. This only applies to streams that decode the audio.
+ *
+ * Default: 0
+ */
+#ifndef PJMEDIA_STREAM_ADAPTIVE_PLAYOUT
+#   define PJMEDIA_STREAM_ADAPTIVE_PLAYOUT	0
+#endif
+
+
 /**
  * Specify the maximum duration of silence period in the codec, in msec. 
  * This is useful for example to keep NAT binding open in the firewall
@@ -26,6 +26,7 @@
  * @brief Echo Cancellation  API.
  */
 #include <pjmedia/types.h>
+#include <pj/math.h>
 
 
 
@@ -112,6 +113,32 @@ typedef enum pjmedia_echo_flag
 } pjmedia_echo_flag;
 
 
+/**
+ * Processing time statistics of an echo canceller, as returned by
+ * #pjmedia_echo_get_stat().
+ */
+typedef struct pjmedia_echo_stat
+{
+    /**
+     * Name of the backend echo canceller algorithm.
+     */
+    const char	    *name;
+
+    /**
+     * Number of samples in each frame.
+     */
+    unsigned	     samples_per_frame;
+
+    /**
+     * Time spent cancelling the echo of each captured frame, in
+     * microseconds, since the echo canceller was created. The number of
+     * frames processed is in the n field.
+     */
+    pj_math_stat     proc_time;
+
+} pjmedia_echo_stat;
+
+
 
 
 /**
@@ -255,6 +282,21 @@ PJ_DECL(pj_status_t) pjmedia_echo_cancel( pjmedia_echo_state *echo,
 					  void *reserved );
 
 
+/**
+ * Get the processing time statistics of the echo canceller. The time of
+ * every frame processed by #pjmedia_echo_capture() or
+ * #pjmedia_echo_cancel() is accounted, whichever backend algorithm is
+ * used.
+ *
+ * @param echo		The Echo Canceller.
+ * @param p_stat	Pointer to receive the statistics.
+ *
+ * @return		PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_echo_get_stat(pjmedia_echo_state *echo,
+					   pjmedia_echo_stat *p_stat);
+
+
 PJ_END_DECL
 
 /**
@@ -216,6 +216,25 @@ PJ_DECL(pj_status_t) pjmedia_jbuf_set_discard(pjmedia_jbuf *jb,
 					      pjmedia_jb_discard_algo algo);
 
 
+/**
+ * Set the number of frames that the jitter buffer keeps in addition to
+ * the delay it needs for the jitter, so that the frames following a
+ * missing frame are usually already available for
+ * #pjmedia_jbuf_peek_frame() when the missing frame is returned, e.g. to
+ * recover it from the forward error correction data of the next packet.
+ * Increasing the lookahead delays the frames by the added number of
+ * frames, for which prefetch frames are returned. Decreasing it lets the
+ * discard algorithm shrink the jitter buffer gradually. The default is 0.
+ *
+ * @param jb		The jitter buffer.
+ * @param lookahead	Number of frames.
+ *
+ * @return		PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_jbuf_set_lookahead(pjmedia_jbuf *jb,
+						unsigned lookahead);
+
+
 /**
  * Destroy jitter buffer instance.
  *
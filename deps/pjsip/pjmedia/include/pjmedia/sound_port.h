@@ -26,6 +26,7 @@
  */
 #include <pjmedia-audiodev/audiodev.h>
 #include <pjmedia/clock.h>
+#include <pjmedia/echo.h>
 #include <pjmedia/port.h>
 
 PJ_BEGIN_DECL
@@ -339,6 +340,20 @@ pjmedia_snd_port_get_clock_src( pjmedia_snd_port *snd_port,
 PJ_DECL(pj_status_t) pjmedia_snd_port_reset_ec_state(pjmedia_snd_port *snd_port);
 
 
+/**
+ * Get the processing time statistics of the software echo canceller of
+ * the sound port. See #pjmedia_echo_get_stat().
+ *
+ * @param snd_port	    The sound device port.
+ * @param p_stat	    Pointer to receive the statistics.
+ *
+ * @return		    PJ_SUCCESS on success, or PJ_ENOTFOUND if the
+ *			    sound port does not use software echo canceller.
+ */
+PJ_DECL(pj_status_t) pjmedia_snd_port_get_ec_stat(pjmedia_snd_port *snd_port,
+						  pjmedia_echo_stat *p_stat);
+
+
 /**
  * Connect a port to the sound device port. If the sound device port has a
  * sound recorder device, then this will start periodic function call to
@@ -231,6 +231,87 @@ PJ_DECL(pj_status_t) pjmedia_stream_get_port(pjmedia_stream *stream,
 					     pjmedia_port **p_port );
 
 
+/**
+ * Check whether the stream can transmit the payload encoded by another
+ * stream, i.e. whether both use the same codec with the same settings, so
+ * that they would encode the same audio to the same payload. This is only
+ * allowed for codecs which keep no state between frames (PCMU and PCMA),
+ * or whose encoder can be reset (see #pjmedia_codec_reset_enc()), since
+ * the stream does not run its own encoder on the shared frames. The
+ * encoder of the stream is reset when it encodes again.
+ *
+ * @param stream	The media stream.
+ * @param enc_src	The stream whose payload would be transmitted.
+ *
+ * @return		PJ_TRUE if the payload can be shared.
+ */
+PJ_DECL(pj_bool_t) pjmedia_stream_can_share_enc(const pjmedia_stream *stream,
+						const pjmedia_stream *enc_src);
+
+
+/**
+ * Transmit a frame, reusing the payload that \a enc_src has just encoded
+ * instead of encoding the frame. The frame must have the same timestamp
+ * and samples as the last frame given to the port of \a enc_src, and the
+ * streams must be able to share their payload (see
+ * #pjmedia_stream_can_share_enc()). If \a enc_src did not transmit an
+ * encoded frame for it (for example because it sent DTMF or was paused),
+ * the frame is encoded as with the put_frame() of the stream port.
+ *
+ * This lets a mixer that sends the same audio to many streams encode it
+ * only once. The RTP sequence, timestamp and marker of each stream are
+ * still maintained separately.
+ *
+ * @param stream	The media stream.
+ * @param enc_src	The stream that has just encoded the frame.
+ * @param frame		The frame to transmit.
+ *
+ * @return		PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_stream_put_frame_shared(pjmedia_stream *stream,
+						     pjmedia_stream *enc_src,
+						     pjmedia_frame *frame);
+
+
+/**
+ * Check whether the payload received by the stream can be transmitted
+ * as is by another stream, i.e. whether the received packets can be
+ * relayed with #pjmedia_stream_relay_frame() instead of being decoded by
+ * the stream and encoded again by \a dst.
+ *
+ * @param stream	The media stream receiving the payload.
+ * @param dst		The media stream that would transmit it.
+ *
+ * @return		PJ_TRUE if the payload can be relayed.
+ */
+PJ_DECL(pj_bool_t) pjmedia_stream_can_relay(const pjmedia_stream *stream,
+					    const pjmedia_stream *dst);
+
+
+/**
+ * Take the next frame from the jitter buffer of the stream, as the
+ * get_frame() of the stream port would, but instead of decoding it,
+ * transmit its payload with \a dst, as the put_frame() of the port of
+ * \a dst would transmit an encoded frame. When the frame is not complete
+ * in the jitter buffer, or its payload does not fit in the packet of
+ * \a dst, \a dst transmits nothing, as with silence.
+ *
+ * This is meant for two party calls using the same codec (see
+ * #pjmedia_stream_can_relay()), and is called instead of the get_frame()
+ * of the stream and the put_frame() of \a dst. The decoder of the stream
+ * and the encoder of \a dst are not run meanwhile.
+ *
+ * @param stream	The media stream receiving the payload.
+ * @param dst		The media stream transmitting it.
+ * @param ts		The timestamp of the frame for \a dst.
+ *
+ * @return		PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjmedia_stream_relay_frame(pjmedia_stream *stream,
+						pjmedia_stream *dst,
+						const pj_timestamp *ts);
+
+
 /**
  * Get the media transport object associated with this stream.
  *
@@ -47,7 +47,18 @@ enum pjmedia_file_player_option
      * Tell the file player to return NULL frame when the whole
      * file has been played.
      */
-    PJMEDIA_FILE_NO_LOOP = 1
+    PJMEDIA_FILE_NO_LOOP = 1,
+
+    /**
+     * Play the samples from a process wide cache, shared by all players
+     * of the same file that were created with this flag. The file is read
+     * and decoded once, when the first of these players is created, and
+     * the cached samples are released with the last one. Playback then
+     * does no file I/O at all. Files with more than
+     * PJMEDIA_WAV_PLAYER_SHARED_MAX_SIZE bytes of audio data are played
+     * from the file as usual.
+     */
+    PJMEDIA_FILE_SHARED = 2
 };
 
 
@@ -204,6 +215,17 @@ enum pjmedia_file_writer_option
      * Tell the file writer to save the audio in G711 Alaw format.
      */
     PJMEDIA_FILE_WRITE_ULAW = 2,
+
+    /**
+     * Tell the file writer to write the file from a writer thread, and
+     * may be combined with one of the formats above. The port then has
+     * two buffers: put_frame() fills one, while the writer thread encodes
+     * and writes the other, so that the thread calling put_frame() never
+     * waits for the disk. When the writer thread falls behind and no
+     * buffer is free, frames are dropped and counted, see
+     * #pjmedia_wav_writer_port_get_overruns().
+     */
+    PJMEDIA_FILE_WRITE_ASYNC = 16
 };
 
 
@@ -225,7 +247,9 @@ enum pjmedia_file_writer_option
  *			    #pjmedia_file_writer_option.
  * @param buff_size	    Buffer size to be allocated. If the value is 
  *			    zero or negative, the port will use default buffer
- *			    size (which is about 4KB).
+ *			    size (which is about 4KB, or
+ *			    PJMEDIA_FILE_WRITER_ASYNC_BUFSIZE for each of the
+ *			    two buffers with PJMEDIA_FILE_WRITE_ASYNC).
  * @param p_port	    Pointer to receive the file port instance.
  *
  * @return		    PJ_SUCCESS on success.
@@ -255,6 +279,18 @@ PJ_DECL(pj_status_t) pjmedia_wav_writer_port_create(pj_pool_t *pool,
 PJ_DECL(pj_ssize_t) pjmedia_wav_writer_port_get_pos( pjmedia_port *port );
 
 
+/**
+ * Get the number of frames dropped by a writer port created with
+ * PJMEDIA_FILE_WRITE_ASYNC flag, because the writer thread has not
+ * finished writing the previous buffer yet.
+ *
+ * @param port		The file writer port.
+ *
+ * @return		The number of dropped frames.
+ */
+PJ_DECL(unsigned) pjmedia_wav_writer_port_get_overruns( pjmedia_port *port );
+
+
 /**
  * Register the callback to be called when the file writing has reached
  * certain size. Application can use this callback, for example, to limit
@@ -83,6 +83,11 @@ static pj_status_t opus_codec_decode(pjmedia_codec *codec,
 static pj_status_t opus_codec_recover(pjmedia_codec *codec,
 				      unsigned output_buf_len,
 				      struct pjmedia_frame *output);
+static pj_status_t opus_codec_recover_fec(pjmedia_codec *codec,
+					  const struct pjmedia_frame *next,
+					  unsigned output_buf_len,
+					  struct pjmedia_frame *output);
+static pj_status_t opus_codec_reset_enc(pjmedia_codec *codec);
 
 /* Definition for OPUS codec operations. */
 static pjmedia_codec_op opus_op = {
@@ -93,7 +98,9 @@ static pjmedia_codec_op opus_op = {
     &opus_codec_parse,
     &opus_codec_encode,
     &opus_codec_decode,
-    &opus_codec_recover
+    &opus_codec_recover,
+    &opus_codec_recover_fec,
+    &opus_codec_reset_enc
 };
 
 /* Definition for OPUS codec factory operations. */
@@ -106,6 +113,21 @@ static pjmedia_codec_factory_op opus_factory_op = {
     &pjmedia_codec_opus_deinit
 };
 
+/* Kinds of libopus states. */
+enum opus_state_type {
+	OPUS_STATE_ENC,
+	OPUS_STATE_DEC
+};
+
+/* Initialized libopus encoder or decoder state, in its own pool. */
+struct opus_state {
+	PJ_DECL_LIST_MEMBER(struct opus_state);
+	pj_pool_t *pool;
+	int clock_rate;
+	unsigned channel_cnt;
+	void *st; /* OpusEncoder or OpusDecoder */
+};
+
 /* OPUS factory private data */
 static struct opus_factory {
 	pjmedia_codec_factory base;
@@ -113,6 +135,8 @@ static struct opus_factory {
 	pj_pool_t *pool;
 	pj_mutex_t *mutex;
 	pjmedia_codec codec_list;
+	struct opus_state states[2];    /* Warm states, most recent first. */
+	unsigned state_cnt[2];
 } opus_factory;
 
 /* OPUS codec private data. */
@@ -123,9 +147,11 @@ struct opus_private {
     int externalFs; /* Clock rate we would like to limit from outside */
 
     pj_bool_t enc_ready;
+    struct opus_state *enc_state;
     OpusEncoder* psEnc;
 
     pj_bool_t dec_ready;
+    struct opus_state *dec_state;
     OpusDecoder* psDec;
 
     /* Buffer of 120ms to hold decoded frames. */
@@ -194,9 +220,121 @@ void apply_opus_codec_params(pj_pool_t* pool, pjmedia_codec_param *attr) {
 	}
 }
 
+/*
+ * Allocate and initialize a new encoder or decoder state.
+ */
+static pj_status_t opus_state_create(enum opus_state_type type, int clock_rate, unsigned channel_cnt, struct opus_state **p_state) {
+	struct opus_state *state;
+	pj_pool_t *pool;
+	unsigned size;
+	int ret;
+
+	if (type == OPUS_STATE_ENC)
+		size = opus_encoder_get_size(channel_cnt);
+	else
+		size = opus_decoder_get_size(channel_cnt);
+	if (size == 0)
+		return PJ_EINVAL;
+
+	pool = pjmedia_endpt_create_pool(opus_factory.endpt, (type == OPUS_STATE_ENC ? "opusenc" : "opusdec"), sizeof(struct opus_state) + size + 64, 512);
+	if (!pool)
+		return PJ_ENOMEM;
+
+	state = PJ_POOL_ZALLOC_T(pool, struct opus_state);
+	state->pool = pool;
+	state->clock_rate = clock_rate;
+	state->channel_cnt = channel_cnt;
+	state->st = pj_pool_zalloc(pool, size);
+
+	if (type == OPUS_STATE_ENC)
+		ret = opus_encoder_init((OpusEncoder*) state->st, clock_rate, channel_cnt, OPUS_APPLICATION_AUDIO);
+	else
+		ret = opus_decoder_init((OpusDecoder*) state->st, clock_rate, channel_cnt);
+	if (ret) {
+		PJ_LOG(1, (THIS_FILE, "Unable to init %s : %d", (type == OPUS_STATE_ENC ? "encoder" : "decoder"), ret));
+		pj_pool_release(pool);
+		return PJ_EINVAL;
+	}
+
+	*p_state = state;
+	return PJ_SUCCESS;
+}
+
+/*
+ * Get a state for the clock rate and channel count, resetting a warm one
+ * if there is any.
+ */
+static pj_status_t opus_state_get(enum opus_state_type type, int clock_rate, unsigned channel_cnt, struct opus_state **p_state) {
+	struct opus_state *list = &opus_factory.states[type];
+	struct opus_state *state;
+
+	pj_mutex_lock(opus_factory.mutex);
+	for (state = list->next; state != list; state = state->next) {
+		if (state->clock_rate == clock_rate && state->channel_cnt == channel_cnt) {
+			pj_list_erase(state);
+			--opus_factory.state_cnt[type];
+			break;
+		}
+	}
+	pj_mutex_unlock(opus_factory.mutex);
+
+	if (state == list)
+		return opus_state_create(type, clock_rate, channel_cnt, p_state);
+
+	/* The encoder keeps its settings across the reset, the caller sets
+	 * all of them again.
+	 */
+	if (type == OPUS_STATE_ENC)
+		opus_encoder_ctl((OpusEncoder*) state->st, OPUS_RESET_STATE);
+	else
+		opus_decoder_ctl((OpusDecoder*) state->st, OPUS_RESET_STATE);
+
+	*p_state = state;
+	return PJ_SUCCESS;
+}
+
+/*
+ * Return a state to the warm pool, destroying the least recently used one
+ * if the pool is full.
+ */
+static void opus_state_put(enum opus_state_type type, struct opus_state *state) {
+	struct opus_state *list = &opus_factory.states[type];
+
+	pj_mutex_lock(opus_factory.mutex);
+	pj_list_push_front(list, state);
+	if (opus_factory.state_cnt[type] < PJMEDIA_CODEC_OPUS_WARM_POOL_SIZE) {
+		++opus_factory.state_cnt[type];
+		state = NULL;
+	} else {
+		state = list->prev;
+		pj_list_erase(state);
+	}
+	pj_mutex_unlock(opus_factory.mutex);
+
+	if (state)
+		pj_pool_release(state->pool);
+}
+
+/*
+ * Destroy the warm states.
+ */
+static void opus_state_clear(void) {
+	unsigned i;
+
+	for (i = 0; i < PJ_ARRAY_SIZE(opus_factory.states); ++i) {
+		while (!pj_list_empty(&opus_factory.states[i])) {
+			struct opus_state *state = opus_factory.states[i].next;
+			pj_list_erase(state);
+			pj_pool_release(state->pool);
+		}
+		opus_factory.state_cnt[i] = 0;
+	}
+}
+
 PJ_DEF(pj_status_t) pjmedia_codec_opus_init(pjmedia_endpt *endpt) {
 	pjmedia_codec_mgr *codec_mgr;
 	pj_status_t status;
+	unsigned i;
 
 	if (opus_factory.endpt != NULL) {
 		/* Already initialized. */
@@ -215,6 +353,10 @@ PJ_DEF(pj_status_t) pjmedia_codec_opus_init(pjmedia_endpt *endpt) {
 
 	/* Init list */
 	pj_list_init(&opus_factory.codec_list);
+	pj_list_init(&opus_factory.states[OPUS_STATE_ENC]);
+	pj_list_init(&opus_factory.states[OPUS_STATE_DEC]);
+	opus_factory.state_cnt[OPUS_STATE_ENC] = 0;
+	opus_factory.state_cnt[OPUS_STATE_DEC] = 0;
 
 	/* Create mutex. */
 	status = pj_mutex_create_simple(opus_factory.pool, "opus codecs", &opus_factory.mutex);
@@ -223,10 +365,26 @@ PJ_DEF(pj_status_t) pjmedia_codec_opus_init(pjmedia_endpt *endpt) {
 
 	PJ_LOG(5, (THIS_FILE, "Init opus"));
 
+	/* Fill the warm pool with states for the default settings. */
+	for (i = 0; i < PJMEDIA_CODEC_OPUS_WARM_POOL_SIZE; ++i) {
+		struct opus_state *enc, *dec;
+
+		if (opus_state_create(OPUS_STATE_ENC, OPUS_CLOCK_RATE, 1, &enc) != PJ_SUCCESS)
+			break;
+		if (opus_state_create(OPUS_STATE_DEC, OPUS_CLOCK_RATE, 1, &dec) != PJ_SUCCESS) {
+			pj_pool_release(enc->pool);
+			break;
+		}
+		opus_state_put(OPUS_STATE_ENC, enc);
+		opus_state_put(OPUS_STATE_DEC, dec);
+	}
+
 	/* Get the codec manager. */
 	codec_mgr = pjmedia_endpt_get_codec_mgr(endpt);
-	if (!codec_mgr)
-		return PJ_EINVALIDOP;
+	if (!codec_mgr) {
+		status = PJ_EINVALIDOP;
+		goto on_error;
+	}
 
 
 	PJ_LOG(5, (THIS_FILE, "Init opus > DONE"));
@@ -234,11 +392,12 @@ PJ_DEF(pj_status_t) pjmedia_codec_opus_init(pjmedia_endpt *endpt) {
 	/* Register codec factory to endpoint. */
 	status = pjmedia_codec_mgr_register_factory(codec_mgr, &opus_factory.base);
 	if (status != PJ_SUCCESS)
-		return status;
+		goto on_error;
 
 	return PJ_SUCCESS;
 
 on_error:
+	opus_state_clear();
 	if (opus_factory.mutex) {
 		pj_mutex_destroy(opus_factory.mutex);
 		opus_factory.mutex = NULL;
@@ -279,6 +438,19 @@ PJ_DEF(pj_status_t) pjmedia_codec_opus_deinit(void) {
 	status = pjmedia_codec_mgr_unregister_factory(codec_mgr, &opus_factory.base);
 	opus_factory.endpt = NULL;
 
+	/* Destroy the warm states and the pools of the free codecs. */
+	opus_state_clear();
+	while (!pj_list_empty(&opus_factory.codec_list)) {
+		pjmedia_codec *codec = opus_factory.codec_list.next;
+		struct opus_private *opus = (struct opus_private*) codec->codec_data;
+
+		pj_list_erase(codec);
+		if (opus->pool) {
+			pj_pool_release(opus->pool);
+			opus->pool = NULL;
+		}
+	}
+
 	/* Destroy mutex. */
         pj_mutex_unlock(opus_factory.mutex);
 	pj_mutex_destroy(opus_factory.mutex);
@@ -418,7 +590,7 @@ static pj_status_t opus_alloc_codec(pjmedia_codec_factory *factory, const pjmedi
 		PJ_ASSERT_RETURN(codec != NULL, PJ_ENOMEM);
 		codec->op = &opus_op;
 		codec->factory = factory;
-		codec->codec_data = pj_pool_alloc(opus_factory.pool, sizeof(struct opus_private));
+		codec->codec_data = pj_pool_zalloc(opus_factory.pool, sizeof(struct opus_private));
 	}
 
 	pj_mutex_unlock(opus_factory.mutex);
@@ -427,8 +599,16 @@ static pj_status_t opus_alloc_codec(pjmedia_codec_factory *factory, const pjmedi
 	opus->enc_ready = PJ_FALSE;
 	opus->dec_ready = PJ_FALSE;
 
-	/* Create pool for codec instance */
-	opus->pool = pjmedia_endpt_create_pool(opus_factory.endpt, "opuscodec", 512, 512);
+	/* Create pool for codec instance, it's kept with the recycled codec */
+	if (!opus->pool) {
+		opus->pool = pjmedia_endpt_create_pool(opus_factory.endpt, "opuscodec", 512, 512);
+		if (!opus->pool) {
+			pj_mutex_lock(opus_factory.mutex);
+			pj_list_push_front(&opus_factory.codec_list, codec);
+			pj_mutex_unlock(opus_factory.mutex);
+			return PJ_ENOMEM;
+		}
+	}
 
 	*p_codec = codec;
 	return PJ_SUCCESS;
@@ -455,9 +635,6 @@ static pj_status_t opus_dealloc_codec(pjmedia_codec_factory *factory, pjmedia_co
 	pj_list_push_front(&opus_factory.codec_list, codec);
 	pj_mutex_unlock(opus_factory.mutex);
 
-	pj_pool_release(opus->pool);
-	opus->pool = NULL;
-
 	return PJ_SUCCESS;
 }
 
@@ -480,8 +657,10 @@ static pj_status_t opus_codec_open(pjmedia_codec *codec, pjmedia_codec_param *at
 	const pj_str_t STR_FMTP_USE_DTX = { "usedtx", 6 };
 
 	struct opus_private *opus;
-	int ret, tmpFmtpVal;
-	unsigned i, structSizeBytes, max_nsamples;
+	int tmpFmtpVal;
+	unsigned i, max_nsamples;
+	pj_size_t dec_buf_size;
+	pj_status_t status;
 
 	opus = (struct opus_private*) codec->codec_data;
 
@@ -491,22 +670,24 @@ static pj_status_t opus_codec_open(pjmedia_codec *codec, pjmedia_codec_param *at
         opus->externalFs = attr->info.clock_rate;
 
 	/* Create Encoder */
-	structSizeBytes = opus_encoder_get_size(attr->info.channel_cnt);
-	opus->psEnc = pj_pool_zalloc(opus->pool, structSizeBytes);
-	ret = opus_encoder_init(opus->psEnc, opus->externalFs, attr->info.channel_cnt, OPUS_APPLICATION_AUDIO);
-	if (ret) {
-		PJ_LOG(1, (THIS_FILE, "Unable to init encoder : %d", ret));
-		return PJ_EINVAL;
-	}
+	status = opus_state_get(OPUS_STATE_ENC, opus->externalFs, attr->info.channel_cnt, &opus->enc_state);
+	if (status != PJ_SUCCESS)
+		return status;
+	opus->psEnc = (OpusEncoder*) opus->enc_state->st;
 
 	/*
-	 * Set Encoder parameters
+	 * Set Encoder parameters. A reused encoder keeps the settings of its
+	 * previous codec, so the defaults of those set from fmtp below are
+	 * set as well.
 	 * TODO : have it configurable
 	 */
 	opus_encoder_ctl(opus->psEnc, OPUS_SET_COMPLEXITY(10));
 	opus_encoder_ctl(opus->psEnc, OPUS_SET_INBAND_FEC(1)); /* on by default */
 	opus_encoder_ctl(opus->psEnc, OPUS_SET_PACKET_LOSS_PERC(5));
 	opus_encoder_ctl(opus->psEnc, OPUS_SET_SIGNAL(OPUS_AUTO));
+	opus_encoder_ctl(opus->psEnc, OPUS_SET_BITRATE(OPUS_AUTO));
+	opus_encoder_ctl(opus->psEnc, OPUS_SET_MAX_BANDWIDTH(OPUS_BANDWIDTH_FULLBAND));
+	opus_encoder_ctl(opus->psEnc, OPUS_SET_DTX(0));
 
 	/* Apply fmtp params to Encoder */
 	for (i = 0; i < attr->setting.enc_fmtp.cnt; ++i) {
@@ -543,17 +724,22 @@ static pj_status_t opus_codec_open(pjmedia_codec *codec, pjmedia_codec_param *at
 	/* Decoder buffer */
 	opus->pcm_bytes_per_sample = attr->info.pcm_bits_per_sample / 8;
 	max_nsamples = 120 * OPUS_CLOCK_RATE / 1000; /* 120ms is max frame time */
-	opus->dec_buf_max_size = max_nsamples * opus->pcm_bytes_per_sample;
-	opus->dec_buf = pj_pool_alloc(opus->pool, opus->dec_buf_max_size);
+	dec_buf_size = max_nsamples * opus->pcm_bytes_per_sample;
+	if (!opus->dec_buf || opus->dec_buf_max_size != dec_buf_size) {
+		opus->dec_buf_max_size = dec_buf_size;
+		opus->dec_buf = pj_pool_alloc(opus->pool, opus->dec_buf_max_size);
+	}
 
 	/* Create decoder */
-	structSizeBytes = opus_decoder_get_size(attr->info.channel_cnt);
-	opus->psDec = pj_pool_zalloc(opus->pool, structSizeBytes);
-	ret = opus_decoder_init(opus->psDec, opus->externalFs, attr->info.channel_cnt);
-	if (ret) {
-		PJ_LOG(1, (THIS_FILE, "Unable to init decoder : %d", ret));
-		return PJ_EINVAL;
+	status = opus_state_get(OPUS_STATE_DEC, opus->externalFs, attr->info.channel_cnt, &opus->dec_state);
+	if (status != PJ_SUCCESS) {
+		opus_state_put(OPUS_STATE_ENC, opus->enc_state);
+		opus->enc_state = NULL;
+		opus->psEnc = NULL;
+		opus->enc_ready = PJ_FALSE;
+		return status;
 	}
+	opus->psDec = (OpusDecoder*) opus->dec_state->st;
 
 	opus->dec_ready = PJ_TRUE;
 
@@ -570,6 +756,18 @@ static pj_status_t opus_codec_close(pjmedia_codec *codec) {
 	opus->enc_ready = PJ_FALSE;
 	opus->dec_ready = PJ_FALSE;
 
+	/* Return the states to the warm pool */
+	if (opus->enc_state) {
+		opus_state_put(OPUS_STATE_ENC, opus->enc_state);
+		opus->enc_state = NULL;
+		opus->psEnc = NULL;
+	}
+	if (opus->dec_state) {
+		opus_state_put(OPUS_STATE_DEC, opus->dec_state);
+		opus->dec_state = NULL;
+		opus->psDec = NULL;
+	}
+
 	PJ_LOG(5, (THIS_FILE, "OPUS codec closed"));
 	return PJ_SUCCESS;
 }
@@ -759,4 +957,54 @@ static pj_status_t opus_codec_recover(pjmedia_codec *codec, unsigned output_buf_
 	return PJ_SUCCESS;
 }
 
+/*
+ * Recover lost frame from the in-band FEC data of the next packet.
+ */
+static pj_status_t opus_codec_recover_fec(pjmedia_codec *codec, const struct pjmedia_frame *next, unsigned output_buf_len, struct pjmedia_frame *output) {
+	struct opus_private *opus;
+	int ret;
+
+	PJ_ASSERT_RETURN(codec && next && output, PJ_EINVAL);
+	opus = (struct opus_private*) codec->codec_data;
+
+	/* The FEC data of a packet is for the frame preceding the packet,
+	 * i.e. preceding its first frame.
+	 */
+	if ((next->bit_info & 0xFF) != 0)
+		return PJ_ENOTSUP;
+
+	/* Decode. Without FEC data in the packet, libopus conceals the frame
+	 * as with PLC.
+	 */
+	ret = opus_decode(opus->psDec, (const unsigned char *) next->buf, (opus_int32) next->size, output->buf, output_buf_len / opus->pcm_bytes_per_sample, 1 /* decode FEC */);
+	if (ret <= 0) {
+		PJ_LOG(4, (THIS_FILE, "Failed to recover opus frame from FEC %d", ret));
+		return PJMEDIA_CODEC_EFAILED;
+	}
+
+#if _TRACE_OPUS
+	PJ_LOG(4, (THIS_FILE, "Frame recovered from FEC %d", ret));
+#endif
+	output->size = ret * opus->pcm_bytes_per_sample;
+	output->type = PJMEDIA_FRAME_TYPE_AUDIO;
+
+	return PJ_SUCCESS;
+}
+
+/*
+ * Reset the encoder state, keeping its settings.
+ */
+static pj_status_t opus_codec_reset_enc(pjmedia_codec *codec) {
+	struct opus_private *opus;
+
+	PJ_ASSERT_RETURN(codec, PJ_EINVAL);
+	opus = (struct opus_private*) codec->codec_data;
+
+	if (!opus->enc_ready)
+		return PJ_EINVALIDOP;
+
+	opus_encoder_ctl(opus->psEnc, OPUS_RESET_STATE);
+	return PJ_SUCCESS;
+}
+
 #endif
@@ -298,3 +298,95 @@ PJ_DEF(unsigned char) pjmedia_ulaw2alaw(
 
 #endif	/* PJMEDIA_HAS_ALAW_ULAW_TABLE */
 
+
+/*
+ * Block conversions.
+ */
+#if defined(PJMEDIA_HAS_ALAW_ULAW_TABLE) && PJMEDIA_HAS_ALAW_ULAW_TABLE!=0 && \
+    defined(PJMEDIA_ALAW_ULAW_USE_SIMD) && PJMEDIA_ALAW_ULAW_USE_SIMD!=0 && \
+    (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#   define ALAW_ULAW_HAS_SIMD	1
+#   include "alaw_ulaw_simd.c"
+#else
+#   define ALAW_ULAW_HAS_SIMD	0
+#endif
+
+PJ_DEF(void) pjmedia_ulaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
+				 pj_size_t count)
+{
+    const pj_int16_t *end;
+
+#if ALAW_ULAW_HAS_SIMD
+    pj_size_t n = count & ~(pj_size_t)(ALAW_ULAW_SIMD_WIDTH - 1);
+
+    ulaw_encode_simd(dst, src, n);
+    dst += n;
+    src += n;
+    count -= n;
+#endif
+
+    end = src + count;
+    while (src < end) {
+	*dst++ = pjmedia_linear2ulaw(*src++);
+    }
+}
+
+PJ_DEF(void) pjmedia_alaw_encode(pj_uint8_t *dst, const pj_int16_t *src, 
+				 pj_size_t count)
+{
+    const pj_int16_t *end;
+
+#if ALAW_ULAW_HAS_SIMD
+    pj_size_t n = count & ~(pj_size_t)(ALAW_ULAW_SIMD_WIDTH - 1);
+
+    alaw_encode_simd(dst, src, n);
+    dst += n;
+    src += n;
+    count -= n;
+#endif
+
+    end = src + count;
+    while (src < end) {
+	*dst++ = pjmedia_linear2alaw(*src++);
+    }
+}
+
+PJ_DEF(void) pjmedia_ulaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
+				 pj_size_t len)
+{
+    const pj_uint8_t *end;
+
+#if ALAW_ULAW_HAS_SIMD
+    pj_size_t n = len & ~(pj_size_t)(ALAW_ULAW_SIMD_WIDTH - 1);
+
+    ulaw_decode_simd(dst, src, n);
+    dst += n;
+    src += n;
+    len -= n;
+#endif
+
+    end = src + len;
+    while (src < end) {
+	*dst++ = (pj_int16_t) pjmedia_ulaw2linear(*src++);
+    }
+}
+
+PJ_DEF(void) pjmedia_alaw_decode(pj_int16_t *dst, const pj_uint8_t *src, 
+				 pj_size_t len)
+{
+    const pj_uint8_t *end;
+
+#if ALAW_ULAW_HAS_SIMD
+    pj_size_t n = len & ~(pj_size_t)(ALAW_ULAW_SIMD_WIDTH - 1);
+
+    alaw_decode_simd(dst, src, n);
+    dst += n;
+    src += n;
+    len -= n;
+#endif
+
+    end = src + len;
+    while (src < end) {
+	*dst++ = (pj_int16_t) pjmedia_alaw2linear(*src++);
+    }
+}
@@ -0,0 +1,292 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY alaw_ulaw.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * Block G.711 conversion with SSE2 or NEON, giving the same results as the
+ * tables in alaw_ulaw_table.c (which ignore the two lowest bits of the
+ * linear value). Instead of searching for the segment, the biased
+ * magnitude is converted to float: the exponent of the float is the
+ * segment number plus 134 and the four top bits of its mantissa are the
+ * quantization bits, so bits 19..30 of the float are the 7-bit code plus
+ * 0x860. Decoding builds the float of the code the same way (with the
+ * half step bit set) and converts it back to integer.
+ */
+
+/* Number of samples converted per iteration */
+#define ALAW_ULAW_SIMD_WIDTH	16
+
+/* (134 << 4), the exponent of the smallest segment in code units */
+#define SEG_EXP_BASE		0x860
+
+/* Float bits of the smallest segment, with the half step bit */
+#define SEG_FLOAT_BASE		((134 << 23) | (1 << 18))
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+/* Code (0..0x7F) of eight biased magnitudes (0x100..0x7FFF) */
+PJ_INLINE(__m128i) simd_seg_code(__m128i mag)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base = _mm_set1_epi32(SEG_EXP_BASE);
+    __m128i lo, hi;
+
+    lo = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpacklo_epi16(mag, zero)));
+    hi = _mm_castps_si128(_mm_cvtepi32_ps(_mm_unpackhi_epi16(mag, zero)));
+    lo = _mm_sub_epi32(_mm_srli_epi32(lo, 19), base);
+    hi = _mm_sub_epi32(_mm_srli_epi32(hi, 19), base);
+    return _mm_packs_epi32(lo, hi);
+}
+
+/* Linear value of eight codes (0..0x7F) of segment 1 and above */
+PJ_INLINE(__m128i) simd_seg_linear(__m128i code)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base = _mm_set1_epi32(SEG_FLOAT_BASE);
+    __m128i lo, hi;
+
+    lo = _mm_add_epi32(_mm_slli_epi32(_mm_unpacklo_epi16(code, zero), 19),
+		       base);
+    hi = _mm_add_epi32(_mm_slli_epi32(_mm_unpackhi_epi16(code, zero), 19),
+		       base);
+    lo = _mm_cvttps_epi32(_mm_castsi128_ps(lo));
+    hi = _mm_cvttps_epi32(_mm_castsi128_ps(hi));
+    return _mm_packs_epi32(lo, hi);
+}
+
+/* U-law of eight linear values */
+PJ_INLINE(__m128i) simd_linear2ulaw(__m128i pcm)
+{
+    __m128i sign, mag;
+
+    pcm = _mm_and_si128(pcm, _mm_set1_epi16(~3));
+    sign = _mm_srai_epi16(pcm, 15);
+    mag = _mm_sub_epi16(_mm_xor_si128(pcm, sign), sign);
+    mag = _mm_add_epi16(mag, _mm_set1_epi16(0x84));
+    /* Clip to 0x7FFF, mag is unsigned here */
+    mag = _mm_sub_epi16(mag, _mm_subs_epu16(mag, _mm_set1_epi16(0x7FFF)));
+
+    return _mm_xor_si128(simd_seg_code(mag),
+			 _mm_xor_si128(_mm_set1_epi16(0xFF),
+				       _mm_and_si128(sign,
+						     _mm_set1_epi16(0x80))));
+}
+
+/* A-law of eight linear values */
+PJ_INLINE(__m128i) simd_linear2alaw(__m128i pcm)
+{
+    __m128i sign, mag, seg0, code;
+
+    pcm = _mm_and_si128(pcm, _mm_set1_epi16(~3));
+    sign = _mm_srai_epi16(pcm, 15);
+    mag = _mm_sub_epi16(_mm_xor_si128(pcm, sign), sign);
+    mag = _mm_sub_epi16(mag, _mm_subs_epu16(mag, _mm_set1_epi16(0x7FFF)));
+
+    /* Segment 0 is linear, encode it as segment 1 and subtract its base */
+    seg0 = _mm_cmplt_epi16(mag, _mm_set1_epi16(0x100));
+    mag = _mm_add_epi16(mag, _mm_and_si128(seg0, _mm_set1_epi16(0x100)));
+    code = _mm_sub_epi16(simd_seg_code(mag),
+			 _mm_and_si128(seg0, _mm_set1_epi16(0x10)));
+
+    return _mm_xor_si128(code,
+			 _mm_xor_si128(_mm_set1_epi16(0xD5),
+				       _mm_and_si128(sign,
+						     _mm_set1_epi16(0x80))));
+}
+
+/* Linear values of eight u-law values */
+PJ_INLINE(__m128i) simd_ulaw2linear(__m128i u)
+{
+    __m128i neg, pcm;
+
+    /* Complemented code, the sign bit set is negative */
+    u = _mm_xor_si128(u, _mm_set1_epi16(0xFF));
+    neg = _mm_cmpgt_epi16(u, _mm_set1_epi16(0x7F));
+    pcm = simd_seg_linear(_mm_and_si128(u, _mm_set1_epi16(0x7F)));
+    pcm = _mm_sub_epi16(pcm, _mm_set1_epi16(0x84));
+    return _mm_sub_epi16(_mm_xor_si128(pcm, neg), neg);
+}
+
+/* Linear values of eight A-law values */
+PJ_INLINE(__m128i) simd_alaw2linear(__m128i a)
+{
+    __m128i neg, code, seg0, pcm;
+
+    a = _mm_xor_si128(a, _mm_set1_epi16(0x55));
+    neg = _mm_cmplt_epi16(a, _mm_set1_epi16(0x80));
+    code = _mm_and_si128(a, _mm_set1_epi16(0x7F));
+
+    /* Segment 0 is linear: (code << 4) + 8 */
+    seg0 = _mm_cmplt_epi16(code, _mm_set1_epi16(0x10));
+    pcm = _mm_or_si128(_mm_and_si128(seg0,
+				     _mm_add_epi16(_mm_slli_epi16(code, 4),
+						   _mm_set1_epi16(8))),
+		       _mm_andnot_si128(seg0, simd_seg_linear(code)));
+    return _mm_sub_epi16(_mm_xor_si128(pcm, neg), neg);
+}
+
+#define SIMD_ENCODE(name, conv)						\
+    static void name(pj_uint8_t *dst, const pj_int16_t *src, pj_size_t n) \
+    {									\
+	for (; n; n -= 16, src += 16, dst += 16) {			\
+	    __m128i lo = _mm_loadu_si128((const __m128i*)src);		\
+	    __m128i hi = _mm_loadu_si128((const __m128i*)(src + 8));	\
+	    _mm_storeu_si128((__m128i*)dst,				\
+			     _mm_packus_epi16(conv(lo), conv(hi)));	\
+	}								\
+    }
+
+#define SIMD_DECODE(name, conv)						\
+    static void name(pj_int16_t *dst, const pj_uint8_t *src, pj_size_t n) \
+    {									\
+	const __m128i zero = _mm_setzero_si128();			\
+	for (; n; n -= 16, src += 16, dst += 16) {			\
+	    __m128i v = _mm_loadu_si128((const __m128i*)src);		\
+	    _mm_storeu_si128((__m128i*)dst,				\
+			     conv(_mm_unpacklo_epi8(v, zero)));		\
+	    _mm_storeu_si128((__m128i*)(dst + 8),			\
+			     conv(_mm_unpackhi_epi8(v, zero)));		\
+	}								\
+    }
+
+#else	/* NEON */
+
+#include <arm_neon.h>
+
+/* Code (0..0x7F) of eight biased magnitudes (0x100..0x7FFF) */
+PJ_INLINE(uint16x8_t) simd_seg_code(uint16x8_t mag)
+{
+    const uint32x4_t base = vdupq_n_u32(SEG_EXP_BASE);
+    uint32x4_t lo, hi;
+
+    lo = vreinterpretq_u32_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(mag))));
+    hi = vreinterpretq_u32_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(mag))));
+    lo = vsubq_u32(vshrq_n_u32(lo, 19), base);
+    hi = vsubq_u32(vshrq_n_u32(hi, 19), base);
+    return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+}
+
+/* Linear value of eight codes (0..0x7F) of segment 1 and above */
+PJ_INLINE(int16x8_t) simd_seg_linear(uint16x8_t code)
+{
+    const uint32x4_t base = vdupq_n_u32(SEG_FLOAT_BASE);
+    uint32x4_t lo, hi;
+
+    lo = vaddq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(code)), 19), base);
+    hi = vaddq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(code)), 19), base);
+    return vcombine_s16(
+		vmovn_s32(vcvtq_s32_f32(vreinterpretq_f32_u32(lo))),
+		vmovn_s32(vcvtq_s32_f32(vreinterpretq_f32_u32(hi))));
+}
+
+/* U-law of eight linear values */
+PJ_INLINE(uint8x8_t) simd_linear2ulaw(int16x8_t pcm)
+{
+    uint16x8_t neg, mag, mask;
+
+    pcm = vandq_s16(pcm, vdupq_n_s16(~3));
+    neg = vreinterpretq_u16_s16(vshrq_n_s16(pcm, 15));
+    mag = vreinterpretq_u16_s16(vabsq_s16(pcm));
+    mag = vminq_u16(vaddq_u16(mag, vdupq_n_u16(0x84)), vdupq_n_u16(0x7FFF));
+    mask = veorq_u16(vdupq_n_u16(0xFF), vandq_u16(neg, vdupq_n_u16(0x80)));
+    return vmovn_u16(veorq_u16(simd_seg_code(mag), mask));
+}
+
+/* A-law of eight linear values */
+PJ_INLINE(uint8x8_t) simd_linear2alaw(int16x8_t pcm)
+{
+    uint16x8_t neg, mag, seg0, code, mask;
+
+    pcm = vandq_s16(pcm, vdupq_n_s16(~3));
+    neg = vreinterpretq_u16_s16(vshrq_n_s16(pcm, 15));
+    mag = vminq_u16(vreinterpretq_u16_s16(vabsq_s16(pcm)),
+		    vdupq_n_u16(0x7FFF));
+
+    /* Segment 0 is linear, encode it as segment 1 and subtract its base */
+    seg0 = vcltq_u16(mag, vdupq_n_u16(0x100));
+    mag = vaddq_u16(mag, vandq_u16(seg0, vdupq_n_u16(0x100)));
+    code = vsubq_u16(simd_seg_code(mag), vandq_u16(seg0, vdupq_n_u16(0x10)));
+
+    mask = veorq_u16(vdupq_n_u16(0xD5), vandq_u16(neg, vdupq_n_u16(0x80)));
+    return vmovn_u16(veorq_u16(code, mask));
+}
+
+/* Linear values of eight u-law values */
+PJ_INLINE(int16x8_t) simd_ulaw2linear(uint8x8_t u8)
+{
+    uint16x8_t u = vmovl_u8(vmvn_u8(u8));
+    int16x8_t pcm;
+
+    /* Complemented code, the sign bit set is negative */
+    pcm = simd_seg_linear(vandq_u16(u, vdupq_n_u16(0x7F)));
+    pcm = vsubq_s16(pcm, vdupq_n_s16(0x84));
+    return vbslq_s16(vcgtq_u16(u, vdupq_n_u16(0x7F)), vnegq_s16(pcm), pcm);
+}
+
+/* Linear values of eight A-law values */
+PJ_INLINE(int16x8_t) simd_alaw2linear(uint8x8_t a8)
+{
+    uint16x8_t a = vmovl_u8(veor_u8(a8, vdup_n_u8(0x55)));
+    uint16x8_t code = vandq_u16(a, vdupq_n_u16(0x7F));
+    int16x8_t seg0, pcm;
+
+    /* Segment 0 is linear: (code << 4) + 8 */
+    seg0 = vreinterpretq_s16_u16(vaddq_u16(vshlq_n_u16(code, 4),
+					   vdupq_n_u16(8)));
+    pcm = vbslq_s16(vcltq_u16(code, vdupq_n_u16(0x10)), seg0,
+		    simd_seg_linear(code));
+    return vbslq_s16(vcltq_u16(a, vdupq_n_u16(0x80)), vnegq_s16(pcm), pcm);
+}
+
+#define SIMD_ENCODE(name, conv)						\
+    static void name(pj_uint8_t *dst, const pj_int16_t *src, pj_size_t n) \
+    {									\
+	for (; n; n -= 16, src += 16, dst += 16) {			\
+	    vst1q_u8(dst, vcombine_u8(conv(vld1q_s16(src)),		\
+				      conv(vld1q_s16(src + 8))));	\
+	}								\
+    }
+
+#define SIMD_DECODE(name, conv)						\
+    static void name(pj_int16_t *dst, const pj_uint8_t *src, pj_size_t n) \
+    {									\
+	for (; n; n -= 16, src += 16, dst += 16) {			\
+	    uint8x16_t v = vld1q_u8(src);				\
+	    vst1q_s16(dst, conv(vget_low_u8(v)));			\
+	    vst1q_s16(dst + 8, conv(vget_high_u8(v)));			\
+	}								\
+    }
+
+#endif
+
+/* Convert n samples, n must be a multiple of ALAW_ULAW_SIMD_WIDTH */
+SIMD_ENCODE(ulaw_encode_simd, simd_linear2ulaw)
+SIMD_ENCODE(alaw_encode_simd, simd_linear2alaw)
+SIMD_DECODE(ulaw_decode_simd, simd_ulaw2linear)
+SIMD_DECODE(alaw_decode_simd, simd_alaw2linear)
+
+#undef SIMD_ENCODE
+#undef SIMD_DECODE
+#undef SEG_EXP_BASE
+#undef SEG_FLOAT_BASE
@@ -26,6 +26,7 @@
 #include <pjmedia/silencedet.h>
 #include <pjmedia/sound_port.h>
 #include <pjmedia/stereo.h>
+#include <pjmedia/stream.h>
 #include <pj/array.h>
 #include <pj/assert.h>
 #include <pj/log.h>
@@ -163,6 +164,11 @@ struct conf_port
     int			 mix_adj;	/**< Adjustment level for mix_buf.  */
     int			 last_mix_adj;	/**< Last adjustment level.	    */
     pj_int32_t		*mix_buf;	/**< Total sum of signal.	    */
+    pj_uint32_t		 mix_sig;	/**< Hash of the ports mixed into
+					     mix_buf in this frame.	    */
+    pj_bool_t		 relayed;	/**< Has the port been relayed the
+					     payload of its transmitter in
+					     this frame?		    */
 
     /* Tx buffer is a temporary buffer to be used when there's mismatch 
      * between port's clock rate or ptime with conference's sample rate
@@ -180,6 +186,15 @@ struct conf_port
     pj_int16_t		*tx_buf;	/**< Tx buffer.			    */
     unsigned		 tx_buf_cap;	/**< Max size, in samples.	    */
     unsigned		 tx_buf_count;	/**< # of samples in the buffer.    */
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+    pj_int16_t		*share_buf;	/**< Copy of the frame from tx_buf
+					     last given to a stream port,
+					     for other streams to compare
+					     their frame with.		    */
+    const void		*enc_frame;	/**< Frame last given to the port
+					     when it was encoding for the
+					     others in this tick.	    */
+#endif
 
     /* When the port is not receiving signal from any other ports (e.g. when
      * no other ports is transmitting to this port), the bridge periodically
@@ -235,6 +250,14 @@ struct pjmedia_conf
     unsigned		  channel_count;/**< Number of channels (1=mono).   */
     unsigned		  samples_per_frame;	/**< Samples per frame.	    */
     unsigned		  bits_per_sample;	/**< Bits per sample.	    */
+
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+    /* Stream ports that have encoded the frame of this clock tick, each
+     * with a different mix or codec setting.
+     */
+    struct conf_port	**enc_leaders;	/**< Array of max_ports entries.    */
+    unsigned		  enc_leader_cnt;
+#endif
 };
 
 
@@ -394,6 +417,17 @@ static pj_status_t create_conf_port( pj_pool_t *pool,
 			    pj_pool_alloc(pool, conf_port->tx_buf_cap *
 						sizeof(conf_port->tx_buf[0]));
 	PJ_ASSERT_RETURN(conf_port->tx_buf, PJ_ENOMEM);
+
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+	/* Create the copy of the transmitted frame for stream ports. */
+	if (port && port->info.signature == PJMEDIA_SIG_PORT_STREAM) {
+	    conf_port->share_buf = (pj_int16_t*)
+				   pj_pool_alloc(pool,
+						 conf_port->samples_per_frame *
+						 sizeof(conf_port->share_buf[0]));
+	    PJ_ASSERT_RETURN(conf_port->share_buf, PJ_ENOMEM);
+	}
+#endif
     }
 
 
@@ -547,6 +581,12 @@ PJ_DEF(pj_status_t) pjmedia_conf_create( pj_pool_t *pool,
 		  pj_pool_zalloc(pool, max_ports*sizeof(void*));
     PJ_ASSERT_RETURN(conf->ports, PJ_ENOMEM);
 
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+    conf->enc_leaders = (struct conf_port**)
+			pj_pool_zalloc(pool, max_ports*sizeof(void*));
+    PJ_ASSERT_RETURN(conf->enc_leaders, PJ_ENOMEM);
+#endif
+
     conf->options = options;
     conf->max_ports = max_ports;
     conf->clock_rate = clock_rate;
@@ -1537,6 +1577,128 @@ static pj_status_t read_port( pjmedia_conf *conf,
 }
 
 
+#if (defined(PJMEDIA_CONF_RELAY_ENCODED) && PJMEDIA_CONF_RELAY_ENCODED!=0) || \
+    (defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0)
+/* Check if the frames of the port last as long as the frames of the
+ * bridge, i.e. the port gives or takes one frame per bridge tick.
+ */
+static pj_bool_t same_ptime(const pjmedia_conf *conf,
+			    const struct conf_port *cport)
+{
+    return (pj_uint64_t)cport->samples_per_frame * conf->channel_count *
+	   conf->clock_rate ==
+	   (pj_uint64_t)conf->samples_per_frame * cport->channel_count *
+	   cport->clock_rate;
+}
+#endif
+
+
+#if defined(PJMEDIA_CONF_RELAY_ENCODED) && PJMEDIA_CONF_RELAY_ENCODED!=0
+/*
+ * If the port is a stream that only transmits to another stream, which
+ * only listens to it, and both use the same codec, relay its payload to
+ * the other stream. The payload doesn't go through the bridge, so the two
+ * ports only need to match each other, whatever the clock rate of the
+ * bridge, as long as their frames last as long as the bridge's.
+ */
+static pj_bool_t relay_port(pjmedia_conf *conf, struct conf_port *cport,
+			    const pj_timestamp *timestamp)
+{
+    struct conf_port *listener;
+    pjmedia_stream *stream, *dst;
+
+    if (cport->listener_cnt != 1 || cport->port == NULL ||
+	cport->port->info.signature != PJMEDIA_SIG_PORT_STREAM ||
+	cport->rx_setting != PJMEDIA_PORT_ENABLE ||
+	cport->rx_adj_level != NORMAL_LEVEL ||
+	!same_ptime(conf, cport))
+    {
+	return PJ_FALSE;
+    }
+
+    listener = conf->ports[cport->listener_slots[0]];
+    if (listener->transmitter_cnt != 1 || listener->port == NULL ||
+	listener->port->info.signature != PJMEDIA_SIG_PORT_STREAM ||
+	listener->tx_setting != PJMEDIA_PORT_ENABLE ||
+	listener->tx_adj_level != NORMAL_LEVEL ||
+	listener->clock_rate != cport->clock_rate ||
+	listener->samples_per_frame != cport->samples_per_frame ||
+	listener->channel_count != cport->channel_count)
+    {
+	return PJ_FALSE;
+    }
+
+    stream = (pjmedia_stream*)cport->port->port_data.pdata;
+    dst = (pjmedia_stream*)listener->port->port_data.pdata;
+    if (!pjmedia_stream_can_relay(stream, dst))
+	return PJ_FALSE;
+
+    pjmedia_stream_relay_frame(stream, dst, timestamp);
+
+    /* Samples buffered for resampling before the relay started must not
+     * be played when the ports are mixed again.
+     */
+    cport->rx_buf_count = 0;
+    listener->tx_buf_count = 0;
+
+    cport->rx_level = 0;
+    listener->relayed = PJ_TRUE;
+    return PJ_TRUE;
+}
+#endif
+
+
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+/*
+ * Transmit the mixed frame to a stream port. If another stream has already
+ * encoded the same samples this tick with the same codec settings, its
+ * payload is transmitted instead of encoding the frame again. Otherwise
+ * the stream becomes the one the others can share with. The port must
+ * take one frame per tick, i.e. have the same ptime as the bridge.
+ */
+static pj_status_t put_stream_frame(pjmedia_conf *conf,
+				    struct conf_port *cport,
+				    pjmedia_frame *frame)
+{
+    pjmedia_stream *stream = (pjmedia_stream*)cport->port->port_data.pdata;
+    unsigned i;
+
+    /* Streams which can't share their payload with anyone, e.g. those with
+     * a stateful codec, just encode their frame.
+     */
+    if (!pjmedia_stream_can_share_enc(stream, stream))
+	return pjmedia_port_put_frame(cport->port, frame);
+
+    for (i = 0; i < conf->enc_leader_cnt; ++i) {
+	struct conf_port *leader = conf->enc_leaders[i];
+	pjmedia_stream *enc_src;
+
+	if (leader->mix_sig != cport->mix_sig ||
+	    leader->samples_per_frame != cport->samples_per_frame ||
+	    pj_memcmp(leader->enc_frame, frame->buf, frame->size) != 0)
+	{
+	    continue;
+	}
+
+	enc_src = (pjmedia_stream*)leader->port->port_data.pdata;
+	if (pjmedia_stream_can_share_enc(stream, enc_src))
+	    return pjmedia_stream_put_frame_shared(stream, enc_src, frame);
+    }
+
+    /* The samples in tx_buf are moved once transmitted, keep a copy. */
+    if (frame->buf == cport->tx_buf) {
+	pj_memcpy(cport->share_buf, frame->buf, frame->size);
+	cport->enc_frame = cport->share_buf;
+    } else {
+	cport->enc_frame = frame->buf;
+    }
+
+    conf->enc_leaders[conf->enc_leader_cnt++] = cport;
+    return pjmedia_port_put_frame(cport->port, frame);
+}
+#endif
+
+
 /*
  * Write the mixed signal to the port.
  */
@@ -1553,6 +1715,15 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
 
     *frm_type = PJMEDIA_FRAME_TYPE_AUDIO;
 
+#if defined(PJMEDIA_CONF_RELAY_ENCODED) && PJMEDIA_CONF_RELAY_ENCODED!=0
+    /* The port has already transmitted the relayed payload */
+    if (cport->relayed) {
+	cport->tx_level = 0;
+	*frm_type = PJMEDIA_FRAME_TYPE_NONE;
+	return PJ_SUCCESS;
+    }
+#endif
+
     /* If port is muted or nobody is transmitting to this port, 
      * transmit NULL frame. 
      */
@@ -1686,6 +1857,11 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
 			       (int)cport->name.slen, cport->name.ptr,
 			       frame.size / BYTES_PER_SAMPLE));
 
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+	    if (cport->port->info.signature == PJMEDIA_SIG_PORT_STREAM)
+		return put_stream_frame(conf, cport, &frame);
+#endif
+
 	    return pjmedia_port_put_frame(cport->port, &frame);
 	} else
 	    return PJ_SUCCESS;
@@ -1757,6 +1933,11 @@ static pj_status_t write_port(pjmedia_conf *conf, struct conf_port *cport,
 			       (int)cport->name.slen, cport->name.ptr,
 			       frame.size / BYTES_PER_SAMPLE));
 
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+	    if (cport->share_buf && same_ptime(conf, cport))
+		status = put_stream_frame(conf, cport, &frame);
+	    else
+#endif
 	    status = pjmedia_port_put_frame(cport->port, &frame);
 
 	} else
@@ -1814,6 +1995,8 @@ static pj_status_t get_frame(pjmedia_port *this_port,
 	 * reset auto adjustment level for mixed signal.
 	 */
 	conf_port->mix_adj = NORMAL_LEVEL;
+	conf_port->mix_sig = 0;
+	conf_port->relayed = PJ_FALSE;
 	if (conf_port->transmitter_cnt) {
 	    pj_bzero(conf_port->mix_buf,
 		     conf->samples_per_frame*sizeof(conf_port->mix_buf[0]));
@@ -1846,6 +2029,12 @@ static pj_status_t get_frame(pjmedia_port *this_port,
 	    continue;
 	}
 
+#if defined(PJMEDIA_CONF_RELAY_ENCODED) && PJMEDIA_CONF_RELAY_ENCODED!=0
+	/* Skip decoding and mixing if the payload can be relayed */
+	if (relay_port(conf, conf_port, &frame->timestamp))
+	    continue;
+#endif
+
 	/* Get frame from this port.
 	 * For passive ports, get the frame from the delay_buf.
 	 * For other ports, get the frame from the port. 
@@ -1951,6 +2140,9 @@ static pj_status_t get_frame(pjmedia_port *this_port,
 
 	    mix_buf = listener->mix_buf;
 
+	    /* Hash of the slots, in the order they are mixed */
+	    listener->mix_sig = (listener->mix_sig ^ (i + 1)) * 16777619;
+
 	    if (listener->transmitter_cnt > 1) {
 		/* Mixing signals,
 		 * and calculate appropriate level adjustment if there is
@@ -1984,6 +2176,9 @@ static pj_status_t get_frame(pjmedia_port *this_port,
     /* Time for all ports to transmit whetever they have in their
      * buffer. 
      */
+#if defined(PJMEDIA_CONF_SHARE_ENCODING) && PJMEDIA_CONF_SHARE_ENCODING!=0
+    conf->enc_leader_cnt = 0;
+#endif
     for (i=0, ci=0; i<conf->max_ports && ci<conf->port_cnt; ++i) {
 	struct conf_port *conf_port = conf->ports[i];
 	pjmedia_frame_type frm_type;
@@ -26,6 +26,7 @@
 #include <pj/list.h>
 #include <pj/log.h>
 #include <pj/math.h>
+#include <pj/os.h>
 #include <pj/pool.h>
 #include "echo_internal.h"
 
@@ -53,6 +54,8 @@ struct pjmedia_echo_state
 
     pjmedia_delay_buf	*delay_buf;
     pj_int16_t	    *frm_buf;
+
+    pj_math_stat     proc_time;	    /* Processing time per frame, usec	    */
 };
 
 
@@ -181,6 +184,7 @@ PJ_DEF(pj_status_t) pjmedia_echo_create2(pj_pool_t *pool,
     ec->frm_buf = (pj_int16_t*)pj_pool_alloc(pool, samples_per_frame<<1);
     pj_list_init(&ec->lat_buf);
     pj_list_init(&ec->lat_free);
+    pj_math_stat_init(&ec->proc_time);
 
     /* Select the backend algorithm */
     if (0) {
@@ -280,6 +284,16 @@ PJ_DEF(pj_status_t) pjmedia_echo_create2(pj_pool_t *pool,
 }
 
 
+/* Account the processing time of a frame which started at t0 */
+static void update_proc_time(pjmedia_echo_state *echo, const pj_timestamp *t0)
+{
+    pj_timestamp t1;
+
+    pj_get_timestamp(&t1);
+    pj_math_stat_update(&echo->proc_time, (int)pj_elapsed_usec(t0, &t1));
+}
+
+
 /*
  * Destroy the Echo Canceller. 
  */
@@ -382,7 +396,12 @@ PJ_DEF(pj_status_t) pjmedia_echo_capture( pjmedia_echo_state *echo,
 
     /* If EC algo has capture handler, just pass the frame. */
     if (echo->op->ec_capture) {
-	return (*echo->op->ec_capture)(echo->state, rec_frm, options);
+	pj_timestamp t0;
+
+	pj_get_timestamp(&t0);
+	status = (*echo->op->ec_capture)(echo->state, rec_frm, options);
+	update_proc_time(echo, &t0);
+	return status;
     }
 
     if (!echo->lat_ready) {
@@ -422,7 +441,28 @@ PJ_DEF(pj_status_t) pjmedia_echo_cancel( pjmedia_echo_state *echo,
 					 unsigned options,
 					 void *reserved )
 {
-    return (*echo->op->ec_cancel)( echo->state, rec_frm, play_frm, options, 
-				   reserved);
+    pj_timestamp t0;
+    pj_status_t status;
+
+    pj_get_timestamp(&t0);
+    status = (*echo->op->ec_cancel)( echo->state, rec_frm, play_frm, options, 
+				     reserved);
+    update_proc_time(echo, &t0);
+    return status;
+}
+
+
+/*
+ * Get the processing time statistics.
+ */
+PJ_DEF(pj_status_t) pjmedia_echo_get_stat(pjmedia_echo_state *echo,
+					  pjmedia_echo_stat *p_stat)
+{
+    PJ_ASSERT_RETURN(echo && p_stat, PJ_EINVAL);
+
+    p_stat->name = echo->op->name;
+    p_stat->samples_per_frame = echo->samples_per_frame;
+    p_stat->proc_time = echo->proc_time;
+    return PJ_SUCCESS;
 }
 
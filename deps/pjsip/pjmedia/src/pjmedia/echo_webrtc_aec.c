@@ -36,6 +36,11 @@
     #define PJMEDIA_WEBRTC_NS_POLICY 0
 #endif
 
+/* Use SSE2 or NEON, when the compiler targets them, for the high pass filter */
+#ifndef PJMEDIA_WEBRTC_AEC_USE_SIMD
+    #define PJMEDIA_WEBRTC_AEC_USE_SIMD 1
+#endif
+
 #define THIS_FILE    "echo_webrtc_aec.c"
 
 #include <third_party/webrtc/src/common_audio/signal_processing_library/main/interface/signal_processing_library.h>
@@ -155,13 +160,40 @@ const WebRtc_Word16 kFilterCoefficients8kHz[5] =
 const WebRtc_Word16 kFilterCoefficients[5] =
     {4012, -8024, 4012, 8002, -3913};
 
+/* Maximum number of samples filtered at once, i.e. 10ms at 16kHz */
+#define HPF_MAX_SAMPLES 160
+
 typedef struct {
   WebRtc_Word16 y[4];
   WebRtc_Word16 x[2];
   const WebRtc_Word16* ba;
+
+  /* Input preceded by the two previous samples, and the feed forward part
+   * of the output (b[0] * x[i] + b[1] * x[i-1] + b[2] * x[i-2]) */
+  WebRtc_Word16 in[HPF_MAX_SAMPLES + 2];
+  WebRtc_Word32 ff[HPF_MAX_SAMPLES];
 } HighPassFilterState;
 
 
+#if PJMEDIA_WEBRTC_AEC_USE_SIMD && \
+    (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#   include "echo_webrtc_aec_simd.c"
+#else
+static void HighPassFilter_FeedForward(const WebRtc_Word16* in,
+                                       const WebRtc_Word16* ba,
+                                       WebRtc_Word32* out,
+                                       int length) {
+  int i;
+
+  for (i = 0; i < length; i++) {
+    out[i] = WEBRTC_SPL_MUL_16_16(in[i + 2], ba[0]) +
+             WEBRTC_SPL_MUL_16_16(in[i + 1], ba[1]) +
+             WEBRTC_SPL_MUL_16_16(in[i], ba[2]);
+  }
+}
+#endif
+
+
 static int HighPassFilter_Initialize(HighPassFilterState* hpf, int sample_rate) {
   assert(hpf != NULL);
 
@@ -179,13 +211,22 @@ static int HighPassFilter_Initialize(HighPassFilterState* hpf, int sample_rate)
 
 
 static int HighPassFilter_Process(HighPassFilterState* hpf, WebRtc_Word16* data, int length) {
-  assert(hpf != NULL);
+  assert(hpf != NULL && length <= HPF_MAX_SAMPLES);
 
   int i;
   WebRtc_Word32 tmp_int32 = 0;
   WebRtc_Word16* y = hpf->y;
-  WebRtc_Word16* x = hpf->x;
   const WebRtc_Word16* ba = hpf->ba;
+  const WebRtc_Word32* ff = hpf->ff;
+
+  // The feed forward part does not depend on the output, compute it for
+  // the whole block first
+  hpf->in[0] = hpf->x[1];
+  hpf->in[1] = hpf->x[0];
+  WEBRTC_SPL_MEMCPY_W16(hpf->in + 2, data, length);
+  HighPassFilter_FeedForward(hpf->in, ba, hpf->ff, length);
+  hpf->x[1] = hpf->in[length];
+  hpf->x[0] = hpf->in[length + 1];
 
   for (i = 0; i < length; i++) {
     //  y[i] = b[0] * x[i] + b[1] * x[i-1] + b[2] * x[i-2]
@@ -198,13 +239,7 @@ static int HighPassFilter_Process(HighPassFilterState* hpf, WebRtc_Word16* data,
     tmp_int32 += WEBRTC_SPL_MUL_16_16(y[2], ba[4]); // -a[2] * y[i-2] (high part)
     tmp_int32 = (tmp_int32 << 1);
 
-    tmp_int32 += WEBRTC_SPL_MUL_16_16(data[i], ba[0]); // b[0]*x[0]
-    tmp_int32 += WEBRTC_SPL_MUL_16_16(x[0], ba[1]);    // b[1]*x[i-1]
-    tmp_int32 += WEBRTC_SPL_MUL_16_16(x[1], ba[2]);    // b[2]*x[i-2]
-
-    // Update state (input part)
-    x[1] = x[0];
-    x[0] = data[i];
+    tmp_int32 += ff[i]; // b[0]*x[0] + b[1]*x[i-1] + b[2]*x[i-2]
 
     // Update state (filtered part)
     y[2] = y[0];
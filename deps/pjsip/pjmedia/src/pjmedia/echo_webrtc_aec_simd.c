@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2011-2013 AG Projects
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY echo_webrtc_aec.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * Feed forward part of the high pass filter with SSE2 or NEON, eight
+ * samples at a time. The products of the 16-bit samples and coefficients
+ * and their sums fit in 32 bits, so the results are the same as those of
+ * the scalar loop.
+ */
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+static void HighPassFilter_FeedForward(const WebRtc_Word16* in,
+                                       const WebRtc_Word16* ba,
+                                       WebRtc_Word32* out,
+                                       int length) {
+  /* (x[i], x[i-1]) pairs are multiplied by (b[0], b[1]), and
+   * (x[i-2], 0) pairs by (b[2], 0) */
+  const __m128i b01 = _mm_set_epi16(ba[1], ba[0], ba[1], ba[0],
+                                    ba[1], ba[0], ba[1], ba[0]);
+  const __m128i b2 = _mm_set_epi16(0, ba[2], 0, ba[2], 0, ba[2], 0, ba[2]);
+  const __m128i zero = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(in + i + 2));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(in + i + 1));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i lo, hi;
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), b01),
+                       _mm_madd_epi16(_mm_unpacklo_epi16(x2, zero), b2));
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), b01),
+                       _mm_madd_epi16(_mm_unpackhi_epi16(x2, zero), b2));
+    _mm_storeu_si128((__m128i*)(out + i), lo);
+    _mm_storeu_si128((__m128i*)(out + i + 4), hi);
+  }
+
+  for (; i < length; i++) {
+    out[i] = WEBRTC_SPL_MUL_16_16(in[i + 2], ba[0]) +
+             WEBRTC_SPL_MUL_16_16(in[i + 1], ba[1]) +
+             WEBRTC_SPL_MUL_16_16(in[i], ba[2]);
+  }
+}
+
+#else	/* NEON */
+
+#include <arm_neon.h>
+
+static void HighPassFilter_FeedForward(const WebRtc_Word16* in,
+                                       const WebRtc_Word16* ba,
+                                       WebRtc_Word32* out,
+                                       int length) {
+  int i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    int16x8_t x0 = vld1q_s16(in + i + 2);
+    int16x8_t x1 = vld1q_s16(in + i + 1);
+    int16x8_t x2 = vld1q_s16(in + i);
+    int32x4_t lo, hi;
+
+    lo = vmull_n_s16(vget_low_s16(x0), ba[0]);
+    lo = vmlal_n_s16(lo, vget_low_s16(x1), ba[1]);
+    lo = vmlal_n_s16(lo, vget_low_s16(x2), ba[2]);
+    hi = vmull_n_s16(vget_high_s16(x0), ba[0]);
+    hi = vmlal_n_s16(hi, vget_high_s16(x1), ba[1]);
+    hi = vmlal_n_s16(hi, vget_high_s16(x2), ba[2]);
+    vst1q_s32(out + i, lo);
+    vst1q_s32(out + i + 4, hi);
+  }
+
+  for (; i < length; i++) {
+    out[i] = WEBRTC_SPL_MUL_16_16(in[i + 2], ba[0]) +
+             WEBRTC_SPL_MUL_16_16(in[i + 1], ba[1]) +
+             WEBRTC_SPL_MUL_16_16(in[i], ba[2]);
+  }
+}
+
+#endif
@@ -60,6 +60,9 @@ typedef struct jb_framelist_t
     /* Settings */
     unsigned	     frame_size;	/**< maximum size of frame	    */
     unsigned	     max_count;		/**< maximum number of frames	    */
+    unsigned	     max_gap;		/**< maximum number of missing
+					     frames kept before a frame put
+					     into an empty buffer	    */
 
     /* Buffers */
     char	    *content;		/**< frame content array	    */
@@ -102,6 +105,8 @@ struct pjmedia_jbuf
 					     calculation		    */
     int		    jb_min_shrink_gap;	/**< How often can we shrink	    */
     discard_algo    jb_discard_algo;	/**< Discard algorithm		    */
+    int		    jb_lookahead;	/**< Frames kept in addition to the
+					     burst level		    */
 
     /* Buffer */
     jb_framelist_t  jb_framelist;	/**< the buffer			    */
@@ -125,6 +130,8 @@ struct pjmedia_jbuf
 					     continuously updated based on
 					     current frame burst level.	    */
     pj_bool_t	    jb_prefetching;	/**< flag if jbuf is prefetching.   */
+    int		    jb_lookahead_fill;	/**< no. of frames still to insert
+					     for an increased lookahead	    */
     int		    jb_status;		/**< status is 'init' until the	first
 					     'put' operation		    */
     int		    jb_init_cycle_cnt;	/**< status is 'init' until the	first
@@ -470,8 +477,13 @@ static pj_status_t jb_framelist_put_at(jb_framelist_t *framelist,
 	}
     }
 
-    /* if jbuf is empty, just reset the origin */
-    if (framelist->size == 0) {
+    /* if jbuf is empty, just reset the origin, unless the frames before
+     * this one are to be returned as missing.
+     */
+    if (framelist->size == 0 &&
+	(framelist->origin == INVALID_OFFSET ||
+	 index - framelist->origin > (int)framelist->max_gap))
+    {
 	pj_assert(framelist->discarded_num == 0);
 	framelist->origin = index;
     }
@@ -626,6 +638,33 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_set_adaptive( pjmedia_jbuf *jb,
 }
 
 
+/*
+ * Set the number of frames kept in addition to the burst level.
+ */
+PJ_DEF(pj_status_t) pjmedia_jbuf_set_lookahead( pjmedia_jbuf *jb,
+						unsigned lookahead)
+{
+    PJ_ASSERT_RETURN(jb, PJ_EINVAL);
+    PJ_ASSERT_RETURN(lookahead < jb->jb_max_count, PJ_EINVAL);
+
+    /* Frames are inserted by returning prefetch frames, while removing
+     * them is left to the discard algorithm.
+     */
+    if ((int)lookahead > jb->jb_lookahead)
+	jb->jb_lookahead_fill += lookahead - jb->jb_lookahead;
+    else if (jb->jb_lookahead_fill > (int)lookahead)
+	jb->jb_lookahead_fill = lookahead;
+    jb->jb_lookahead = lookahead;
+
+    /* Keep the frames lost after the buffer has run empty as missing, they
+     * may still be recovered from the frames following them.
+     */
+    jb->jb_framelist.max_gap = lookahead;
+
+    return PJ_SUCCESS;
+}
+
+
 PJ_DEF(pj_status_t) pjmedia_jbuf_set_discard( pjmedia_jbuf *jb,
 					      pjmedia_jb_discard_algo algo)
 {
@@ -659,6 +698,7 @@ PJ_DEF(pj_status_t) pjmedia_jbuf_reset(pjmedia_jbuf *jb)
     jb->jb_init_cycle_cnt= 0;
     jb->jb_max_hist_level= 0;
     jb->jb_prefetching   = (jb->jb_prefetch != 0);
+    jb->jb_lookahead_fill= (jb->jb_prefetching ? 0 : jb->jb_lookahead);
     jb->jb_discard_dist  = 0;
 
     jb_framelist_reset(&jb->jb_framelist);
@@ -791,7 +831,7 @@ static void jbuf_discard_static(pjmedia_jbuf *jb)
      */
     int diff, burst_level;
 
-    burst_level = PJ_MAX(jb->jb_eff_level, jb->jb_level);
+    burst_level = PJ_MAX(jb->jb_eff_level, jb->jb_level) + jb->jb_lookahead;
     diff = jb_framelist_eff_size(&jb->jb_framelist) - burst_level*2;
 
     if (diff >= STA_DISC_SAFE_SHRINKING_DIFF) {
@@ -833,7 +873,7 @@ static void jbuf_discard_progressive(pjmedia_jbuf *jb)
 
     /* Check if latency is longer than burst */
     cur_size = jb_framelist_eff_size(&jb->jb_framelist);
-    burst_level = PJ_MAX(jb->jb_eff_level, jb->jb_level);
+    burst_level = PJ_MAX(jb->jb_eff_level, jb->jb_level) + jb->jb_lookahead;
     if (cur_size <= burst_level) {
 	/* Reset any scheduled discard */
 	jb->jb_discard_dist = 0;
@@ -1012,7 +1052,10 @@ PJ_DEF(void) pjmedia_jbuf_put_frame3(pjmedia_jbuf *jb,
 	if (jb->jb_prefetching) {
 	    TRACE__((jb->jb_name.ptr, "PUT prefetch_cnt=%d/%d",
 		     new_size, jb->jb_prefetch));
-	    if (new_size >= jb->jb_prefetch)
+	    /* The lookahead frames are in addition to the frame to be
+	     * returned next, which is one of the prefetched frames.
+	     */
+	    if (new_size >= PJ_MAX(jb->jb_prefetch, 1) + jb->jb_lookahead)
 		jb->jb_prefetching = PJ_FALSE;
 	}
 	jb->jb_level += (new_size > cur_size ? new_size-cur_size : 1);
@@ -1072,6 +1115,20 @@ PJ_DEF(void) pjmedia_jbuf_get_frame3(pjmedia_jbuf *jb,
 
 	jb->jb_empty++;
 
+    } else if (jb->jb_lookahead_fill > 0) {
+
+	/* Delay the frames by one more frame for the increased lookahead */
+	--jb->jb_lookahead_fill;
+
+	*p_frame_type = PJMEDIA_JB_ZERO_PREFETCH_FRAME;
+	if (size)
+	    *size = 0;
+
+	TRACE__((jb->jb_name.ptr, "GET lookahead fill, %d more",
+		 jb->jb_lookahead_fill));
+
+	jb->jb_empty++;
+
     } else {
 
 	pjmedia_jb_frame_type ftype = PJMEDIA_JB_NORMAL_FRAME;
@@ -1102,7 +1159,7 @@ PJ_DEF(void) pjmedia_jbuf_get_frame3(pjmedia_jbuf *jb,
 	    }
 	} else {
 	    /* Jitter buffer is empty */
-	    if (jb->jb_prefetch)
+	    if (jb->jb_prefetch || jb->jb_lookahead)
 		jb->jb_prefetching = PJ_TRUE;
 
 	    //pj_bzero(frame, jb->jb_frame_size);
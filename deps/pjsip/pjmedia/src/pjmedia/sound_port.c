@@ -557,6 +557,17 @@ PJ_DEF(pj_status_t) pjmedia_snd_port_reset_ec_state( pjmedia_snd_port *snd_port
 }
 
 
+/* Get software EC statistics */
+PJ_DEF(pj_status_t) pjmedia_snd_port_get_ec_stat( pjmedia_snd_port *snd_port,
+						  pjmedia_echo_stat *p_stat)
+{
+    PJ_ASSERT_RETURN(snd_port && p_stat, PJ_EINVAL);
+    if (!snd_port->ec_state)
+	return PJ_ENOTFOUND;
+    return pjmedia_echo_get_stat(snd_port->ec_state, p_stat);
+}
+
+
 /*
  * Change EC settings.
  */
@@ -23,6 +23,8 @@
 #include <pjmedia/rtcp.h>
 #include <pjmedia/jbuf.h>
 #include <pjmedia/stream_common.h>
+#include <pjmedia/circbuf.h>
+#include <pjmedia/wsola.h>
 #include <pj/array.h>
 #include <pj/assert.h>
 #include <pj/ctype.h>
@@ -147,10 +149,46 @@ struct pjmedia_stream
     pj_uint32_t		     ts_vad_disabled;/**< TS when VAD was disabled. */
     pj_uint32_t		     tx_duration;   /**< TX duration in timestamp.  */
 
+    const void		    *tx_payload;    /**< Payload to transmit instead
+						 of encoding, during
+						 put_frame_shared() and
+						 relay_frame().		    */
+    pj_size_t		     tx_payload_size;/**< Size of tx_payload.	    */
+    pj_bool_t		     tx_enc_valid;  /**< Is the payload in enc's
+						 out_pkt encoded audio of
+						 the last frame?	    */
+    pj_timestamp	     tx_enc_ts;	    /**< Timestamp of that frame.   */
+    pj_size_t		     tx_enc_size;   /**< Size of the payload.	    */
+    pj_bool_t		     tx_enc_stale;  /**< Were payloads of another
+						 stream transmitted since
+						 the codec last encoded? */
+
     pj_mutex_t		    *jb_mutex;
     pjmedia_jbuf	    *jb;	    /**< Jitter buffer.		    */
     char		     jb_last_frm;   /**< Last frame type from jb    */
     unsigned		     jb_last_frm_cnt;/**< Last JB frame type counter*/
+    pj_bool_t		     jb_split_pkt;  /**< Have the frames in the jb
+						 been split from a payload
+						 that can't be rebuilt by
+						 concatenating them?	    */
+    char		    *relay_buf;	    /**< Payload being relayed.	    */
+    unsigned		     fec_window;    /**< # of get_frame() calls the
+						 loss rate is measured over,
+						 zero if no FEC lookahead.  */
+    unsigned		     fec_call_cnt;  /**< # of calls in the window.  */
+    pj_uint32_t		     fec_last_pkt;  /**< RX packets at window start.*/
+    unsigned		     fec_last_loss; /**< RX loss at window start.   */
+    pj_bool_t		     fec_lookahead; /**< Extra frame held in jb?    */
+
+#if defined(PJMEDIA_STREAM_ADAPTIVE_PLAYOUT) && \
+    PJMEDIA_STREAM_ADAPTIVE_PLAYOUT!=0
+    pjmedia_wsola	    *ts_wsola;	    /**< WSOLA for time-scaling.    */
+    pjmedia_circ_buf	    *ts_buf;	    /**< Decoded samples to play.   */
+    pj_int16_t		    *ts_frame;	    /**< Frame to decode into.	    */
+    unsigned		     ts_spf;	    /**< WSOLA samples per frame.   */
+    pj_bool_t		     ts_expanded;   /**< Was synthetic audio added
+						 after the last frame?	    */
+#endif
 
     pjmedia_rtcp_session     rtcp;	    /**< RTCP for incoming RTP.	    */
 
@@ -468,6 +506,89 @@ static void send_keep_alive_packet(pjmedia_stream *stream)
 }
 #endif	/* defined(PJMEDIA_STREAM_ENABLE_KA) */
 
+/*
+ * Recover the missing frame with the specified sequence number from the
+ * FEC data of the next frame in the jitter buffer, if it's there.
+ */
+static pj_status_t recover_fec(pjmedia_stream *stream, int seq,
+			       unsigned out_size, pjmedia_frame *frame_out)
+{
+    pjmedia_frame next;
+    const void *buf;
+    pj_size_t size;
+    char frame_type;
+    pj_uint32_t bit_info;
+    int next_seq;
+
+    pjmedia_jbuf_peek_frame(stream->jb, 0, &buf, &size, &frame_type,
+			    &bit_info, NULL, &next_seq);
+    if (frame_type != PJMEDIA_JB_NORMAL_FRAME || next_seq != seq + 1)
+	return PJ_ENOTFOUND;
+
+    next.type = PJMEDIA_FRAME_TYPE_AUDIO;
+    next.buf = (void*) buf;
+    next.size = size;
+    next.bit_info = bit_info;
+    return pjmedia_codec_recover_fec(stream->codec, &next, out_size,
+				     frame_out);
+}
+
+
+/*
+ * Measure the packet loss rate, and hold one more frame in the jitter
+ * buffer for FEC recovery while the loss rate is high.
+ */
+static void update_fec_lookahead(pjmedia_stream *stream)
+{
+    pj_uint32_t pkt;
+    unsigned loss, loss_pct;
+
+    if (stream->fec_window == 0 ||
+	++stream->fec_call_cnt < stream->fec_window)
+    {
+	return;
+    }
+
+    /* Lost packets are counted by RTCP, whether or not the jitter buffer
+     * gets to see the gap. The counters go backwards when the statistics
+     * are reset, or when packets counted as lost arrive late, in which
+     * case the window is skipped.
+     */
+    if (stream->rtcp.stat.rx.pkt < stream->fec_last_pkt ||
+	stream->rtcp.stat.rx.loss < stream->fec_last_loss)
+    {
+	pkt = loss = 0;
+    } else {
+	pkt = stream->rtcp.stat.rx.pkt - stream->fec_last_pkt;
+	loss = stream->rtcp.stat.rx.loss - stream->fec_last_loss;
+    }
+    stream->fec_last_pkt = stream->rtcp.stat.rx.pkt;
+    stream->fec_last_loss = stream->rtcp.stat.rx.loss;
+    stream->fec_call_cnt = 0;
+
+    if (pkt + loss == 0)
+	return;
+    loss_pct = (unsigned)((pj_uint64_t)loss * 100 / (pkt + loss));
+
+    if (!stream->fec_lookahead &&
+	loss_pct >= PJMEDIA_STREAM_FEC_LOSS_THRESHOLD)
+    {
+	stream->fec_lookahead = PJ_TRUE;
+    } else if (stream->fec_lookahead &&
+	       loss_pct * 2 < PJMEDIA_STREAM_FEC_LOSS_THRESHOLD)
+    {
+	stream->fec_lookahead = PJ_FALSE;
+    } else {
+	return;
+    }
+
+    pjmedia_jbuf_set_lookahead(stream->jb, stream->fec_lookahead? 1 : 0);
+    PJ_LOG(5,(stream->port.info.name.ptr,
+	      "Packet loss %d%%, FEC lookahead %s", loss_pct,
+	      (stream->fec_lookahead? "enabled" : "disabled")));
+}
+
+
 /*
  * play_callback()
  *
@@ -496,6 +617,8 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
     /* Lock jitter buffer mutex first */
     pj_mutex_lock( stream->jb_mutex );
 
+    update_fec_lookahead(stream);
+
     samples_required = PJMEDIA_PIA_SPF(&stream->port.info);
     samples_per_frame = stream->codec_param.info.frm_ptime *
 			stream->codec_param.info.clock_rate *
@@ -509,10 +632,11 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
 	char frame_type;
 	pj_size_t frame_size;
 	pj_uint32_t bit_info;
+	int seq;
 
 	/* Get frame from jitter buffer. */
-	pjmedia_jbuf_get_frame2(stream->jb, channel->out_pkt, &frame_size,
-			        &frame_type, &bit_info);
+	pjmedia_jbuf_get_frame3(stream->jb, channel->out_pkt, &frame_size,
+			        &frame_type, &bit_info, NULL, &seq);
 
 #if TRACE_JB
 	trace_jb_get(stream, frame_type, frame_size);
@@ -520,8 +644,26 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
 
 	if (frame_type == PJMEDIA_JB_MISSING_FRAME) {
 
-	    /* Activate PLC */
-	    if (stream->codec->op->recover &&
+	    status = -1;
+
+	    /* Recover from the FEC data of the next frame if possible */
+	    if (stream->codec->op->recover_fec &&
+		stream->codec_param.setting.plc)
+	    {
+		pjmedia_frame frame_out;
+
+		frame_out.buf = p_out_samp + samples_count;
+		frame_out.size = frame->size - samples_count*BYTES_PER_SAMPLE;
+		status = recover_fec(stream, seq,
+				     samples_per_frame*BYTES_PER_SAMPLE,
+				     &frame_out);
+		if (status == PJ_SUCCESS)
+		    stream->plc_cnt = 0;
+	    }
+
+	    /* Otherwise activate PLC */
+	    if (status != PJ_SUCCESS &&
+		stream->codec->op->recover &&
 		stream->codec_param.setting.plc &&
 		stream->plc_cnt < stream->max_plc_cnt)
 	    {
@@ -534,9 +676,6 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
 					       &frame_out);
 
 		++stream->plc_cnt;
-
-	    } else {
-		status = -1;
 	    }
 
 	    if (status != PJ_SUCCESS) {
@@ -730,6 +869,152 @@ static pj_status_t get_frame( pjmedia_port *port, pjmedia_frame *frame)
 }
 
 
+#if defined(PJMEDIA_STREAM_ADAPTIVE_PLAYOUT) && \
+    PJMEDIA_STREAM_ADAPTIVE_PLAYOUT!=0
+
+/*
+ * Decode frames with get_frame() into the time-scaling buffer until it
+ * has at least the specified number of samples.
+ */
+static void fill_ts_buf(pjmedia_stream *stream, unsigned count)
+{
+    unsigned samples_required = PJMEDIA_PIA_SPF(&stream->port.info);
+    unsigned i;
+
+    while (pjmedia_circ_buf_get_len(stream->ts_buf) < count) {
+	pjmedia_frame frame;
+
+	frame.buf = stream->ts_frame;
+	frame.size = samples_required * BYTES_PER_SAMPLE;
+	get_frame(&stream->port, &frame);
+	if (frame.type != PJMEDIA_FRAME_TYPE_AUDIO)
+	    break;
+
+	/* Keep WSOLA up to date, it merges the frame with the synthetic
+	 * audio added before it.
+	 */
+	for (i = 0; i < samples_required; i += stream->ts_spf) {
+	    pjmedia_wsola_save(stream->ts_wsola, stream->ts_frame + i,
+			       stream->ts_expanded);
+	    stream->ts_expanded = PJ_FALSE;
+	}
+
+	pjmedia_circ_buf_write(stream->ts_buf, stream->ts_frame,
+			       samples_required);
+    }
+}
+
+
+/* The version of get_frame callback used for adaptive playout. The audio
+ * is decoded into a buffer, where it is compressed or stretched to move
+ * the jitter buffer size towards the burst level.
+ */
+static pj_status_t get_frame_stretch( pjmedia_port *port,
+				      pjmedia_frame *frame)
+{
+    pjmedia_stream *stream = (pjmedia_stream*) port->port_data.pdata;
+    unsigned samples_required, samples_per_frame, buf_len;
+    unsigned level, target;
+    pjmedia_jb_state jb_state;
+    pj_bool_t normal;
+
+    /* Return no frame is channel is paused */
+    if (stream->dec->paused) {
+	frame->type = PJMEDIA_FRAME_TYPE_NONE;
+	return PJ_SUCCESS;
+    }
+
+    samples_required = PJMEDIA_PIA_SPF(&stream->port.info);
+    samples_per_frame = stream->codec_param.info.frm_ptime *
+			stream->codec_param.info.clock_rate *
+			stream->codec_param.info.channel_cnt /
+			1000;
+
+    /* Compare the frames buffered, including the decoded samples not
+     * played yet, with the burst level.
+     */
+    pj_mutex_lock( stream->jb_mutex );
+    pjmedia_jbuf_get_state(stream->jb, &jb_state);
+    normal = (stream->jb_last_frm == PJMEDIA_JB_NORMAL_FRAME);
+    pj_mutex_unlock( stream->jb_mutex );
+
+    buf_len = pjmedia_circ_buf_get_len(stream->ts_buf);
+    level = jb_state.size + buf_len / samples_per_frame;
+    target = jb_state.burst + (stream->fec_lookahead? 1 : 0);
+
+    if (normal && jb_state.size && level < target) {
+	/* Stretch: add one WSOLA frame of synthetic audio, and take fewer
+	 * frames from the jitter buffer. An empty jitter buffer is left to
+	 * the prefetching and PLC in get_frame().
+	 */
+	if (pjmedia_wsola_generate(stream->ts_wsola,
+				   stream->ts_frame) == PJ_SUCCESS)
+	{
+	    pjmedia_circ_buf_write(stream->ts_buf, stream->ts_frame,
+				   stream->ts_spf);
+	    stream->ts_expanded = PJ_TRUE;
+
+	    PJ_LOG(6,(stream->port.info.name.ptr,
+		      "Playout stretched, jb size=%d burst=%d",
+		      jb_state.size, jb_state.burst));
+	}
+
+    } else if (normal && level > target + 1) {
+	/* Compress: erase half a WSOLA frame or more, at a pitch period
+	 * boundary, from the decoded samples.
+	 */
+	pj_int16_t *buf1, *buf2;
+	unsigned buf1_len, buf2_len, erase_cnt = stream->ts_spf >> 1;
+
+	fill_ts_buf(stream, samples_required + stream->ts_spf * 2);
+
+	buf_len = pjmedia_circ_buf_get_len(stream->ts_buf);
+	if (buf_len >= samples_required + stream->ts_spf * 2) {
+	    pjmedia_circ_buf_get_read_regions(stream->ts_buf, &buf1,
+					      &buf1_len, &buf2, &buf2_len);
+	    if (pjmedia_wsola_discard(stream->ts_wsola, buf1, buf1_len,
+				      buf2, buf2_len,
+				      &erase_cnt) == PJ_SUCCESS &&
+		erase_cnt > 0)
+	    {
+		pjmedia_circ_buf_set_len(stream->ts_buf, buf_len - erase_cnt);
+
+		PJ_LOG(6,(stream->port.info.name.ptr,
+			  "Playout compressed by %d samples, jb size=%d "
+			  "burst=%d", erase_cnt, jb_state.size,
+			  jb_state.burst));
+	    }
+	}
+    }
+
+    fill_ts_buf(stream, samples_required);
+
+    /* Give what the buffer has, padded with zeroes */
+    buf_len = pjmedia_circ_buf_get_len(stream->ts_buf);
+    if (buf_len == 0) {
+	frame->type = PJMEDIA_FRAME_TYPE_NONE;
+	frame->size = 0;
+	return PJ_SUCCESS;
+    }
+
+    if (buf_len > samples_required)
+	buf_len = samples_required;
+    pjmedia_circ_buf_read(stream->ts_buf, (pj_int16_t*)frame->buf, buf_len);
+    if (buf_len < samples_required) {
+	pjmedia_zero_samples((pj_int16_t*)frame->buf + buf_len,
+			     samples_required - buf_len);
+    }
+
+    frame->type = PJMEDIA_FRAME_TYPE_AUDIO;
+    frame->size = samples_required * BYTES_PER_SAMPLE;
+    frame->timestamp.u64 = 0;
+
+    return PJ_SUCCESS;
+}
+
+#endif	/* PJMEDIA_STREAM_ADAPTIVE_PLAYOUT */
+
+
 /* The other version of get_frame callback used when stream port format
  * is non linear PCM.
  */
@@ -1150,6 +1435,20 @@ static void rebuffer(pjmedia_stream *stream,
 }
 
 
+/*
+ * Reset the encoder if payloads of another stream were transmitted since
+ * it last encoded, so that a codec keeping state between frames doesn't
+ * continue from the state of a frame long gone.
+ */
+static void reset_stale_enc(pjmedia_stream *stream)
+{
+    if (stream->tx_enc_stale) {
+	pjmedia_codec_reset_enc(stream->codec);
+	stream->tx_enc_stale = PJ_FALSE;
+    }
+}
+
+
 /**
  * put_frame_imp()
  */
@@ -1185,6 +1484,9 @@ static pj_status_t put_frame_imp( pjmedia_port *port,
     }
 #endif
 
+    /* The payload of the last frame is about to be overwritten */
+    stream->tx_enc_valid = PJ_FALSE;
+
     /* Don't do anything if stream is paused */
     if (channel->paused) {
 	stream->enc_buf_pos = stream->enc_buf_count = 0;
@@ -1278,6 +1580,8 @@ static pj_status_t put_frame_imp( pjmedia_port *port,
 	silence_frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
 	silence_frame.timestamp.u32.lo = pj_ntohl(stream->enc->rtp.out_hdr.ts);
 
+	reset_stale_enc(stream);
+
 	/* Encode! */
 	status = pjmedia_codec_encode( stream->codec, &silence_frame,
 				       channel->out_pkt_size -
@@ -1302,17 +1606,33 @@ static pj_status_t put_frame_imp( pjmedia_port *port,
 	        frame->buf != NULL) ||
 	       (frame->type == PJMEDIA_FRAME_TYPE_EXTENDED))
     {
-	/* Encode! */
-	status = pjmedia_codec_encode( stream->codec, frame,
-				       channel->out_pkt_size -
-				       sizeof(pjmedia_rtp_hdr),
-				       &frame_out);
-	if (status != PJ_SUCCESS) {
-	    LOGERR_((stream->port.info.name.ptr,
-		    "Codec encode() error", status));
-	    return status;
+	if (stream->tx_payload &&
+	    stream->tx_payload_size <= channel->out_pkt_size -
+				       sizeof(pjmedia_rtp_hdr))
+	{
+	    /* Take the payload encoded by another stream */
+	    frame_out.size = stream->tx_payload_size;
+	    pj_memcpy(frame_out.buf, stream->tx_payload, frame_out.size);
+	    stream->tx_enc_stale = PJ_TRUE;
+	} else {
+	    reset_stale_enc(stream);
+
+	    /* Encode! */
+	    status = pjmedia_codec_encode( stream->codec, frame,
+					   channel->out_pkt_size -
+					   sizeof(pjmedia_rtp_hdr),
+					   &frame_out);
+	    if (status != PJ_SUCCESS) {
+		LOGERR_((stream->port.info.name.ptr,
+			"Codec encode() error", status));
+		return status;
+	    }
 	}
 
+	stream->tx_enc_valid = PJ_TRUE;
+	stream->tx_enc_ts = frame->timestamp;
+	stream->tx_enc_size = frame_out.size;
+
 	/* Encapsulate. */
 	status = pjmedia_rtp_encode_rtp( &channel->rtp,
 					 channel->pt, 0,
@@ -1832,6 +2152,16 @@ static void on_rx_rtp( void *data,
 		  1000;
 #endif
 
+	/* Frames that the codec parses by bit position or out of a whole
+	 * payload (bit_info is set) can't be rejoined into that payload.
+	 */
+	if (count > 1 && !stream->jb_split_pkt) {
+	    for (i=0; i<count; ++i) {
+		if (frames[i].bit_info)
+		    stream->jb_split_pkt = PJ_TRUE;
+	    }
+	}
+
 	/* Put each frame to jitter buffer. */
 	for (i=0; i<count; ++i) {
 	    unsigned ext_seq;
@@ -2221,6 +2551,14 @@ PJ_DEF(pj_status_t) pjmedia_stream_create( pjmedia_endpt *endpt,
     stream->max_plc_cnt = (MAX_PLC_MSEC+stream->codec_param.info.frm_ptime-1)/
 			    stream->codec_param.info.frm_ptime;
 
+    /* Measure the loss rate for FEC recovery over about five seconds */
+    if (stream->codec->op->recover_fec &&
+	PJMEDIA_STREAM_FEC_LOSS_THRESHOLD > 0)
+    {
+	stream->fec_window = 5000 / stream->codec_param.info.frm_ptime /
+			     stream->codec_param.setting.frm_per_pkt;
+    }
+
 #if defined(PJMEDIA_HANDLE_G722_MPEG_BUG) && (PJMEDIA_HANDLE_G722_MPEG_BUG!=0)
     stream->rtp_rx_check_cnt = 50;
     stream->has_g722_mpeg_bug = PJ_FALSE;
@@ -2282,6 +2620,41 @@ PJ_DEF(pj_status_t) pjmedia_stream_create( pjmedia_endpt *endpt,
     /* Set up jitter buffer */
     pjmedia_jbuf_set_adaptive( stream->jb, jb_init, jb_min_pre, jb_max_pre);
 
+#if defined(PJMEDIA_STREAM_ADAPTIVE_PLAYOUT) && \
+    PJMEDIA_STREAM_ADAPTIVE_PLAYOUT!=0
+    /* Set up adaptive playout, which takes over reducing the delay from
+     * the jitter buffer. WSOLA works on 10 ms frames when the frame size
+     * allows, so the audio is compressed or stretched in small steps.
+     */
+    if (stream->port.get_frame == &get_frame) {
+	unsigned samples_required = PJMEDIA_PIA_SPF(&stream->port.info);
+
+	stream->ts_spf = afd->clock_rate * afd->channel_count / 100;
+	if (samples_required % stream->ts_spf)
+	    stream->ts_spf = samples_required;
+
+	status = pjmedia_wsola_create(pool, afd->clock_rate, stream->ts_spf,
+				      afd->channel_count,
+				      PJMEDIA_WSOLA_NO_FADING,
+				      &stream->ts_wsola);
+	if (status != PJ_SUCCESS)
+	    goto err_cleanup;
+
+	status = pjmedia_circ_buf_create(pool, samples_required * 2 +
+					       stream->ts_spf * 3,
+					 &stream->ts_buf);
+	if (status != PJ_SUCCESS)
+	    goto err_cleanup;
+
+	stream->ts_frame = (pj_int16_t*)
+			   pj_pool_alloc(pool, samples_required *
+					       BYTES_PER_SAMPLE);
+
+	pjmedia_jbuf_set_discard(stream->jb, PJMEDIA_JB_DISCARD_NONE);
+	stream->port.get_frame = &get_frame_stretch;
+    }
+#endif
+
     /* Create decoder channel: */
 
     status = create_channel( pool, stream, PJMEDIA_DIR_DECODING,
@@ -2297,6 +2670,9 @@ PJ_DEF(pj_status_t) pjmedia_stream_create( pjmedia_endpt *endpt,
     if (status != PJ_SUCCESS)
 	goto err_cleanup;
 
+    /* Buffer to rebuild the received payload, for relaying */
+    stream->relay_buf = (char*) pj_pool_alloc(pool, stream->dec->out_pkt_size);
+
 
     /* Init RTCP session: */
 
@@ -2556,6 +2932,15 @@ PJ_DEF(pj_status_t) pjmedia_stream_destroy( pjmedia_stream *stream )
     if (stream->jb)
 	pjmedia_jbuf_destroy(stream->jb);
 
+#if defined(PJMEDIA_STREAM_ADAPTIVE_PLAYOUT) && \
+    PJMEDIA_STREAM_ADAPTIVE_PLAYOUT!=0
+    /* Destroy WSOLA of adaptive playout */
+    if (stream->ts_wsola) {
+	pjmedia_wsola_destroy(stream->ts_wsola);
+	stream->ts_wsola = NULL;
+    }
+#endif
+
 #if TRACE_JB
     if (TRACE_JB_OPENED(stream)) {
 	pj_file_close(stream->trace_jb_fd);
@@ -2592,6 +2977,223 @@ PJ_DEF(pj_status_t) pjmedia_stream_get_port( pjmedia_stream *stream,
 }
 
 
+/*
+ * Compare codec fmtp parameters.
+ */
+static pj_bool_t fmtp_equal(const pjmedia_codec_fmtp *a,
+			    const pjmedia_codec_fmtp *b)
+{
+    unsigned i;
+
+    if (a->cnt != b->cnt)
+	return PJ_FALSE;
+
+    for (i = 0; i < a->cnt; ++i) {
+	if (pj_stricmp(&a->param[i].name, &b->param[i].name) != 0 ||
+	    pj_strcmp(&a->param[i].val, &b->param[i].val) != 0)
+	{
+	    return PJ_FALSE;
+	}
+    }
+    return PJ_TRUE;
+}
+
+
+/*
+ * Check whether both streams encode the same audio to the same payload.
+ */
+static pj_bool_t same_encoding(const pjmedia_stream *stream,
+			       const pjmedia_stream *enc_src)
+{
+    const pjmedia_codec_param *p1 = &stream->codec_param;
+    const pjmedia_codec_param *p2 = &enc_src->codec_param;
+
+    /* Frames passed through the encoding buffer are not the frames given
+     * to the port.
+     */
+    if (stream->enc_buf || enc_src->enc_buf || !stream->codec ||
+	!enc_src->codec)
+    {
+	return PJ_FALSE;
+    }
+
+    /* The payload type may differ, it is not part of the payload */
+    return stream->codec->factory == enc_src->codec->factory &&
+	   pj_stricmp(&stream->si.fmt.encoding_name,
+		      &enc_src->si.fmt.encoding_name) == 0 &&
+	   stream->si.fmt.clock_rate == enc_src->si.fmt.clock_rate &&
+	   stream->si.fmt.channel_cnt == enc_src->si.fmt.channel_cnt &&
+	   stream->enc_samples_per_pkt == enc_src->enc_samples_per_pkt &&
+	   p1->info.avg_bps == p2->info.avg_bps &&
+	   p1->info.max_bps == p2->info.max_bps &&
+	   p1->info.frm_ptime == p2->info.frm_ptime &&
+	   p1->setting.frm_per_pkt == p2->setting.frm_per_pkt &&
+	   p1->setting.vad == p2->setting.vad &&
+	   p1->setting.cng == p2->setting.cng &&
+	   fmtp_equal(&p1->setting.enc_fmtp, &p2->setting.enc_fmtp) &&
+	   fmtp_equal(&p1->setting.dec_fmtp, &p2->setting.dec_fmtp);
+}
+
+
+/*
+ * Check whether the stream can transmit the payload of enc_src. A stream
+ * sharing the payload doesn't run its own encoder, so this is limited to
+ * the codecs which keep no state between frames (G.711), and those whose
+ * encoder can be reset before the stream encodes again. Otherwise the
+ * stream would resume from a stale encoder state once its audio differs.
+ */
+PJ_DEF(pj_bool_t) pjmedia_stream_can_share_enc(const pjmedia_stream *stream,
+					       const pjmedia_stream *enc_src)
+{
+    PJ_ASSERT_RETURN(stream && enc_src, PJ_FALSE);
+
+    if (!same_encoding(stream, enc_src))
+	return PJ_FALSE;
+
+    return pj_stricmp2(&stream->si.fmt.encoding_name, "PCMU") == 0 ||
+	   pj_stricmp2(&stream->si.fmt.encoding_name, "PCMA") == 0 ||
+	   stream->codec->op->reset_enc != NULL;
+}
+
+
+/*
+ * Transmit a frame with the payload encoded by enc_src.
+ */
+PJ_DEF(pj_status_t) pjmedia_stream_put_frame_shared(pjmedia_stream *stream,
+						    pjmedia_stream *enc_src,
+						    pjmedia_frame *frame)
+{
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(stream && enc_src && frame, PJ_EINVAL);
+
+    if (enc_src->tx_enc_valid &&
+	enc_src->tx_enc_ts.u64 == frame->timestamp.u64 &&
+	stream->enc_buf == NULL)
+    {
+	stream->tx_payload = (char*)enc_src->enc->out_pkt +
+			     sizeof(pjmedia_rtp_hdr);
+	stream->tx_payload_size = enc_src->tx_enc_size;
+    }
+
+    status = put_frame(&stream->port, frame);
+    stream->tx_payload = NULL;
+
+    return status;
+}
+
+
+/*
+ * Check whether the payload received by the stream can be relayed to dst.
+ */
+PJ_DEF(pj_bool_t) pjmedia_stream_can_relay(const pjmedia_stream *stream,
+					   const pjmedia_stream *dst)
+{
+    PJ_ASSERT_RETURN(stream && dst, PJ_FALSE);
+
+    return stream->port.info.fmt.id == PJMEDIA_FORMAT_L16 &&
+	   dst->port.info.fmt.id == PJMEDIA_FORMAT_L16 &&
+	   (stream->dir & PJMEDIA_DIR_DECODING) &&
+	   (dst->dir & PJMEDIA_DIR_ENCODING) &&
+	   !stream->jb_split_pkt &&
+#if defined(PJMEDIA_STREAM_ADAPTIVE_PLAYOUT) && \
+    PJMEDIA_STREAM_ADAPTIVE_PLAYOUT!=0
+	   stream->ts_buf == NULL &&
+#endif
+	   same_encoding(dst, stream);
+}
+
+
+/*
+ * Transmit the frames in the jitter buffer of the stream with dst.
+ */
+PJ_DEF(pj_status_t) pjmedia_stream_relay_frame(pjmedia_stream *stream,
+					       pjmedia_stream *dst,
+					       const pj_timestamp *ts)
+{
+    pjmedia_channel *channel = stream->dec;
+    unsigned samples_count, samples_per_frame, samples_required;
+    pj_size_t size = 0, max_size;
+    pj_bool_t complete = PJ_TRUE;
+    pjmedia_frame frame;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(stream && dst && ts, PJ_EINVAL);
+    PJ_ASSERT_RETURN(dst->enc_buf == NULL, PJ_EINVALIDOP);
+
+    /* The payload must fit in the relay buffer, and in the packet of dst
+     * after the RTP header.
+     */
+    max_size = dst->enc->out_pkt_size - sizeof(pjmedia_rtp_hdr);
+    if (max_size > channel->out_pkt_size)
+	max_size = channel->out_pkt_size;
+
+    samples_required = PJMEDIA_PIA_SPF(&stream->port.info);
+    samples_per_frame = stream->codec_param.info.frm_ptime *
+			stream->codec_param.info.clock_rate *
+			stream->codec_param.info.channel_cnt /
+			1000;
+
+    /* Take the frames of one packet from the jitter buffer, as get_frame()
+     * would, but without decoding them. The payload is only relayed when
+     * all of them are there, otherwise dst transmits nothing this time.
+     */
+    if (channel->paused) {
+	complete = PJ_FALSE;
+    } else {
+	pj_mutex_lock( stream->jb_mutex );
+
+	for (samples_count=0; samples_count < samples_required;
+	     samples_count += samples_per_frame)
+	{
+	    char frame_type;
+	    pj_size_t frame_size;
+	    pj_uint32_t bit_info;
+
+	    pjmedia_jbuf_get_frame2(stream->jb, channel->out_pkt, &frame_size,
+				    &frame_type, &bit_info);
+
+	    if (frame_type != stream->jb_last_frm) {
+		stream->jb_last_frm = frame_type;
+		stream->jb_last_frm_cnt = 1;
+	    } else {
+		stream->jb_last_frm_cnt++;
+	    }
+
+	    if (frame_type == PJMEDIA_JB_NORMAL_FRAME) {
+		stream->plc_cnt = 0;
+		if (complete && size + frame_size <= max_size) {
+		    pj_memcpy(stream->relay_buf + size, channel->out_pkt,
+			      frame_size);
+		    size += frame_size;
+		} else {
+		    complete = PJ_FALSE;
+		}
+	    } else {
+		complete = PJ_FALSE;
+		if (frame_type != PJMEDIA_JB_MISSING_FRAME)
+		    break;
+	    }
+	}
+
+	pj_mutex_unlock( stream->jb_mutex );
+    }
+
+    frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
+    frame.buf = stream->relay_buf;
+    frame.size = PJMEDIA_PIA_SPF(&dst->port.info) * BYTES_PER_SAMPLE;
+    frame.timestamp = *ts;
+    frame.bit_info = 0;
+
+    dst->tx_payload = stream->relay_buf;
+    dst->tx_payload_size = complete ? size : 0;
+    status = put_frame(&dst->port, &frame);
+    dst->tx_payload = NULL;
+
+    return status;
+}
+
+
 /*
  * Get the transport object
  */
@@ -2660,6 +3262,13 @@ PJ_DEF(pj_status_t) pjmedia_stream_reset_stat(pjmedia_stream *stream)
 
     pjmedia_rtcp_init_stat(&stream->rtcp.stat);
 
+    /* Measure the loss rate for the FEC lookahead from the new counters */
+    pj_mutex_lock(stream->jb_mutex);
+    stream->fec_last_pkt = 0;
+    stream->fec_last_loss = 0;
+    stream->fec_call_cnt = 0;
+    pj_mutex_unlock(stream->jb_mutex);
+
     return PJ_SUCCESS;
 }
 
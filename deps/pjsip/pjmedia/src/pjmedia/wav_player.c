@@ -24,7 +24,9 @@
 #include <pj/assert.h>
 #include <pj/file_access.h>
 #include <pj/file_io.h>
+#include <pj/list.h>
 #include <pj/log.h>
+#include <pj/os.h>
 #include <pj/pool.h>
 #include <pj/string.h>
 
@@ -53,6 +55,31 @@
 #   define samples_to_host(samples,count)
 #endif
 
+/* Decoded samples of a file, shared by the players created with
+ * PJMEDIA_FILE_SHARED. The list of these is protected by the pjlib
+ * critical section, the samples are read only once loaded.
+ */
+struct shared_wav
+{
+    PJ_DECL_LIST_MEMBER(struct shared_wav);
+    pj_pool_t	    *pool;
+    char	    *filename;
+    pj_off_t	     fsize;
+    pj_time_val	     mtime;
+    unsigned	     ref_cnt;
+
+    pjmedia_wave_fmt_tag fmt_tag;	/* Format of the file.		*/
+    unsigned	     clock_rate;
+    unsigned	     channel_count;
+    unsigned	     start_data;
+    unsigned	     data_len;
+    char	    *buf;		/* 16 bit samples in host order	*/
+    pj_uint32_t	     bufsize;
+};
+
+static struct shared_wav shared_wav_list = { &shared_wav_list,
+					     &shared_wav_list };
+
 struct file_reader_port
 {
     pjmedia_port     base;
@@ -71,6 +98,7 @@ struct file_reader_port
     unsigned         data_left;
     pj_off_t	     fpos;
     pj_oshandle_t    fd;
+    struct shared_wav *shared;
 
     pj_status_t	   (*cb)(pjmedia_port*, void*);
 };
@@ -112,6 +140,13 @@ static pj_status_t fill_buffer(struct file_reader_port *fport)
     pj_ssize_t size;
     pj_status_t status;
 
+    /* The shared buffer holds the whole file, so reaching its end is EOF */
+    if (fport->shared) {
+	fport->eof = PJ_TRUE;
+	fport->eofpos = fport->buf;
+	return PJ_SUCCESS;
+    }
+
     fport->eofpos = NULL;
     
     while (size_left > 0) {
@@ -175,6 +210,169 @@ static pj_status_t fill_buffer(struct file_reader_port *fport)
 }
 
 
+/*
+ * Find the shared samples of a file, and take a reference to them. The file
+ * is identified by its name, size and modification time, so that a changed
+ * file is loaded again. Must be called in the critical section.
+ */
+static struct shared_wav *find_shared_wav(const char *filename,
+					  const pj_file_stat *st)
+{
+    struct shared_wav *sw = shared_wav_list.next;
+
+    for (; sw != &shared_wav_list; sw = sw->next) {
+	if (sw->fsize == st->size && PJ_TIME_VAL_EQ(sw->mtime, st->mtime) &&
+	    pj_ansi_strcmp(sw->filename, filename) == 0)
+	{
+	    ++sw->ref_cnt;
+	    return sw;
+	}
+    }
+    return NULL;
+}
+
+/*
+ * Read and decode the data chunk of the file that fport has just parsed,
+ * and add it to the shared list. If another player has loaded the file in
+ * the meantime, its samples are used instead.
+ */
+static pj_status_t load_shared_wav(pj_pool_t *pool,
+				   struct file_reader_port *fport,
+				   const char *filename,
+				   const pj_file_stat *st,
+				   struct shared_wav **p_sw)
+{
+    struct shared_wav *sw, *other;
+    pj_pool_t *sw_pool;
+    char *data;
+    pj_uint32_t len, i;
+    pj_ssize_t size;
+    pj_status_t status;
+
+    len = fport->data_len;
+    if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM)
+	len &= ~1;
+
+    sw_pool = pj_pool_create(pool->factory, "wavshared",
+			     len * 2 + 512, 4096, NULL);
+    if (!sw_pool)
+	return PJ_ENOMEM;
+
+    sw = PJ_POOL_ZALLOC_T(sw_pool, struct shared_wav);
+    sw->pool = sw_pool;
+    sw->filename = (char*) pj_pool_alloc(sw_pool,
+					  pj_ansi_strlen(filename) + 1);
+    pj_ansi_strcpy(sw->filename, filename);
+    sw->fsize = st->size;
+    sw->mtime = st->mtime;
+    sw->ref_cnt = 1;
+    sw->fmt_tag = fport->fmt_tag;
+    sw->clock_rate = PJMEDIA_PIA_SRATE(&fport->base.info);
+    sw->channel_count = PJMEDIA_PIA_CCNT(&fport->base.info);
+    sw->start_data = fport->start_data;
+    sw->data_len = fport->data_len;
+    sw->bufsize = (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) ? len : len*2;
+    sw->buf = (char*) pj_pool_alloc(sw_pool, sw->bufsize);
+
+    /* G.711 data is read into the second half of the buffer, and decoded
+     * forward: sample i is stored below data byte i+1.
+     */
+    data = sw->buf + sw->bufsize - len;
+    for (i = 0; i < len; i += (pj_uint32_t)size) {
+	size = len - i;
+	status = pj_file_read(fport->fd, data + i, &size);
+	if (status == PJ_SUCCESS && size <= 0)
+	    status = PJMEDIA_EWAVETOOSHORT;
+	if (status != PJ_SUCCESS) {
+	    pj_pool_release(sw_pool);
+	    return status;
+	}
+    }
+
+    if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
+	samples_to_host((pj_int16_t*)sw->buf, len / 2);
+    } else {
+	pj_int16_t *dst = (pj_int16_t*)sw->buf;
+	const pj_uint8_t *src = (const pj_uint8_t*)data;
+
+	if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_ULAW)
+	    pjmedia_ulaw_decode(dst, src, len);
+	else
+	    pjmedia_alaw_decode(dst, src, len);
+    }
+
+    pj_enter_critical_section();
+    other = find_shared_wav(filename, st);
+    if (!other)
+	pj_list_push_back(&shared_wav_list, sw);
+    pj_leave_critical_section();
+
+    if (other) {
+	pj_pool_release(sw_pool);
+	sw = other;
+    }
+
+    *p_sw = sw;
+    return PJ_SUCCESS;
+}
+
+/*
+ * Release a reference to shared samples.
+ */
+static void release_shared_wav(struct shared_wav *sw)
+{
+    pj_bool_t last;
+
+    pj_enter_critical_section();
+    last = (--sw->ref_cnt == 0);
+    if (last)
+	pj_list_erase(sw);
+    pj_leave_critical_section();
+
+    if (last)
+	pj_pool_release(sw->pool);
+}
+
+/*
+ * Make fport a player of the shared samples.
+ */
+static pj_status_t init_shared_port(pj_pool_t *pool,
+				    struct file_reader_port *fport,
+				    struct shared_wav *sw,
+				    const char *filename,
+				    unsigned ptime,
+				    unsigned options)
+{
+    pj_str_t name;
+    unsigned samples_per_frame;
+
+    samples_per_frame = ptime * sw->clock_rate * sw->channel_count / 1000;
+
+    /* Same checks as for the file, in samples rather than in bytes */
+    if (samples_per_frame * 2 > sw->bufsize)
+	return PJMEDIA_EWAVETOOSHORT;
+    if (samples_per_frame * 2 >= sw->bufsize)
+	return PJ_EINVAL;
+
+    pj_strdup2(pool, &name, filename);
+    pjmedia_port_info_init(&fport->base.info, &name, SIGNATURE,
+			   sw->clock_rate, sw->channel_count,
+			   BITS_PER_SAMPLE, samples_per_frame);
+
+    fport->options = options;
+    fport->shared = sw;
+    fport->fmt_tag = PJMEDIA_WAVE_FMT_TAG_PCM;
+    fport->bytes_per_sample = 2;
+    fport->fsize = sw->fsize;
+    fport->start_data = sw->start_data;
+    fport->data_len = sw->data_len;
+    fport->buf = fport->readpos = sw->buf;
+    fport->bufsize = sw->bufsize;
+
+    return PJ_SUCCESS;
+}
+
+
 /*
  * Create WAVE player port.
  */
@@ -192,6 +390,7 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_create( pj_pool_t *pool,
     pj_off_t pos;
     pj_str_t name;
     unsigned samples_per_frame;
+    pj_file_stat st;
     pj_status_t status = PJ_SUCCESS;
 
 
@@ -217,6 +416,29 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_create( pj_pool_t *pool,
 	return PJ_ENOMEM;
     }
 
+    /* Use the shared samples, if another player has loaded them */
+    if ((options & PJMEDIA_FILE_SHARED) &&
+	pj_file_getstat(filename, &st) == PJ_SUCCESS)
+    {
+	struct shared_wav *sw;
+
+	pj_enter_critical_section();
+	sw = find_shared_wav(filename, &st);
+	pj_leave_critical_section();
+
+	if (sw) {
+	    status = init_shared_port(pool, fport, sw, filename, ptime,
+				      options);
+	    if (status != PJ_SUCCESS) {
+		release_shared_wav(sw);
+		return status;
+	    }
+	    goto on_created;
+	}
+    } else {
+	options &= ~PJMEDIA_FILE_SHARED;
+    }
+
 
     /* Get the file size. */
     fport->fsize = pj_file_size(filename);
@@ -356,7 +578,6 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_create( pj_pool_t *pool,
     fport->options = options;
 
     /* Update port info. */
-    ad = pjmedia_format_get_audio_format_detail(&fport->base.info.fmt, 1);
     pj_strdup2(pool, &name, filename);
     samples_per_frame = ptime * wave_hdr.fmt_hdr.sample_rate *
 		        wave_hdr.fmt_hdr.nchan / 1000;
@@ -366,6 +587,26 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_create( pj_pool_t *pool,
 			   BITS_PER_SAMPLE,
 			   samples_per_frame);
 
+    /* Load the samples for sharing, and play them instead of the file */
+    if ((options & PJMEDIA_FILE_SHARED) &&
+	fport->data_len <= PJMEDIA_WAV_PLAYER_SHARED_MAX_SIZE)
+    {
+	struct shared_wav *sw;
+
+	status = load_shared_wav(pool, fport, filename, &st, &sw);
+	pj_file_close(fport->fd);
+	fport->fd = NULL;
+	if (status != PJ_SUCCESS)
+	    return status;
+
+	status = init_shared_port(pool, fport, sw, filename, ptime, options);
+	if (status != PJ_SUCCESS) {
+	    release_shared_wav(sw);
+	    return status;
+	}
+	goto on_created;
+    }
+
     /* If file is shorter than buffer size, adjust buffer size to file
      * size. Otherwise EOF callback will be called multiple times when
      * fill_buffer() is called.
@@ -406,19 +647,20 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_create( pj_pool_t *pool,
     }
 
     /* Done. */
-
+on_created:
     *p_port = &fport->base;
 
-
+    ad = pjmedia_format_get_audio_format_detail(&fport->base.info.fmt, 1);
     PJ_LOG(4,(THIS_FILE, 
 	      "File player '%.*s' created: samp.rate=%d, ch=%d, bufsize=%uKB, "
-	      "filesize=%luKB",
+	      "filesize=%luKB%s",
 	      (int)fport->base.info.name.slen,
 	      fport->base.info.name.ptr,
 	      ad->clock_rate,
 	      ad->channel_count,
 	      fport->bufsize / 1000,
-	      (unsigned long)(fport->fsize / 1000)));
+	      (unsigned long)(fport->fsize / 1000),
+	      (fport->shared ? ", shared" : "")));
 
     return PJ_SUCCESS;
 }
@@ -432,6 +674,7 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_get_info(
 					pjmedia_wav_player_info *info)
 {
     struct file_reader_port *fport;
+    pjmedia_wave_fmt_tag fmt_tag;
     PJ_ASSERT_RETURN(port && info, PJ_EINVAL);
 
     pj_bzero(info, sizeof(*info));
@@ -440,14 +683,15 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_get_info(
     PJ_ASSERT_RETURN(port->info.signature == SIGNATURE, PJ_EINVALIDOP);
 
     fport = (struct file_reader_port*) port;
+    fmt_tag = fport->shared ? fport->shared->fmt_tag : fport->fmt_tag;
 
-    if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
+    if (fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
 	info->fmt_id = PJMEDIA_FORMAT_PCM;
 	info->payload_bits_per_sample = 16;
-    } else if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_ULAW) {
+    } else if (fmt_tag == PJMEDIA_WAVE_FMT_TAG_ULAW) {
 	info->fmt_id = PJMEDIA_FORMAT_ULAW;
 	info->payload_bits_per_sample = 8;
-    } else if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_ALAW) {
+    } else if (fmt_tag == PJMEDIA_WAVE_FMT_TAG_ALAW) {
 	info->fmt_id = PJMEDIA_FORMAT_ALAW;
 	info->payload_bits_per_sample = 8;
     } else {
@@ -506,6 +750,20 @@ PJ_DEF(pj_status_t) pjmedia_wav_player_port_set_pos(pjmedia_port *port,
      */
     PJ_ASSERT_RETURN(bytes < fport->data_len, PJ_EINVAL);
 
+    /* Shared samples are 16 bit, whatever the file format is */
+    if (fport->shared) {
+	if (fport->shared->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM)
+	    bytes &= ~1;
+	else
+	    bytes *= 2;
+	if (bytes >= fport->bufsize)
+	    return PJ_EINVAL;
+
+	fport->readpos = fport->buf + bytes;
+	fport->eof = PJ_FALSE;
+	return PJ_SUCCESS;
+    }
+
     fport->fpos = fport->start_data + bytes;
     fport->data_left = fport->data_len - bytes;
     pj_file_setpos( fport->fd, fport->fpos, PJ_SEEK_SET);
@@ -537,6 +795,13 @@ PJ_DEF(pj_ssize_t) pjmedia_wav_player_port_get_pos( pjmedia_port *port )
 
     fport = (struct file_reader_port*) port;
 
+    if (fport->shared) {
+	payload_pos = fport->readpos - fport->buf;
+	if (fport->shared->fmt_tag != PJMEDIA_WAVE_FMT_TAG_PCM)
+	    payload_pos /= 2;
+	return payload_pos;
+    }
+
     payload_pos = (pj_size_t)(fport->fpos - fport->start_data);
     if (payload_pos >= fport->bufsize)
 	return payload_pos - fport->bufsize + (fport->readpos - fport->buf);
@@ -657,8 +922,12 @@ static pj_status_t file_get_frame(pjmedia_port *this_port,
 	pj_memcpy(frame->buf, fport->readpos, endread);
 
 	/* End Of Buffer and EOF and NO LOOP */
-	if (fport->eof && (fport->options & PJMEDIA_FILE_NO_LOOP)) {
+	if ((fport->eof || fport->shared) &&
+	    (fport->options & PJMEDIA_FILE_NO_LOOP))
+	{
 	    fport->readpos += endread;
+	    if (fport->shared)
+		fill_buffer(fport);
 
             if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
                 pj_bzero((char*)frame->buf + endread, frame_size - endread);
@@ -721,7 +990,10 @@ static pj_status_t file_on_destroy(pjmedia_port *this_port)
 
     pj_assert(this_port->info.signature == SIGNATURE);
 
-    pj_file_close(fport->fd);
+    if (fport->shared)
+	release_shared_wav(fport->shared);
+    else
+	pj_file_close(fport->fd);
     return PJ_SUCCESS;
 }
 
@@ -25,14 +25,24 @@
 #include <pj/file_access.h>
 #include <pj/file_io.h>
 #include <pj/log.h>
+#include <pj/os.h>
 #include <pj/pool.h>
 #include <pj/string.h>
 
 
 #define THIS_FILE	    "wav_writer.c"
 #define SIGNATURE	    PJMEDIA_SIG_PORT_WAV_WRITER
+#define ASYNC_BUF_CNT	    2
 
 
+/* Buffer of asynchronous writer, holding 16 bit samples */
+struct file_buf
+{
+    char	    *buf;
+    pj_size_t	     len;	/* Bytes to write, when full.		*/
+    pj_bool_t	     full;	/* Owned by the writer thread.		*/
+};
+
 struct file_port
 {
     pjmedia_port     base;
@@ -48,6 +58,21 @@ struct file_port
 
     pj_size_t	     cb_size;
     pj_status_t	   (*cb)(pjmedia_port*, void*);
+
+    /* With PJMEDIA_FILE_WRITE_ASYNC, buf is the buffer being filled by
+     * put_frame(), and writepos is NULL when no buffer is free. The mutex
+     * protects the full flags and wr_idx.
+     */
+    pj_bool_t	     async;
+    struct file_buf  abuf[ASYNC_BUF_CNT];
+    unsigned	     abuf_idx;	/* Buffer being filled.			*/
+    unsigned	     wr_idx;	/* Next buffer to be written.		*/
+    pj_mutex_t	    *mutex;
+    pj_sem_t	    *sem;
+    pj_thread_t	    *thread;
+    pj_bool_t	     quit;
+    pj_status_t	     wr_status;	/* Last write error.			*/
+    unsigned	     overruns;
 };
 
 static pj_status_t file_put_frame(pjmedia_port *this_port, 
@@ -55,6 +80,7 @@ static pj_status_t file_put_frame(pjmedia_port *this_port,
 static pj_status_t file_get_frame(pjmedia_port *this_port, 
 				  pjmedia_frame *frame);
 static pj_status_t file_on_destroy(pjmedia_port *this_port);
+static pj_status_t async_start(pj_pool_t *pool, struct file_port *fport);
 
 
 /*
@@ -74,6 +100,7 @@ PJ_DEF(pj_status_t) pjmedia_wav_writer_port_create( pj_pool_t *pool,
     pjmedia_wave_hdr wave_hdr;
     pj_ssize_t size;
     pj_str_t name;
+    unsigned fmt;
     pj_status_t status;
 
     /* Check arguments. */
@@ -98,10 +125,11 @@ PJ_DEF(pj_status_t) pjmedia_wav_writer_port_create( pj_pool_t *pool,
     fport->base.put_frame = &file_put_frame;
     fport->base.on_destroy = &file_on_destroy;
 
-    if (flags == PJMEDIA_FILE_WRITE_ALAW) {
+    fmt = flags & ~PJMEDIA_FILE_WRITE_ASYNC;
+    if (fmt == PJMEDIA_FILE_WRITE_ALAW) {
 	fport->fmt_tag = PJMEDIA_WAVE_FMT_TAG_ALAW;
 	fport->bytes_per_sample = 1;
-    } else if (flags == PJMEDIA_FILE_WRITE_ULAW) {
+    } else if (fmt == PJMEDIA_FILE_WRITE_ULAW) {
 	fport->fmt_tag = PJMEDIA_WAVE_FMT_TAG_ULAW;
 	fport->bytes_per_sample = 1;
     } else {
@@ -194,30 +222,44 @@ PJ_DEF(pj_status_t) pjmedia_wav_writer_port_create( pj_pool_t *pool,
     }
 
     /* Set buffer size. */
-    if (buff_size < 1) buff_size = PJMEDIA_FILE_PORT_BUFSIZE;
+    fport->async = (flags & PJMEDIA_FILE_WRITE_ASYNC) != 0;
+    if (buff_size < 1) {
+	buff_size = fport->async ? PJMEDIA_FILE_WRITER_ASYNC_BUFSIZE :
+				   PJMEDIA_FILE_PORT_BUFSIZE;
+    }
     fport->bufsize = buff_size;
 
     /* Check that buffer size is greater than bytes per frame */
     pj_assert(fport->bufsize >= PJMEDIA_PIA_AVG_FSZ(&fport->base.info));
 
 
-    /* Allocate buffer and set initial write position */
-    fport->buf = (char*) pj_pool_alloc(pool, fport->bufsize);
-    if (fport->buf == NULL) {
-	pj_file_close(fport->fd);
-	return PJ_ENOMEM;
+    if (fport->async) {
+	/* Allocate the buffers and start the writer thread */
+	status = async_start(pool, fport);
+	if (status != PJ_SUCCESS) {
+	    pj_file_close(fport->fd);
+	    return status;
+	}
+    } else {
+	/* Allocate buffer and set initial write position */
+	fport->buf = (char*) pj_pool_alloc(pool, fport->bufsize);
+	if (fport->buf == NULL) {
+	    pj_file_close(fport->fd);
+	    return PJ_ENOMEM;
+	}
+	fport->writepos = fport->buf;
     }
-    fport->writepos = fport->buf;
 
     /* Done. */
     *p_port = &fport->base;
 
     PJ_LOG(4,(THIS_FILE, 
-	      "File writer '%.*s' created: samp.rate=%d, bufsize=%uKB",
+	      "File writer '%.*s' created: samp.rate=%d, bufsize=%uKB%s",
 	      (int)fport->base.info.name.slen,
 	      fport->base.info.name.ptr,
 	      PJMEDIA_PIA_SRATE(&fport->base.info),
-	      fport->bufsize / 1000));
+	      fport->bufsize / 1000,
+	      (fport->async ? ", async" : "")));
 
 
     return PJ_SUCCESS;
@@ -244,6 +286,25 @@ PJ_DEF(pj_ssize_t) pjmedia_wav_writer_port_get_pos( pjmedia_port *port )
 }
 
 
+/*
+ * Get number of frames dropped by asynchronous writer.
+ */
+PJ_DEF(unsigned) pjmedia_wav_writer_port_get_overruns( pjmedia_port *port )
+{
+    struct file_port *fport;
+
+    /* Sanity check */
+    PJ_ASSERT_RETURN(port, 0);
+
+    /* Check that this is really a writer port */
+    PJ_ASSERT_RETURN(port->info.signature == SIGNATURE, 0);
+
+    fport = (struct file_port*) port;
+
+    return fport->overruns;
+}
+
+
 /*
  * Register callback.
  */
@@ -303,6 +364,192 @@ static pj_status_t flush_buffer(struct file_port *fport)
     return status;
 }
 
+/*
+ * Encode 16 bit samples in place to the file format, and write them.
+ * Used for asynchronous writer, where the buffers hold the samples as
+ * received and the encoding is left to the writer thread.
+ */
+static pj_status_t write_samples(struct file_port *fport, char *buf,
+				 pj_size_t len)
+{
+    pj_ssize_t bytes;
+
+    if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
+	swap_samples((pj_int16_t*)buf, len >> 1);
+	bytes = len;
+    } else {
+	/* Encoded in place */
+	pj_size_t count = len >> 1;
+
+	if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_ULAW) {
+	    pjmedia_ulaw_encode((pj_uint8_t*)buf, (const pj_int16_t*)buf,
+				count);
+	} else {
+	    pjmedia_alaw_encode((pj_uint8_t*)buf, (const pj_int16_t*)buf,
+				count);
+	}
+	bytes = count;
+    }
+
+    return pj_file_write(fport->fd, buf, &bytes);
+}
+
+/*
+ * Writer thread of asynchronous writer, writing the full buffers in turn.
+ */
+static int async_writer_thread(void *arg)
+{
+    struct file_port *fport = (struct file_port*) arg;
+    pj_bool_t quit;
+
+    do {
+	pj_sem_wait(fport->sem);
+
+	for (;;) {
+	    struct file_buf *fb;
+	    pj_bool_t full;
+	    pj_status_t status;
+
+	    pj_mutex_lock(fport->mutex);
+	    fb = &fport->abuf[fport->wr_idx];
+	    full = fb->full;
+	    quit = fport->quit;
+	    pj_mutex_unlock(fport->mutex);
+
+	    if (!full)
+		break;
+
+	    status = write_samples(fport, fb->buf, fb->len);
+	    if (status != PJ_SUCCESS)
+		fport->wr_status = status;
+
+	    pj_mutex_lock(fport->mutex);
+	    fb->full = PJ_FALSE;
+	    fport->wr_idx = (fport->wr_idx + 1) % ASYNC_BUF_CNT;
+	    pj_mutex_unlock(fport->mutex);
+	}
+    } while (!quit);
+
+    return 0;
+}
+
+/*
+ * Allocate the buffers of asynchronous writer and start the writer thread.
+ */
+static pj_status_t async_start(pj_pool_t *pool, struct file_port *fport)
+{
+    unsigned i;
+    pj_status_t status;
+
+    for (i = 0; i < ASYNC_BUF_CNT; ++i) {
+	fport->abuf[i].buf = (char*) pj_pool_alloc(pool, fport->bufsize);
+	if (fport->abuf[i].buf == NULL)
+	    return PJ_ENOMEM;
+    }
+    fport->buf = fport->writepos = fport->abuf[0].buf;
+
+    status = pj_mutex_create_simple(pool, "wavwriter", &fport->mutex);
+    if (status != PJ_SUCCESS)
+	return status;
+
+    status = pj_sem_create(pool, "wavwriter", 0, ASYNC_BUF_CNT + 1,
+			   &fport->sem);
+    if (status != PJ_SUCCESS) {
+	pj_mutex_destroy(fport->mutex);
+	return status;
+    }
+
+    status = pj_thread_create(pool, "wavwriter", &async_writer_thread,
+			      fport, 0, 0, &fport->thread);
+    if (status != PJ_SUCCESS) {
+	pj_sem_destroy(fport->sem);
+	pj_mutex_destroy(fport->mutex);
+	return status;
+    }
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * Stop the writer thread, after it has written the full buffers, and
+ * write the remaining samples.
+ */
+static void async_stop(struct file_port *fport)
+{
+    pj_mutex_lock(fport->mutex);
+    fport->quit = PJ_TRUE;
+    pj_mutex_unlock(fport->mutex);
+
+    pj_sem_post(fport->sem);
+    pj_thread_join(fport->thread);
+    pj_thread_destroy(fport->thread);
+    pj_sem_destroy(fport->sem);
+    pj_mutex_destroy(fport->mutex);
+
+    if (fport->writepos && fport->writepos != fport->buf)
+	write_samples(fport, fport->buf, fport->writepos - fport->buf);
+
+    if (fport->overruns) {
+	PJ_LOG(3,(THIS_FILE, "File writer '%.*s': %u frames dropped since "
+		  "the writer could not keep up",
+		  (int)fport->base.info.name.slen,
+		  fport->base.info.name.ptr,
+		  fport->overruns));
+    }
+}
+
+/*
+ * Put a frame into the buffer of asynchronous writer. When the buffer is
+ * full, hand it over to the writer thread. This never waits for the writer
+ * thread, the frame is dropped instead when no buffer is free.
+ */
+static pj_status_t async_put_frame(struct file_port *fport,
+				   const pjmedia_frame *frame)
+{
+    if (fport->writepos &&
+	fport->writepos + frame->size > fport->buf + fport->bufsize)
+    {
+	struct file_buf *fb = &fport->abuf[fport->abuf_idx];
+
+	if (pj_mutex_trylock(fport->mutex) != PJ_SUCCESS) {
+	    ++fport->overruns;
+	    return PJ_SUCCESS;
+	}
+	fb->len = fport->writepos - fport->buf;
+	fb->full = PJ_TRUE;
+	fport->abuf_idx = (fport->abuf_idx + 1) % ASYNC_BUF_CNT;
+	fport->writepos = NULL;
+	pj_mutex_unlock(fport->mutex);
+
+	pj_sem_post(fport->sem);
+    }
+
+    if (fport->writepos == NULL) {
+	/* Check if the writer has released the next buffer */
+	struct file_buf *fb = &fport->abuf[fport->abuf_idx];
+
+	if (pj_mutex_trylock(fport->mutex) == PJ_SUCCESS) {
+	    if (!fb->full)
+		fport->buf = fport->writepos = fb->buf;
+	    pj_mutex_unlock(fport->mutex);
+	}
+
+	if (fport->writepos == NULL) {
+	    ++fport->overruns;
+	    return PJ_SUCCESS;
+	}
+    }
+
+    /* Check if frame is not too large. */
+    PJ_ASSERT_RETURN(fport->writepos+frame->size <= fport->buf+fport->bufsize,
+		     PJMEDIA_EFRMFILETOOBIG);
+
+    pj_memcpy(fport->writepos, frame->buf, frame->size);
+    fport->writepos += frame->size;
+
+    return fport->wr_status;
+}
+
 /*
  * Put a frame into the buffer. When the buffer is full, flush the buffer
  * to the file.
@@ -318,6 +565,16 @@ static pj_status_t file_put_frame(pjmedia_port *this_port,
     else
 	frame_size = frame->size >> 1;
 
+    if (fport->async) {
+	unsigned overruns = fport->overruns;
+	pj_status_t status;
+
+	status = async_put_frame(fport, frame);
+	if (status != PJ_SUCCESS || overruns != fport->overruns)
+	    return status;
+	goto on_frame_written;
+    }
+
     /* Flush buffer if we don't have enough room for the frame. */
     if (fport->writepos + frame_size > fport->buf + fport->bufsize) {
 	pj_status_t status;
@@ -334,23 +591,18 @@ static pj_status_t file_put_frame(pjmedia_port *this_port,
     if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_PCM) {
 	pj_memcpy(fport->writepos, frame->buf, frame->size);
     } else {
-	unsigned i;
 	pj_int16_t *src = (pj_int16_t*)frame->buf;
 	pj_uint8_t *dst = (pj_uint8_t*)fport->writepos;
 
 	if (fport->fmt_tag == PJMEDIA_WAVE_FMT_TAG_ULAW) {
-	    for (i = 0; i < frame_size; ++i) {
-		*dst++ = pjmedia_linear2ulaw(*src++);
-	    }
+	    pjmedia_ulaw_encode(dst, src, frame_size);
 	} else {
-	    for (i = 0; i < frame_size; ++i) {
-		*dst++ = pjmedia_linear2alaw(*src++);
-	    }
+	    pjmedia_alaw_encode(dst, src, frame_size);
 	}
-
     }
     fport->writepos += frame_size;
 
+on_frame_written:
     /* Increment total written, and check if we need to call callback */
     fport->total += frame_size;
     if (fport->cb && fport->total >= fport->cb_size) {
@@ -393,7 +645,9 @@ static pj_status_t file_on_destroy(pjmedia_port *this_port)
     pj_uint32_t data_len_pos = DATA_LEN_POS;
 
     /* Flush remaining buffers. */
-    if (fport->writepos != fport->buf) 
+    if (fport->async)
+	async_stop(fport);
+    else if (fport->writepos != fport->buf) 
 	flush_buffer(fport);
 
     /* Get file size. */
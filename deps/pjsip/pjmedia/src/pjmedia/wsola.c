@@ -155,6 +155,16 @@ struct pjmedia_wsola
 
 };
 
+/* Vectorized correlation for find_pitch(), see wsola_simd.c */
+#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA) && \
+    defined(PJMEDIA_WSOLA_USE_SIMD) && PJMEDIA_WSOLA_USE_SIMD!=0 && \
+    (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#   define WSOLA_HAS_SIMD	1
+#   include "wsola_simd.c"
+#else
+#   define WSOLA_HAS_SIMD	0
+#endif
+
 #if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA_LITE)
 
 /* In this implementation, waveform similarity comparison is done by calculating
@@ -222,50 +232,35 @@ static pj_int16_t *find_pitch(pj_int16_t *frm, pj_int16_t *beg, pj_int16_t *end,
  * Floating point version.
  */
 
-#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA)
-
-static pj_int16_t *find_pitch(pj_int16_t *frm, pj_int16_t *beg, pj_int16_t *end, 
-			 unsigned template_cnt, int first)
-{
-    pj_int16_t *sr, *best=beg;
-    double best_corr = 0;
+#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA) && !WSOLA_HAS_SIMD
 
-    for (sr=beg; sr!=end; ++sr) {
-	double corr = 0;
-	unsigned i;
+typedef double corr_t;
 
-	/* Do calculation on 8 samples at once */
-	for (i=0; i<template_cnt-8; i += 8) {
-	    corr += ((float)frm[i+0]) * ((float)sr[i+0]) + 
-		    ((float)frm[i+1]) * ((float)sr[i+1]) + 
-		    ((float)frm[i+2]) * ((float)sr[i+2]) + 
-		    ((float)frm[i+3]) * ((float)sr[i+3]) + 
-		    ((float)frm[i+4]) * ((float)sr[i+4]) + 
-		    ((float)frm[i+5]) * ((float)sr[i+5]) + 
-		    ((float)frm[i+6]) * ((float)sr[i+6]) + 
-		    ((float)frm[i+7]) * ((float)sr[i+7]);
-	}
+/* Correlation of template_cnt samples of the template with sr */
+static corr_t correlate(const pj_int16_t *frm, const pj_int16_t *sr,
+			unsigned template_cnt)
+{
+    double corr = 0;
+    unsigned i;
 
-	/* Process remaining samples. */
-	for (; i<template_cnt; ++i) {
-	    corr += ((float)frm[i]) * ((float)sr[i]);
-	}
+    /* Do calculation on 8 samples at once */
+    for (i=0; i<template_cnt-8; i += 8) {
+	corr += ((float)frm[i+0]) * ((float)sr[i+0]) + 
+		((float)frm[i+1]) * ((float)sr[i+1]) + 
+		((float)frm[i+2]) * ((float)sr[i+2]) + 
+		((float)frm[i+3]) * ((float)sr[i+3]) + 
+		((float)frm[i+4]) * ((float)sr[i+4]) + 
+		((float)frm[i+5]) * ((float)sr[i+5]) + 
+		((float)frm[i+6]) * ((float)sr[i+6]) + 
+		((float)frm[i+7]) * ((float)sr[i+7]);
+    }
 
-	if (first) {
-	    if (corr > best_corr) {
-		best_corr = corr;
-		best = sr;
-	    }
-	} else {
-	    if (corr >= best_corr) {
-		best_corr = corr;
-		best = sr;
-	    }
-	}
+    /* Process remaining samples. */
+    for (; i<template_cnt; ++i) {
+	corr += ((float)frm[i]) * ((float)sr[i]);
     }
 
-    /*TRACE_((THIS_FILE, "found pitch at %u", best-beg));*/
-    return best;
+    return corr;
 }
 
 #endif
@@ -312,51 +307,35 @@ static void create_win(pj_pool_t *pool, float **pw, unsigned count)
 #define WINDOW_BITS	15
 enum { WINDOW_MAX_VAL = (1 << WINDOW_BITS)-1 };
 
-#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA)
-
-static pj_int16_t *find_pitch(pj_int16_t *frm, pj_int16_t *beg, pj_int16_t *end, 
-			 unsigned template_cnt, int first)
-{
-    pj_int16_t *sr, *best=beg;
-    pj_int64_t best_corr = 0;
+#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA) && !WSOLA_HAS_SIMD
 
-    
-    for (sr=beg; sr!=end; ++sr) {
-	pj_int64_t corr = 0;
-	unsigned i;
+typedef pj_int64_t corr_t;
 
-	/* Do calculation on 8 samples at once */
-	for (i=0; i<template_cnt-8; i+=8) {
-	    corr += ((int)frm[i+0]) * ((int)sr[i+0]) + 
-		    ((int)frm[i+1]) * ((int)sr[i+1]) + 
-		    ((int)frm[i+2]) * ((int)sr[i+2]) +
-		    ((int)frm[i+3]) * ((int)sr[i+3]) +
-		    ((int)frm[i+4]) * ((int)sr[i+4]) +
-		    ((int)frm[i+5]) * ((int)sr[i+5]) +
-		    ((int)frm[i+6]) * ((int)sr[i+6]) +
-		    ((int)frm[i+7]) * ((int)sr[i+7]);
-	}
+/* Correlation of template_cnt samples of the template with sr */
+static corr_t correlate(const pj_int16_t *frm, const pj_int16_t *sr,
+			unsigned template_cnt)
+{
+    pj_int64_t corr = 0;
+    unsigned i;
 
-	/* Process remaining samples. */
-	for (; i<template_cnt; ++i) {
-	    corr += ((int)frm[i]) * ((int)sr[i]);
-	}
+    /* Do calculation on 8 samples at once */
+    for (i=0; i<template_cnt-8; i+=8) {
+	corr += ((int)frm[i+0]) * ((int)sr[i+0]) + 
+		((int)frm[i+1]) * ((int)sr[i+1]) + 
+		((int)frm[i+2]) * ((int)sr[i+2]) +
+		((int)frm[i+3]) * ((int)sr[i+3]) +
+		((int)frm[i+4]) * ((int)sr[i+4]) +
+		((int)frm[i+5]) * ((int)sr[i+5]) +
+		((int)frm[i+6]) * ((int)sr[i+6]) +
+		((int)frm[i+7]) * ((int)sr[i+7]);
+    }
 
-	if (first) {
-	    if (corr > best_corr) {
-		best_corr = corr;
-		best = sr;
-	    }
-	} else {
-	    if (corr >= best_corr) {
-		best_corr = corr;
-		best = sr;
-	    }
-	}
+    /* Process remaining samples. */
+    for (; i<template_cnt; ++i) {
+	corr += ((int)frm[i]) * ((int)sr[i]);
     }
 
-    /*TRACE_((THIS_FILE, "found pitch at %u", best-beg));*/
-    return best;
+    return corr;
 }
 
 #endif
@@ -439,6 +418,70 @@ static void create_win(pj_pool_t *pool, pj_uint16_t **pw, unsigned count)
 
 #endif	/* PJ_HAS_FLOATING_POINT */
 
+#if (PJMEDIA_WSOLA_IMP==PJMEDIA_WSOLA_IMP_WSOLA)
+
+/* Update best with the best correlating position of every step samples
+ * in [beg, end). If first is set, the earliest of equal correlations is
+ * taken, otherwise the latest.
+ */
+static void search_pitch(pj_int16_t *frm, pj_int16_t *beg, pj_int16_t *end,
+			 unsigned step, unsigned template_cnt, int first,
+			 pj_int16_t **best, corr_t *best_corr)
+{
+    pj_int16_t *sr;
+
+    for (sr=beg; sr<end; sr+=step) {
+	corr_t corr = correlate(frm, sr, template_cnt);
+
+	if (first) {
+	    if (corr > *best_corr) {
+		*best_corr = corr;
+		*best = sr;
+	    }
+	} else {
+	    if (corr >= *best_corr) {
+		*best_corr = corr;
+		*best = sr;
+	    }
+	}
+    }
+}
+
+static pj_int16_t *find_pitch(pj_int16_t *frm, pj_int16_t *beg, pj_int16_t *end, 
+			 unsigned template_cnt, int first)
+{
+    pj_int16_t *best=beg;
+    corr_t best_corr = 0;
+
+#if PJMEDIA_WSOLA_SEARCH_STEP > 1
+    /* Coarse search, then refine around the best position found */
+    enum { STEP = PJMEDIA_WSOLA_SEARCH_STEP };
+
+    if (end - beg > 2 * STEP) {
+	pj_int16_t *coarse, *fine_beg, *fine_end;
+
+	search_pitch(frm, beg, end, STEP, template_cnt, first,
+		     &best, &best_corr);
+
+	coarse = best;
+	fine_beg = (coarse - beg >= STEP) ? coarse - (STEP-1) : beg;
+	fine_end = (end - coarse > STEP) ? coarse + STEP : end;
+	search_pitch(frm, fine_beg, fine_end, 1, template_cnt, first,
+		     &best, &best_corr);
+
+	/*TRACE_((THIS_FILE, "found pitch at %u", best-beg));*/
+	return best;
+    }
+#endif
+
+    search_pitch(frm, beg, end, 1, template_cnt, first, &best, &best_corr);
+
+    /*TRACE_((THIS_FILE, "found pitch at %u", best-beg));*/
+    return best;
+}
+
+#endif
+
 /* Apply fade-in to the buffer.
  *  - fade_cnt is the number of samples on which the volume
  *       will go from zero to 100%
@@ -0,0 +1,166 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * THIS FILE IS INCLUDED BY wsola.c.
+ * DO NOT COMPILE THIS FILE ALONE!
+ *
+ * Correlation of the template with a candidate position, for find_pitch(),
+ * with SSE2 (or AVX2 when the CPU has it) or NEON. The sum is computed
+ * exactly in 64-bit integers, for both the floating and fixed point
+ * builds.
+ *
+ * On x86, PMADDWD adds two 16-bit products into a 32-bit lane. The sum
+ * lies in [-2147418112, 2147483648], which only overflows when both
+ * pairs are -32768. Subtracting 65536 from every lane brings the range
+ * within 32 bits, so the lanes are widened to 64 bits exactly, and the
+ * bias is added back once at the end.
+ */
+
+typedef pj_int64_t corr_t;
+
+#if defined(__SSE2__)
+
+#include <immintrin.h>
+
+/* Bias of each PMADDWD lane */
+#define WSOLA_SIMD_BIAS		65536
+
+/* template_cnt must be a multiple of 16 */
+__attribute__((target("avx2")))
+static corr_t correlate_avx2(const pj_int16_t *frm, const pj_int16_t *sr,
+			     unsigned template_cnt)
+{
+    const __m256i bias = _mm256_set1_epi32(-WSOLA_SIMD_BIAS);
+    __m256i acc = _mm256_setzero_si256();
+    __m128i sum;
+    pj_int64_t corr[2];
+    unsigned i;
+
+    for (i=0; i<template_cnt; i+=16) {
+	__m256i p = _mm256_madd_epi16(
+			_mm256_loadu_si256((const __m256i*)(frm+i)),
+			_mm256_loadu_si256((const __m256i*)(sr+i)));
+	__m256i s;
+
+	p = _mm256_add_epi32(p, bias);
+	s = _mm256_srai_epi32(p, 31);
+	acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(p, s));
+	acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(p, s));
+    }
+
+    sum = _mm_add_epi64(_mm256_castsi256_si128(acc),
+			_mm256_extracti128_si256(acc, 1));
+    _mm_storeu_si128((__m128i*)corr, sum);
+    return corr[0] + corr[1] + (pj_int64_t)(template_cnt/2)*WSOLA_SIMD_BIAS;
+}
+
+/* template_cnt must be a multiple of 8 */
+static corr_t correlate_sse2(const pj_int16_t *frm, const pj_int16_t *sr,
+			     unsigned template_cnt)
+{
+    const __m128i bias = _mm_set1_epi32(-WSOLA_SIMD_BIAS);
+    __m128i acc = _mm_setzero_si128();
+    pj_int64_t corr[2];
+    unsigned i;
+
+    for (i=0; i<template_cnt; i+=8) {
+	__m128i p = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(frm+i)),
+				   _mm_loadu_si128((const __m128i*)(sr+i)));
+	__m128i s;
+
+	p = _mm_add_epi32(p, bias);
+	s = _mm_srai_epi32(p, 31);
+	acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(p, s));
+	acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(p, s));
+    }
+
+    _mm_storeu_si128((__m128i*)corr, acc);
+    return corr[0] + corr[1] + (pj_int64_t)(template_cnt/2)*WSOLA_SIMD_BIAS;
+}
+
+/* The result is cached, concurrent first calls merely repeat the check.
+ * __builtin_cpu_supports() also checks that the OS saves the AVX state.
+ */
+static int correlate_avx2_available(void)
+{
+    static int available = -1;
+
+    if (available < 0) {
+	__builtin_cpu_init();
+	available = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return available;
+}
+
+/* Correlation of template_cnt samples of the template with sr */
+static corr_t correlate(const pj_int16_t *frm, const pj_int16_t *sr,
+			unsigned template_cnt)
+{
+    corr_t corr;
+    unsigned i;
+
+    if (template_cnt >= 16 && correlate_avx2_available()) {
+	i = template_cnt & ~15U;
+	corr = correlate_avx2(frm, sr, i);
+    } else {
+	i = template_cnt & ~7U;
+	corr = correlate_sse2(frm, sr, i);
+    }
+
+    /* Process remaining samples. */
+    for (; i<template_cnt; ++i) {
+	corr += ((int)frm[i]) * ((int)sr[i]);
+    }
+
+    return corr;
+}
+
+#else	/* NEON */
+
+#include <arm_neon.h>
+
+/* Correlation of template_cnt samples of the template with sr */
+static corr_t correlate(const pj_int16_t *frm, const pj_int16_t *sr,
+			unsigned template_cnt)
+{
+    int64x2_t acc = vdupq_n_s64(0);
+    corr_t corr;
+    unsigned i, n = template_cnt & ~7U;
+
+    /* The 32-bit products are exact, pairs of them are added in 64 bits */
+    for (i=0; i<n; i+=8) {
+	int16x8_t x = vld1q_s16(frm+i);
+	int16x8_t y = vld1q_s16(sr+i);
+
+	acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(y)));
+	acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(y)));
+    }
+    corr = vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+
+    /* Process remaining samples. */
+    for (; i<template_cnt; ++i) {
+	corr += ((int)frm[i]) * ((int)sr[i]);
+    }
+
+    return corr;
+}
+
+#endif
@@ -143,6 +143,31 @@
 #endif
 
 
+/**
+ * Number of HMAC-SHA1 key schedules cached by each STUN session (see
+ * #pj_stun_hmac_cache). A session normally uses one or two keys (e.g. the
+ * local and the remote ICE password, or one TURN long term credential),
+ * so the MESSAGE-INTEGRITY of each message then costs two SHA1 blocks
+ * less. Zero disables the cache.
+ *
+ * Default: 4
+ */
+#ifndef PJ_STUN_HMAC_CACHE_SIZE
+#   define PJ_STUN_HMAC_CACHE_SIZE		    4
+#endif
+
+
+/**
+ * Maximum length of a key kept in the HMAC-SHA1 key schedule cache.
+ * Longer keys are still accepted, but not cached.
+ *
+ * Default: 128
+ */
+#ifndef PJ_STUN_HMAC_CACHE_KEY_MAX
+#   define PJ_STUN_HMAC_CACHE_KEY_MAX		    128
+#endif
+
+
 /* **************************************************************************
  * STUN TRANSPORT CONFIGURATION
  */
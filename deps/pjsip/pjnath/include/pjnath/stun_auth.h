@@ -408,6 +408,37 @@ PJ_DECL(pj_status_t) pj_stun_authenticate_request(const pj_uint8_t *pkt,
 					          pj_stun_msg **p_response);
 
 
+/**
+ * This is the same as #pj_stun_authenticate_request(), except that the
+ * key schedule of the MESSAGE-INTEGRITY key is looked up in (and added to)
+ * the specified cache.
+ *
+ * @param pkt		The original packet which has been parsed into
+ *			the message.
+ * @param pkt_len	The length of the packet.
+ * @param msg		The parsed message to be verified.
+ * @param cred		Pointer to credential to be used to authenticate
+ *			the message.
+ * @param pool		If response is to be created, then memory will
+ *			be allocated from this pool.
+ * @param info		Optional pointer to receive authentication information.
+ * @param hmac_cache	Optional key schedule cache.
+ * @param p_response	Optional pointer to receive the response message
+ *			then the credential in the request fails to
+ *			authenticate.
+ *
+ * @return		PJ_SUCCESS if credential is verified successfully.
+ */
+PJ_DECL(pj_status_t) pj_stun_authenticate_request2(const pj_uint8_t *pkt,
+					           unsigned pkt_len,
+					           const pj_stun_msg *msg,
+					           pj_stun_auth_cred *cred,
+					           pj_pool_t *pool,
+						   pj_stun_req_cred_info *info,
+						   pj_stun_hmac_cache *hmac_cache,
+					           pj_stun_msg **p_response);
+
+
 /**
  * Determine if STUN message can be authenticated. Some STUN error
  * responses cannot be authenticated since they cannot contain STUN
@@ -445,6 +476,28 @@ PJ_DECL(pj_status_t) pj_stun_authenticate_response(const pj_uint8_t *pkt,
 					           const pj_str_t *key);
 
 
+/**
+ * This is the same as #pj_stun_authenticate_response(), except that the
+ * key schedule of the key is looked up in (and added to) the specified
+ * cache.
+ *
+ * @param pkt		The original packet which has been parsed into
+ *			the message.
+ * @param pkt_len	The length of the packet.
+ * @param msg		The parsed message to be verified.
+ * @param key		Authentication key to calculate MESSAGE-INTEGRITY
+ *			value.
+ * @param hmac_cache	Optional key schedule cache.
+ *
+ * @return		PJ_SUCCESS if credential is verified successfully.
+ */
+PJ_DECL(pj_status_t) pj_stun_authenticate_response2(const pj_uint8_t *pkt,
+					            unsigned pkt_len,
+					            const pj_stun_msg *msg,
+					            const pj_str_t *key,
+						    pj_stun_hmac_cache *hmac_cache);
+
+
 /**
  * @}
  */
@@ -26,6 +26,7 @@
  */
 
 #include <pjnath/types.h>
+#include <pjlib-util/hmac_sha1.h>
 #include <pj/sock.h>
 
 
@@ -1362,6 +1363,75 @@ PJ_DECL(pj_status_t) pj_stun_msg_encode(pj_stun_msg *msg,
 					const pj_str_t *key,
 				        pj_size_t *p_msg_len);
 
+/**
+ * Cache of HMAC-SHA1 key schedules (see #pj_hmac_sha1_key), which saves
+ * hashing the key pads for every MESSAGE-INTEGRITY calculated with a key
+ * that was used recently. The cache is not thread safe; the STUN session
+ * keeps one and only uses it with its lock held.
+ */
+typedef struct pj_stun_hmac_cache
+{
+    /** Index of the entry to be replaced next. */
+    unsigned		next;
+
+    /** The cached keys. */
+    struct {
+	int		 key_len;   /**< Key length, -1 if unused.  */
+	pj_uint8_t	 key[PJ_STUN_HMAC_CACHE_KEY_MAX]; /**< The key.	*/
+	pj_hmac_sha1_key hkey;	    /**< Its key schedule.	    */
+    } entry[PJ_STUN_HMAC_CACHE_SIZE ? PJ_STUN_HMAC_CACHE_SIZE : 1];
+
+} pj_stun_hmac_cache;
+
+
+/**
+ * Initialize an empty HMAC-SHA1 key schedule cache.
+ *
+ * @param cache		The cache.
+ */
+PJ_DECL(void) pj_stun_hmac_cache_init(pj_stun_hmac_cache *cache);
+
+
+/**
+ * Start HMAC-SHA1 calculation with the specified key, taking the key
+ * schedule from the cache if it is there, and adding it to the cache
+ * otherwise.
+ *
+ * @param ctx		The HMAC-SHA1 context to be initialized.
+ * @param key		The key.
+ * @param cache		The cache, or NULL to compute the key schedule
+ *			without caching it.
+ */
+PJ_DECL(void) pj_stun_hmac_init(pj_hmac_sha1_context *ctx,
+				const pj_str_t *key,
+				pj_stun_hmac_cache *cache);
+
+
+/**
+ * This is the same as #pj_stun_msg_encode(), except that the key schedule
+ * of the MESSAGE-INTEGRITY key is looked up in (and added to) the
+ * specified cache.
+ *
+ * @param msg		The STUN message to be printed.
+ * @param pkt_buf	The buffer to be filled with the packet.
+ * @param buf_size	Size of the buffer.
+ * @param options	Options, which currently must be zero.
+ * @param key		Authentication key to calculate MESSAGE-INTEGRITY
+ *			value.
+ * @param hmac_cache	Optional key schedule cache.
+ * @param p_msg_len	Upon return, it will be filed with the size of 
+ *			the packet in bytes, or negative value on error.
+ *
+ * @return		PJ_SUCCESS on success or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_stun_msg_encode2(pj_stun_msg *msg,
+					 pj_uint8_t *pkt_buf,
+					 pj_size_t buf_size,
+					 unsigned options,
+					 const pj_str_t *key,
+					 pj_stun_hmac_cache *hmac_cache,
+					 pj_size_t *p_msg_len);
+
 /**
  * Check that the PDU is potentially a valid STUN message. This function
  * is useful when application needs to multiplex STUN packets with other
@@ -219,6 +219,19 @@ PJ_DEF(pj_status_t) pj_stun_authenticate_request(const pj_uint8_t *pkt,
 					         pj_pool_t *pool,
 						 pj_stun_req_cred_info *p_info,
 					         pj_stun_msg **p_response)
+{
+    return pj_stun_authenticate_request2(pkt, pkt_len, msg, cred, pool,
+					 p_info, NULL, p_response);
+}
+
+PJ_DEF(pj_status_t) pj_stun_authenticate_request2(const pj_uint8_t *pkt,
+					          unsigned pkt_len,
+					          const pj_stun_msg *msg,
+					          pj_stun_auth_cred *cred,
+					          pj_pool_t *pool,
+						  pj_stun_req_cred_info *p_info,
+						  pj_stun_hmac_cache *hmac_cache,
+					          pj_stun_msg **p_response)
 {
     pj_stun_req_cred_info tmp_info;
     const pj_stun_msgint_attr *amsgi;
@@ -442,8 +455,7 @@ PJ_DEF(pj_status_t) pj_stun_authenticate_request(const pj_uint8_t *pkt,
     }
 
     /* Now calculate HMAC of the message. */
-    pj_hmac_sha1_init(&ctx, (pj_uint8_t*)p_info->auth_key.ptr, 
-		      (unsigned)p_info->auth_key.slen);
+    pj_stun_hmac_init(&ctx, &p_info->auth_key, hmac_cache);
 
 #if PJ_STUN_OLD_STYLE_MI_FINGERPRINT
     /* Pre rfc3489bis-06 style of calculation */
@@ -545,6 +557,15 @@ PJ_DEF(pj_status_t) pj_stun_authenticate_response(const pj_uint8_t *pkt,
 					          unsigned pkt_len,
 					          const pj_stun_msg *msg,
 					          const pj_str_t *key)
+{
+    return pj_stun_authenticate_response2(pkt, pkt_len, msg, key, NULL);
+}
+
+PJ_DEF(pj_status_t) pj_stun_authenticate_response2(const pj_uint8_t *pkt,
+					           unsigned pkt_len,
+					           const pj_stun_msg *msg,
+					           const pj_str_t *key,
+						   pj_stun_hmac_cache *hmac_cache)
 {
     const pj_stun_msgint_attr *amsgi;
     unsigned i, amsgi_pos;
@@ -587,7 +608,7 @@ PJ_DEF(pj_status_t) pj_stun_authenticate_response(const pj_uint8_t *pkt,
     }
 
     /* Now calculate HMAC of the message. */
-    pj_hmac_sha1_init(&ctx, (pj_uint8_t*)key->ptr, (unsigned)key->slen);
+    pj_stun_hmac_init(&ctx, key, hmac_cache);
 
 #if PJ_STUN_OLD_STYLE_MI_FINGERPRINT
     /* Pre rfc3489bis-06 style of calculation */
@@ -2572,6 +2572,54 @@ static char *print_binary(const pj_uint8_t *data, unsigned data_len)
 }
 */
 
+/*
+ * Initialize the cache of prepared HMAC-SHA1 keys.
+ */
+PJ_DEF(void) pj_stun_hmac_cache_init(pj_stun_hmac_cache *cache)
+{
+    unsigned i;
+
+    cache->next = 0;
+    for (i=0; i<PJ_ARRAY_SIZE(cache->entry); ++i)
+	cache->entry[i].key_len = -1;
+}
+
+/*
+ * Initialize the HMAC-SHA1 context with the key, from the cache if it has
+ * been prepared before.
+ */
+PJ_DEF(void) pj_stun_hmac_init(pj_hmac_sha1_context *ctx,
+			       const pj_str_t *key,
+			       pj_stun_hmac_cache *cache)
+{
+    unsigned i;
+
+    if (!cache || PJ_STUN_HMAC_CACHE_SIZE == 0 ||
+	key->slen > PJ_STUN_HMAC_CACHE_KEY_MAX)
+    {
+	pj_hmac_sha1_init(ctx, (const pj_uint8_t*)key->ptr,
+			  (unsigned)key->slen);
+	return;
+    }
+
+    for (i=0; i<PJ_ARRAY_SIZE(cache->entry); ++i) {
+	if (cache->entry[i].key_len == (int)key->slen &&
+	    pj_memcmp(cache->entry[i].key, key->ptr, key->slen) == 0)
+	{
+	    pj_hmac_sha1_init_key(ctx, &cache->entry[i].hkey);
+	    return;
+	}
+    }
+
+    i = cache->next;
+    cache->next = (i + 1) % PJ_ARRAY_SIZE(cache->entry);
+    pj_memcpy(cache->entry[i].key, key->ptr, key->slen);
+    cache->entry[i].key_len = (int)key->slen;
+    pj_hmac_sha1_key_init(&cache->entry[i].hkey,
+			  (const pj_uint8_t*)key->ptr, (unsigned)key->slen);
+    pj_hmac_sha1_init_key(ctx, &cache->entry[i].hkey);
+}
+
 /*
  * Print the message structure to a buffer.
  */
@@ -2580,6 +2628,17 @@ PJ_DEF(pj_status_t) pj_stun_msg_encode(pj_stun_msg *msg,
 				       unsigned options,
 				       const pj_str_t *key,
 				       pj_size_t *p_msg_len)
+{
+    return pj_stun_msg_encode2(msg, buf, buf_size, options, key, NULL,
+			       p_msg_len);
+}
+
+PJ_DEF(pj_status_t) pj_stun_msg_encode2(pj_stun_msg *msg,
+					pj_uint8_t *buf, pj_size_t buf_size,
+					unsigned options,
+					const pj_str_t *key,
+					pj_stun_hmac_cache *hmac_cache,
+					pj_size_t *p_msg_len)
 {
     pj_uint8_t *start = buf;
     pj_stun_msgint_attr *amsgint = NULL;
@@ -2726,8 +2785,7 @@ PJ_DEF(pj_status_t) pj_stun_msg_encode(pj_stun_msg *msg,
 	/* Calculate HMAC-SHA1 digest, add zero padding to input
 	 * if necessary to make the input 64 bytes aligned.
 	 */
-	pj_hmac_sha1_init(&ctx, (const pj_uint8_t*)key->ptr, 
-			  (unsigned)key->slen);
+	pj_stun_hmac_init(&ctx, key, hmac_cache);
 	pj_hmac_sha1_update(&ctx, (const pj_uint8_t*)start, 
 			    (unsigned)(buf-start));
 #if PJ_STUN_OLD_STYLE_MI_FINGERPRINT
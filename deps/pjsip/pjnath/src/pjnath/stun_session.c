@@ -47,6 +47,8 @@ struct pj_stun_session
 
     pj_str_t		 srv_name;
 
+    pj_stun_hmac_cache	 hmac_cache;
+
     pj_stun_tx_data	 pending_request_list;
     pj_stun_tx_data	 cached_response_list;
 };
@@ -526,6 +528,7 @@ PJ_DEF(pj_status_t) pj_stun_session_create( pj_stun_config *cfg,
     pj_memcpy(&sess->cb, cb, sizeof(*cb));
     sess->use_fingerprint = fingerprint;
     sess->log_flag = 0xFFFF;
+    pj_stun_hmac_cache_init(&sess->hmac_cache);
 
     if (grp_lock) {
 	sess->grp_lock = grp_lock;
@@ -964,10 +967,10 @@ PJ_DEF(pj_status_t) pj_stun_session_send_msg( pj_stun_session *sess,
     }
 
     /* Encode message */
-    status = pj_stun_msg_encode(tdata->msg, (pj_uint8_t*)tdata->pkt, 
-    				tdata->max_len, 0, 
-    				&tdata->auth_info.auth_key,
-				&tdata->pkt_size);
+    status = pj_stun_msg_encode2(tdata->msg, (pj_uint8_t*)tdata->pkt, 
+    				 tdata->max_len, 0, 
+    				 &tdata->auth_info.auth_key,
+				 &sess->hmac_cache, &tdata->pkt_size);
     if (status != PJ_SUCCESS) {
 	pj_stun_msg_destroy_tdata(sess, tdata);
 	LOG_ERR_(sess, "STUN encode() error", status);
@@ -1180,8 +1183,9 @@ static pj_status_t send_response(pj_stun_session *sess, void *token,
     out_pkt = (pj_uint8_t*) pj_pool_alloc(pool, out_max_len);
 
     /* Encode */
-    status = pj_stun_msg_encode(response, out_pkt, out_max_len, 0, 
-				&auth_info->auth_key, &out_len);
+    status = pj_stun_msg_encode2(response, out_pkt, out_max_len, 0, 
+				 &auth_info->auth_key, &sess->hmac_cache,
+				 &out_len);
     if (status != PJ_SUCCESS) {
 	LOG_ERR_(sess, "Error encoding message", status);
 	return status;
@@ -1216,9 +1220,9 @@ static pj_status_t authenticate_req(pj_stun_session *sess,
 	return PJ_SUCCESS;
     }
 
-    status = pj_stun_authenticate_request(pkt, pkt_len, rdata->msg, 
-					  &sess->cred, tmp_pool, &rdata->info,
-					  &response);
+    status = pj_stun_authenticate_request2(pkt, pkt_len, rdata->msg, 
+					   &sess->cred, tmp_pool, &rdata->info,
+					   &sess->hmac_cache, &response);
     if (status != PJ_SUCCESS && response != NULL) {
 	PJ_LOG(5,(SNAME(sess), "Message authentication failed"));
 	send_response(sess, token, tmp_pool, response, &rdata->info, 
@@ -1259,8 +1263,9 @@ static pj_status_t on_incoming_response(pj_stun_session *sess,
 	tdata->auth_info.auth_key.slen != 0 && 
 	pj_stun_auth_valid_for_msg(msg))
     {
-	status = pj_stun_authenticate_response(pkt, pkt_len, msg, 
-					       &tdata->auth_info.auth_key);
+	status = pj_stun_authenticate_response2(pkt, pkt_len, msg, 
+						&tdata->auth_info.auth_key,
+						&sess->hmac_cache);
 	if (status != PJ_SUCCESS) {
 	    PJ_LOG(5,(SNAME(sess), 
 		      "Response authentication failed"));
@@ -34,6 +34,8 @@
 #define PJ_TURN_CHANNEL_MIN	    0x4000
 #define PJ_TURN_CHANNEL_MAX	    0x7FFF  /* inclusive */
 #define PJ_TURN_CHANNEL_HTABLE_SIZE 8
+#define PJ_TURN_CHANNEL_ARRAY_SIZE  16	    /* bound channels indexed by
+					       number, see ch_array */
 #define PJ_TURN_PERM_HTABLE_SIZE    8
 
 static const char *state_names[] = 
@@ -147,6 +149,14 @@ struct pj_turn_session
     pj_hash_table_t	*ch_table;
     pj_hash_table_t	*perm_table;
 
+    /* Channel numbers are assigned sequentially and never reused, so the
+     * first bound channels are also kept in an array indexed by number,
+     * and the channel of the last sent packet is remembered. This keeps
+     * the hash tables out of the per packet relay path.
+     */
+    struct ch_t		*ch_array[PJ_TURN_CHANNEL_ARRAY_SIZE];
+    struct ch_t		*tx_ch;
+
     pj_uint32_t		 send_ind_tsx_id[3];
     /* tx_pkt must be 16bit aligned */
     pj_uint8_t		 tx_pkt[PJ_TURN_MAX_PKT_LEN];
@@ -949,27 +959,38 @@ PJ_DEF(pj_status_t) pj_turn_session_sendto( pj_turn_session *sess,
     /* Lock session now */
     pj_grp_lock_acquire(sess->grp_lock);
 
-    /* Lookup permission first */
-    perm = lookup_perm(sess, addr, pj_sockaddr_get_len(addr), PJ_FALSE);
-    if (perm == NULL) {
-	/* Permission doesn't exist, install it first */
-	char ipstr[PJ_INET6_ADDRSTRLEN+2];
-
-	PJ_LOG(4,(sess->obj_name, 
-		  "sendto(): IP %s has no permission, requesting it first..",
-		  pj_sockaddr_print(addr, ipstr, sizeof(ipstr), 2)));
-
-	status = pj_turn_session_set_perm(sess, 1, (const pj_sockaddr*)addr, 
-					  0);
-	if (status != PJ_SUCCESS) {
-	    pj_grp_lock_release(sess->grp_lock);
-	    return status;
+    /* The peer of the previous packet has its permission and channel
+     * already checked, skip the lookups.
+     */
+    ch = sess->tx_ch;
+    if (ch == NULL || pj_sockaddr_cmp(&ch->addr, addr) != 0) {
+
+	/* Lookup permission first */
+	perm = lookup_perm(sess, addr, pj_sockaddr_get_len(addr), PJ_FALSE);
+	if (perm == NULL) {
+	    /* Permission doesn't exist, install it first */
+	    char ipstr[PJ_INET6_ADDRSTRLEN+2];
+
+	    PJ_LOG(4,(sess->obj_name, 
+		      "sendto(): IP %s has no permission, requesting it "
+		      "first..",
+		      pj_sockaddr_print(addr, ipstr, sizeof(ipstr), 2)));
+
+	    status = pj_turn_session_set_perm(sess, 1,
+					      (const pj_sockaddr*)addr, 0);
+	    if (status != PJ_SUCCESS) {
+		pj_grp_lock_release(sess->grp_lock);
+		return status;
+	    }
 	}
+
+	/* See if the peer is bound to a channel number */
+	ch = lookup_ch_by_addr(sess, addr, pj_sockaddr_get_len(addr), 
+			       PJ_FALSE, PJ_FALSE);
+	if (perm && ch && ch->num != PJ_TURN_INVALID_CHANNEL && ch->bound)
+	    sess->tx_ch = ch;
     }
 
-    /* See if the peer is bound to a channel number */
-    ch = lookup_ch_by_addr(sess, addr, pj_sockaddr_get_len(addr), 
-			   PJ_FALSE, PJ_FALSE);
     if (ch && ch->num != PJ_TURN_INVALID_CHANNEL && ch->bound) {
 	unsigned total_len;
 
@@ -1772,6 +1793,8 @@ static struct ch_t *lookup_ch_by_addr(pj_turn_session *sess,
 
 	if (bind_channel) {
 	    pj_uint32_t hval2 = 0;
+	    unsigned idx = ch->num - PJ_TURN_CHANNEL_MIN;
+
 	    /* Register by channel number */
 	    pj_assert(ch->num != PJ_TURN_INVALID_CHANNEL && ch->bound);
 
@@ -1780,6 +1803,8 @@ static struct ch_t *lookup_ch_by_addr(pj_turn_session *sess,
 		pj_hash_set(sess->pool, sess->ch_table, &ch->num,
 			    sizeof(ch->num), hval2, ch);
 	    }
+	    if (idx < PJ_ARRAY_SIZE(sess->ch_array))
+		sess->ch_array[idx] = ch;
 	}
     }
 
@@ -1802,6 +1827,11 @@ static struct ch_t *lookup_ch_by_addr(pj_turn_session *sess,
 static struct ch_t *lookup_ch_by_chnum(pj_turn_session *sess,
 					 pj_uint16_t chnum)
 {
+    unsigned idx = (unsigned)chnum - PJ_TURN_CHANNEL_MIN;
+
+    if (idx < PJ_ARRAY_SIZE(sess->ch_array))
+	return sess->ch_array[idx];
+
     return (struct ch_t*) pj_hash_get(sess->ch_table, &chnum, 
 				      sizeof(chnum), NULL);
 }
@@ -1853,6 +1883,9 @@ static struct perm_t *lookup_perm(pj_turn_session *sess,
 static void invalidate_perm(pj_turn_session *sess,
 			    struct perm_t *perm)
 {
+    /* Make the next sendto() check the permission again */
+    sess->tx_ch = NULL;
+
     pj_hash_set(NULL, sess->perm_table, &perm->addr,
 		pj_sockaddr_get_len(&perm->addr), perm->hval, NULL);
 }
@@ -157,6 +157,28 @@ typedef struct pjsip_cfg_t
 	 */
 	pj_bool_t disable_secure_dlg_check;
 
+	/**
+	 * Enable lazy parsing of incoming messages. When enabled, only the
+	 * headers needed for transaction matching, dialog and routing are
+	 * parsed when the message is received, and the other headers are
+	 * parsed on their first lookup. See #PJSIP_LAZY_HDR_PARSING for
+	 * the details.
+	 *
+	 * Default is PJSIP_LAZY_HDR_PARSING.
+	 */
+	pj_bool_t lazy_hdr_parsing;
+
+	/**
+	 * Number of ioqueues created by the endpoint. The first one is
+	 * polled by #pjsip_endpt_handle_events() as usual, and each of the
+	 * others is polled by its own worker thread owned by the endpoint.
+	 * See #PJSIP_ENDPT_IOQUEUE_COUNT for the details. This setting is
+	 * only read when the endpoint is created.
+	 *
+	 * Default is PJSIP_ENDPT_IOQUEUE_COUNT.
+	 */
+	unsigned ioqueue_cnt;
+
     } endpt;
 
     /** Transaction layer settings. */
@@ -293,6 +315,18 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_MAX_DIALOG_COUNT	(512-1)
 #endif
 
+/**
+ * Number of shards of the dialog table in the user agent layer. Dialog
+ * sets are distributed among the shards by the hash of their local tag,
+ * and each shard has its own lock, so that messages of different dialogs
+ * can be matched in parallel by several threads.
+ *
+ * Default value is 16.
+ */
+#ifndef PJSIP_UA_DLG_TABLE_SHARDS
+#   define PJSIP_UA_DLG_TABLE_SHARDS	16
+#endif
+
 
 /**
  * Specify maximum number of transports.
@@ -304,6 +338,30 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Number of ioqueues to be created by the SIP endpoint. When the value is
+ * greater than one, the endpoint creates one worker thread to poll each
+ * additional ioqueue, so that network events are processed on several
+ * threads in parallel instead of serializing on a single ioqueue:
+ *  - UDP transports started with #pjsip_udp_transport_start() open one
+ *    socket per ioqueue on the same address with SO_REUSEPORT, and the
+ *    kernel distributes incoming packets among them by source address.
+ *  - TCP and TLS connections are assigned to the ioqueues by hash.
+ *
+ * Application and modules must then be prepared to receive callbacks
+ * from several threads at the same time. Note that each ioqueue is
+ * created with PJSIP_MAX_TRANSPORTS handles.
+ *
+ * This option can also be controlled at run-time by the
+ * \a ioqueue_cnt setting in pjsip_cfg_t.
+ *
+ * Default: 1
+ */
+#ifndef PJSIP_ENDPT_IOQUEUE_COUNT
+#   define PJSIP_ENDPT_IOQUEUE_COUNT	1
+#endif
+
+
 /**
  * Transport manager hash table size (must be 2^n-1). 
  * See also PJSIP_MAX_TRANSPORTS
@@ -339,6 +397,19 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Initial size of the buffer to print outgoing message. The buffer is
+ * grown as needed for larger messages, up to PJSIP_MAX_PKT_LEN, so that
+ * the full PJSIP_MAX_PKT_LEN doesn't need to be allocated for every
+ * message.
+ *
+ * Default: 2000
+ */
+#ifndef PJSIP_TDATA_BUF_LEN
+#   define PJSIP_TDATA_BUF_LEN		2000
+#endif
+
+
 /**
  * RFC 3261 section 18.1.1:
  * If a request is within 200 bytes of the path MTU, or if it is larger
@@ -418,6 +489,31 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_RESOLVE_HOSTNAME_TO_GET_INTERFACE  PJ_FALSE
 #endif
 
+/**
+ * Enable lazy header parsing for incoming messages. When enabled, the
+ * headers which are needed by the transaction, dialog and proxy layers
+ * (Via, From, To, Call-ID, CSeq, Content-Length, Content-Type, Route,
+ * Record-Route, Max-Forwards and Require), as well as the headers with
+ * parser registered with #pjsip_register_hdr_parser(), are parsed as
+ * usual by #pjsip_parse_rdata(). The remaining standard headers (Accept,
+ * Allow, Contact, Expires, Min-Expires, Retry-After, Supported and
+ * Unsupported) are kept as unparsed #pjsip_lazy_hdr, and are parsed on
+ * their first lookup with #pjsip_msg_find_hdr(),
+ * #pjsip_msg_find_hdr_by_name() or #pjsip_msg_find_hdr_by_names().
+ *
+ * Application which walks the header list of received messages directly
+ * must call #pjsip_parse_lazy_hdr() on the headers, and note that
+ * \a msg_info.supported in pjsip_rx_data is not set in this mode.
+ *
+ * This option can also be controlled at run-time by the
+ * \a lazy_hdr_parsing setting in pjsip_cfg_t.
+ *
+ * Default is PJ_FALSE.
+ */
+#ifndef PJSIP_LAZY_HDR_PARSING
+#   define PJSIP_LAZY_HDR_PARSING		    PJ_FALSE
+#endif
+
 /**
  * Accept call replace in early state when invite is not initiated
  * by the user agent. RFC 3891 Section 3 disallows this, however,
@@ -453,6 +453,31 @@ PJ_DECL(pjsip_tpmgr*) pjsip_endpt_get_tpmgr(pjsip_endpoint *endpt);
  */
 PJ_DECL(pj_ioqueue_t*) pjsip_endpt_get_ioqueue(pjsip_endpoint *endpt);
 
+/**
+ * Get the number of ioqueues created by the endpoint, as configured by
+ * the \a ioqueue_cnt setting in pjsip_cfg_t.
+ *
+ * @param endpt	    The endpoint.
+ *
+ * @return	    The number of ioqueues.
+ */
+PJ_DECL(unsigned) pjsip_endpt_get_ioqueue_count(pjsip_endpoint *endpt);
+
+/**
+ * Get one of the ioqueues created by the endpoint. Index zero is the
+ * ioqueue returned by #pjsip_endpt_get_ioqueue(), which is polled by
+ * #pjsip_endpt_handle_events(), and the others are polled by worker
+ * threads of the endpoint. The index is taken modulo the number of
+ * ioqueues, so a hash value may be used to spread sockets among them.
+ *
+ * @param endpt	    The endpoint.
+ * @param index	    The index or hash value.
+ *
+ * @return	    The ioqueue.
+ */
+PJ_DECL(pj_ioqueue_t*) pjsip_endpt_get_ioqueue_at(pjsip_endpoint *endpt,
+						  unsigned index);
+
 /**
  * Find a SIP transport suitable for sending SIP message to the specified
  * address. If transport selector ("sel") is set, then the function will
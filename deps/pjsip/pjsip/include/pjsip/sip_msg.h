@@ -962,6 +962,28 @@ PJ_INLINE(void) pjsip_msg_insert_first_hdr( pjsip_msg *msg, pjsip_hdr *hdr )
 PJ_DECL(pj_ssize_t) pjsip_msg_print(const pjsip_msg *msg, 
 				    char *buf, pj_size_t size);
 
+/**
+ * Print the message, allocating a larger buffer from the pool when the
+ * message does not fit in the buffer. The message is printed in a single
+ * pass: when the buffer is full, only the piece being printed (the start
+ * line, a header, or the body) is printed again to the larger buffer.
+ *
+ * @param msg	    The message to print.
+ * @param pool	    Pool to allocate larger buffer from.
+ * @param buf	    On input, the initial buffer, or NULL. On output, the
+ *		    buffer which contains the printed message.
+ * @param size	    On input, the size of the initial buffer. On output,
+ *		    the size of the buffer.
+ * @param max_size  Maximum size of the buffer.
+ *
+ * @return	    The length of the printed characters (in bytes), or
+ *		    NEGATIVE value if the message is larger than max_size.
+ */
+PJ_DECL(pj_ssize_t) pjsip_msg_print_alloc(const pjsip_msg *msg,
+					  pj_pool_t *pool,
+					  char **buf, pj_size_t *size,
+					  pj_size_t max_size);
+
 
 /*
  * Some usefull macros to find common headers.
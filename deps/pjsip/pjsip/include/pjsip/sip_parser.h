@@ -308,6 +308,52 @@ PJ_DECL(pj_status_t) pjsip_parse_headers( pj_pool_t *pool, char *input,
 				          unsigned options);
 
 
+/**
+ * This structure describes a header which has been left unparsed by
+ * #pjsip_parse_rdata() when lazy header parsing is enabled (see
+ * #PJSIP_LAZY_HDR_PARSING). The header has PJSIP_H_OTHER type and can be
+ * printed and cloned like generic string header. It is replaced in the
+ * message by the parsed header(s) on its first lookup with
+ * #pjsip_msg_find_hdr() and friends, or with #pjsip_parse_lazy_hdr().
+ */
+typedef struct pjsip_lazy_hdr
+{
+    /** Standard header field. */
+    PJSIP_DECL_HDR_MEMBER(struct pjsip_lazy_hdr);
+    /** The unparsed header value. */
+    pj_str_t		  hvalue;
+    /** The type of the header once parsed. */
+    pjsip_hdr_e		  lazy_type;
+    /** The function to parse the header, or NULL if parsing has failed. */
+    pjsip_parse_hdr_func *parse;
+    /** The pool to allocate the parsed header from. */
+    pj_pool_t		 *pool;
+} pjsip_lazy_hdr;
+
+
+/**
+ * Check if the header is an unparsed header (see #pjsip_lazy_hdr).
+ *
+ * @param hdr		The header.
+ *
+ * @return		PJ_TRUE if the header is an unparsed header.
+ */
+PJ_DECL(pj_bool_t) pjsip_hdr_is_lazy(const pjsip_hdr *hdr);
+
+/**
+ * Parse an unparsed header (see #pjsip_lazy_hdr). If the header is part
+ * of a header list (such as the header list of a message), it will be
+ * replaced in the list by the parsed header(s). If parsing fails, the
+ * header is kept and will behave as generic string header from then on.
+ *
+ * @param hdr		The header.
+ *
+ * @return		The (first) parsed header, or the header itself if
+ *			it is not an unparsed header or it fails to parse.
+ */
+PJ_DECL(pjsip_hdr*) pjsip_parse_lazy_hdr(pjsip_hdr *hdr);
+
+
 /**
  * @}
  */
@@ -49,6 +49,15 @@ typedef struct exit_cb
 } exit_cb;
 
 
+/* Additional ioqueue, polled by its own worker thread. */
+typedef struct ioq_worker
+{
+    pjsip_endpoint		   *endpt;
+    pj_ioqueue_t		   *ioqueue;
+    pj_thread_t			   *thread;
+} ioq_worker;
+
+
 /**
  * The SIP endpoint.
  */
@@ -75,6 +84,17 @@ struct pjsip_endpoint
     /** Ioqueue. */
     pj_ioqueue_t	*ioqueue;
 
+    /** Number of ioqueues, including the one above. */
+    unsigned		 ioqueue_cnt;
+
+    /** Additional ioqueues and their worker threads. */
+    ioq_worker		*ioq_worker;
+
+    /** Flag to stop the ioqueue worker threads, set to non-zero by the
+     *  thread destroying the endpoint.
+     */
+    pj_atomic_t		*ioq_quit;
+
     /** Last ioqueue err */
     pj_status_t		 ioq_last_err;
 
@@ -121,6 +141,9 @@ static pj_status_t endpt_on_tx_msg( pjsip_endpoint *endpt,
 static pj_status_t unload_module(pjsip_endpoint *endpt,
 				 pjsip_module *mod);
 
+static pj_status_t create_ioqueues(pjsip_endpoint *endpt);
+static void destroy_ioqueues(pjsip_endpoint *endpt);
+
 /* Defined in sip_parser.c */
 void init_sip_parser(void);
 void deinit_sip_parser(void);
@@ -503,8 +526,8 @@ PJ_DEF(pj_status_t) pjsip_endpt_create(pj_pool_factory *pf,
     pj_timer_heap_set_max_timed_out_per_poll(endpt->timer_heap, 
 					     PJSIP_MAX_TIMED_OUT_ENTRIES);
 
-    /* Create ioqueue. */
-    status = pj_ioqueue_create( endpt->pool, PJSIP_MAX_TRANSPORTS, &endpt->ioqueue);
+    /* Create ioqueue(s). */
+    status = create_ioqueues(endpt);
     if (status != PJ_SUCCESS) {
 	goto on_error;
     }
@@ -546,10 +569,7 @@ on_error:
 	pjsip_tpmgr_destroy(endpt->transport_mgr);
 	endpt->transport_mgr = NULL;
     }
-    if (endpt->ioqueue) {
-	pj_ioqueue_destroy(endpt->ioqueue);
-	endpt->ioqueue = NULL;
-    }
+    destroy_ioqueues(endpt);
     if (endpt->timer_heap) {
 	pj_timer_heap_destroy(endpt->timer_heap);
 	endpt->timer_heap = NULL;
@@ -603,8 +623,8 @@ PJ_DEF(void) pjsip_endpt_destroy(pjsip_endpoint *endpt)
     /* Shutdown and destroy all transports. */
     pjsip_tpmgr_destroy(endpt->transport_mgr);
 
-    /* Destroy ioqueue */
-    pj_ioqueue_destroy(endpt->ioqueue);
+    /* Destroy ioqueue(s) */
+    destroy_ioqueues(endpt);
 
     /* Destroy timer heap */
 #if PJ_TIMER_DEBUG
@@ -694,6 +714,95 @@ PJ_DEF(void) pjsip_endpt_release_pool( pjsip_endpoint *endpt, pj_pool_t *pool )
 }
 
 
+/* Worker thread to poll one of the additional ioqueues. */
+static int PJ_THREAD_FUNC ioq_worker_proc(void *arg)
+{
+    ioq_worker *w = (ioq_worker*) arg;
+
+    while (pj_atomic_get(w->endpt->ioq_quit) == 0) {
+	pj_time_val timeout = { 0, 500 };
+	pj_ioqueue_poll(w->ioqueue, &timeout);
+    }
+
+    return 0;
+}
+
+/* Create the endpoint's ioqueue, and the additional ioqueues with their
+ * worker threads when more than one is configured.
+ */
+static pj_status_t create_ioqueues(pjsip_endpoint *endpt)
+{
+    unsigned i, cnt = pjsip_cfg()->endpt.ioqueue_cnt;
+    pj_status_t status;
+
+    status = pj_ioqueue_create(endpt->pool, PJSIP_MAX_TRANSPORTS,
+			       &endpt->ioqueue);
+    if (status != PJ_SUCCESS)
+	return status;
+
+    endpt->ioqueue_cnt = 1;
+    if (cnt <= 1)
+	return PJ_SUCCESS;
+
+    status = pj_atomic_create(endpt->pool, 0, &endpt->ioq_quit);
+    if (status != PJ_SUCCESS)
+	return status;
+
+    endpt->ioq_worker = (ioq_worker*)
+			pj_pool_calloc(endpt->pool, cnt - 1,
+				       sizeof(ioq_worker));
+    for (i=0; i<cnt-1; ++i) {
+	ioq_worker *w = &endpt->ioq_worker[i];
+
+	w->endpt = endpt;
+	status = pj_ioqueue_create(endpt->pool, PJSIP_MAX_TRANSPORTS,
+				   &w->ioqueue);
+	if (status != PJ_SUCCESS)
+	    return status;
+
+	status = pj_thread_create(endpt->pool, "sipioq%p", &ioq_worker_proc,
+				  w, 0, 0, &w->thread);
+	if (status != PJ_SUCCESS) {
+	    pj_ioqueue_destroy(w->ioqueue);
+	    w->ioqueue = NULL;
+	    return status;
+	}
+
+	++endpt->ioqueue_cnt;
+    }
+
+    PJ_LOG(4, (THIS_FILE, "Endpoint uses %d ioqueues", endpt->ioqueue_cnt));
+    return PJ_SUCCESS;
+}
+
+/* Stop the worker threads and destroy all ioqueues. */
+static void destroy_ioqueues(pjsip_endpoint *endpt)
+{
+    unsigned i;
+
+    if (endpt->ioq_quit)
+	pj_atomic_set(endpt->ioq_quit, 1);
+    for (i=0; i+1<endpt->ioqueue_cnt; ++i) {
+	ioq_worker *w = &endpt->ioq_worker[i];
+
+	pj_thread_join(w->thread);
+	pj_thread_destroy(w->thread);
+	pj_ioqueue_destroy(w->ioqueue);
+    }
+    endpt->ioqueue_cnt = 0;
+
+    if (endpt->ioq_quit) {
+	pj_atomic_destroy(endpt->ioq_quit);
+	endpt->ioq_quit = NULL;
+    }
+
+    if (endpt->ioqueue) {
+	pj_ioqueue_destroy(endpt->ioqueue);
+	endpt->ioqueue = NULL;
+    }
+}
+
+
 PJ_DEF(pj_status_t) pjsip_endpt_handle_events2(pjsip_endpoint *endpt,
 					       const pj_time_val *max_timeout,
 					       unsigned *p_count)
@@ -1173,6 +1282,24 @@ PJ_DEF(pj_ioqueue_t*) pjsip_endpt_get_ioqueue(pjsip_endpoint *endpt)
     return endpt->ioqueue;
 }
 
+/*
+ * Get number of ioqueues.
+ */
+PJ_DEF(unsigned) pjsip_endpt_get_ioqueue_count(pjsip_endpoint *endpt)
+{
+    return endpt->ioqueue_cnt;
+}
+
+/*
+ * Get ioqueue instance by index or hash value.
+ */
+PJ_DEF(pj_ioqueue_t*) pjsip_endpt_get_ioqueue_at(pjsip_endpoint *endpt,
+						 unsigned index)
+{
+    index %= endpt->ioqueue_cnt;
+    return index == 0 ? endpt->ioqueue : endpt->ioq_worker[index-1].ioqueue;
+}
+
 /*
  * Find/create transport.
  */
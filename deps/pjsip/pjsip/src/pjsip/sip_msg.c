@@ -335,6 +335,15 @@ PJ_DEF(pjsip_msg*) pjsip_msg_clone( pj_pool_t *pool, const pjsip_msg *src)
     return dst;
 }
 
+/* Check for header which has been left unparsed (see pjsip_lazy_hdr). */
+#define IS_LAZY_HDR(hdr)    ((hdr)->type == PJSIP_H_OTHER && \
+			     pjsip_hdr_is_lazy(hdr))
+
+/* Parse the unparsed header found by the lookup functions below. The
+ * header is replaced in the message, hence the const cast.
+ */
+#define PARSE_LAZY_HDR(hdr) pjsip_parse_lazy_hdr((pjsip_hdr*)(hdr))
+
 PJ_DEF(void*)  pjsip_msg_find_hdr( const pjsip_msg *msg, 
 				   pjsip_hdr_e hdr_type, const void *start)
 {
@@ -344,6 +353,11 @@ PJ_DEF(void*)  pjsip_msg_find_hdr( const pjsip_msg *msg,
 	hdr = msg->hdr.next;
     }
     for (; hdr!=end; hdr = hdr->next) {
+	if (IS_LAZY_HDR(hdr)) {
+	    if (((const pjsip_lazy_hdr*)hdr)->lazy_type != hdr_type)
+		continue;
+	    hdr = PARSE_LAZY_HDR(hdr);
+	}
 	if (hdr->type == hdr_type)
 	    return (void*)hdr;
     }
@@ -361,7 +375,7 @@ PJ_DEF(void*)  pjsip_msg_find_hdr_by_name( const pjsip_msg *msg,
     }
     for (; hdr!=end; hdr = hdr->next) {
 	if (pj_stricmp(&hdr->name, name) == 0)
-	    return (void*)hdr;
+	    return IS_LAZY_HDR(hdr) ? PARSE_LAZY_HDR(hdr) : (void*)hdr;
     }
     return NULL;
 }
@@ -377,10 +391,11 @@ PJ_DEF(void*)  pjsip_msg_find_hdr_by_names( const pjsip_msg *msg,
 	hdr = msg->hdr.next;
     }
     for (; hdr!=end; hdr = hdr->next) {
-	if (pj_stricmp(&hdr->name, name) == 0)
-	    return (void*)hdr;
-	if (pj_stricmp(&hdr->name, sname) == 0)
-	    return (void*)hdr;
+	if (pj_stricmp(&hdr->name, name) == 0 ||
+	    pj_stricmp(&hdr->name, sname) == 0)
+	{
+	    return IS_LAZY_HDR(hdr) ? PARSE_LAZY_HDR(hdr) : (void*)hdr;
+	}
     }
     return NULL;
 }
@@ -406,31 +421,69 @@ PJ_DEF(void*) pjsip_msg_find_remove_hdr_by_name( pjsip_msg *msg,
     return hdr;
 }
 
-PJ_DEF(pj_ssize_t) pjsip_msg_print( const pjsip_msg *msg, 
-				    char *buf, pj_size_t size)
+/*
+ * Message printer. The message is printed piece by piece (the start line,
+ * each header, and the body), and when a piece doesn't fit in the buffer
+ * and a pool is given, the buffer is grown and only that piece is printed
+ * again, instead of the whole message.
+ */
+typedef struct msg_printer
+{
+    pj_pool_t	*pool;
+    char	*start;
+    char	*p;
+    char	*end;
+    pj_size_t	 max_size;
+} msg_printer;
+
+/* Space reserved for the Content-Length value. */
+enum { CLEN_SPACE = 5 };
+
+/* Print with the expression, growing the buffer until the piece fits. */
+#define PRINT_OR_GROW(pr, len, expr)	\
+	    while ((len = (expr)) < 0) {	\
+		if (!printer_grow(pr))	\
+		    return -1;		\
+	    }
+
+/* Grow the buffer to twice its size, keeping what has been printed. */
+static pj_bool_t printer_grow(msg_printer *pr)
 {
-    char *p=buf, *end=buf+size;
-    pj_ssize_t len;
-    pjsip_hdr *hdr;
-    pj_str_t clen_hdr =  { "Content-Length: ", 16};
+    pj_size_t size = pr->end - pr->start;
+    pj_size_t len = pr->p - pr->start;
+    char *buf;
 
-    if (pjsip_use_compact_form) {
-	clen_hdr.ptr = "l: ";
-	clen_hdr.slen = 3;
-    }
+    if (pr->pool == NULL || size >= pr->max_size)
+	return PJ_FALSE;
 
-    /* Get a wild guess on how many bytes are typically needed.
-     * We'll check this later in detail, but this serves as a quick check.
-     */
-    if (size < 256)
-	return -1;
+    size = size ? size * 2 : 512;
+    if (size > pr->max_size)
+	size = pr->max_size;
+
+    buf = (char*) pj_pool_alloc(pr->pool, size);
+    if (len)
+	pj_memcpy(buf, pr->start, len);
+
+    pr->start = buf;
+    pr->p = buf + len;
+    pr->end = buf + size;
+    return PJ_TRUE;
+}
+
+/* Print request line or status line. */
+static pj_ssize_t print_start_line(const pjsip_msg *msg,
+				   char *buf, pj_size_t size)
+{
+    char *p=buf, *end=buf+size;
+    pj_ssize_t len;
 
-    /* Print request line or status line depending on message type */
     if (msg->type == PJSIP_REQUEST_MSG) {
 	pjsip_uri *uri;
 
 	/* Add method. */
 	len = msg->line.req.method.name.slen;
+	if (end-p < len + 1)
+	    return -1;
 	pj_memcpy(p, msg->line.req.method.name.ptr, len);
 	p += len;
 	*p++ = ' ';
@@ -450,6 +503,10 @@ PJ_DEF(pj_ssize_t) pjsip_msg_print( const pjsip_msg *msg,
 
     } else {
 
+	/* Status code is at most 10 digits. */
+	if (end-p < 8 + 10 + 1 + msg->line.status.reason.slen + 2)
+	    return -1;
+
 	/* Add 'SIP/2.0 ' */
 	pj_memcpy(p, "SIP/2.0 ", 8);
 	p += 8;
@@ -469,107 +526,218 @@ PJ_DEF(pj_ssize_t) pjsip_msg_print( const pjsip_msg *msg,
 	*p++ = '\n';
     }
 
-    /* Print each of the headers. */
-    for (hdr=msg->hdr.next; hdr!=&msg->hdr; hdr=hdr->next) {
-	len = pjsip_hdr_print_on(hdr, p, end-p);
-	if (len < 0)
-	    return -1;
+    return p-buf;
+}
 
-	if (len > 0) {
-	    p += len;
-	    if (p+3 >= end)
-		return -1;
+/* Print one header line. */
+static pj_ssize_t print_hdr_line(const pjsip_hdr *hdr,
+				 char *buf, pj_size_t size)
+{
+    pj_ssize_t len;
 
-	    *p++ = '\r';
-	    *p++ = '\n';
-	}
-    }
+    len = pjsip_hdr_print_on((void*)hdr, buf, size);
+    if (len <= 0)
+	return len;
 
-    /* Process message body. */
-    if (msg->body) {
-	enum { CLEN_SPACE = 5 };
-	char *clen_pos = NULL;
+    if (len + 3 >= (pj_ssize_t)size)
+	return -1;
 
-	/* Automaticly adds Content-Type and Content-Length headers, only
-	 * if content_type is set in the message body.
-	 */
-	if (msg->body->content_type.type.slen) {
-	    pj_str_t ctype_hdr = { "Content-Type: ", 14};
-	    const pjsip_media_type *media = &msg->body->content_type;
+    buf[len++] = '\r';
+    buf[len++] = '\n';
+    return len;
+}
 
-	    if (pjsip_use_compact_form) {
-		ctype_hdr.ptr = "c: ";
-		ctype_hdr.slen = 3;
-	    }
+/* Print Content-Type and Content-Length of the body, and the blank line.
+ * The Content-Length value is filled in after the body is printed.
+ */
+static pj_ssize_t print_body_hdrs(const pjsip_msg_body *body,
+				  char *buf, pj_size_t size,
+				  pj_ssize_t *clen_off)
+{
+    char *p=buf, *end=buf+size;
 
-	    /* Add Content-Type header. */
-	    if ( (end-p) < 24 + media->type.slen + media->subtype.slen) {
-		return -1;
-	    }
-	    pj_memcpy(p, ctype_hdr.ptr, ctype_hdr.slen);
-	    p += ctype_hdr.slen;
-	    p += print_media_type(p, (unsigned)(end-p), media);
-	    *p++ = '\r';
-	    *p++ = '\n';
-
-	    /* Add Content-Length header. */
-	    if ((end-p) < clen_hdr.slen + 12 + 2) {
-		return -1;
-	    }
-	    pj_memcpy(p, clen_hdr.ptr, clen_hdr.slen);
-	    p += clen_hdr.slen;
-	    
-	    /* Print blanks after "Content-Length:", this is where we'll put
-	     * the content length value after we know the length of the
-	     * body.
-	     */
-	    pj_memset(p, ' ', CLEN_SPACE);
-	    clen_pos = p;
-	    p += CLEN_SPACE;
-	    *p++ = '\r';
-	    *p++ = '\n';
+    *clen_off = -1;
+
+    /* Automaticly adds Content-Type and Content-Length headers, only
+     * if content_type is set in the message body.
+     */
+    if (body->content_type.type.slen) {
+	pj_str_t ctype_hdr = { "Content-Type: ", 14};
+	pj_str_t clen_hdr =  { "Content-Length: ", 16};
+	const pjsip_media_type *media = &body->content_type;
+
+	if (pjsip_use_compact_form) {
+	    ctype_hdr.ptr = "c: ";
+	    ctype_hdr.slen = 3;
+	    clen_hdr.ptr = "l: ";
+	    clen_hdr.slen = 3;
 	}
-	
-	/* Add blank newline. */
+
+	/* Add Content-Type header. */
+	if ( (end-p) < 24 + media->type.slen + media->subtype.slen) {
+	    return -1;
+	}
+	pj_memcpy(p, ctype_hdr.ptr, ctype_hdr.slen);
+	p += ctype_hdr.slen;
+	p += print_media_type(p, (unsigned)(end-p), media);
 	*p++ = '\r';
 	*p++ = '\n';
 
-	/* Print the message body itself. */
-	len = (*msg->body->print_body)(msg->body, p, end-p);
-	if (len < 0) {
+	/* Add Content-Length header. */
+	if ((end-p) < clen_hdr.slen + 12 + 2) {
 	    return -1;
 	}
-	p += len;
+	pj_memcpy(p, clen_hdr.ptr, clen_hdr.slen);
+	p += clen_hdr.slen;
+
+	/* Print blanks after "Content-Length:", this is where we'll put
+	 * the content length value after we know the length of the
+	 * body.
+	 */
+	pj_memset(p, ' ', CLEN_SPACE);
+	*clen_off = p - buf;
+	p += CLEN_SPACE;
+	*p++ = '\r';
+	*p++ = '\n';
+
+    } else if (end-p < 2) {
+	return -1;
+    }
+
+    /* Add blank newline. */
+    *p++ = '\r';
+    *p++ = '\n';
+
+    return p-buf;
+}
+
+/* Print the message body, leaving room for the NULL terminator. */
+static pj_ssize_t print_body(pjsip_msg_body *body, char *buf, pj_size_t size)
+{
+    if (size < 1)
+	return -1;
+    return (*body->print_body)(body, buf, size-1);
+}
+
+/* Print Content-Length with zero value, for message without body. */
+static pj_ssize_t print_zero_clen(char *buf, pj_size_t size)
+{
+    char *p = buf;
+    pj_str_t clen_hdr =  { "Content-Length: ", 16};
+
+    if (pjsip_use_compact_form) {
+	clen_hdr.ptr = "l: ";
+	clen_hdr.slen = 3;
+    }
+
+    if ((pj_ssize_t)size < clen_hdr.slen+8) {
+	return -1;
+    }
+    pj_memcpy(p, clen_hdr.ptr, clen_hdr.slen);
+    p += clen_hdr.slen;
+    *p++ = ' ';
+    *p++ = '0';
+    *p++ = '\r';
+    *p++ = '\n';
+    *p++ = '\r';
+    *p++ = '\n';
+
+    return p-buf;
+}
+
+/* Print the whole message. */
+static pj_ssize_t print_msg(msg_printer *pr, const pjsip_msg *msg)
+{
+    pj_ssize_t len;
+    const pjsip_hdr *hdr;
+
+    /* Print request line or status line depending on message type */
+    PRINT_OR_GROW(pr, len, print_start_line(msg, pr->p, pr->end-pr->p));
+    pr->p += len;
+
+    /* Print each of the headers. */
+    for (hdr=msg->hdr.next; hdr!=&msg->hdr; hdr=hdr->next) {
+	PRINT_OR_GROW(pr, len, print_hdr_line(hdr, pr->p, pr->end-pr->p));
+	pr->p += len;
+    }
+
+    /* Process message body. */
+    if (msg->body) {
+	pj_ssize_t clen_off, clen_pos = -1;
+
+	PRINT_OR_GROW(pr, len, print_body_hdrs(msg->body, pr->p,
+					       pr->end-pr->p, &clen_off));
+	if (clen_off >= 0)
+	    clen_pos = (pr->p - pr->start) + clen_off;
+	pr->p += len;
+
+	/* Print the message body itself. */
+	PRINT_OR_GROW(pr, len, print_body(msg->body, pr->p, pr->end-pr->p));
+	pr->p += len;
 
 	/* Now that we have the length of the body, print this to the
 	 * Content-Length header.
 	 */
-	if (clen_pos) {
+	if (clen_pos >= 0) {
 	    char tmp[16];
 	    len = pj_utoa((unsigned long)len, tmp);
 	    if (len > CLEN_SPACE) len = CLEN_SPACE;
-	    pj_memcpy(clen_pos+CLEN_SPACE-len, tmp, len);
+	    pj_memcpy(pr->start+clen_pos+CLEN_SPACE-len, tmp, len);
 	}
 
     } else {
 	/* There's no message body.
 	 * Add Content-Length with zero value.
 	 */
-	if ((end-p) < clen_hdr.slen+8) {
-	    return -1;
-	}
-	pj_memcpy(p, clen_hdr.ptr, clen_hdr.slen);
-	p += clen_hdr.slen;
-	*p++ = ' ';
-	*p++ = '0';
-	*p++ = '\r';
-	*p++ = '\n';
-	*p++ = '\r';
-	*p++ = '\n';
+	PRINT_OR_GROW(pr, len, print_zero_clen(pr->p, pr->end-pr->p));
+	pr->p += len;
     }
 
-    *p = '\0';
-    return p-buf;
+    *pr->p = '\0';
+    return pr->p - pr->start;
+}
+
+PJ_DEF(pj_ssize_t) pjsip_msg_print( const pjsip_msg *msg, 
+				    char *buf, pj_size_t size)
+{
+    msg_printer pr;
+
+    /* Get a wild guess on how many bytes are typically needed.
+     * We'll check this later in detail, but this serves as a quick check.
+     */
+    if (size < 256)
+	return -1;
+
+    pr.pool = NULL;
+    pr.start = pr.p = buf;
+    pr.end = buf + size;
+    pr.max_size = size;
+
+    return print_msg(&pr, msg);
+}
+
+PJ_DEF(pj_ssize_t) pjsip_msg_print_alloc( const pjsip_msg *msg,
+					  pj_pool_t *pool,
+					  char **buf, pj_size_t *size,
+					  pj_size_t max_size)
+{
+    msg_printer pr;
+    pj_ssize_t len;
+
+    PJ_ASSERT_RETURN(msg && pool && buf && size, -1);
+
+    pr.pool = pool;
+    pr.start = pr.p = *buf;
+    pr.end = *buf ? *buf + *size : NULL;
+    pr.max_size = max_size;
+
+    len = print_msg(&pr, msg);
+    if (len < 0)
+	return -1;
+
+    *buf = pr.start;
+    *size = pr.end - pr.start;
+    return len;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
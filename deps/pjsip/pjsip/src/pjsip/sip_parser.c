@@ -24,6 +24,7 @@
 #include <pjsip/sip_auth_parser.h>
 #include <pjsip/sip_errno.h>
 #include <pjsip/sip_transport.h>        /* rdata structure */
+#include <pjsip/print_util.h>
 #include <pjlib-util/scanner.h>
 #include <pjlib-util/string.h>
 #include <pj/except.h>
@@ -62,6 +63,20 @@
 #define IS_NEWLINE(c)	((c)=='\r' || (c)=='\n')
 #define IS_SPACE(c)	((c)==' ' || (c)=='\t')
 
+/*
+ * Headers which may be left unparsed by pjsip_parse_rdata() when lazy
+ * header parsing is enabled (see PJSIP_LAZY_HDR_PARSING). Headers which
+ * are needed for transaction matching, dialog and routing, as well as
+ * Content-Type which is needed to parse the body, are always parsed.
+ */
+typedef struct lazy_hdr_rec
+{
+    pj_str_t		  name;
+    pj_str_t		  sname;
+    pjsip_hdr_e		  type;
+    pjsip_parse_hdr_func *handler;
+} lazy_hdr_rec;
+
 /*
  * Header parser records.
  */
@@ -71,6 +86,7 @@ typedef struct handler_rec
     pj_size_t		  hname_len;
     pj_uint32_t		  hname_hash;
     pjsip_parse_hdr_func *handler;
+    const lazy_hdr_rec	 *lazy;
 } handler_rec;
 
 static handler_rec handler[PJSIP_MAX_HEADER_TYPES];
@@ -94,6 +110,9 @@ static unsigned uri_handler_count;
  */
 int PJSIP_SYN_ERR_EXCEPTION = -1;
 
+/* Defined in sip_msg.c */
+extern pj_bool_t pjsip_use_compact_form;
+
 /* Parser constants */
 static pjsip_parser_const_t pconst =
 {
@@ -184,6 +203,84 @@ static pjsip_hdr*   parse_hdr_to( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_unsupported( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_via( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_generic_string( pjsip_parse_ctx *ctx);
+static pjsip_hdr*   parse_hdr_lazy( pjsip_parse_ctx *ctx,
+				    const lazy_hdr_rec *lazy);
+
+static const lazy_hdr_rec lazy_hdr[] =
+{
+    { {"Accept", 6},	    {"Accept", 6},	 PJSIP_H_ACCEPT,
+      &parse_hdr_accept },
+    { {"Allow", 5},	    {"Allow", 5},	 PJSIP_H_ALLOW,
+      &parse_hdr_allow },
+    { {"Contact", 7},	    {"m", 1},		 PJSIP_H_CONTACT,
+      &parse_hdr_contact },
+    { {"Expires", 7},	    {"Expires", 7},	 PJSIP_H_EXPIRES,
+      &parse_hdr_expires },
+    { {"Min-Expires", 11},  {"Min-Expires", 11}, PJSIP_H_MIN_EXPIRES,
+      &parse_hdr_min_expires },
+    { {"Retry-After", 11},  {"Retry-After", 11}, PJSIP_H_RETRY_AFTER,
+      &parse_hdr_retry_after },
+    { {"Supported", 9},	    {"k", 1},		 PJSIP_H_SUPPORTED,
+      &parse_hdr_supported },
+    { {"Unsupported", 11},  {"Unsupported", 11}, PJSIP_H_UNSUPPORTED,
+      &parse_hdr_unsupported },
+};
+
+/*
+ * Parsers of the standard headers, for both the full and the compact
+ * form of the header name. These are found with a perfect hash of the
+ * header name (see BUILTIN_HASH()) instead of the run-time table, and
+ * builtin_index[] maps the hash value to the (1-based) position in this
+ * table. When adding a header here, the multipliers of BUILTIN_HASH()
+ * and builtin_index[] must be recomputed so that all the names still
+ * hash to distinct values.
+ */
+static const handler_rec builtin_handler[] =
+{
+    { "Accept",		6,  0, &parse_hdr_accept,	&lazy_hdr[0] },
+    { "Allow",		5,  0, &parse_hdr_allow,	&lazy_hdr[1] },
+    { "Call-ID",	7,  0, &parse_hdr_call_id,	NULL },
+    { "i",		1,  0, &parse_hdr_call_id,	NULL },
+    { "Contact",	7,  0, &parse_hdr_contact,	&lazy_hdr[2] },
+    { "m",		1,  0, &parse_hdr_contact,	&lazy_hdr[2] },
+    { "Content-Length",	14, 0, &parse_hdr_content_len,	NULL },
+    { "l",		1,  0, &parse_hdr_content_len,	NULL },
+    { "Content-Type",	12, 0, &parse_hdr_content_type,	NULL },
+    { "c",		1,  0, &parse_hdr_content_type,	NULL },
+    { "CSeq",		4,  0, &parse_hdr_cseq,		NULL },
+    { "Expires",	7,  0, &parse_hdr_expires,	&lazy_hdr[3] },
+    { "From",		4,  0, &parse_hdr_from,		NULL },
+    { "f",		1,  0, &parse_hdr_from,		NULL },
+    { "Max-Forwards",	12, 0, &parse_hdr_max_forwards,	NULL },
+    { "Min-Expires",	11, 0, &parse_hdr_min_expires,	&lazy_hdr[4] },
+    { "Record-Route",	12, 0, &parse_hdr_rr,		NULL },
+    { "Route",		5,  0, &parse_hdr_route,	NULL },
+    { "Require",	7,  0, &parse_hdr_require,	NULL },
+    { "Retry-After",	11, 0, &parse_hdr_retry_after,	&lazy_hdr[5] },
+    { "Supported",	9,  0, &parse_hdr_supported,	&lazy_hdr[6] },
+    { "k",		1,  0, &parse_hdr_supported,	&lazy_hdr[6] },
+    { "To",		2,  0, &parse_hdr_to,		NULL },
+    { "t",		1,  0, &parse_hdr_to,		NULL },
+    { "Unsupported",	11, 0, &parse_hdr_unsupported,	&lazy_hdr[7] },
+    { "Via",		3,  0, &parse_hdr_via,		NULL },
+    { "v",		1,  0, &parse_hdr_via,		NULL },
+};
+
+/* Case insensitive hash of the first and last character and the length
+ * of the header name.
+ */
+#define BUILTIN_HASH(name, len) \
+	    ((((pj_uint8_t)(name)[0] | 0x20) * 2 + \
+	      ((pj_uint8_t)(name)[(len)-1] | 0x20) * 31 + \
+	      (unsigned)(len)) & 63)
+
+static const pj_uint8_t builtin_index[64] =
+{
+     0,  0,  0, 13, 10,  0,  0,  0,  0,  0,  4, 21, 22,  9,  6,  0,
+     0, 25, 16, 15,  1,  0,  0,  0,  0,  5,  0, 23,  0,  0,  0,  0,
+     0,  0,  0,  0, 18,  0, 19, 14,  0,  3,  0, 17,  7,  8, 26,  0,
+     2,  0,  0,  0,  0, 24,  0, 27,  0, 11,  0,  0,  0, 20, 12,  0
+};
 
 /* Convert non NULL terminated string to integer. */
 static unsigned long pj_strtoul_mindigit(const pj_str_t *str, 
@@ -401,74 +498,6 @@ static pj_status_t init_parser()
     status = pjsip_register_uri_parser("sips", &int_parse_sip_url);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    /*
-     * Register header parsers.
-     */
-
-    status = pjsip_register_hdr_parser( "Accept", NULL, &parse_hdr_accept);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Allow", NULL, &parse_hdr_allow);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Call-ID", "i", &parse_hdr_call_id);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Contact", "m", &parse_hdr_contact);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Content-Length", "l", 
-                                        &parse_hdr_content_len);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Content-Type", "c", 
-                                        &parse_hdr_content_type);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "CSeq", NULL, &parse_hdr_cseq);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Expires", NULL, &parse_hdr_expires);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "From", "f", &parse_hdr_from);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Max-Forwards", NULL, 
-                                        &parse_hdr_max_forwards);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Min-Expires", NULL, 
-                                        &parse_hdr_min_expires);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Record-Route", NULL, &parse_hdr_rr);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Route", NULL, &parse_hdr_route);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Require", NULL, &parse_hdr_require);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Retry-After", NULL, 
-                                        &parse_hdr_retry_after);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Supported", "k", 
-                                        &parse_hdr_supported);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "To", "t", &parse_hdr_to);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Unsupported", NULL, 
-                                        &parse_hdr_unsupported);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
-    status = pjsip_register_hdr_parser( "Via", "v", &parse_hdr_via);
-    PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
-
     /* 
      * Register auth parser. 
      */
@@ -536,6 +565,30 @@ PJ_INLINE(int) compare_handler( const handler_rec *r1,
     return pj_memcmp(r1->hname, name, name_len);
 }
 
+/* Find the parser of standard header. */
+PJ_INLINE(const handler_rec*) find_builtin_handler( const char *name,
+						    pj_size_t name_len )
+{
+    const handler_rec *rec;
+    unsigned idx;
+
+    if (name_len == 0)
+	return NULL;
+
+    idx = builtin_index[BUILTIN_HASH(name, name_len)];
+    if (idx == 0)
+	return NULL;
+
+    rec = &builtin_handler[idx-1];
+    if (rec->hname_len != name_len ||
+	pj_ansi_strnicmp(rec->hname, name, name_len) != 0)
+    {
+	return NULL;
+    }
+
+    return rec;
+}
+
 /* Register one handler for one header name. */
 static pj_status_t int_register_parser( const char *name, 
                                         pjsip_parse_hdr_func *fptr )
@@ -548,8 +601,15 @@ static pj_status_t int_register_parser( const char *name,
 	return PJ_ETOOMANY;
     }
 
+    /* Standard headers can not be overridden. */
+    if (find_builtin_handler(name, strlen(name))) {
+	pj_assert(0);
+	return PJ_EEXISTS;
+    }
+
     /* Initialize temporary handler. */
     rec.handler = fptr;
+    rec.lazy = NULL;
     rec.hname_len = strlen(name);
     if (rec.hname_len >= sizeof(rec.hname)) {
 	pj_assert(!"Header name is too long!");
@@ -636,9 +696,9 @@ PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
 }
 
 
-/* Find handler to parse the header name. */
-static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash, 
-					       const pj_str_t *hname)
+/* Find handler record of the header name. */
+static const handler_rec * find_handler_imp(pj_uint32_t  hash,
+				      const pj_str_t *hname)
 {
     handler_rec *first;
     int		 comp;
@@ -664,28 +724,35 @@ static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash,
 	}
     }
 
-    return comp==0 ? first->handler : NULL;
+    return comp==0 ? first : NULL;
 }
 
 
-/* Find handler to parse the header name. */
-static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
+/* Find handler record of the header name. */
+static const handler_rec* find_handler_rec(const pj_str_t *hname)
 {
     pj_uint32_t hash;
     char hname_copy[PJSIP_MAX_HNAME_LEN];
     pj_str_t tmp;
-    pjsip_parse_hdr_func *func;
+    const handler_rec *rec;
 
     if (hname->slen >= PJSIP_MAX_HNAME_LEN) {
 	/* Guaranteed not to be able to find handler. */
         return NULL;
     }
 
-    /* First, common case, try to find handler with exact name */
+    /* Most headers are standard headers. */
+    rec = find_builtin_handler(hname->ptr, hname->slen);
+    if (rec)
+	return rec;
+
+    /* Otherwise try to find handler registered at run-time, first with
+     * exact name.
+     */
     hash = pj_hash_calc(0, hname->ptr, (unsigned)hname->slen);
-    func = find_handler_imp(hash, hname);
-    if (func)
-	return func;
+    rec = find_handler_imp(hash, hname);
+    if (rec)
+	return rec;
 
 
     /* If not found, try converting the header name to lowercase and
@@ -698,6 +765,14 @@ static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
 }
 
 
+/* Find handler to parse the header name. */
+static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
+{
+    const handler_rec *rec = find_handler_rec(hname);
+    return rec ? rec->handler : NULL;
+}
+
+
 /* Find URI handler. */
 static pjsip_parse_uri_func* find_uri_handler(const pj_str_t *scheme)
 {
@@ -944,10 +1019,14 @@ static pjsip_msg *int_parse_msg( pjsip_parse_ctx *ctx,
     pjsip_ctype_hdr *ctype_hdr = NULL;
     pj_scanner *scanner = ctx->scanner;
     pj_pool_t *pool = ctx->pool;
+    pj_bool_t lazy;
     PJ_USE_EXCEPTION;
 
     parsing_headers = PJ_FALSE;
 
+    /* Only received messages are parsed lazily. */
+    lazy = (ctx->rdata && pjsip_cfg()->endpt.lazy_hdr_parsing);
+
 retry_parse:
     PJ_TRY 
     {
@@ -980,7 +1059,7 @@ retry_parse:
 parse_headers:
 	/* Parse headers. */
 	do {
-	    pjsip_parse_hdr_func * func;
+	    const handler_rec *rec;
 	    pjsip_hdr *hdr = NULL;
 
 	    /* Init hname just in case parsing fails.
@@ -995,14 +1074,19 @@ parse_headers:
 	    }
 	    
 	    /* Find handler. */
-	    func = find_handler(&hname);
-	    
+	    rec = find_handler_rec(&hname);
+
 	    /* Call the handler if found.
 	     * If no handler is found, then treat the header as generic
 	     * hname/hvalue pair.
+	     * In lazy mode, the header value is only kept to be parsed
+	     * when the header is looked up for the first time.
 	     */
-	    if (func) {
-		hdr = (*func)(ctx);
+	    if (rec && lazy && rec->lazy) {
+		hdr = parse_hdr_lazy(ctx, rec->lazy);
+
+	    } else if (rec) {
+		hdr = (*rec->handler)(ctx);
 
 		/* Note:
 		 *  hdr MAY BE NULL, if parsing does not yield a new header
@@ -1692,38 +1776,44 @@ PJ_DEF(void) pjsip_parse_generic_array_hdr_imp( pjsip_generic_array_hdr *hdr,
 }
 
 
-/* Parse generic string header. */
-static void parse_generic_string_hdr( pjsip_generic_string_hdr *hdr,
-				      pjsip_parse_ctx *ctx)
+/* Parse header value as string. */
+static void parse_hdr_string_value( pj_str_t *hvalue, pjsip_parse_ctx *ctx)
 {
     pj_scanner *scanner = ctx->scanner;
 
-    hdr->hvalue.slen = 0;
+    hvalue->slen = 0;
 
     /* header may be mangled hence the loop */
     while (pj_cis_match(&pconst.pjsip_NOT_NEWLINE, *scanner->curptr)) {
 	pj_str_t next, tmp;
 
-	pj_scan_get( scanner, &pconst.pjsip_NOT_NEWLINE, &hdr->hvalue);
+	pj_scan_get( scanner, &pconst.pjsip_NOT_NEWLINE, hvalue);
 	if (pj_scan_is_eof(scanner) || IS_NEWLINE(*scanner->curptr))
 	    break;
 	/* mangled, get next fraction */
 	pj_scan_get( scanner, &pconst.pjsip_NOT_NEWLINE, &next);
 	/* concatenate */
-	tmp.ptr = (char*)pj_pool_alloc(ctx->pool, 
-				       hdr->hvalue.slen + next.slen + 2);
+	tmp.ptr = (char*)pj_pool_alloc(ctx->pool,
+				       hvalue->slen + next.slen + 2);
 	tmp.slen = 0;
-	pj_strcpy(&tmp, &hdr->hvalue);
+	pj_strcpy(&tmp, hvalue);
 	pj_strcat2(&tmp, " ");
 	pj_strcat(&tmp, &next);
 	tmp.ptr[tmp.slen] = '\0';
 
-	hdr->hvalue = tmp;
+	*hvalue = tmp;
     }
 
     parse_hdr_end(scanner);
 }
 
+/* Parse generic string header. */
+static void parse_generic_string_hdr( pjsip_generic_string_hdr *hdr,
+				      pjsip_parse_ctx *ctx)
+{
+    parse_hdr_string_value(&hdr->hvalue, ctx);
+}
+
 /* Parse generic integer header. */
 static void parse_generic_int_hdr( pjsip_generic_int_hdr *hdr,
 				   pj_scanner *scanner )
@@ -2246,6 +2336,143 @@ static pjsip_hdr* parse_hdr_generic_string( pjsip_parse_ctx *ctx )
 
 }
 
+/*
+ * Unparsed header.
+ */
+static int lazy_hdr_print( pjsip_lazy_hdr *hdr, char *buf, pj_size_t size);
+static pjsip_lazy_hdr* lazy_hdr_clone( pj_pool_t *pool,
+				       const pjsip_lazy_hdr *rhs);
+static pjsip_lazy_hdr* lazy_hdr_shallow_clone( pj_pool_t *pool,
+					       const pjsip_lazy_hdr *rhs);
+
+static pjsip_hdr_vptr lazy_hdr_vptr =
+{
+    (pjsip_hdr_clone_fptr) &lazy_hdr_clone,
+    (pjsip_hdr_clone_fptr) &lazy_hdr_shallow_clone,
+    (pjsip_hdr_print_fptr) &lazy_hdr_print,
+};
+
+static int lazy_hdr_print( pjsip_lazy_hdr *hdr, char *buf, pj_size_t size)
+{
+    char *p = buf;
+    const pj_str_t *hname = pjsip_use_compact_form? &hdr->sname : &hdr->name;
+
+    if ((pj_ssize_t)size < hname->slen + hdr->hvalue.slen + 5)
+	return -1;
+
+    pj_memcpy(p, hname->ptr, hname->slen);
+    p += hname->slen;
+    *p++ = ':';
+    *p++ = ' ';
+    pj_memcpy(p, hdr->hvalue.ptr, hdr->hvalue.slen);
+    p += hdr->hvalue.slen;
+    *p = '\0';
+
+    return (int)(p - buf);
+}
+
+static pjsip_lazy_hdr* lazy_hdr_clone( pj_pool_t *pool,
+				       const pjsip_lazy_hdr *rhs)
+{
+    pjsip_lazy_hdr *hdr = PJ_POOL_ALLOC_T(pool, pjsip_lazy_hdr);
+
+    pj_memcpy(hdr, rhs, sizeof(*hdr));
+    pj_list_init(hdr);
+    pj_strdup(pool, &hdr->hvalue, &rhs->hvalue);
+    hdr->pool = pool;
+    return hdr;
+}
+
+static pjsip_lazy_hdr* lazy_hdr_shallow_clone( pj_pool_t *pool,
+					       const pjsip_lazy_hdr *rhs)
+{
+    pjsip_lazy_hdr *hdr = PJ_POOL_ALLOC_T(pool, pjsip_lazy_hdr);
+
+    pj_memcpy(hdr, rhs, sizeof(*hdr));
+    hdr->pool = pool;
+    return hdr;
+}
+
+/* Keep the header value to be parsed later. */
+static pjsip_hdr* parse_hdr_lazy( pjsip_parse_ctx *ctx,
+				  const lazy_hdr_rec *lazy)
+{
+    pjsip_lazy_hdr *hdr = PJ_POOL_ALLOC_T(ctx->pool, pjsip_lazy_hdr);
+
+    pj_list_init(hdr);
+    hdr->type = PJSIP_H_OTHER;
+    hdr->name = lazy->name;
+    hdr->sname = lazy->sname;
+    hdr->vptr = &lazy_hdr_vptr;
+    hdr->lazy_type = lazy->type;
+    hdr->parse = lazy->handler;
+    hdr->pool = ctx->pool;
+
+    parse_hdr_string_value(&hdr->hvalue, ctx);
+    return (pjsip_hdr*)hdr;
+}
+
+/* Check if the header is an unparsed header. */
+PJ_DEF(pj_bool_t) pjsip_hdr_is_lazy(const pjsip_hdr *hdr)
+{
+    return hdr->vptr == &lazy_hdr_vptr;
+}
+
+/* Parse an unparsed header, and replace it with the parsed header(s). */
+PJ_DEF(pjsip_hdr*) pjsip_parse_lazy_hdr(pjsip_hdr *hdr)
+{
+    pjsip_lazy_hdr *lhdr = (pjsip_lazy_hdr*)hdr;
+    pjsip_hdr *parsed = NULL;
+    pj_scanner scanner;
+    pjsip_parse_ctx context;
+    char *buf;
+    PJ_USE_EXCEPTION;
+
+    if (hdr->vptr != &lazy_hdr_vptr || lhdr->parse == NULL)
+	return hdr;
+
+    /* The value may point to the middle of the packet, so parse a copy
+     * which is NULL terminated as required by the scanner.
+     */
+    buf = (char*) pj_pool_alloc(lhdr->pool, lhdr->hvalue.slen + 1);
+    pj_memcpy(buf, lhdr->hvalue.ptr, lhdr->hvalue.slen);
+    buf[lhdr->hvalue.slen] = '\0';
+
+    pj_scan_init(&scanner, buf, lhdr->hvalue.slen,
+		 PJ_SCAN_AUTOSKIP_WS_HEADER, &on_syntax_error);
+
+    context.scanner = &scanner;
+    context.pool = lhdr->pool;
+    context.rdata = NULL;
+
+    PJ_TRY {
+	parsed = (*lhdr->parse)(&context);
+    }
+    PJ_CATCH_ANY {
+	parsed = NULL;
+    }
+    PJ_END
+
+    pj_scan_fini(&scanner);
+
+    if (parsed == NULL) {
+	/* Keep the header as generic string header. */
+	lhdr->parse = NULL;
+	lhdr->lazy_type = PJSIP_H_OTHER;
+	return hdr;
+    }
+
+    /* Replace the header in the list. */
+    if (hdr->next && hdr->next != hdr) {
+	pjsip_hdr *prev = hdr->prev;
+
+	pj_list_erase(hdr);
+	pj_list_insert_nodes_after(prev, parsed);
+    }
+
+    return parsed;
+}
+
 /* Public function to parse a header value. */
 PJ_DEF(void*) pjsip_parse_hdr( pj_pool_t *pool, const pj_str_t *hname,
 			       char *buf, pj_size_t size, int *parsed_len )
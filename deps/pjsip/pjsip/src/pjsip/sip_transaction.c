@@ -469,8 +469,11 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
     mod_tsx_layer.endpt = endpt;
 
 
-    /* Create hash table. */
-    mod_tsx_layer.htable = pj_hash_create( pool, pjsip_cfg()->tsx.max_count );
+    /* Create hash table. It's an open addressing table, which grows past
+     * max_count when there are more transactions.
+     */
+    mod_tsx_layer.htable = pj_hash_create2( pool, pjsip_cfg()->tsx.max_count,
+					    PJ_HASH_OPEN_ADDRESSING );
     if (!mod_tsx_layer.htable) {
 	pjsip_endpt_release_pool(endpt, pool);
 	return PJ_ENOMEM;
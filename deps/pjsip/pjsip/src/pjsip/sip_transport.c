@@ -54,6 +54,13 @@ static const char *addr_string(const pj_sockaddr_t *addr)
 #   define TRACE_(x)
 #endif
 
+/* Initial size of the buffer to print tdata. */
+#if PJSIP_TDATA_BUF_LEN < PJSIP_MAX_PKT_LEN
+#   define TDATA_BUF_LEN    PJSIP_TDATA_BUF_LEN
+#else
+#   define TDATA_BUF_LEN    PJSIP_MAX_PKT_LEN
+#endif
+
 /* Prototype. */
 static pj_status_t mod_on_tx_msg(pjsip_tx_data *tdata);
 
@@ -517,11 +524,11 @@ PJ_DEF(pj_status_t) pjsip_tx_data_encode(pjsip_tx_data *tdata)
 {
     /* Allocate buffer if necessary. */
     if (tdata->buf.start == NULL) {
+	pj_size_t buf_len = TDATA_BUF_LEN;
 	PJ_USE_EXCEPTION;
 
 	PJ_TRY {
-	    tdata->buf.start = (char*) 
-			       pj_pool_alloc(tdata->pool, PJSIP_MAX_PKT_LEN);
+	    tdata->buf.start = (char*) pj_pool_alloc(tdata->pool, buf_len);
 	}
 	PJ_CATCH_ANY {
 	    return PJ_ENOMEM;
@@ -529,21 +536,33 @@ PJ_DEF(pj_status_t) pjsip_tx_data_encode(pjsip_tx_data *tdata)
 	PJ_END
 
 	tdata->buf.cur = tdata->buf.start;
-	tdata->buf.end = tdata->buf.start + PJSIP_MAX_PKT_LEN;
+	tdata->buf.end = tdata->buf.start + buf_len;
     }
 
     /* Do we need to reprint? */
     if (!pjsip_tx_data_is_valid(tdata)) {
-	pj_ssize_t size;
+	char *buf = tdata->buf.start;
+	pj_size_t buf_len = tdata->buf.end - tdata->buf.start;
+	pj_ssize_t size = -1;
+	PJ_USE_EXCEPTION;
+
+	/* The buffer is grown as needed while the message is printed. */
+	PJ_TRY {
+	    size = pjsip_msg_print_alloc(tdata->msg, tdata->pool, &buf,
+					 &buf_len, PJSIP_MAX_PKT_LEN);
+	}
+	PJ_CATCH_ANY {
+	    return PJ_ENOMEM;
+	}
+	PJ_END
 
-	size = pjsip_msg_print( tdata->msg, tdata->buf.start, 
-			        tdata->buf.end - tdata->buf.start);
 	if (size < 0) {
 	    return PJSIP_EMSGTOOLONG;
 	}
 	pj_assert(size != 0);
-	tdata->buf.cur[size] = '\0';
-	tdata->buf.cur += size;
+	tdata->buf.start = buf;
+	tdata->buf.cur = buf + size;
+	tdata->buf.end = buf + buf_len;
     }
 
     return PJ_SUCCESS;
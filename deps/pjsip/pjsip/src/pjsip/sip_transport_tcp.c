@@ -732,7 +732,8 @@ static pj_status_t tcp_create( struct tcp_listener *listener,
     tcp_callback.on_data_sent = &on_data_sent;
     tcp_callback.on_connect_complete = &on_connect_complete;
 
-    ioqueue = pjsip_endpt_get_ioqueue(listener->endpt);
+    /* Spread the connections among the ioqueues of the endpoint */
+    ioqueue = pjsip_endpt_get_ioqueue_at(listener->endpt, (unsigned)sock);
     status = pj_activesock_create(pool, sock, pj_SOCK_STREAM(), &asock_cfg,
 				  ioqueue, &tcp_callback, tcp, &tcp->asock);
     if (status != PJ_SUCCESS) {
@@ -1038,7 +1038,9 @@ static pj_status_t lis_create_transport(pjsip_tpfactory *factory,
     ssock_param.cb.on_data_read = &on_data_read;
     ssock_param.cb.on_data_sent = &on_data_sent;
     ssock_param.async_cnt = 1;
-    ssock_param.ioqueue = pjsip_endpt_get_ioqueue(listener->endpt);
+    /* Spread the connections among the ioqueues of the endpoint */
+    ssock_param.ioqueue = pjsip_endpt_get_ioqueue_at(listener->endpt,
+			    pj_hash_calc(0, rem_addr, addr_len));
     ssock_param.server_name = remote_name;
     ssock_param.timeout = listener->tls_setting.timeout;
     ssock_param.user_data = NULL; /* pending, must be set later */
@@ -77,6 +77,16 @@ struct udp_transport
     int			is_closing;
     pj_bool_t		is_paused;
 
+    /* Additional sockets bound to the same address with SO_REUSEPORT,
+     * one in each additional ioqueue of the endpoint. Each socket has
+     * async_cnt rdata, the first ones being for the main socket.
+     */
+    unsigned		async_cnt;
+    unsigned		replica_max;
+    unsigned		replica_cnt;
+    pj_sock_t	       *replica_sock;
+    pj_ioqueue_key_t  **replica_key;
+
     /* Group lock to be used by UDP transport and ioqueue key */
     pj_grp_lock_t      *grp_lock;
 };
@@ -111,6 +121,20 @@ static void init_rdata(struct udp_transport *tp, unsigned rdata_index,
 }
 
 
+static void destroy_replicas(struct udp_transport *tp);
+
+/* Get the ioqueue key of the socket which the rdata belongs to. */
+static pj_ioqueue_key_t *rdata_key(struct udp_transport *tp, unsigned index)
+{
+    unsigned sock_idx = index / tp->async_cnt;
+
+    if (sock_idx == 0)
+	return tp->key;
+
+    return (sock_idx <= tp->replica_cnt) ? tp->replica_key[sock_idx-1] : NULL;
+}
+
+
 /*
  * udp_on_read_complete()
  *
@@ -401,6 +425,9 @@ static pj_status_t udp_destroy( pjsip_transport *transport )
     }
     */
 
+    /* Close the additional sockets. */
+    destroy_replicas(tp);
+
     /* Unregister from ioqueue. */
     if (tp->key) {
 	pj_ioqueue_unregister(tp->key);
@@ -453,7 +480,8 @@ static pj_status_t udp_shutdown(pjsip_transport *transport)
 
 /* Create socket */
 static pj_status_t create_socket(int af, const pj_sockaddr_t *local_a,
-				 int addr_len, pj_sock_t *p_sock)
+				 int addr_len, pj_bool_t reuse_port,
+				 pj_sock_t *p_sock)
 {
     pj_sock_t sock;
     pj_sockaddr_in tmp_addr;
@@ -477,6 +505,18 @@ static pj_status_t create_socket(int af, const pj_sockaddr_t *local_a,
 	}
     }
 
+    /* Allow other sockets to be bound to the same address, so that the
+     * kernel distributes incoming packets among them.
+     */
+    if (reuse_port) {
+	int enabled = 1;
+	status = pj_sock_setsockopt(sock, pj_SOL_SOCKET(), pj_SO_REUSEPORT(),
+				    &enabled, sizeof(enabled));
+	if (status != PJ_SUCCESS) {
+	    PJ_PERROR(4,(THIS_FILE, status, "Error setting SO_REUSEPORT"));
+	}
+    }
+
     status = pj_sock_bind(sock, local_a, addr_len);
     if (status != PJ_SUCCESS) {
 	pj_sock_close(sock);
@@ -577,10 +617,8 @@ static void udp_set_pub_name(struct udp_transport *tp,
 	tp->base.local_name.port);
 }
 
-/* Set the socket handle of the transport */
-static void udp_set_socket(struct udp_transport *tp,
-			   pj_sock_t sock,
-			   const pjsip_host_port *a_name)
+/* Adjust the socket buffer sizes */
+static void udp_set_sobuf_size(pj_sock_t sock)
 {
 #if PJSIP_UDP_SO_RCVBUF_SIZE || PJSIP_UDP_SO_SNDBUF_SIZE
     long sobuf_size;
@@ -612,6 +650,15 @@ static void udp_set_socket(struct udp_transport *tp,
 		  status));
     }
 #endif
+    PJ_UNUSED_ARG(sock);
+}
+
+/* Set the socket handle of the transport */
+static void udp_set_socket(struct udp_transport *tp,
+			   pj_sock_t sock,
+			   const pjsip_host_port *a_name)
+{
+    udp_set_sobuf_size(sock);
 
     /* Set the socket. */
     tp->sock = sock;
@@ -649,6 +696,64 @@ static pj_status_t register_to_ioqueue(struct udp_transport *tp)
 				     tp->grp_lock, tp, &ioqueue_cb, &tp->key);
 }
 
+/* Open the additional sockets on the bound address of the main socket,
+ * and register each of them to its own ioqueue. Failure is not fatal,
+ * the transport then just runs with fewer sockets.
+ */
+static void create_replicas(struct udp_transport *tp)
+{
+    pj_ioqueue_callback ioqueue_cb;
+    unsigned i;
+
+    pj_memset(&ioqueue_cb, 0, sizeof(ioqueue_cb));
+    ioqueue_cb.on_read_complete = &udp_on_read_complete;
+
+    for (i=tp->replica_cnt; i<tp->replica_max; ++i) {
+	pj_ioqueue_t *ioqueue;
+	pj_sock_t sock;
+	pj_status_t status;
+
+	status = create_socket(tp->base.local_addr.addr.sa_family,
+			       &tp->base.local_addr, tp->base.addr_len,
+			       PJ_TRUE, &sock);
+	if (status != PJ_SUCCESS) {
+	    PJ_PERROR(3,(tp->base.obj_name, status,
+			 "Unable to create additional socket"));
+	    break;
+	}
+
+	udp_set_sobuf_size(sock);
+
+	ioqueue = pjsip_endpt_get_ioqueue_at(tp->base.endpt, i+1);
+	status = pj_ioqueue_register_sock2(tp->base.pool, ioqueue, sock,
+					   tp->grp_lock, tp, &ioqueue_cb,
+					   &tp->replica_key[i]);
+	if (status != PJ_SUCCESS) {
+	    PJ_PERROR(3,(tp->base.obj_name, status,
+			 "Unable to register additional socket"));
+	    pj_sock_close(sock);
+	    break;
+	}
+
+	tp->replica_sock[i] = sock;
+	tp->replica_cnt = i + 1;
+    }
+}
+
+/* Close the additional sockets */
+static void destroy_replicas(struct udp_transport *tp)
+{
+    unsigned i;
+
+    for (i=0; i<tp->replica_cnt; ++i) {
+	/* This implicitly closes the socket */
+	pj_ioqueue_unregister(tp->replica_key[i]);
+	tp->replica_key[i] = NULL;
+	tp->replica_sock[i] = PJ_INVALID_SOCKET;
+    }
+    tp->replica_cnt = 0;
+}
+
 /* Start ioqueue asynchronous reading to all rdata */
 static pj_status_t start_async_read(struct udp_transport *tp)
 {
@@ -657,11 +762,16 @@ static pj_status_t start_async_read(struct udp_transport *tp)
 
     /* Start reading the ioqueue. */
     for (i=0; i<tp->rdata_cnt; ++i) {
+	pj_ioqueue_key_t *key = rdata_key(tp, i);
 	pj_ssize_t size;
 
+	/* Skip the rdata of additional sockets which are not open */
+	if (key == NULL)
+	    continue;
+
 	size = sizeof(tp->rdata[i]->pkt_info.packet);
 	tp->rdata[i]->pkt_info.src_addr_len = sizeof(tp->rdata[i]->pkt_info.src_addr);
-	status = pj_ioqueue_recvfrom(tp->key, 
+	status = pj_ioqueue_recvfrom(key, 
 				     &tp->rdata[i]->tp_info.op_key.op_key,
 				     tp->rdata[i]->pkt_info.packet,
 				     &size, PJ_IOQUEUE_ALWAYS_ASYNC,
@@ -669,7 +779,7 @@ static pj_status_t start_async_read(struct udp_transport *tp)
 				     &tp->rdata[i]->pkt_info.src_addr_len);
 	if (status == PJ_SUCCESS) {
 	    pj_assert(!"Shouldn't happen because PJ_IOQUEUE_ALWAYS_ASYNC!");
-	    udp_on_read_complete(tp->key, &tp->rdata[i]->tp_info.op_key.op_key,
+	    udp_on_read_complete(key, &tp->rdata[i]->tp_info.op_key.op_key,
 				 size);
 	} else if (status != PJ_EPENDING) {
 	    /* Error! */
@@ -691,6 +801,7 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
 				     pj_sock_t sock,
 				     const pjsip_host_port *a_name,
 				     unsigned async_cnt,
+				     unsigned replica_cnt,
 				     pjsip_transport **p_transport)
 {
     pj_pool_t *pool;
@@ -783,6 +894,17 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
     if (status != PJ_SUCCESS)
 	goto on_error;
 
+    /* Open the additional sockets */
+    if (replica_cnt) {
+	tp->replica_max = replica_cnt;
+	tp->replica_sock = (pj_sock_t*)
+			   pj_pool_calloc(pool, replica_cnt, sizeof(pj_sock_t));
+	tp->replica_key = (pj_ioqueue_key_t**)
+			  pj_pool_calloc(pool, replica_cnt,
+					 sizeof(pj_ioqueue_key_t*));
+	create_replicas(tp);
+    }
+
     /* Set functions. */
     tp->base.send_msg = &udp_send_msg;
     tp->base.do_shutdown = &udp_shutdown;
@@ -802,11 +924,12 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
 
 
     /* Create rdata and put it in the array. */
+    tp->async_cnt = async_cnt;
     tp->rdata_cnt = 0;
     tp->rdata = (pjsip_rx_data**)
-    		pj_pool_calloc(tp->base.pool, async_cnt, 
+    		pj_pool_calloc(tp->base.pool, async_cnt * (1 + replica_cnt),
 			       sizeof(pjsip_rx_data*));
-    for (i=0; i<async_cnt; ++i) {
+    for (i=0; i<async_cnt * (1 + replica_cnt); ++i) {
 	pj_pool_t *rdata_pool = pjsip_endpt_create_pool(endpt, "rtd%p", 
 							PJSIP_POOL_RDATA_LEN,
 							PJSIP_POOL_RDATA_INC);
@@ -855,7 +978,7 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach( pjsip_endpoint *endpt,
 						pjsip_transport **p_transport)
 {
     return transport_attach(endpt, PJSIP_TRANSPORT_UDP, sock, a_name,
-			    async_cnt, p_transport);
+			    async_cnt, 0, p_transport);
 }
 
 PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
@@ -866,7 +989,7 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
 						 pjsip_transport **p_transport)
 {
     return transport_attach(endpt, type, sock, a_name,
-			    async_cnt, p_transport);
+			    async_cnt, 0, p_transport);
 }
 
 /*
@@ -884,11 +1007,15 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start( pjsip_endpoint *endpt,
     pj_status_t status;
     char addr_buf[PJ_INET6_ADDRSTRLEN];
     pjsip_host_port bound_name;
+    unsigned replica_cnt;
 
     PJ_ASSERT_RETURN(endpt && async_cnt, PJ_EINVAL);
 
+    /* One socket per ioqueue of the endpoint */
+    replica_cnt = pjsip_endpt_get_ioqueue_count(endpt) - 1;
+
     status = create_socket(pj_AF_INET(), local_a, sizeof(pj_sockaddr_in), 
-			   &sock);
+			   replica_cnt > 0, &sock);
     if (status != PJ_SUCCESS)
 	return status;
 
@@ -906,8 +1033,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start( pjsip_endpoint *endpt,
 	a_name = &bound_name;
     }
 
-    return pjsip_udp_transport_attach( endpt, sock, a_name, async_cnt, 
-				       p_transport );
+    return transport_attach(endpt, PJSIP_TRANSPORT_UDP, sock, a_name,
+			    async_cnt, replica_cnt, p_transport);
 }
 
 
@@ -926,11 +1053,15 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start6(pjsip_endpoint *endpt,
     pj_status_t status;
     char addr_buf[PJ_INET6_ADDRSTRLEN];
     pjsip_host_port bound_name;
+    unsigned replica_cnt;
 
     PJ_ASSERT_RETURN(endpt && async_cnt, PJ_EINVAL);
 
+    /* One socket per ioqueue of the endpoint */
+    replica_cnt = pjsip_endpt_get_ioqueue_count(endpt) - 1;
+
     status = create_socket(pj_AF_INET6(), local_a, sizeof(pj_sockaddr_in6), 
-			   &sock);
+			   replica_cnt > 0, &sock);
     if (status != PJ_SUCCESS)
 	return status;
 
@@ -948,8 +1079,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start6(pjsip_endpoint *endpt,
 	a_name = &bound_name;
     }
 
-    return pjsip_udp_transport_attach2(endpt, PJSIP_TRANSPORT_UDP6,
-				       sock, a_name, async_cnt, p_transport);
+    return transport_attach(endpt, PJSIP_TRANSPORT_UDP6, sock, a_name,
+			    async_cnt, replica_cnt, p_transport);
 }
 
 /*
@@ -994,12 +1125,19 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_pause(pjsip_transport *transport,
 
     /* Cancel the ioqueue operation. */
     for (i=0; i<(unsigned)tp->rdata_cnt; ++i) {
-	pj_ioqueue_post_completion(tp->key, 
-				   &tp->rdata[i]->tp_info.op_key.op_key, -1);
+	pj_ioqueue_key_t *key = rdata_key(tp, i);
+
+	if (key) {
+	    pj_ioqueue_post_completion(key,
+				       &tp->rdata[i]->tp_info.op_key.op_key,
+				       -1);
+	}
     }
 
     /* Destroy the socket? */
     if (option & PJSIP_UDP_TRANSPORT_DESTROY_SOCKET) {
+	destroy_replicas(tp);
+
 	if (tp->key) {
 	    /* This implicitly closes the socket */
 	    pj_ioqueue_unregister(tp->key);
@@ -1051,7 +1189,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_restart(pjsip_transport *transport,
 
 	/* Request to recreate transport */
 
-	/* Destroy existing socket, if any. */
+	/* Destroy existing sockets, if any. */
+	destroy_replicas(tp);
 	if (tp->key) {
 	    /* This implicitly closes the socket */
 	    pj_ioqueue_unregister(tp->key);
@@ -1068,7 +1207,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_restart(pjsip_transport *transport,
 	/* Create the socket if it's not specified */
 	if (sock == PJ_INVALID_SOCKET) {
 	    status = create_socket(pj_AF_INET(), local, 
-				   sizeof(pj_sockaddr_in), &sock);
+				   sizeof(pj_sockaddr_in),
+				   tp->replica_max > 0, &sock);
 	    if (status != PJ_SUCCESS)
 		return status;
 	}
@@ -1114,6 +1254,9 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_restart(pjsip_transport *transport,
 	return status;
     }
 
+    /* Reopen the additional sockets */
+    create_replicas(tp);
+
     /* Restart async read operation. */
     status = start_async_read(tp);
     if (status != PJ_SUCCESS)
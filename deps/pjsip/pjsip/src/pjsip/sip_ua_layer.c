@@ -70,6 +70,19 @@ struct dlg_set
 };
 
 
+/* A shard of the dialog table. Dialog sets are assigned to the shards by
+ * the hash value of their local tag, and the mutex of the shard protects
+ * its hash table, its free nodes, and the dialog lists of its dialog sets.
+ */
+struct dlg_shard
+{
+    pj_pool_t		*pool;
+    pj_mutex_t		*mutex;
+    pj_hash_table_t	*dlg_table;
+    struct dlg_set	 free_dlgset_nodes;
+};
+
+
 /*
  * Module interface.
  */
@@ -78,10 +91,8 @@ static struct user_agent
     pjsip_module	 mod;
     pj_pool_t		*pool;
     pjsip_endpoint	*endpt;
-    pj_mutex_t		*mutex;
-    pj_hash_table_t	*dlg_table;
+    struct dlg_shard	 shard[PJSIP_UA_DLG_TABLE_SHARDS];
     pjsip_ua_init_param  param;
-    struct dlg_set	 free_dlgset_nodes;
 
 } mod_ua = 
 {
@@ -109,6 +120,7 @@ static struct user_agent
  */
 static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
 {
+    unsigned i;
     pj_status_t status;
 
     /* Initialize the user agent. */
@@ -118,15 +130,34 @@ static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
     if (mod_ua.pool == NULL)
 	return PJ_ENOMEM;
 
-    status = pj_mutex_create_recursive(mod_ua.pool, " ua%p", &mod_ua.mutex);
-    if (status != PJ_SUCCESS)
-	return status;
-
-    mod_ua.dlg_table = pj_hash_create(mod_ua.pool, PJSIP_MAX_DIALOG_COUNT);
-    if (mod_ua.dlg_table == NULL)
-	return PJ_ENOMEM;
+    /* Each shard has its own pool, since the shards allocate dialog set
+     * nodes under their own mutex only.
+     */
+    for (i = 0; i < PJ_ARRAY_SIZE(mod_ua.shard); ++i) {
+	struct dlg_shard *shard = &mod_ua.shard[i];
+
+	shard->pool = pjsip_endpt_create_pool( endpt, "uash%p",
+					       PJSIP_POOL_LEN_UA,
+					       PJSIP_POOL_INC_UA);
+	if (shard->pool == NULL)
+	    return PJ_ENOMEM;
+
+	status = pj_mutex_create_recursive(shard->pool, " ua%p",
+					   &shard->mutex);
+	if (status != PJ_SUCCESS)
+	    return status;
+
+	/* Chained table: the entries live in the dialog set nodes, so
+	 * registering and unregistering dialogs never allocates.
+	 */
+	shard->dlg_table = pj_hash_create(shard->pool,
+					  PJSIP_MAX_DIALOG_COUNT /
+					      PJSIP_UA_DLG_TABLE_SHARDS);
+	if (shard->dlg_table == NULL)
+	    return PJ_ENOMEM;
 
-    pj_list_init(&mod_ua.free_dlgset_nodes);
+	pj_list_init(&shard->free_dlgset_nodes);
+    }
 
     /* Initialize dialog lock. */
     status = pj_thread_local_alloc(&pjsip_dlg_lock_tls_id);
@@ -146,8 +177,22 @@ static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
  */
 static pj_status_t mod_ua_unload(void)
 {
+    unsigned i;
+
     pj_thread_local_free(pjsip_dlg_lock_tls_id);
-    pj_mutex_destroy(mod_ua.mutex);
+
+    for (i = 0; i < PJ_ARRAY_SIZE(mod_ua.shard); ++i) {
+	struct dlg_shard *shard = &mod_ua.shard[i];
+
+	if (shard->mutex) {
+	    pj_mutex_destroy(shard->mutex);
+	    shard->mutex = NULL;
+	}
+	if (shard->pool) {
+	    pjsip_endpt_release_pool( mod_ua.endpt, shard->pool );
+	    shard->pool = NULL;
+	}
+    }
 
     /* Release pool */
     if (mod_ua.pool) {
@@ -256,21 +301,41 @@ PJ_DEF(void) pjsip_ua_create_dlg_set_key( pj_pool_t *pool,
 }
 */
 
+/*
+ * Get the shard of the dialog table for the hash value of a local tag.
+ */
+static struct dlg_shard *get_shard(pj_uint32_t tag_hval)
+{
+    return &mod_ua.shard[(tag_hval ^ (tag_hval >> 16)) %
+			 PJSIP_UA_DLG_TABLE_SHARDS];
+}
+
+/*
+ * Get the shard for a local tag, and calculate the hash value of the tag
+ * for the lookup in the shard.
+ */
+static struct dlg_shard *get_shard_by_tag(const pj_str_t *tag,
+					  pj_uint32_t *p_hval)
+{
+    *p_hval = pj_hash_calc_tolower(0, NULL, tag);
+    return get_shard(*p_hval);
+}
+
 /*
  * Acquire one dlg_set node to be put in the hash table.
  * This will first look in the free nodes list, then allocate
- * a new one from UA's pool when one is not available.
+ * a new one from the shard's pool when one is not available.
  */
-static struct dlg_set *alloc_dlgset_node(void)
+static struct dlg_set *alloc_dlgset_node(struct dlg_shard *shard)
 {
     struct dlg_set *set;
 
-    if (!pj_list_empty(&mod_ua.free_dlgset_nodes)) {
-	set = mod_ua.free_dlgset_nodes.next;
+    if (!pj_list_empty(&shard->free_dlgset_nodes)) {
+	set = shard->free_dlgset_nodes.next;
 	pj_list_erase(set);
 	return set;
     } else {
-	set = PJ_POOL_ALLOC_T(mod_ua.pool, struct dlg_set);
+	set = PJ_POOL_ALLOC_T(shard->pool, struct dlg_set);
 	return set;
     }
 }
@@ -282,6 +347,8 @@ static struct dlg_set *alloc_dlgset_node(void)
 PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
 					   pjsip_dialog *dlg )
 {
+    struct dlg_shard *shard;
+
     /* Sanity check. */
     PJ_ASSERT_RETURN(ua && dlg, PJ_EINVAL);
 
@@ -294,15 +361,16 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
     //		     (dlg->role==PJSIP_ROLE_UAS && dlg->remote.info->tag.slen
     //		      && dlg->remote.tag_hval != 0), PJ_EBUG);
 
-    /* Lock the user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    /* Lock the shard of the dialog set. */
+    shard = get_shard(dlg->local.tag_hval);
+    pj_mutex_lock(shard->mutex);
 
     /* For UAC, check if there is existing dialog in the same set. */
     if (dlg->role == PJSIP_ROLE_UAC) {
 	struct dlg_set *dlg_set;
 
 	dlg_set = (struct dlg_set*)
-		  pj_hash_get_lower( mod_ua.dlg_table,
+		  pj_hash_get_lower( shard->dlg_table,
                                      dlg->local.info->tag.ptr, 
 			             (unsigned)dlg->local.info->tag.slen,
 			             &dlg->local.tag_hval);
@@ -320,14 +388,14 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
 	    /* This is the first dialog in the dialog set. 
 	     * Create the dialog set and add this dialog to it.
 	     */
-	    dlg_set = alloc_dlgset_node();
+	    dlg_set = alloc_dlgset_node(shard);
 	    pj_list_init(&dlg_set->dlg_list);
 	    pj_list_push_back(&dlg_set->dlg_list, dlg);
 
 	    dlg->dlg_set = dlg_set;
 
 	    /* Register the dialog set in the hash table. */
-	    pj_hash_set_np_lower(mod_ua.dlg_table, 
+	    pj_hash_set_np_lower(shard->dlg_table, 
 			         dlg->local.info->tag.ptr,
                                  (unsigned)dlg->local.info->tag.slen,
 			         dlg->local.tag_hval, dlg_set->ht_entry,
@@ -338,20 +406,20 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
 	/* For UAS, create the dialog set with a single dialog as member. */
 	struct dlg_set *dlg_set;
 
-	dlg_set = alloc_dlgset_node();
+	dlg_set = alloc_dlgset_node(shard);
 	pj_list_init(&dlg_set->dlg_list);
 	pj_list_push_back(&dlg_set->dlg_list, dlg);
 
 	dlg->dlg_set = dlg_set;
 
-	pj_hash_set_np_lower(mod_ua.dlg_table, 
+	pj_hash_set_np_lower(shard->dlg_table, 
 		             dlg->local.info->tag.ptr,
                              (unsigned)dlg->local.info->tag.slen,
 		             dlg->local.tag_hval, dlg_set->ht_entry, dlg_set);
     }
 
-    /* Unlock user agent. */
-    pj_mutex_unlock(mod_ua.mutex);
+    /* Unlock the shard. */
+    pj_mutex_unlock(shard->mutex);
 
     /* Done. */
     return PJ_SUCCESS;
@@ -361,6 +429,7 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
 PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
 					     pjsip_dialog *dlg )
 {
+    struct dlg_shard *shard;
     struct dlg_set *dlg_set;
     pjsip_dialog *d;
 
@@ -370,8 +439,9 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
     /* Check that dialog has been registered. */
     PJ_ASSERT_RETURN(dlg->dlg_set, PJ_EINVALIDOP);
 
-    /* Lock user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    /* Lock the shard of the dialog set. */
+    shard = get_shard(dlg->local.tag_hval);
+    pj_mutex_lock(shard->mutex);
 
     /* Find this dialog from the dialog set. */
     dlg_set = (struct dlg_set*) dlg->dlg_set;
@@ -382,7 +452,7 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
 
     if (d != dlg) {
 	pj_assert(!"Dialog is not registered!");
-	pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
 	return PJ_EINVALIDOP;
     }
 
@@ -391,16 +461,16 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
 
     /* If dialog list is empty, remove the dialog set from the hash table. */
     if (pj_list_empty(&dlg_set->dlg_list)) {
-	pj_hash_set_lower(NULL, mod_ua.dlg_table, dlg->local.info->tag.ptr,
+	pj_hash_set_lower(NULL, shard->dlg_table, dlg->local.info->tag.ptr,
 		          (unsigned)dlg->local.info->tag.slen, 
 			  dlg->local.tag_hval, NULL);
 
 	/* Return dlg_set to free nodes. */
-	pj_list_push_back(&mod_ua.free_dlgset_nodes, dlg_set);
+	pj_list_push_back(&shard->free_dlgset_nodes, dlg_set);
     }
 
-    /* Unlock user agent. */
-    pj_mutex_unlock(mod_ua.mutex);
+    /* Unlock the shard. */
+    pj_mutex_unlock(shard->mutex);
 
     /* Done. */
     return PJ_SUCCESS;
@@ -424,13 +494,15 @@ PJ_DEF(pjsip_dialog*) pjsip_tsx_get_dlg( pjsip_transaction *tsx )
  */
 PJ_DEF(unsigned) pjsip_ua_get_dlg_set_count(void)
 {
-    unsigned count;
+    unsigned i, count = 0;
 
     PJ_ASSERT_RETURN(mod_ua.endpt, 0);
 
-    pj_mutex_lock(mod_ua.mutex);
-    count = pj_hash_count(mod_ua.dlg_table);
-    pj_mutex_unlock(mod_ua.mutex);
+    for (i = 0; i < PJ_ARRAY_SIZE(mod_ua.shard); ++i) {
+	pj_mutex_lock(mod_ua.shard[i].mutex);
+	count += pj_hash_count(mod_ua.shard[i].dlg_table);
+	pj_mutex_unlock(mod_ua.shard[i].mutex);
+    }
 
     return count;
 }
@@ -444,21 +516,24 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 					   const pj_str_t *remote_tag,
 					   pj_bool_t lock_dialog)
 {
+    struct dlg_shard *shard;
     struct dlg_set *dlg_set;
     pjsip_dialog *dlg;
+    pj_uint32_t hval;
 
     PJ_ASSERT_RETURN(call_id && local_tag && remote_tag, NULL);
 
-    /* Lock user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    /* Lock the shard of the dialog set. */
+    shard = get_shard_by_tag(local_tag, &hval);
+    pj_mutex_lock(shard->mutex);
 
     /* Lookup the dialog set. */
     dlg_set = (struct dlg_set*)
-    	      pj_hash_get_lower(mod_ua.dlg_table, local_tag->ptr,
-                                (unsigned)local_tag->slen, NULL);
+    	      pj_hash_get_lower(shard->dlg_table, local_tag->ptr,
+                                (unsigned)local_tag->slen, &hval);
     if (dlg_set == NULL) {
 	/* Not found */
-	pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
 	return NULL;
     }
 
@@ -474,7 +549,7 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 
     if (dlg == (pjsip_dialog*)&dlg_set->dlg_list) {
 	/* Not found */
-	pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
 	return NULL;
     }
 
@@ -484,7 +559,7 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 	PJ_LOG(6, (THIS_FILE, "Dialog not found: local and remote tags "
 		              "matched but not call id"));
 
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(shard->mutex);
         return NULL;
     }
 
@@ -499,19 +574,19 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 	     * THIS MAY CAUSE RACE CONDITION!
 	     */
 
-	    /* Unlock user agent. */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    /* Unlock the shard. */
+	    pj_mutex_unlock(shard->mutex);
 	    /* Lock dialog */
 	    pjsip_dlg_inc_lock(dlg);
 
 	} else {
-	    /* Unlock user agent. */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    /* Unlock the shard. */
+	    pj_mutex_unlock(shard->mutex);
 	}
 
     } else {
-	/* Unlock user agent. */
-	pj_mutex_unlock(mod_ua.mutex);
+	/* Unlock the shard. */
+	pj_mutex_unlock(shard->mutex);
     }
 
     return dlg;
@@ -520,8 +595,10 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 
 /*
  * Find the first dialog in dialog set in hash table for an incoming message.
+ * When the dialog set is found, its shard is returned locked in p_shard.
  */
-static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
+static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata,
+					     struct dlg_shard **p_shard )
 {
     /* CANCEL message doesn't have To tag, so we must lookup the dialog
      * by finding the INVITE UAS transaction being cancelled.
@@ -551,6 +628,12 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
 	/* We should find the dialog attached to the INVITE transaction */
 	if (tsx) {
 	    dlg = (pjsip_dialog*) tsx->mod_data[mod_ua.mod.id];
+
+	    /* Lock the shard while the transaction still holds the dialog */
+	    if (dlg) {
+		*p_shard = get_shard(dlg->local.tag_hval);
+		pj_mutex_lock((*p_shard)->mutex);
+	    }
 	    pj_grp_lock_release(tsx->grp_lock);
 
 	    /* Dlg may be NULL on some extreme condition
@@ -565,7 +648,9 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
 
     } else {
 	pj_str_t *tag;
+	struct dlg_shard *shard;
 	struct dlg_set *dlg_set;
+	pj_uint32_t hval;
 
 	if (rdata->msg_info.msg->type == PJSIP_REQUEST_MSG)
 	    tag = &rdata->msg_info.to->tag;
@@ -573,9 +658,18 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
 	    tag = &rdata->msg_info.from->tag;
 
 	/* Lookup the dialog set. */
+	shard = get_shard_by_tag(tag, &hval);
+	pj_mutex_lock(shard->mutex);
+
 	dlg_set = (struct dlg_set*)
-		  pj_hash_get_lower(mod_ua.dlg_table, tag->ptr, 
-				    (unsigned)tag->slen, NULL);
+		  pj_hash_get_lower(shard->dlg_table, tag->ptr, 
+				    (unsigned)tag->slen, &hval);
+	if (dlg_set == NULL) {
+	    pj_mutex_unlock(shard->mutex);
+	    return NULL;
+	}
+
+	*p_shard = shard;
 	return dlg_set;
     }
 }
@@ -583,6 +677,7 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
 /* On received requests. */
 static pj_bool_t mod_ua_on_rx_request(pjsip_rx_data *rdata)
 {
+    struct dlg_shard *shard = NULL;
     struct dlg_set *dlg_set;
     pj_str_t *from_tag;
     pjsip_dialog *dlg;
@@ -603,19 +698,16 @@ static pj_bool_t mod_ua_on_rx_request(pjsip_rx_data *rdata)
 
 retry_on_deadlock:
 
-    /* Lock user agent before looking up the dialog hash table. */
-    pj_mutex_lock(mod_ua.mutex);
-
-    /* Lookup the dialog set, based on the To tag header. */
-    dlg_set = find_dlg_set_for_msg(rdata);
+    /* Lookup the dialog set, based on the To tag header. This locks the
+     * shard of the dialog set.
+     */
+    dlg_set = find_dlg_set_for_msg(rdata, &shard);
 
     /* If dialog is not found, respond with 481 (Call/Transaction
      * Does Not Exist).
      */
     if (dlg_set == NULL) {
 	/* Unable to find dialog. */
-	pj_mutex_unlock(mod_ua.mutex);
-
 	if (rdata->msg_info.msg->line.req.method.id != PJSIP_ACK_METHOD) {
 	    PJ_LOG(5,(THIS_FILE, 
 		      "Unable to find dialogset for %s, answering with 481",
@@ -655,7 +747,7 @@ retry_on_deadlock:
 
 	if (first_dlg->remote.info->tag.slen != 0) {
 	    /* Not found. Mulfunction UAC? */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    pj_mutex_unlock(shard->mutex);
 
 	    if (rdata->msg_info.msg->line.req.method.id != PJSIP_ACK_METHOD) {
 		PJ_LOG(5,(THIS_FILE, 
@@ -687,13 +779,13 @@ retry_on_deadlock:
 	 * because of deadlock. Release UA mutex, yield, and retry 
 	 * the whole thing once again.
 	 */
-	pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
 	pj_thread_sleep(0);
 	goto retry_on_deadlock;
     }
 
     /* Done with processing in UA layer, release lock */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(shard->mutex);
 
     /* Pass to dialog. */
     pjsip_dlg_on_rx_request(dlg, rdata);
@@ -711,8 +803,10 @@ retry_on_deadlock:
 static pj_bool_t mod_ua_on_rx_response(pjsip_rx_data *rdata)
 {
     pjsip_transaction *tsx;
+    struct dlg_shard *shard;
     struct dlg_set *dlg_set;
     pjsip_dialog *dlg;
+    pj_uint32_t hval;
     pj_status_t status;
 
     /*
@@ -729,8 +823,11 @@ retry_on_deadlock:
 
     dlg = NULL;
 
-    /* Lock user agent dlg table before we're doing anything. */
-    pj_mutex_lock(mod_ua.mutex);
+    /* Lock the dlg table shard before we're doing anything. The local tag
+     * of the dialog is the From tag of the response.
+     */
+    shard = get_shard_by_tag(&rdata->msg_info.from->tag, &hval);
+    pj_mutex_lock(shard->mutex);
 
     /* Check if transaction is present. */
     tsx = pjsip_rdata_get_tsx(rdata);
@@ -739,10 +836,17 @@ retry_on_deadlock:
 	dlg = pjsip_tsx_get_dlg(tsx);
 	if (!dlg) {
 	    /* Unlock dialog hash table. */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    pj_mutex_unlock(shard->mutex);
 	    return PJ_FALSE;
 	}
 
+	/* The From tag may have been altered by the remote party */
+	if (get_shard(dlg->local.tag_hval) != shard) {
+	    pj_mutex_unlock(shard->mutex);
+	    shard = get_shard(dlg->local.tag_hval);
+	    pj_mutex_lock(shard->mutex);
+	}
+
 	/* Get the dialog set. */
 	dlg_set = (struct dlg_set*) dlg->dlg_set;
 
@@ -766,21 +870,21 @@ retry_on_deadlock:
 	     * or a very late response.
 	     */
 	    /* Unlock dialog hash table. */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    pj_mutex_unlock(shard->mutex);
 	    return PJ_FALSE;
 	}
 
 
 	/* Get the dialog set. */
 	dlg_set = (struct dlg_set*)
-		  pj_hash_get_lower(mod_ua.dlg_table, 
+		  pj_hash_get_lower(shard->dlg_table, 
 			            rdata->msg_info.from->tag.ptr,
 			            (unsigned)rdata->msg_info.from->tag.slen,
-			            NULL);
+			            &hval);
 
 	if (!dlg_set) {
 	    /* Unlock dialog hash table. */
-	    pj_mutex_unlock(mod_ua.mutex);
+	    pj_mutex_unlock(shard->mutex);
 
 	    /* Strayed 2xx response!! */
 	    PJ_LOG(4,(THIS_FILE, 
@@ -850,7 +954,7 @@ retry_on_deadlock:
 		dlg = (*mod_ua.param.on_dlg_forked)(dlg_set->dlg_list.next, 
 						    rdata);
 		if (dlg == NULL) {
-		    pj_mutex_unlock(mod_ua.mutex);
+		    pj_mutex_unlock(shard->mutex);
 		    return PJ_TRUE;
 		}
 	    } else {
@@ -896,13 +1000,13 @@ retry_on_deadlock:
 	 * situation, and for safety, try to avoid deadlock by releasing
 	 * UA mutex, yield, and retry the whole processing once again.
 	 */
-	pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
 	pj_thread_sleep(0);
 	goto retry_on_deadlock;
     }
 
     /* We're done with processing in the UA layer, we can release the mutex */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(shard->mutex);
 
     /* Pass the response to the dialog. */
     pjsip_dlg_on_rx_response(dlg, rdata);
@@ -948,21 +1052,28 @@ PJ_DEF(void) pjsip_ua_dump(pj_bool_t detail)
 #if PJ_LOG_MAX_LEVEL >= 3
     pj_hash_iterator_t itbuf, *it;
     char dlginfo[128];
-
-    pj_mutex_lock(mod_ua.mutex);
+    unsigned i;
 
     PJ_LOG(3, (THIS_FILE, "Number of dialog sets: %u", 
-			  pj_hash_count(mod_ua.dlg_table)));
+			  pjsip_ua_get_dlg_set_count()));
 
-    if (detail && pj_hash_count(mod_ua.dlg_table)) {
-	PJ_LOG(3, (THIS_FILE, "Dumping dialog sets:"));
-	it = pj_hash_first(mod_ua.dlg_table, &itbuf);
-	for (; it != NULL; it = pj_hash_next(mod_ua.dlg_table, it))  {
+    if (!detail)
+	return;
+
+    PJ_LOG(3, (THIS_FILE, "Dumping dialog sets:"));
+
+    for (i = 0; i < PJ_ARRAY_SIZE(mod_ua.shard); ++i) {
+	struct dlg_shard *shard = &mod_ua.shard[i];
+
+	pj_mutex_lock(shard->mutex);
+
+	it = pj_hash_first(shard->dlg_table, &itbuf);
+	for (; it != NULL; it = pj_hash_next(shard->dlg_table, it))  {
 	    struct dlg_set *dlg_set;
 	    pjsip_dialog *dlg;
 	    const char *title;
 
-	    dlg_set = (struct dlg_set*) pj_hash_this(mod_ua.dlg_table, it);
+	    dlg_set = (struct dlg_set*) pj_hash_this(shard->dlg_table, it);
 	    if (!dlg_set || pj_list_empty(&dlg_set->dlg_list)) continue;
 
 	    /* First dialog in dialog set. */
@@ -982,9 +1093,9 @@ PJ_DEF(void) pjsip_ua_dump(pj_bool_t detail)
 		dlg = dlg->next;
 	    }
 	}
-    }
 
-    pj_mutex_unlock(mod_ua.mutex);
+	pj_mutex_unlock(shard->mutex);
+    }
 #endif
 }
 
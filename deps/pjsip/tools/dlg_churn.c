@@ -0,0 +1,147 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Dialog churn on the UA layer: keeps a constant number of dialogs
+ * registered while terminating a random one and creating a new one.
+ * Checks that every live dialog can be found, and that the memory in use
+ * by the pool factory does not grow with the number of operations. The
+ * shards keep the dialog set nodes they have allocated for reuse, and only
+ * allocate more when a shard holds more dialog sets than it ever did, so
+ * the second half of the run may only add about one pool increment per
+ * shard.
+ *
+ * Usage: dlg_churn [operations [dialogs]]
+ */
+#include <pjsip.h>
+#include <pjsip_ua.h>
+#include <pjlib-util.h>
+#include <pjlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE   "dlg_churn.c"
+
+#define MAX_GROWTH  (PJSIP_UA_DLG_TABLE_SHARDS * PJSIP_POOL_INC_UA)
+
+static pj_caching_pool cp;
+
+static pj_status_t create_dlg(pjsip_dialog **p_dlg)
+{
+    const pj_str_t local = pj_str("<sip:alice@127.0.0.1>");
+    const pj_str_t remote = pj_str("<sip:bob@127.0.0.1>");
+
+    return pjsip_dlg_create_uac(pjsip_ua_instance(), &local, &local,
+				&remote, NULL, p_dlg);
+}
+
+/* Check that the UA layer holds exactly the live dialogs */
+static int check_dlgs(pjsip_dialog **dlgs, unsigned dlg_cnt)
+{
+    unsigned i;
+
+    if (pjsip_ua_get_dlg_set_count() != dlg_cnt)
+	return -1;
+
+    for (i = 0; i < dlg_cnt; ++i) {
+	pjsip_dialog *dlg = pjsip_ua_find_dialog(&dlgs[i]->call_id->id,
+						 &dlgs[i]->local.info->tag,
+						 &dlgs[i]->remote.info->tag,
+						 PJ_FALSE);
+	if (dlg != dlgs[i])
+	    return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned op_cnt = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+    unsigned dlg_cnt = argc > 2 ? (unsigned)atoi(argv[2]) : 1000;
+    pjsip_endpoint *endpt;
+    pjsip_dialog **dlgs;
+    pj_size_t used_start, used_mid, used_end;
+    unsigned i;
+    int rc = 0;
+    pj_status_t status;
+
+    pj_log_set_level(3);
+    pj_init();
+    pjlib_util_init();
+    pj_caching_pool_init(&cp, NULL, 0);
+    pj_srand(1);
+
+    status = pjsip_endpt_create(&cp.factory, "dlg_churn", &endpt);
+    if (status == PJ_SUCCESS)
+	status = pjsip_tsx_layer_init_module(endpt);
+    if (status == PJ_SUCCESS)
+	status = pjsip_ua_init_module(endpt, NULL);
+    if (status != PJ_SUCCESS) {
+	printf("Error initializing the endpoint: %d\n", status);
+	return 1;
+    }
+
+    dlgs = (pjsip_dialog**) calloc(dlg_cnt, sizeof(pjsip_dialog*));
+    for (i = 0; i < dlg_cnt && rc == 0; ++i) {
+	if (create_dlg(&dlgs[i]) != PJ_SUCCESS)
+	    rc = -1;
+    }
+    used_start = cp.used_size;
+
+    used_mid = 0;
+    for (i = 0; i < op_cnt && rc == 0; ++i) {
+	unsigned d = pj_rand() % dlg_cnt;
+
+	pjsip_dlg_terminate(dlgs[d]);
+	dlgs[d] = NULL;
+	if (create_dlg(&dlgs[d]) != PJ_SUCCESS) {
+	    rc = -1;
+	    break;
+	}
+
+	if (i == op_cnt / 2)
+	    used_mid = cp.used_size;
+	if ((i & 0x3FFF) == 0 && check_dlgs(dlgs, dlg_cnt))
+	    rc = -1;
+    }
+    used_end = cp.used_size;
+
+    if (rc == 0 && check_dlgs(dlgs, dlg_cnt))
+	rc = -1;
+    if (rc == 0 && used_end > used_mid + MAX_GROWTH)
+	rc = -2;
+
+    printf("dialogs=%u operations=%u memory used: %lu, %lu, %lu bytes  %s\n",
+	   dlg_cnt, op_cnt, (unsigned long)used_start,
+	   (unsigned long)used_mid, (unsigned long)used_end,
+	   rc == 0 ? "ok" : (rc == -1 ? "FAILED (dialogs)" :
+				       "FAILED (memory growth)"));
+
+    for (i = 0; i < dlg_cnt; ++i) {
+	if (dlgs[i])
+	    pjsip_dlg_terminate(dlgs[i]);
+    }
+    free(dlgs);
+
+    pjsip_endpt_destroy(endpt);
+    pj_caching_pool_destroy(&cp);
+    pj_shutdown();
+    return rc ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * G.711 benchmark. Encodes and decodes a noisy signal in 20 ms frames at
+ * 8 kHz, once a sample at a time with pjmedia_linear2ulaw() and friends
+ * ("table" with PJMEDIA_HAS_ALAW_ULAW_TABLE, "scalar" without it), and
+ * once with the block functions such as pjmedia_ulaw_encode() ("simd"
+ * when PJMEDIA_ALAW_ULAW_USE_SIMD is in effect, "block" otherwise). The
+ * throughput is printed in MB/s of 16-bit PCM. Build with and without
+ * PJMEDIA_HAS_ALAW_ULAW_TABLE to compare all the paths. Checks that both
+ * give the same result for every linear value and every code.
+ *
+ * Usage: g711_bench [frames]
+ */
+#include <pjmedia.h>
+#include <pjlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE   "g711_bench.c"
+
+#define SPF	    160
+
+#if defined(PJMEDIA_HAS_ALAW_ULAW_TABLE) && PJMEDIA_HAS_ALAW_ULAW_TABLE!=0
+#   define SAMPLE_PATH	"table"
+#   if defined(PJMEDIA_ALAW_ULAW_USE_SIMD) && PJMEDIA_ALAW_ULAW_USE_SIMD!=0 && \
+       (defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#	define BLOCK_PATH   "simd"
+#   endif
+#else
+#   define SAMPLE_PATH	"scalar"
+#endif
+
+#ifndef BLOCK_PATH
+#   define BLOCK_PATH	"block"
+#endif
+
+enum op
+{
+    ULAW_ENCODE,
+    ALAW_ENCODE,
+    ULAW_DECODE,
+    ALAW_DECODE
+};
+
+static const char *op_names[] =
+{
+    "ulaw encode", "alaw encode", "ulaw decode", "alaw decode"
+};
+
+static void run_sample(enum op op, pj_int16_t *pcm, pj_uint8_t *code,
+		       unsigned count)
+{
+    unsigned i;
+
+    switch (op) {
+    case ULAW_ENCODE:
+	for (i = 0; i < count; ++i)
+	    code[i] = pjmedia_linear2ulaw(pcm[i]);
+	break;
+    case ALAW_ENCODE:
+	for (i = 0; i < count; ++i)
+	    code[i] = pjmedia_linear2alaw(pcm[i]);
+	break;
+    case ULAW_DECODE:
+	for (i = 0; i < count; ++i)
+	    pcm[i] = (pj_int16_t) pjmedia_ulaw2linear(code[i]);
+	break;
+    case ALAW_DECODE:
+	for (i = 0; i < count; ++i)
+	    pcm[i] = (pj_int16_t) pjmedia_alaw2linear(code[i]);
+	break;
+    }
+}
+
+static void run_block(enum op op, pj_int16_t *pcm, pj_uint8_t *code,
+		      unsigned count)
+{
+    switch (op) {
+    case ULAW_ENCODE:
+	pjmedia_ulaw_encode(code, pcm, count);
+	break;
+    case ALAW_ENCODE:
+	pjmedia_alaw_encode(code, pcm, count);
+	break;
+    case ULAW_DECODE:
+	pjmedia_ulaw_decode(pcm, code, count);
+	break;
+    case ALAW_DECODE:
+	pjmedia_alaw_decode(pcm, code, count);
+	break;
+    }
+}
+
+/* Check that the block functions give the same result as the per-sample
+ * conversions, for every linear value and every code.
+ */
+static int check(enum op op, pj_int16_t *pcm1, pj_int16_t *pcm2,
+		 pj_uint8_t *code1, pj_uint8_t *code2)
+{
+    unsigned i;
+
+    if (op == ULAW_ENCODE || op == ALAW_ENCODE) {
+	for (i = 0; i < 65536; ++i)
+	    pcm1[i] = (pj_int16_t)(i - 32768);
+	run_sample(op, pcm1, code1, 65536);
+	run_block(op, pcm1, code2, 65536);
+	return pj_memcmp(code1, code2, 65536) ? -1 : 0;
+    } else {
+	for (i = 0; i < 256; ++i)
+	    code1[i] = (pj_uint8_t)i;
+	run_sample(op, pcm1, code1, 256);
+	run_block(op, pcm2, code1, 256);
+	return pj_memcmp(pcm1, pcm2, 256 * sizeof(pj_int16_t)) ? -1 : 0;
+    }
+}
+
+static double bench(enum op op, pj_bool_t block, pj_int16_t *pcm,
+		    pj_uint8_t *code, unsigned frame_cnt)
+{
+    pj_timestamp t0, t1, freq;
+    unsigned i;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < frame_cnt; ++i) {
+	unsigned pos = (i * SPF) & 0xFFFF;
+
+	if (block)
+	    run_block(op, pcm + pos, code + pos, SPF);
+	else
+	    run_sample(op, pcm + pos, code + pos, SPF);
+    }
+    pj_get_timestamp(&t1);
+
+    pj_get_timestamp_freq(&freq);
+    return (double)frame_cnt * SPF * sizeof(pj_int16_t) * freq.u64 /
+	   (t1.u64 - t0.u64) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned frame_cnt = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+    pj_int16_t *pcm, *pcm2, *buf;
+    pj_uint8_t *code, *code2;
+    pj_uint32_t seed = 1;
+    unsigned i;
+    int rc = 0;
+
+    /* The signal is read in frames from a ring of 64K samples, with room
+     * for the frame which wraps around.
+     */
+    pcm = (pj_int16_t*) malloc((65536 + SPF) * sizeof(pj_int16_t));
+    pcm2 = (pj_int16_t*) malloc(65536 * sizeof(pj_int16_t));
+    buf = (pj_int16_t*) malloc((65536 + SPF) * sizeof(pj_int16_t));
+    code = (pj_uint8_t*) malloc(65536 + SPF);
+    code2 = (pj_uint8_t*) malloc(65536);
+    if (!pcm || !pcm2 || !buf || !code || !code2) {
+	printf("out of memory\n");
+	return 1;
+    }
+
+    pj_log_set_level(1);
+    pj_init();
+
+    printf("per-sample path: %s, block path: %s\n", SAMPLE_PATH, BLOCK_PATH);
+
+    for (i = ULAW_ENCODE; i <= ALAW_DECODE; ++i) {
+	enum op op = (enum op)i;
+	double sample_mbps, block_mbps;
+	unsigned k;
+	int err;
+
+	err = check(op, pcm2, buf, code, code2);
+
+	for (k = 0; k < 65536 + SPF; ++k) {
+	    seed = seed * 1103515245 + 12345;
+	    pcm[k] = (pj_int16_t)(seed >> 16);
+	    code[k] = (pj_uint8_t)(seed >> 24);
+	}
+
+	sample_mbps = bench(op, PJ_FALSE, pcm, code, frame_cnt);
+	block_mbps = bench(op, PJ_TRUE, pcm, code, frame_cnt);
+
+	printf("%s: %-6s %8.1f MB/s, %-6s %8.1f MB/s  %s\n",
+	       op_names[op], SAMPLE_PATH, sample_mbps, BLOCK_PATH,
+	       block_mbps, err ? "FAILED (results differ)" : "ok");
+	if (err)
+	    rc = 1;
+    }
+
+    free(pcm);
+    free(pcm2);
+    free(buf);
+    free(code);
+    free(code2);
+    pj_shutdown();
+    return rc;
+}
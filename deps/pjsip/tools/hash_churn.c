@@ -0,0 +1,228 @@
+/* $Id$ */
+/* 
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
+ */
+
+/*
+ * Insert/delete churn on pj_hash tables at a constant number of live
+ * entries, as the transaction and dialog tables see over the life of an
+ * endpoint. Checks that the pool the table was created from stops growing
+ * once the table has reached its steady size, and that the table contents
+ * match a shadow copy. Then times pj_hash_get_lower() of random entries,
+ * looked up in upper case, in tables holding 64 to 16384 entries, for
+ * chained tables of 255 and 16383 buckets and with open addressing.
+ *
+ * Usage: hash_churn [operations]
+ */
+#include <pjlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE   "hash_churn.c"
+
+#define KEY_LEN	    24
+
+typedef struct item
+{
+    char		key[KEY_LEN];
+    unsigned		keylen;
+    pj_bool_t		live;
+    pj_hash_entry_buf	entry_buf;
+} item;
+
+static pj_caching_pool cp;
+
+/* Check that the table holds exactly the live items */
+static int check_table(pj_hash_table_t *ht, item *items, unsigned item_cnt,
+		       unsigned live_cnt)
+{
+    unsigned i;
+
+    if (pj_hash_count(ht) != live_cnt)
+	return -1;
+
+    for (i = 0; i < item_cnt; ++i) {
+	void *value = pj_hash_get(ht, items[i].key, items[i].keylen, NULL);
+	if (value != (items[i].live ? &items[i] : NULL))
+	    return -2;
+    }
+    return 0;
+}
+
+/* Run op_cnt replacements of a random live entry with a random dead one,
+ * holding live_cnt entries in a table created for size entries.
+ */
+static int churn(const char *title, unsigned options, unsigned size,
+		 unsigned live_cnt, unsigned op_cnt)
+{
+    pj_pool_t *pool;
+    pj_hash_table_t *ht;
+    item *items;
+    unsigned *live, *dead, item_cnt = live_cnt * 2, i;
+    pj_size_t used_start, used_mid, used_end;
+    int rc = 0;
+
+    pool = pj_pool_create(&cp.factory, title, 4000, 4000, NULL);
+    ht = pj_hash_create2(pool, size, options);
+    used_start = pj_pool_get_used_size(pool);
+
+    items = (item*) calloc(item_cnt, sizeof(item));
+    live = (unsigned*) malloc(live_cnt * sizeof(unsigned));
+    dead = (unsigned*) malloc(live_cnt * sizeof(unsigned));
+
+    for (i = 0; i < item_cnt; ++i) {
+	items[i].keylen = pj_ansi_snprintf(items[i].key, KEY_LEN,
+					   "z9hG4bK-%08x", pj_rand());
+	if (i < live_cnt) {
+	    items[i].live = PJ_TRUE;
+	    pj_hash_set_np(ht, items[i].key, items[i].keylen, 0,
+			   items[i].entry_buf, &items[i]);
+	    live[i] = i;
+	} else {
+	    dead[i - live_cnt] = i;
+	}
+    }
+
+    used_mid = 0;
+    for (i = 0; i < op_cnt; ++i) {
+	unsigned l = pj_rand() % live_cnt, d = pj_rand() % live_cnt;
+	item *out = &items[live[l]], *in = &items[dead[d]];
+
+	pj_hash_set_np(ht, out->key, out->keylen, 0, out->entry_buf, NULL);
+	out->live = PJ_FALSE;
+	pj_hash_set_np(ht, in->key, in->keylen, 0, in->entry_buf, in);
+	in->live = PJ_TRUE;
+
+	live[l] = (unsigned)(in - items);
+	dead[d] = (unsigned)(out - items);
+
+	if (i == op_cnt / 2)
+	    used_mid = pj_pool_get_used_size(pool);
+	if ((i & 0xFFFF) == 0 && check_table(ht, items, item_cnt, live_cnt)) {
+	    rc = -1;
+	    break;
+	}
+    }
+    used_end = pj_pool_get_used_size(pool);
+
+    if (rc == 0 && check_table(ht, items, item_cnt, live_cnt))
+	rc = -1;
+    if (rc == 0 && used_end != used_mid)
+	rc = -2;
+
+    printf("%-28s size=%-5u live=%-5u pool used: %lu, %lu, %lu bytes  %s\n",
+	   title, size, live_cnt, (unsigned long)used_start,
+	   (unsigned long)used_mid, (unsigned long)used_end,
+	   rc == 0 ? "ok" : (rc == -1 ? "FAILED (contents)" :
+				       "FAILED (pool growth)"));
+
+    free(items);
+    free(live);
+    free(dead);
+    pj_pool_release(pool);
+    return rc;
+}
+
+/* Time op_cnt lookups of random entries, holding entry_cnt entries in a
+ * table created for size entries, and check that each finds its entry.
+ */
+static int lookup(const char *title, unsigned options, unsigned size,
+		  unsigned entry_cnt, unsigned op_cnt)
+{
+    pj_pool_t *pool;
+    pj_hash_table_t *ht;
+    item *items;
+    char (*upper)[KEY_LEN];
+    unsigned *order, i, k, miss = 0;
+    pj_timestamp t0, t1, freq;
+    double nsec;
+
+    pool = pj_pool_create(&cp.factory, title, 4000, 4000, NULL);
+    ht = pj_hash_create2(pool, size, options);
+
+    items = (item*) calloc(entry_cnt, sizeof(item));
+    upper = (char(*)[KEY_LEN]) malloc(entry_cnt * KEY_LEN);
+    order = (unsigned*) malloc(0x10000 * sizeof(unsigned));
+
+    for (i = 0; i < entry_cnt; ++i) {
+	items[i].keylen = pj_ansi_snprintf(items[i].key, KEY_LEN,
+					   "z9hg4bk-%05x-%08x", i, pj_rand());
+	items[i].live = PJ_TRUE;
+	pj_hash_set_np_lower(ht, items[i].key, items[i].keylen, 0,
+			     items[i].entry_buf, &items[i]);
+	for (k = 0; k < items[i].keylen; ++k)
+	    upper[i][k] = (char)pj_toupper(items[i].key[k]);
+    }
+    for (i = 0; i < 0x10000; ++i)
+	order[i] = pj_rand() % entry_cnt;
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < op_cnt; ++i) {
+	k = order[i & 0xFFFF];
+	if (pj_hash_get_lower(ht, upper[k], items[k].keylen, NULL) !=
+	    &items[k])
+	{
+	    ++miss;
+	}
+    }
+    pj_get_timestamp(&t1);
+
+    pj_get_timestamp_freq(&freq);
+    nsec = (double)(t1.u64 - t0.u64) * 1e9 / freq.u64 / op_cnt;
+
+    printf("%-28s size=%-5u live=%-5u %7.1f ns per lookup  %s\n",
+	   title, size, entry_cnt, nsec, miss ? "FAILED (lookup)" : "ok");
+
+    free(items);
+    free(upper);
+    free(order);
+    pj_pool_release(pool);
+    return miss ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned entry_cnts[] = { 64, 1024, 4096, 16384 };
+    unsigned i;
+    unsigned op_cnt = argc > 1 ? (unsigned)atoi(argv[1]) : 2000000;
+    int rc = 0;
+
+    pj_init();
+    pj_log_set_level(3);
+    pj_caching_pool_init(&cp, NULL, 0);
+    pj_srand(1);
+
+    rc |= churn("chained", 0, 1000, 1000, op_cnt);
+    rc |= churn("open addressing", PJ_HASH_OPEN_ADDRESSING, 1000, 1000,
+		op_cnt);
+    rc |= churn("open addressing, grown", PJ_HASH_OPEN_ADDRESSING, 1000,
+		1400, op_cnt);
+    rc |= churn("open addressing, small", PJ_HASH_OPEN_ADDRESSING, 16,
+		12, op_cnt);
+
+    for (i = 0; i < PJ_ARRAY_SIZE(entry_cnts); ++i) {
+	rc |= lookup("lookup, chained", 0, 255, entry_cnts[i], op_cnt);
+	rc |= lookup("lookup, chained", 0, 16383, entry_cnts[i], op_cnt);
+	rc |= lookup("lookup, open addressing", PJ_HASH_OPEN_ADDRESSING,
+		     entry_cnts[i], entry_cnts[i], op_cnt);
+    }
+
+    pj_caching_pool_destroy(&cp);
+    pj_shutdown();
+    return rc ? 1 : 0;
+}
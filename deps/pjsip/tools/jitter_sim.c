@@ -0,0 +1,327 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Jitter trace simulator. A sender and a receiver PCMU stream are
+ * connected through a loopback socket owned by the simulator, which
+ * delays each packet by the delay of the trace and delivers it in arrival
+ * order. Time is virtual: each 20 ms tick, a frame of a synthetic voiced
+ * signal is given to the sender, the packets arrived by then are
+ * delivered, and one frame is taken from the receiver. At the end the
+ * jitter buffer delay and the rate of concealed frames are printed.
+ *
+ * Build the library with PJMEDIA_STREAM_ADAPTIVE_PLAYOUT set to 0 and 1
+ * to compare the progressive discard with the adaptive playout.
+ *
+ * Usage: jitter_sim [wifi|mobile|flat] [trace file]
+ *
+ * The trace file has one delay in milliseconds per packet. Otherwise a
+ * synthetic trace is generated: a 40 ms base delay with exponential
+ * jitter (12 ms mean for "wifi", 8 ms for "mobile"), plus for "mobile" a
+ * 300 ms spike every 8 seconds, decaying over 15 packets.
+ */
+#include <pjmedia.h>
+#include <pjmedia-codec.h>
+#include <pjlib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE	"jitter_sim.c"
+
+#define PKT_CNT		3000	/* Number of packets (20 ms each)	*/
+#define MAX_PKT_LEN	512	/* Maximum RTP packet length		*/
+#define MAX_DELAY_TICKS	40	/* Later packets are lost		*/
+#define WARMUP_TICKS	100	/* Ticks not counted in the delay	*/
+#define CLOCK_RATE	8000
+#define SPF		160	/* Samples per frame			*/
+
+#define TX_PORT		53000	/* RTP port of the sender stream	*/
+#define RX_PORT		53002	/* RTP port of the receiver stream	*/
+#define NET_PORT	45680	/* Port of the simulated network	*/
+
+#ifndef M_PI
+#   define M_PI		3.14159265358979323846
+#endif
+
+static pj_caching_pool cp;
+static pjmedia_endpt *endpt;
+static pj_pool_t *pool;
+static const pjmedia_codec_info *codec_info;
+static pjmedia_transport *transports[2];
+static unsigned transport_cnt;
+
+static double delay_ms[PKT_CNT];
+static pj_uint8_t pkt[PKT_CNT][MAX_PKT_LEN];
+static pj_ssize_t pkt_len[PKT_CNT];
+
+/* Uniform random number in [0, 1) */
+static double urand(void)
+{
+    return (pj_rand() & 0xFFFF) / 65536.0;
+}
+
+static void gen_trace(const char *kind)
+{
+    unsigned i, k;
+
+    for (i = 0; i < PKT_CNT; ++i) {
+	delay_ms[i] = 40;
+	if (pj_ansi_strcmp(kind, "wifi") == 0)
+	    delay_ms[i] += -12 * log(1 - urand());
+	else if (pj_ansi_strcmp(kind, "mobile") == 0)
+	    delay_ms[i] += -8 * log(1 - urand());
+    }
+
+    if (pj_ansi_strcmp(kind, "mobile") == 0) {
+	for (i = 200; i < PKT_CNT; i += 400) {
+	    for (k = 0; k < 15 && i + k < PKT_CNT; ++k)
+		delay_ms[i + k] += 300 - 20 * k;
+	}
+    }
+}
+
+static pj_status_t read_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    unsigned i;
+
+    if (!f)
+	return PJ_ENOTFOUND;
+
+    for (i = 0; i < PKT_CNT; ++i) {
+	if (fscanf(f, "%lf", &delay_ms[i]) != 1)
+	    delay_ms[i] = i ? delay_ms[i - 1] : 0;
+    }
+    fclose(f);
+    return PJ_SUCCESS;
+}
+
+static pj_status_t create_stream(unsigned local_port, unsigned remote_port,
+				 pjmedia_dir dir, pj_uint32_t ssrc,
+				 pjmedia_stream **p_stream)
+{
+    pj_str_t localhost = pj_str("127.0.0.1");
+    pjmedia_transport *tp;
+    pjmedia_stream_info si;
+    pj_status_t status;
+
+    status = pjmedia_transport_udp_create(endpt, NULL, local_port, 0, &tp);
+    if (status != PJ_SUCCESS)
+	return status;
+    transports[transport_cnt++] = tp;
+
+    pj_bzero(&si, sizeof(si));
+    si.type = PJMEDIA_TYPE_AUDIO;
+    si.proto = PJMEDIA_TP_PROTO_RTP_AVP;
+    si.dir = dir;
+    pj_sockaddr_in_init(&si.rem_addr.ipv4, &localhost,
+			(pj_uint16_t)remote_port);
+    pj_sockaddr_in_init(&si.rem_rtcp.ipv4, &localhost,
+			(pj_uint16_t)(remote_port + 1));
+    si.fmt = *codec_info;
+    si.tx_pt = codec_info->pt;
+    si.rx_pt = codec_info->pt;
+    si.ssrc = ssrc;
+    si.tx_event_pt = -1;
+    si.rx_event_pt = -1;
+    si.jb_init = si.jb_min_pre = si.jb_max_pre = si.jb_max = -1;
+
+    status = pjmedia_stream_create(endpt, pool, &si, tp, NULL, p_stream);
+    if (status != PJ_SUCCESS)
+	return status;
+
+    return pjmedia_stream_start(*p_stream);
+}
+
+/* Synthetic voiced signal: harmonics of a gliding pitch, with a tremolo */
+static void gen_frame(unsigned tick, pj_int16_t *buf)
+{
+    static double phase;
+    unsigned i, h;
+
+    for (i = 0; i < SPF; ++i) {
+	double t = (double)(tick * SPF + i) / CLOCK_RATE;
+	double v = 0;
+
+	phase += 2 * M_PI * (140 + 40 * sin(2 * M_PI * 0.7 * t)) / CLOCK_RATE;
+	for (h = 1; h < 8; ++h)
+	    v += sin(h * phase) / h;
+	buf[i] = (pj_int16_t)(v * 6000 * (0.6 + 0.4 * sin(2 * M_PI * 3 * t)));
+    }
+}
+
+/* Wait until the receiver stream has received the delivered packets */
+static void wait_received(pjmedia_stream *rx, unsigned delivered)
+{
+    static int base = -1;
+    pjmedia_rtcp_stat stat;
+    unsigned i;
+
+    for (i = 0; i < 200; ++i) {
+	pjmedia_stream_get_stat(rx, &stat);
+
+	/* The packets before the first counted one are not in the stat */
+	if (base < 0 && stat.rx.pkt)
+	    base = (int)(delivered - stat.rx.pkt);
+	if (base >= 0 && (int)stat.rx.pkt + base >= (int)delivered)
+	    break;
+	pj_thread_sleep(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *kind = argc > 1 ? argv[1] : "wifi";
+    pj_str_t codec_id = pj_str("PCMU");
+    pj_str_t localhost = pj_str("127.0.0.1");
+    pjmedia_stream *tx, *rx;
+    pjmedia_port *tx_port, *rx_port;
+    pj_sock_t sock;
+    pj_sockaddr_in net_addr, rx_addr;
+    pjmedia_jb_state jb;
+    unsigned i, cnt = 1, delivered = 0, concealed = 0;
+    double buffered = 0;
+    pj_status_t status;
+
+    pj_log_set_level(1);
+    pj_init();
+    pj_caching_pool_init(&cp, NULL, 0);
+    pool = pj_pool_create(&cp.factory, "jitter_sim", 4000, 4000, NULL);
+    pj_srand(12345);
+
+    status = pjmedia_endpt_create(&cp.factory, NULL, 1, &endpt);
+    if (status == PJ_SUCCESS)
+	status = pjmedia_codec_register_audio_codecs(endpt, NULL);
+    if (status == PJ_SUCCESS)
+	status = pjmedia_codec_mgr_find_codecs_by_id(
+		    pjmedia_endpt_get_codec_mgr(endpt), &codec_id, &cnt,
+		    &codec_info, NULL);
+    if (status != PJ_SUCCESS || cnt == 0) {
+	printf("Error initializing the media endpoint: %d\n", status);
+	return 1;
+    }
+
+    if (argc > 2) {
+	if (read_trace(argv[2]) != PJ_SUCCESS) {
+	    printf("Error reading %s\n", argv[2]);
+	    return 1;
+	}
+    } else {
+	gen_trace(kind);
+    }
+
+    /* The simulated network: the sender transmits to this socket, which
+     * forwards the packets to the receiver.
+     */
+    pj_sockaddr_in_init(&net_addr, &localhost, NET_PORT);
+    pj_sockaddr_in_init(&rx_addr, &localhost, RX_PORT);
+    status = pj_sock_socket(pj_AF_INET(), pj_SOCK_DGRAM(), 0, &sock);
+    if (status == PJ_SUCCESS)
+	status = pj_sock_bind(sock, &net_addr, sizeof(net_addr));
+    if (status == PJ_SUCCESS)
+	status = create_stream(TX_PORT, NET_PORT, PJMEDIA_DIR_ENCODING, 1,
+			       &tx);
+    if (status == PJ_SUCCESS)
+	status = create_stream(RX_PORT, 9000, PJMEDIA_DIR_DECODING, 2, &rx);
+    if (status != PJ_SUCCESS) {
+	printf("Error creating the streams: %d\n", status);
+	return 1;
+    }
+
+    pjmedia_stream_get_port(tx, &tx_port);
+    pjmedia_stream_get_port(rx, &rx_port);
+
+    for (i = 0; i < PKT_CNT; ++i) {
+	pj_int16_t samples[SPF];
+	pjmedia_frame frame;
+	unsigned empty, lost;
+
+	/* Send a frame, and capture its packet */
+	gen_frame(i, samples);
+	frame.type = PJMEDIA_FRAME_TYPE_AUDIO;
+	frame.buf = samples;
+	frame.size = sizeof(samples);
+	frame.timestamp.u64 = i * SPF;
+	frame.bit_info = 0;
+	pjmedia_port_put_frame(tx_port, &frame);
+
+	do {
+	    pkt_len[i] = MAX_PKT_LEN;
+	    status = pj_sock_recv(sock, pkt[i], &pkt_len[i], 0);
+	} while (status != PJ_SUCCESS || pkt_len[i] <= 0);
+
+	/* Deliver the packets arrived by this tick, in arrival order */
+	for (;;) {
+	    unsigned k, first = i > MAX_DELAY_TICKS ? i - MAX_DELAY_TICKS : 0;
+	    int best = -1;
+
+	    for (k = first; k <= i; ++k) {
+		double arrival = k * 20 + delay_ms[k];
+
+		if (pkt_len[k] > 0 && arrival < (i + 1) * 20 &&
+		    (best < 0 || arrival < best * 20 + delay_ms[best]))
+		{
+		    best = (int)k;
+		}
+	    }
+	    if (best < 0)
+		break;
+
+	    pj_sock_sendto(sock, pkt[best], &pkt_len[best], 0, &rx_addr,
+			   sizeof(rx_addr));
+	    pkt_len[best] = -1;
+	    ++delivered;
+	}
+	wait_received(rx, delivered);
+
+	/* Play a frame, and see whether the jitter buffer had it */
+	pjmedia_stream_get_stat_jbuf(rx, &jb);
+	empty = jb.empty;
+	lost = jb.lost;
+
+	frame.buf = samples;
+	frame.size = sizeof(samples);
+	pjmedia_port_get_frame(rx_port, &frame);
+
+	pjmedia_stream_get_stat_jbuf(rx, &jb);
+	if (jb.empty != empty || jb.lost != lost)
+	    ++concealed;
+	if (i >= WARMUP_TICKS)
+	    buffered += jb.size * 20;
+    }
+
+    pjmedia_stream_get_stat_jbuf(rx, &jb);
+    printf("%-7s jb avg_delay %3u ms, mean buffered %5.1f ms, "
+	   "concealed %5.2f%% (lost %u empty %u discard %u)\n",
+	   kind, jb.avg_delay, buffered / (PKT_CNT - WARMUP_TICKS),
+	   100.0 * concealed / PKT_CNT, jb.lost, jb.empty, jb.discard);
+
+    pjmedia_stream_destroy(tx);
+    pjmedia_stream_destroy(rx);
+    for (i = 0; i < transport_cnt; ++i)
+	pjmedia_transport_close(transports[i]);
+    pj_sock_close(sock);
+    pjmedia_endpt_destroy(endpt);
+    pj_pool_release(pool);
+    pj_caching_pool_destroy(&cp);
+    pj_shutdown();
+    return 0;
+}
@@ -0,0 +1,137 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Pool churn on the caching pool: each thread creates a pool of one of a
+ * few sizes, allocates from it and releases it, as the transmit and
+ * receive buffers of the SIP endpoint do. The wall time per create/release
+ * pair over all the threads is printed for 1 to 8 threads running at the
+ * same time, for a caching pool which keeps no released pools (maximum
+ * capacity zero, which also disables the per-thread caches) and for one
+ * which keeps them. Run a build with PJ_CACHING_POOL_THREAD_CACHE set to
+ * zero to compare with a caching pool without per-thread caches. Checks
+ * that no pool is left in use.
+ *
+ * Usage: pool_churn [operations per thread]
+ */
+#include <pjlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE   "pool_churn.c"
+
+#define MAX_THREADS 8
+
+static pj_caching_pool cp;
+static unsigned op_cnt;
+
+static int worker(void *arg)
+{
+    static const pj_size_t sizes[] = { 1000, 4000, 4000, 12000 };
+    pj_uint32_t seed = (pj_uint32_t)(pj_ssize_t)arg;
+    unsigned i;
+
+    for (i = 0; i < op_cnt; ++i) {
+	pj_pool_t *pool;
+
+	seed = seed * 1103515245 + 12345;
+	pool = pj_pool_create(&cp.factory, "churn",
+			      sizes[(seed >> 16) % PJ_ARRAY_SIZE(sizes)],
+			      4000, NULL);
+	if (!pool)
+	    return -1;
+	pj_pool_alloc(pool, 200 + (seed >> 20) % 2000);
+	pj_pool_release(pool);
+    }
+    return 0;
+}
+
+static int bench(pj_pool_t *pool, pj_size_t max_capacity,
+		 unsigned thread_cnt)
+{
+    pj_thread_t *threads[MAX_THREADS];
+    pj_timestamp t0, t1, freq;
+    unsigned i;
+    double nsec;
+    int rc = 0;
+
+    pj_caching_pool_init(&cp, NULL, max_capacity);
+
+    pj_get_timestamp(&t0);
+    for (i = 0; i < thread_cnt; ++i) {
+	if (pj_thread_create(pool, "churn", &worker, (void*)(pj_ssize_t)(i+1),
+			     0, 0, &threads[i]) != PJ_SUCCESS)
+	{
+	    thread_cnt = i;
+	    rc = -1;
+	    break;
+	}
+    }
+    for (i = 0; i < thread_cnt; ++i) {
+	pj_thread_join(threads[i]);
+	pj_thread_destroy(threads[i]);
+    }
+    pj_get_timestamp(&t1);
+
+    if (cp.used_count != 0)
+	rc = -1;
+
+    pj_get_timestamp_freq(&freq);
+    nsec = (double)(t1.u64 - t0.u64) * 1e9 / freq.u64 /
+	   ((double)op_cnt * thread_cnt);
+
+    printf("max capacity %8lu, %u thread(s): %8.1f ns/op  %s\n",
+	   (unsigned long)max_capacity, thread_cnt, nsec,
+	   rc == 0 ? "ok" : "FAILED");
+
+    pj_caching_pool_destroy(&cp);
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    static const pj_size_t capacities[] = { 0, 1024 * 1024 };
+    pj_caching_pool main_cp;
+    pj_pool_t *pool;
+    unsigned i, thread_cnt;
+    int rc = 0;
+
+    op_cnt = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+
+    pj_log_set_level(1);
+    pj_init();
+
+    /* The threads are created from a pool of their own factory, so that
+     * the factories being measured only hold the pools of the workers.
+     */
+    pj_caching_pool_init(&main_cp, NULL, 0);
+    pool = pj_pool_create(&main_cp.factory, "pool_churn", 4000, 4000, NULL);
+
+    printf("PJ_CACHING_POOL_THREAD_CACHE=%d\n", PJ_CACHING_POOL_THREAD_CACHE);
+    for (i = 0; i < PJ_ARRAY_SIZE(capacities); ++i) {
+	for (thread_cnt = 1; thread_cnt <= MAX_THREADS; thread_cnt *= 2)
+	    rc |= bench(pool, capacities[i], thread_cnt);
+    }
+
+    pj_pool_release(pool);
+    pj_caching_pool_destroy(&main_cp);
+    pj_shutdown();
+    return rc ? 1 : 0;
+}
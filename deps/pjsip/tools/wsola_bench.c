@@ -0,0 +1,131 @@
+/* $Id$ */
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * WSOLA benchmark. A synthetic voiced signal with a gliding pitch and
+ * some noise is fed to pjmedia_wsola_save() in 20 ms frames, with bursts
+ * of two lost frames which are concealed with pjmedia_wsola_generate().
+ * The time spent per concealed frame is printed for 8, 16 and 48 kHz,
+ * with the CRC32 of the output, so that the output of builds with
+ * different PJMEDIA_WSOLA_USE_SIMD or PJMEDIA_WSOLA_SEARCH_STEP settings
+ * can be compared.
+ *
+ * Usage: wsola_bench [frames]
+ */
+#include <pjmedia.h>
+#include <pjlib-util.h>
+#include <pjlib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THIS_FILE   "wsola_bench.c"
+
+#ifndef M_PI
+#   define M_PI	    3.14159265358979323846
+#endif
+
+static pj_caching_pool cp;
+
+static pj_status_t bench(unsigned clock_rate, unsigned frame_cnt)
+{
+    unsigned spf = clock_rate / 50, i, k, lost = 0;
+    pj_uint32_t seed = 1;
+    pj_int16_t *frm;
+    pj_pool_t *pool;
+    pjmedia_wsola *wsola;
+    pj_crc32_context crc;
+    pj_timestamp t0, t1, elapsed, freq;
+    double phase = 0, usec;
+    pj_status_t status;
+
+    pool = pj_pool_create(&cp.factory, "wsola_bench", 4000, 4000, NULL);
+    frm = (pj_int16_t*) pj_pool_alloc(pool, spf * sizeof(pj_int16_t));
+
+    status = pjmedia_wsola_create(pool, clock_rate, spf, 1,
+				  PJMEDIA_WSOLA_NO_FADING, &wsola);
+    if (status != PJ_SUCCESS) {
+	pj_pool_release(pool);
+	return status;
+    }
+
+    pj_crc32_init(&crc);
+    elapsed.u64 = 0;
+
+    for (i = 0; i < frame_cnt; ++i) {
+	if ((i / 7) % 3 == 1 && (i % 7) < 2) {
+	    pj_get_timestamp(&t0);
+	    pjmedia_wsola_generate(wsola, frm);
+	    pj_get_timestamp(&t1);
+	    pj_add_timestamp(&elapsed, &t1);
+	    pj_sub_timestamp(&elapsed, &t0);
+	    ++lost;
+	} else {
+	    for (k = 0; k < spf; ++k) {
+		double f0 = 120 + 40 * sin(i * 0.05);
+
+		phase += 2 * M_PI * f0 / clock_rate;
+		seed = seed * 1103515245 + 12345;
+		frm[k] = (pj_int16_t)(6000 * sin(phase) +
+				      4000 * sin(2 * phase + 0.3) +
+				      2500 * sin(3 * phase + 1) +
+				      (int)(seed >> 16) % 1500);
+	    }
+	    pjmedia_wsola_save(wsola, frm, PJ_FALSE);
+	}
+	pj_crc32_update(&crc, (const pj_uint8_t*)frm,
+			spf * sizeof(pj_int16_t));
+    }
+
+    pj_get_timestamp_freq(&freq);
+    usec = lost ? (double)elapsed.u64 * 1e6 / freq.u64 / lost : 0;
+
+    printf("%5u Hz: %u frames concealed, %7.2f us per frame, "
+	   "output crc32 %08x\n",
+	   clock_rate, lost, usec, pj_crc32_final(&crc));
+
+    pjmedia_wsola_destroy(wsola);
+    pj_pool_release(pool);
+    return PJ_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned rates[] = { 8000, 16000, 48000 };
+    unsigned frame_cnt = argc > 1 ? (unsigned)atoi(argv[1]) : 20000;
+    unsigned i;
+    int rc = 0;
+
+    pj_log_set_level(1);
+    pj_init();
+    pj_caching_pool_init(&cp, NULL, 0);
+
+    for (i = 0; i < PJ_ARRAY_SIZE(rates); ++i) {
+	pj_status_t status = bench(rates[i], frame_cnt);
+	if (status != PJ_SUCCESS) {
+	    printf("%5u Hz: error %d\n", rates[i], status);
+	    rc = 1;
+	}
+    }
+
+    pj_caching_pool_destroy(&cp);
+    pj_shutdown();
+    return rc;
+}
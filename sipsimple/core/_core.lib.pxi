@@ -31,7 +31,8 @@ cdef class PJLIB:
 
 cdef class PJCachingPool:
     def __cinit__(self):
-        pj_caching_pool_init(&self._obj, &pj_pool_factory_default_policy, 0)
+        # keep up to 1MB of released pools for reuse; with no capacity, the per-thread pool caches are not used either
+        pj_caching_pool_init(&self._obj, &pj_pool_factory_default_policy, 1024*1024)
         self._init_done = 1
 
     def __dealloc__(self):
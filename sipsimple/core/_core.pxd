@@ -134,6 +134,7 @@ cdef extern from "pjlib.h":
         char *ptr
         int slen
     ctypedef pj_str_t *pj_str_ptr_const "const pj_str_t *"
+    int pj_strcmp(pj_str_t *str1, pj_str_t *str2) nogil
 
     # errors
     pj_str_t pj_strerror(int statcode, char *buf, int bufsize) nogil
@@ -165,6 +166,7 @@ cdef extern from "pjlib.h":
         pj_pool_factory factory
     void pj_caching_pool_init(pj_caching_pool *ch_pool, pj_pool_factory_policy *policy, int max_capacity) nogil
     void pj_caching_pool_destroy(pj_caching_pool *ch_pool) nogil
+    pj_pool_t *pj_pool_create(pj_pool_factory *factory, char *name, int initial_size, int increment_size, void *callback) nogil
     void *pj_pool_alloc(pj_pool_t *pool, int size) nogil
     void pj_pool_reset(pj_pool_t *pool) nogil
     pj_pool_t *pj_pool_create_on_buf(char *name, void *buf, int size) nogil
@@ -190,6 +192,8 @@ cdef extern from "pjlib.h":
     int pj_rwmutex_destroy(pj_rwmutex_t *mutex) nogil
     int pj_thread_is_registered() nogil
     int pj_thread_register(char *thread_name, long *thread_desc, pj_thread_t **thread) nogil
+    int pj_log_start_async(pj_pool_t *pool, unsigned int max_msg) nogil
+    void pj_log_stop_async() nogil
 
     # sockets
     enum:
@@ -947,6 +951,7 @@ cdef extern from "pjmedia.h":
     # wav player
     enum:
         PJMEDIA_FILE_NO_LOOP
+        PJMEDIA_FILE_SHARED
     int pjmedia_port_destroy(pjmedia_port *port) nogil
     int pjmedia_wav_player_port_create(pj_pool_t *pool, char *filename, unsigned int ptime, unsigned int flags,
                                        unsigned int buff_size, pjmedia_port **p_port) nogil
@@ -957,6 +962,7 @@ cdef extern from "pjmedia.h":
     # wav recorder
     enum pjmedia_file_writer_option:
         PJMEDIA_FILE_WRITE_PCM
+        PJMEDIA_FILE_WRITE_ASYNC
     int pjmedia_wav_writer_port_create(pj_pool_t *pool, char *filename, unsigned int clock_rate,
                                        unsigned int channel_count, unsigned int samples_per_frame,
                                        unsigned int bits_per_sample, unsigned int flags, int buff_size,
@@ -1204,6 +1210,9 @@ cdef extern from "pjsip.h":
         pjsip_rx_data_tp_info tp_info
         pjsip_rx_data_msg_info msg_info
     void *pjsip_hdr_clone(pj_pool_t *pool, void *hdr) nogil
+    int pjsip_hdr_is_lazy(pjsip_hdr *hdr) nogil
+    pjsip_hdr *pjsip_parse_lazy_hdr(pjsip_hdr *hdr) nogil
+    pjsip_msg *pjsip_msg_clone(pj_pool_t *pool, pjsip_msg *msg) nogil
     void pjsip_msg_add_hdr(pjsip_msg *msg, pjsip_hdr *hdr) nogil
     void *pjsip_msg_find_hdr(pjsip_msg *msg, pjsip_hdr_e type, void *start) nogil
     void *pjsip_msg_find_hdr_by_name(pjsip_msg *msg, pj_str_t *name, void *start) nogil
@@ -1926,6 +1935,25 @@ cdef int _remove_headers_from_tdata(pjsip_tx_data *tdata, object headers) except
 cdef int _BaseSIPURI_to_pjsip_sip_uri(BaseSIPURI uri, pjsip_sip_uri *pj_uri, pj_pool_t *pool) except -1
 cdef int _BaseRouteHeader_to_pjsip_route_hdr(BaseIdentityHeader header, pjsip_route_hdr *pj_header, pj_pool_t *pool) except -1
 
+cdef class SIPMessageView(object):
+    # attributes
+    cdef PJCachingPool _caching_pool
+    cdef PJLIB _pjlib
+    cdef pj_pool_t *_pool
+    cdef pjsip_msg *_msg
+    cdef dict _headers
+    cdef int _complete
+
+    # private methods
+    cdef object _get(self, object name)
+    cdef int _materialize(self) except -1
+    cdef pj_pool_t *_create_pool(self) except NULL
+    cdef void _release(self)
+
+cdef pjsip_hdr *_SIPMessageView_parse_header(pjsip_hdr *header) except NULL
+cdef SIPMessageView _SIPMessageView_new()
+cdef SIPMessageView SIPMessageView_create(pjsip_msg *msg)
+
 # core.ua
 
 ctypedef int (*timer_callback)(object, object) except -1 with gil
@@ -1982,6 +2010,7 @@ cdef class PJSIPUA(object):
     cdef set _incoming_requests
     cdef pj_rwmutex_t *audio_change_rwlock
     cdef pj_mutex_t *video_lock
+    cdef pj_pool_t *_log_pool
     cdef list old_devices
     cdef list old_video_devices
     cdef object _zrtp_cache
@@ -2418,7 +2447,7 @@ cdef class Subscription(object):
     cdef int _cancel_timers(self, PJSIPUA ua, int cancel_timeout, int cancel_refresh) except -1
     cdef int _send_subscribe(self, PJSIPUA ua, int expires, pj_time_val *timeout,
                              object extra_headers, object content_type, object body) except -1
-    cdef int _cb_state(self, PJSIPUA ua, object state, int code, object reason, dict headers) except -1
+    cdef int _cb_state(self, PJSIPUA ua, object state, int code, object reason, object headers) except -1
     cdef int _cb_got_response(self, PJSIPUA ua, pjsip_rx_data *rdata) except -1
     cdef int _cb_notify(self, PJSIPUA ua, pjsip_rx_data *rdata) except -1
     cdef int _cb_timeout_timer(self, PJSIPUA ua)
@@ -2535,6 +2564,9 @@ cdef class FrozenSDPSession(BaseSDPSession):
     cdef readonly FrozenSDPBandwidthInfoList bandwidth_info
     cdef readonly frozenlist media
 
+    # private methods
+    cdef pjmedia_sdp_session* get_sdp_session(self)
+
 cdef class BaseSDPMediaStream(object):
     # attributes
     cdef pjmedia_sdp_media _sdp_media
@@ -2570,6 +2602,9 @@ cdef class FrozenSDPMediaStream(BaseSDPMediaStream):
     cdef readonly FrozenSDPAttributeList attributes
     cdef readonly FrozenSDPBandwidthInfoList bandwidth_info
 
+    # private methods
+    cdef pjmedia_sdp_media* get_sdp_media(self)
+
 cdef class BaseSDPAttribute(object):
     # attributes
     cdef pjmedia_sdp_attr _sdp_attribute
@@ -2616,6 +2651,11 @@ cdef SDPAttribute SDPAttribute_create(pjmedia_sdp_attr *pj_attr)
 cdef FrozenSDPAttribute FrozenSDPAttribute_create(pjmedia_sdp_attr *pj_attr)
 cdef SDPBandwidthInfo SDPBandwidthInfo_create(pjmedia_sdp_bandw *pj_bandw)
 cdef FrozenSDPBandwidthInfo FrozenSDPBandwidthInfo_create(pjmedia_sdp_bandw *pj_bandw)
+cdef int _FrozenSDP_cache_add(dict cache, object key, object value) except -1
+cdef object _FrozenSDP_conn_key(pjmedia_sdp_conn *pj_conn)
+cdef object _FrozenSDP_attr_key(pjmedia_sdp_attr *pj_attr)
+cdef object _FrozenSDP_bandw_key(pjmedia_sdp_bandw *pj_bandw)
+cdef object _FrozenSDP_media_key(pjmedia_sdp_media *pj_media)
 
 cdef class SDPNegotiator(object):
     # attributes
@@ -327,6 +327,7 @@ cdef class FrozenSDPSession(BaseSDPSession):
             self.attributes = FrozenSDPAttributeList(attributes) if not isinstance(attributes, FrozenSDPAttributeList) else attributes
             self.bandwidth_info = FrozenSDPBandwidthInfoList(bandwidth_info) if not isinstance(bandwidth_info, FrozenSDPBandwidthInfo) else bandwidth_info
             self.media = media
+            BaseSDPSession.get_sdp_session(self)
             self.initialized = 1
 
     @classmethod
@@ -352,6 +353,10 @@ cdef class FrozenSDPSession(BaseSDPSession):
     def __richcmp__(self, other, op):
         return BaseSDPSession_richcmp(self, other, op)
 
+    cdef pjmedia_sdp_session* get_sdp_session(self):
+        # the pointer arrays are filled in once by __init__, as nothing can change afterwards
+        return &self._sdp_session
+
 
 class MediaCodec(object):
     name = WriteOnceAttribute()
@@ -649,6 +654,7 @@ cdef class FrozenSDPMediaStream(BaseSDPMediaStream):
             else:
                 self.codec_list = frozenlist()
             self.bandwidth_info = FrozenSDPBandwidthInfoList(bandwidth_info) if not isinstance(bandwidth_info, FrozenSDPBandwidthInfoList) else bandwidth_info
+            BaseSDPMediaStream.get_sdp_media(self)
             self.initialized = 1
 
     @classmethod
@@ -667,6 +673,10 @@ cdef class FrozenSDPMediaStream(BaseSDPMediaStream):
     def __richcmp__(self, other, op):
         return BaseSDPMediaStream_richcmp(self, other, op)
 
+    cdef pjmedia_sdp_media* get_sdp_media(self):
+        # the pointer arrays are filled in once by __init__, as nothing can change afterwards
+        return &self._sdp_media
+
 
 cdef object BaseSDPConnection_richcmp(object self, object other, int op) with gil:
     cdef int eq = 1
@@ -959,6 +969,49 @@ cdef class FrozenSDPBandwidthInfo(BaseSDPBandwidthInfo):
         return BaseSDPBandwidthInfo_richcmp(self, other, op)
 
 
+# Frozen object cache
+#
+
+# The frozen SDP objects are immutable, so the ones built from an SDP that
+# was already seen (the same session appears as the proposed and active
+# one, and re-INVITEs mostly repeat the media sections unchanged) can be
+# shared instead of being built again. The caches are keyed by the content
+# of the pjmedia structures and are flushed when they grow too large.
+
+cdef int _frozen_sdp_cache_size = 256
+cdef dict _frozen_sdp_session_cache = {}
+cdef dict _frozen_sdp_media_cache = {}
+cdef dict _frozen_sdp_attribute_cache = {}
+
+cdef int _FrozenSDP_cache_add(dict cache, object key, object value) except -1:
+    if len(cache) >= _frozen_sdp_cache_size:
+        cache.clear()
+    cache[key] = value
+    return 0
+
+cdef object _FrozenSDP_conn_key(pjmedia_sdp_conn *pj_conn):
+    if pj_conn == NULL:
+        return None
+    return (_pj_str_to_str(pj_conn.addr), _pj_str_to_str(pj_conn.net_type), _pj_str_to_str(pj_conn.addr_type))
+
+cdef object _FrozenSDP_attr_key(pjmedia_sdp_attr *pj_attr):
+    return (_pj_str_to_str(pj_attr.name), _pj_str_to_str(pj_attr.value))
+
+cdef object _FrozenSDP_bandw_key(pjmedia_sdp_bandw *pj_bandw):
+    return (_pj_str_to_str(pj_bandw.modifier), int(pj_bandw.value))
+
+cdef object _FrozenSDP_media_key(pjmedia_sdp_media *pj_media):
+    cdef int i
+    return (_pj_str_to_str(pj_media.desc.media),
+            pj_media.desc.port,
+            _pj_str_to_str(pj_media.desc.transport),
+            pj_media.desc.port_count,
+            tuple([_pj_str_to_str(pj_media.desc.fmt[i]) for i in range(pj_media.desc.fmt_count)]),
+            _FrozenSDP_conn_key(pj_media.conn),
+            tuple([_FrozenSDP_attr_key(pj_media.attr[i]) for i in range(pj_media.attr_count)]),
+            tuple([_FrozenSDP_bandw_key(pj_media.bandw[i]) for i in range(pj_media.bandw_count)]))
+
+
 # Factory functions
 #
 
@@ -983,22 +1036,35 @@ cdef SDPSession SDPSession_create(pjmedia_sdp_session_ptr_const pj_session):
 
 cdef FrozenSDPSession FrozenSDPSession_create(pjmedia_sdp_session_ptr_const pj_session):
     cdef FrozenSDPConnection connection = None
+    cdef FrozenSDPSession session
     cdef int i
+    key = (_pj_str_to_str(pj_session.origin.addr),
+           pj_session.origin.id,
+           pj_session.origin.version,
+           _pj_str_to_str(pj_session.origin.user),
+           _pj_str_to_str(pj_session.origin.net_type),
+           _pj_str_to_str(pj_session.origin.addr_type),
+           _pj_str_to_str(pj_session.name),
+           _FrozenSDP_conn_key(pj_session.conn),
+           pj_session.time.start,
+           pj_session.time.stop,
+           tuple([_FrozenSDP_attr_key(pj_session.attr[i]) for i in range(pj_session.attr_count)]),
+           tuple([_FrozenSDP_bandw_key(pj_session.bandw[i]) for i in range(pj_session.bandw_count)]),
+           tuple([_FrozenSDP_media_key(pj_session.media[i]) if pj_session.media[i] != NULL else None for i in range(pj_session.media_count)]))
+    session = _frozen_sdp_session_cache.get(key)
+    if session is not None:
+        return session
     if pj_session.conn != NULL:
         connection = FrozenSDPConnection_create(pj_session.conn)
-    return FrozenSDPSession(_pj_str_to_str(pj_session.origin.addr),
-                            pj_session.origin.id,
-                            pj_session.origin.version,
-                            _pj_str_to_str(pj_session.origin.user),
-                            _pj_str_to_str(pj_session.origin.net_type),
-                            _pj_str_to_str(pj_session.origin.addr_type),
-                            _pj_str_to_str(pj_session.name),
-                            connection,
-                            pj_session.time.start,
-                            pj_session.time.stop,
-                            frozenlist([FrozenSDPAttribute_create(pj_session.attr[i]) for i in range(pj_session.attr_count)]),
-                            frozenlist([FrozenSDPBandwidthInfo_create(pj_session.bandw[i]) for i in range(pj_session.bandw_count)]),
-                            frozenlist([FrozenSDPMediaStream_create(pj_session.media[i]) if pj_session.media[i] != NULL else None for i in range(pj_session.media_count)]))
+    session = FrozenSDPSession(key[0], key[1], key[2], key[3], key[4], key[5], key[6],
+                               connection,
+                               pj_session.time.start,
+                               pj_session.time.stop,
+                               frozenlist([FrozenSDPAttribute_create(pj_session.attr[i]) for i in range(pj_session.attr_count)]),
+                               frozenlist([FrozenSDPBandwidthInfo_create(pj_session.bandw[i]) for i in range(pj_session.bandw_count)]),
+                               frozenlist([FrozenSDPMediaStream_create(pj_session.media[i]) if pj_session.media[i] != NULL else None for i in range(pj_session.media_count)]))
+    _FrozenSDP_cache_add(_frozen_sdp_session_cache, key, session)
+    return session
 
 cdef SDPMediaStream SDPMediaStream_create(pjmedia_sdp_media *pj_media):
     cdef SDPConnection connection = None
@@ -1016,17 +1082,21 @@ cdef SDPMediaStream SDPMediaStream_create(pjmedia_sdp_media *pj_media):
 
 cdef FrozenSDPMediaStream FrozenSDPMediaStream_create(pjmedia_sdp_media *pj_media):
     cdef FrozenSDPConnection connection = None
+    cdef FrozenSDPMediaStream media
     cdef int i
+    key = _FrozenSDP_media_key(pj_media)
+    media = _frozen_sdp_media_cache.get(key)
+    if media is not None:
+        return media
     if pj_media.conn != NULL:
         connection = FrozenSDPConnection_create(pj_media.conn)
-    return FrozenSDPMediaStream(_pj_str_to_str(pj_media.desc.media),
-                          pj_media.desc.port,
-                          _pj_str_to_str(pj_media.desc.transport),
-                          pj_media.desc.port_count,
-                          frozenlist([_pj_str_to_str(pj_media.desc.fmt[i]) for i in range(pj_media.desc.fmt_count)]),
-                          connection,
-                          frozenlist([FrozenSDPAttribute_create(pj_media.attr[i]) for i in range(pj_media.attr_count)]),
-                          frozenlist([FrozenSDPBandwidthInfo_create(pj_media.bandw[i]) for i in range(pj_media.bandw_count)]))
+    media = FrozenSDPMediaStream(key[0], key[1], key[2], key[3],
+                                 frozenlist(key[4]),
+                                 connection,
+                                 frozenlist([FrozenSDPAttribute_create(pj_media.attr[i]) for i in range(pj_media.attr_count)]),
+                                 frozenlist([FrozenSDPBandwidthInfo_create(pj_media.bandw[i]) for i in range(pj_media.bandw_count)]))
+    _FrozenSDP_cache_add(_frozen_sdp_media_cache, key, media)
+    return media
 
 cdef SDPConnection SDPConnection_create(pjmedia_sdp_conn *pj_conn):
     return SDPConnection(_pj_str_to_str(pj_conn.addr), _pj_str_to_str(pj_conn.net_type),
@@ -1040,7 +1110,13 @@ cdef SDPAttribute SDPAttribute_create(pjmedia_sdp_attr *pj_attr):
     return SDPAttribute(_pj_str_to_str(pj_attr.name), _pj_str_to_str(pj_attr.value))
 
 cdef FrozenSDPAttribute FrozenSDPAttribute_create(pjmedia_sdp_attr *pj_attr):
-    return FrozenSDPAttribute(_pj_str_to_str(pj_attr.name), _pj_str_to_str(pj_attr.value))
+    cdef FrozenSDPAttribute attribute
+    key = _FrozenSDP_attr_key(pj_attr)
+    attribute = _frozen_sdp_attribute_cache.get(key)
+    if attribute is None:
+        attribute = FrozenSDPAttribute(key[0], key[1])
+        _FrozenSDP_cache_add(_frozen_sdp_attribute_cache, key, attribute)
+    return attribute
 
 cdef SDPBandwidthInfo SDPBandwidthInfo_create(pjmedia_sdp_bandw *pj_bandw):
     return SDPBandwidthInfo(_pj_str_to_str(pj_bandw.modifier), int(pj_bandw.value))
@@ -952,7 +952,8 @@ cdef class RecordingWaveFile:
                     status = pjmedia_wav_writer_port_create(pool, filename,
                                                             sample_rate, 1,
                                                             sample_rate / 50, 16,
-                                                            PJMEDIA_FILE_WRITE_PCM, 0, port_address)
+                                                            PJMEDIA_FILE_WRITE_PCM | PJMEDIA_FILE_WRITE_ASYNC, 0,
+                                                            port_address)
                 if status != 0:
                     raise PJSIPError("Could not create WAV file", status)
                 self._slot = self.mixer._add_port(ua, self._pool, self._port)
@@ -1128,7 +1129,8 @@ cdef class WaveFile:
             self._pool = pool
             try:
                 with nogil:
-                    status = pjmedia_wav_player_port_create(pool, filename, 0, PJMEDIA_FILE_NO_LOOP, 0, port_address)
+                    status = pjmedia_wav_player_port_create(pool, filename, 0, PJMEDIA_FILE_NO_LOOP | PJMEDIA_FILE_SHARED, 0,
+                                                            port_address)
                 if status != 0:
                     raise PJSIPError("Could not open WAV file", status)
                 with nogil:
@@ -232,7 +232,7 @@ cdef class Subscription:
 
     # callback methods
 
-    cdef int _cb_state(self, PJSIPUA ua, object state, int code, object reason, dict headers) except -1:
+    cdef int _cb_state(self, PJSIPUA ua, object state, int code, object reason, object headers) except -1:
         # PJSIP holds the dialog lock when this callback is entered
         cdef object prev_state = self.state
         cdef int expires
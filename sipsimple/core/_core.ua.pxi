@@ -99,6 +99,13 @@ cdef class PJSIPUA:
         status = pj_mutex_create_simple(self._pjsip_endpoint._pool, "event_queue_lock", &_event_queue_lock)
         if status != 0:
             raise PJSIPError("Could not initialize event queue mutex", status)
+        # the log writer outlives the endpoints, so that their destruction is logged through it
+        self._log_pool = pj_pool_create(&self._caching_pool._obj.factory, "log_writer", 4096, 4096, NULL)
+        if self._log_pool == NULL:
+            raise SIPCoreError("Could not allocate memory pool")
+        status = pj_log_start_async(self._log_pool, 0)
+        if status != 0:
+            raise PJSIPError("Could not start log writer thread", status)
         self._ip_address = kwargs["ip_address"]
         self.codecs = kwargs["codecs"]
         self.video_codecs = kwargs["video_codecs"]
@@ -774,6 +781,11 @@ cdef class PJSIPUA:
             _event_queue_lock = NULL
         self._pjsip_endpoint = None
         self._pjmedia_endpoint = None
+        with nogil:
+            pj_log_stop_async()
+        if self._log_pool != NULL:
+            pj_pool_release(self._log_pool)
+            self._log_pool = NULL
         self._caching_pool = None
         self._pjlib = None
         _ua = NULL
@@ -196,84 +196,270 @@ cdef int _dict_to_pjsip_param(object params, pjsip_param *param_list, pj_pool_t
         pj_list_insert_after(<pj_list *> param_list, <pj_list *> param)
     return 0
 
-cdef int _pjsip_msg_to_dict(pjsip_msg *msg, dict info_dict) except -1:
-    cdef pjsip_msg_body *body
-    cdef pjsip_hdr *header
+cdef object _SIPMessageView_header_data(pjsip_hdr *header, int kind, object header_name):
     cdef pjsip_generic_array_hdr *array_header
-    cdef pjsip_ctype_hdr *ctype_header
     cdef pjsip_cseq_hdr *cseq_header
-    cdef char *buf
-    cdef int buf_len, i, status
-    headers = {}
-    header = <pjsip_hdr *> (<pj_list *> &msg.hdr).next
-    while header != &msg.hdr:
-        header_name = _pj_str_to_str(header.name)
-        header_data = None
-        multi_header = False
-        if header_name in ("Accept", "Allow", "Require", "Supported", "Unsupported", "Allow-Events"):
-            array_header = <pjsip_generic_array_hdr *> header
-            header_data = []
-            for i from 0 <= i < array_header.count:
-                header_data.append(_pj_str_to_str(array_header.values[i]))
-        elif header_name == "Contact":
-            multi_header = True
-            header_data = FrozenContactHeader_create(<pjsip_contact_hdr *> header)
-        elif header_name == "Content-Length":
-            header_data = (<pjsip_clen_hdr *> header).len
-        elif header_name == "Content-Type":
-            header_data = FrozenContentTypeHeader_create(<pjsip_ctype_hdr *> header)
-        elif header_name == "CSeq":
-            cseq_header = <pjsip_cseq_hdr *> header
-            header_data = (cseq_header.cseq, _pj_str_to_str(cseq_header.method.name))
-        elif header_name in ("Expires", "Max-Forwards", "Min-Expires"):
-            header_data = (<pjsip_generic_int_hdr *> header).ivalue
-        elif header_name == "From":
-            header_data = FrozenFromHeader_create(<pjsip_fromto_hdr *> header)
-        elif header_name == "To":
-            header_data = FrozenToHeader_create(<pjsip_fromto_hdr *> header)
-        elif header_name == "Route":
-            multi_header = True
-            header_data = FrozenRouteHeader_create(<pjsip_routing_hdr *> header)
-        elif header_name == "Reason":
-            value = _pj_str_to_str((<pjsip_generic_string_hdr *>header).hvalue)
-            protocol, sep, params_str = value.partition(';')
-            params = frozendict([(name, value or None) for name, sep, value in [param.partition('=') for param in params_str.split(';')]])
-            header_data = FrozenReasonHeader(protocol, params)
-        elif header_name == "Record-Route":
-            multi_header = True
-            header_data = FrozenRecordRouteHeader_create(<pjsip_routing_hdr *> header)
-        elif header_name == "Retry-After":
-            header_data = FrozenRetryAfterHeader_create(<pjsip_retry_after_hdr *> header)
-        elif header_name == "Via":
-            multi_header = True
-            header_data = FrozenViaHeader_create(<pjsip_via_hdr *> header)
-        elif header_name == "Warning":
-            match = _re_warning_hdr.match(_pj_str_to_str((<pjsip_generic_string_hdr *>header).hvalue))
-            if match is not None:
-                warning_params = match.groupdict()
-                warning_params['code'] = int(warning_params['code'])
-                header_data = FrozenWarningHeader(**warning_params)
-        elif header_name == "Event":
-            header_data = FrozenEventHeader_create(<pjsip_event_hdr *> header)
-        elif header_name == "Subscription-State":
-            header_data = FrozenSubscriptionStateHeader_create(<pjsip_sub_state_hdr *> header)
-        elif header_name == "Refer-To":
-            header_data = FrozenReferToHeader_create(<pjsip_generic_string_hdr *> header)
-        elif header_name == "Subject":
-            header_data = FrozenSubjectHeader_create(<pjsip_generic_string_hdr *> header)
-        elif header_name == "Replaces":
-            header_data = FrozenReplacesHeader_create(<pjsip_replaces_hdr *> header)
-        # skip the following headers:
-        elif header_name not in ("Authorization", "Proxy-Authenticate", "Proxy-Authorization", "WWW-Authenticate"):
-            header_data = FrozenHeader(header_name, _pj_str_to_str((<pjsip_generic_string_hdr *> header).hvalue))
-        if header_data is not None:
-            if multi_header:
-                headers.setdefault(header_name, []).append(header_data)
+    cdef int i
+    if kind == _HEADER_ARRAY:
+        array_header = <pjsip_generic_array_hdr *> header
+        header_data = []
+        for i from 0 <= i < array_header.count:
+            header_data.append(_pj_str_to_str(array_header.values[i]))
+        return header_data
+    elif kind == _HEADER_CONTACT:
+        return FrozenContactHeader_create(<pjsip_contact_hdr *> header)
+    elif kind == _HEADER_CONTENT_LENGTH:
+        return (<pjsip_clen_hdr *> header).len
+    elif kind == _HEADER_CONTENT_TYPE:
+        return FrozenContentTypeHeader_create(<pjsip_ctype_hdr *> header)
+    elif kind == _HEADER_CSEQ:
+        cseq_header = <pjsip_cseq_hdr *> header
+        return (cseq_header.cseq, _pj_str_to_str(cseq_header.method.name))
+    elif kind == _HEADER_INT:
+        return (<pjsip_generic_int_hdr *> header).ivalue
+    elif kind == _HEADER_FROM:
+        return FrozenFromHeader_create(<pjsip_fromto_hdr *> header)
+    elif kind == _HEADER_TO:
+        return FrozenToHeader_create(<pjsip_fromto_hdr *> header)
+    elif kind == _HEADER_ROUTE:
+        return FrozenRouteHeader_create(<pjsip_routing_hdr *> header)
+    elif kind == _HEADER_REASON:
+        value = _pj_str_to_str((<pjsip_generic_string_hdr *>header).hvalue)
+        protocol, sep, params_str = value.partition(';')
+        params = frozendict([(name, value or None) for name, sep, value in [param.partition('=') for param in params_str.split(';')]])
+        return FrozenReasonHeader(protocol, params)
+    elif kind == _HEADER_RECORD_ROUTE:
+        return FrozenRecordRouteHeader_create(<pjsip_routing_hdr *> header)
+    elif kind == _HEADER_RETRY_AFTER:
+        return FrozenRetryAfterHeader_create(<pjsip_retry_after_hdr *> header)
+    elif kind == _HEADER_VIA:
+        return FrozenViaHeader_create(<pjsip_via_hdr *> header)
+    elif kind == _HEADER_WARNING:
+        match = _re_warning_hdr.match(_pj_str_to_str((<pjsip_generic_string_hdr *>header).hvalue))
+        if match is not None:
+            warning_params = match.groupdict()
+            warning_params['code'] = int(warning_params['code'])
+            return FrozenWarningHeader(**warning_params)
+        return None
+    elif kind == _HEADER_EVENT:
+        return FrozenEventHeader_create(<pjsip_event_hdr *> header)
+    elif kind == _HEADER_SUBSCRIPTION_STATE:
+        return FrozenSubscriptionStateHeader_create(<pjsip_sub_state_hdr *> header)
+    elif kind == _HEADER_REFER_TO:
+        return FrozenReferToHeader_create(<pjsip_generic_string_hdr *> header)
+    elif kind == _HEADER_SUBJECT:
+        return FrozenSubjectHeader_create(<pjsip_generic_string_hdr *> header)
+    elif kind == _HEADER_REPLACES:
+        return FrozenReplacesHeader_create(<pjsip_replaces_hdr *> header)
+    elif kind == _HEADER_SKIP:
+        return None
+    else:
+        return FrozenHeader(header_name, _pj_str_to_str((<pjsip_generic_string_hdr *> header).hvalue))
+
+cdef inline int _SIPMessageView_header_kind(pjsip_hdr *header, object header_name):
+    # headers left unparsed because parsing failed behave as generic string headers
+    if pjsip_hdr_is_lazy(header):
+        return _HEADER_GENERIC
+    return _header_kinds.get(header_name, _HEADER_GENERIC)
+
+cdef pjsip_hdr *_SIPMessageView_parse_header(pjsip_hdr *header) except NULL:
+    if pjsip_hdr_is_lazy(header):
+        # the parser is only available while the engine runs, and the calling thread must be known to PJLIB
+        _get_ua()
+        header = pjsip_parse_lazy_hdr(header)
+    return header
+
+cdef class SIPMessageView:
+    # Read-only mapping of the headers of a SIP message, as found in the "headers" entry of the dictionaries
+    # built by _pjsip_msg_to_dict. It keeps a copy of the message and only creates the header objects when
+    # they are accessed. The copy is released once all the headers have been created. All the methods run
+    # with the GIL held, which serializes the access to the copy.
+
+    def __cinit__(self, *args, **kwargs):
+        self._pool = NULL
+        self._msg = NULL
+        self._headers = dict()
+        self._complete = 1
+
+    def __dealloc__(self):
+        self._release()
+
+    def __reduce__(self):
+        self._materialize()
+        return (dict, (self._headers,), None)
+
+    def __repr__(self):
+        self._materialize()
+        return "SIPMessageView(%r)" % self._headers
+
+    def __len__(self):
+        self._materialize()
+        return len(self._headers)
+
+    def __iter__(self):
+        self._materialize()
+        return iter(self._headers)
+
+    def __richcmp__(SIPMessageView self, other, op):
+        self._materialize()
+        if isinstance(other, SIPMessageView):
+            (<SIPMessageView>other)._materialize()
+            other = (<SIPMessageView>other)._headers
+        if op == 2:
+            return self._headers == other
+        elif op == 3:
+            return self._headers != other
+        else:
+            return NotImplemented
+
+    def __contains__(self, name):
+        try:
+            self._get(name)
+        except KeyError:
+            return False
+        return True
+
+    def __getitem__(self, name):
+        return self._get(name)
+
+    def copy(self):
+        self._materialize()
+        return self._headers.copy()
+
+    def get(self, name, default=None):
+        try:
+            return self._get(name)
+        except KeyError:
+            return default
+
+    def has_key(self, name):
+        return name in self
+
+    def items(self):
+        self._materialize()
+        return self._headers.items()
+
+    def iteritems(self):
+        self._materialize()
+        return self._headers.iteritems()
+
+    def iterkeys(self):
+        self._materialize()
+        return self._headers.iterkeys()
+
+    def itervalues(self):
+        self._materialize()
+        return self._headers.itervalues()
+
+    def keys(self):
+        self._materialize()
+        return self._headers.keys()
+
+    def values(self):
+        self._materialize()
+        return self._headers.values()
+
+    cdef object _get(self, object name):
+        cdef pjsip_hdr *header
+        cdef pj_str_t name_pj
+        cdef int kind
+        cdef list header_list
+        try:
+            return self._headers[name]
+        except KeyError:
+            if self._complete:
+                raise
+        if not isinstance(name, str):
+            self._materialize()
+            return self._headers[name]
+        kind = _header_kinds.get(name, _HEADER_GENERIC)
+        if kind == _HEADER_SKIP:
+            raise KeyError(name)
+        _str_to_pj_str(name, &name_pj)
+        header_list = None
+        header = <pjsip_hdr *> (<pj_list *> &self._msg.hdr).next
+        while header != &self._msg.hdr:
+            if pj_strcmp(&header.name, &name_pj) == 0:
+                header = _SIPMessageView_parse_header(header)
+                header_data = _SIPMessageView_header_data(header, _SIPMessageView_header_kind(header, name), name)
+                if header_data is not None:
+                    if name not in _multi_headers:
+                        self._headers[name] = header_data
+                        return header_data
+                    if header_list is None:
+                        header_list = []
+                    header_list.append(header_data)
+            header = <pjsip_hdr *> (<pj_list *> header).next
+        if header_list is None:
+            raise KeyError(name)
+        self._headers[name] = header_list
+        return header_list
+
+    cdef int _materialize(self) except -1:
+        cdef pjsip_hdr *header
+        cdef dict headers
+        if self._complete:
+            return 0
+        headers = {}
+        header = <pjsip_hdr *> (<pj_list *> &self._msg.hdr).next
+        while header != &self._msg.hdr:
+            header = _SIPMessageView_parse_header(header)
+            header_name = _pj_str_to_str(header.name)
+            if header_name in self._headers:
+                # keep the objects which have already been handed out
+                headers[header_name] = self._headers[header_name]
             else:
-                if header_name not in headers:
-                    headers[header_name] = header_data
-        header = <pjsip_hdr *> (<pj_list *> header).next
-    info_dict["headers"] = headers
+                header_data = _SIPMessageView_header_data(header, _SIPMessageView_header_kind(header, header_name), header_name)
+                if header_data is not None:
+                    if header_name in _multi_headers:
+                        headers.setdefault(header_name, []).append(header_data)
+                    elif header_name not in headers:
+                        headers[header_name] = header_data
+            header = <pjsip_hdr *> (<pj_list *> header).next
+        self._headers = headers
+        self._complete = 1
+        self._release()
+        return 0
+
+    cdef pj_pool_t *_create_pool(self) except NULL:
+        cdef pj_pool_factory *factory = &self._caching_pool._obj.factory
+        cdef pj_pool_t *pool
+        with nogil:
+            pool = pj_pool_create(factory, "SIPMessageView%p", 4096, 4096, NULL)
+        if pool == NULL:
+            raise SIPCoreError("Could not allocate memory pool")
+        return pool
+
+    cdef void _release(self):
+        if self._pool != NULL:
+            pj_pool_release(self._pool)
+            self._pool = NULL
+        self._msg = NULL
+
+cdef SIPMessageView _SIPMessageView_new():
+    cdef SIPMessageView view
+    cdef PJSIPUA ua = _get_ua()
+    view = SIPMessageView.__new__(SIPMessageView)
+    # the caching pool and the library must outlive the message
+    view._caching_pool = ua._caching_pool
+    view._pjlib = ua._pjlib
+    view._complete = 0
+    return view
+
+cdef SIPMessageView SIPMessageView_create(pjsip_msg *msg):
+    cdef SIPMessageView view = _SIPMessageView_new()
+    cdef pj_pool_t *pool = view._create_pool()
+    view._pool = pool
+    with nogil:
+        msg = pjsip_msg_clone(pool, msg)
+    view._msg = msg
+    return view
+
+cdef int _pjsip_msg_to_dict(pjsip_msg *msg, dict info_dict) except -1:
+    cdef pjsip_msg_body *body
+    cdef char *buf
+    cdef int buf_len, status
+    info_dict["headers"] = SIPMessageView_create(msg)
     body = msg.body
     if body == NULL:
         info_dict["body"] = None
@@ -394,5 +580,52 @@ def decode_device_name(device_name):
 
 cdef object _re_pj_status_str_def = re.compile("^.*\((.*)\)$")
 cdef object _re_warning_hdr = re.compile('(?P<code>[0-9]{3}) (?P<agent>.*?) "(?P<text>.*?)"')
+
+# how the headers of received and sent messages are converted by SIPMessageView
+cdef enum:
+    _HEADER_GENERIC
+    _HEADER_SKIP
+    _HEADER_ARRAY
+    _HEADER_CONTACT
+    _HEADER_CONTENT_LENGTH
+    _HEADER_CONTENT_TYPE
+    _HEADER_CSEQ
+    _HEADER_INT
+    _HEADER_FROM
+    _HEADER_TO
+    _HEADER_ROUTE
+    _HEADER_REASON
+    _HEADER_RECORD_ROUTE
+    _HEADER_RETRY_AFTER
+    _HEADER_VIA
+    _HEADER_WARNING
+    _HEADER_EVENT
+    _HEADER_SUBSCRIPTION_STATE
+    _HEADER_REFER_TO
+    _HEADER_SUBJECT
+    _HEADER_REPLACES
+cdef dict _header_kinds = {"Accept": _HEADER_ARRAY, "Allow": _HEADER_ARRAY, "Require": _HEADER_ARRAY,
+                           "Supported": _HEADER_ARRAY, "Unsupported": _HEADER_ARRAY, "Allow-Events": _HEADER_ARRAY,
+                           "Contact": _HEADER_CONTACT,
+                           "Content-Length": _HEADER_CONTENT_LENGTH,
+                           "Content-Type": _HEADER_CONTENT_TYPE,
+                           "CSeq": _HEADER_CSEQ,
+                           "Expires": _HEADER_INT, "Max-Forwards": _HEADER_INT, "Min-Expires": _HEADER_INT,
+                           "From": _HEADER_FROM,
+                           "To": _HEADER_TO,
+                           "Route": _HEADER_ROUTE,
+                           "Reason": _HEADER_REASON,
+                           "Record-Route": _HEADER_RECORD_ROUTE,
+                           "Retry-After": _HEADER_RETRY_AFTER,
+                           "Via": _HEADER_VIA,
+                           "Warning": _HEADER_WARNING,
+                           "Event": _HEADER_EVENT,
+                           "Subscription-State": _HEADER_SUBSCRIPTION_STATE,
+                           "Refer-To": _HEADER_REFER_TO,
+                           "Subject": _HEADER_SUBJECT,
+                           "Replaces": _HEADER_REPLACES,
+                           "Authorization": _HEADER_SKIP, "Proxy-Authenticate": _HEADER_SKIP,
+                           "Proxy-Authorization": _HEADER_SKIP, "WWW-Authenticate": _HEADER_SKIP}
+cdef frozenset _multi_headers = frozenset(["Contact", "Route", "Record-Route", "Via"])
 sip_status_messages = SIPStatusMessages()
 